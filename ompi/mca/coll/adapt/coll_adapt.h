@@ -33,9 +33,19 @@ typedef enum {
     OMPI_COLL_ADAPT_ALGORITHM_PIPELINE,
     OMPI_COLL_ADAPT_ALGORITHM_CHAIN,
     OMPI_COLL_ADAPT_ALGORITHM_LINEAR,
+    OMPI_COLL_ADAPT_ALGORITHM_TOPO_BINOMIAL,
+    OMPI_COLL_ADAPT_ALGORITHM_TOPO_CHAIN,
     OMPI_COLL_ADAPT_ALGORITHM_COUNT /* number of algorithms, keep last! */
 } ompi_coll_adapt_algorithm_t;
 
+/* Algorithms of allreduce, made of the ireduce and ibcast above */
+typedef enum {
+    OMPI_COLL_ADAPT_ALLREDUCE_PREVIOUS = 0,
+    OMPI_COLL_ADAPT_ALLREDUCE_REDUCE_BCAST,
+    OMPI_COLL_ADAPT_ALLREDUCE_REDUCE_SCATTER_ALLGATHER,
+    OMPI_COLL_ADAPT_ALLREDUCE_COUNT /* number of algorithms, keep last! */
+} ompi_coll_adapt_allreduce_algorithm_t;
+
 /*
  * Structure to hold the adapt coll component.  First it holds the
  * base coll component, and then holds a bunch of
@@ -84,6 +94,14 @@ typedef struct mca_coll_adapt_component_t {
     /* Reduce free list */
     opal_free_list_t *adapt_ireduce_context_free_list;
 
+    /* Allreduce MCA parameter */
+    int adapt_iallreduce_algorithm;
+    size_t adapt_iallreduce_block_size;
+    int adapt_iallreduce_max_blocks;
+
+    /* Allgather MCA parameter */
+    int adapt_iallgather_max_blocks;
+
 } mca_coll_adapt_component_t;
 
 /*
@@ -94,6 +112,10 @@ typedef struct mca_coll_adapt_collective_fallback_s {
     union {
         mca_coll_base_module_reduce_fn_t   reduce;
         mca_coll_base_module_ireduce_fn_t ireduce;
+        mca_coll_base_module_allreduce_fn_t   allreduce;
+        mca_coll_base_module_iallreduce_fn_t iallreduce;
+        mca_coll_base_module_allgather_fn_t   allgather;
+        mca_coll_base_module_iallgather_fn_t iallgather;
     } previous_routine;
     mca_coll_base_module_t *previous_module;
 } mca_coll_adapt_collective_fallback_t;
@@ -102,6 +124,10 @@ typedef struct mca_coll_adapt_collective_fallback_s {
 typedef enum mca_coll_adapt_colltype {
     ADAPT_REDUCE  = 0,
     ADAPT_IREDUCE = 1,
+    ADAPT_ALLREDUCE = 2,
+    ADAPT_IALLREDUCE = 3,
+    ADAPT_ALLGATHER = 4,
+    ADAPT_IALLGATHER = 5,
     ADAPT_COLLCOUNT
 } mca_coll_adapt_colltype_t;
 
@@ -111,9 +137,17 @@ typedef enum mca_coll_adapt_colltype {
  */
 #define previous_reduce     previous_routines[ADAPT_REDUCE].previous_routine.reduce
 #define previous_ireduce    previous_routines[ADAPT_IREDUCE].previous_routine.ireduce
+#define previous_allreduce  previous_routines[ADAPT_ALLREDUCE].previous_routine.allreduce
+#define previous_iallreduce previous_routines[ADAPT_IALLREDUCE].previous_routine.iallreduce
+#define previous_allgather  previous_routines[ADAPT_ALLGATHER].previous_routine.allgather
+#define previous_iallgather previous_routines[ADAPT_IALLGATHER].previous_routine.iallgather
 
 #define previous_reduce_module     previous_routines[ADAPT_REDUCE].previous_module
 #define previous_ireduce_module    previous_routines[ADAPT_IREDUCE].previous_module
+#define previous_allreduce_module  previous_routines[ADAPT_ALLREDUCE].previous_module
+#define previous_iallreduce_module previous_routines[ADAPT_IALLREDUCE].previous_module
+#define previous_allgather_module  previous_routines[ADAPT_ALLGATHER].previous_module
+#define previous_iallgather_module previous_routines[ADAPT_IALLGATHER].previous_module
 
 
 /* Coll adapt module per communicator*/
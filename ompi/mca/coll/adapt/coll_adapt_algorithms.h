@@ -12,6 +12,7 @@
 #include "ompi/mca/coll/coll.h"
 #include "ompi/mca/coll/base/coll_base_topo.h"
 #include "ompi/mca/coll/base/coll_base_functions.h"
+#include "ompi/datatype/ompi_datatype.h"
 #include <math.h>
 
 typedef int (*ompi_mca_coll_adapt_ibcast_function_t)(IBCAST_ARGS);
@@ -25,15 +26,48 @@ typedef struct ompi_coll_adapt_algorithm_index_s {
     };
 } ompi_coll_adapt_algorithm_index_t;
 
+/* Number of segments, and so of tags, of an ibcast or ireduce */
+static inline int ompi_coll_adapt_num_segs(int count, struct ompi_datatype_t *datatype,
+                                           size_t seg_size)
+{
+    int seg_count = count;
+    size_t type_size;
+
+    ompi_datatype_type_size(datatype, &type_size);
+    COLL_BASE_COMPUTED_SEGCOUNT(seg_size, type_size, seg_count);
+    return (0 == seg_count) ? 0 : (count + seg_count - 1) / seg_count;
+}
+
 /* Bcast */
 int ompi_coll_adapt_ibcast_register(void);
 int ompi_coll_adapt_ibcast_fini(void);
 int ompi_coll_adapt_bcast(BCAST_ARGS);
 int ompi_coll_adapt_ibcast(IBCAST_ARGS);
+int ompi_coll_adapt_ibcast_generic(IBCAST_ARGS, ompi_coll_tree_t * tree, size_t seg_size, int tag);
 
 /* Reduce */
 int ompi_coll_adapt_ireduce_register(void);
 int ompi_coll_adapt_ireduce_fini(void);
 int ompi_coll_adapt_reduce(REDUCE_ARGS);
 int ompi_coll_adapt_ireduce(IREDUCE_ARGS);
+int ompi_coll_adapt_ireduce_generic(IREDUCE_ARGS, ompi_coll_tree_t * tree, size_t seg_size, int tag);
+
+/* Allreduce */
+int ompi_coll_adapt_iallreduce_register(void);
+int ompi_coll_adapt_allreduce(ALLREDUCE_ARGS);
+int ompi_coll_adapt_iallreduce(IALLREDUCE_ARGS);
+
+/* Allgather */
+int ompi_coll_adapt_iallgather_register(void);
+int ompi_coll_adapt_allgather(ALLGATHER_ARGS);
+int ompi_coll_adapt_iallgather(IALLGATHER_ARGS);
+
+/* Blocks of allreduce and allgather */
+struct ompi_coll_adapt_constant_blocks_context_s;
+struct ompi_coll_adapt_constant_blocks_context_s *
+ompi_coll_adapt_blocks_new(int num_blocks, int max_blocks, const void *sbuf, void *rbuf,
+                           struct ompi_datatype_t *datatype, struct ompi_op_t *op,
+                           struct ompi_communicator_t *comm, mca_coll_base_module_t *module);
+int ompi_coll_adapt_blocks_start(struct ompi_coll_adapt_constant_blocks_context_s *con,
+                                 ompi_request_t **request);
 
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2014-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "coll_adapt.h"
+#include "coll_adapt_algorithms.h"
+
+int ompi_coll_adapt_allgather(const void *sbuf, int scount, struct ompi_datatype_t *sdtype,
+                              void *rbuf, int rcount, struct ompi_datatype_t *rdtype,
+                              struct ompi_communicator_t *comm, mca_coll_base_module_t * module)
+{
+    /* Fall-back if there are no trees to broadcast the blocks */
+    if (OMPI_COLL_ADAPT_ALGORITHM_TUNED == mca_coll_adapt_component.adapt_ibcast_algorithm) {
+        mca_coll_adapt_module_t *adapt_module = (mca_coll_adapt_module_t *) module;
+        return adapt_module->previous_allgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                                adapt_module->previous_allgather_module);
+    }
+
+    ompi_request_t *request = NULL;
+    int err = ompi_coll_adapt_iallgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                         &request, module);
+    if( MPI_SUCCESS != err ) {
+        if( NULL == request )
+            return err;
+    }
+    ompi_request_wait(&request, MPI_STATUS_IGNORE);
+    return err;
+}
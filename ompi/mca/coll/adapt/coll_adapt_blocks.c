@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2014-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Allreduce and allgather as sets of blocks.  Each block is reduced on
+ * its root with the ireduce engine (allreduce only), then broadcast
+ * from it with the ibcast engine, both segmented and driven by the
+ * completion of their segments.  The ibcast of a block starts from the
+ * completion callback of its ireduce, and the next block starts when a
+ * block is done with its first operation, so that at most max_blocks
+ * blocks are in their first operation at the same time.  As every
+ * process starts the blocks in the same order and the lowest block not
+ * yet done is started everywhere, the blocks always progress.
+ *
+ * The tags of all the operations are reserved when the collective
+ * starts, and their trees fetched from the topology cache, so that the
+ * callbacks do not touch any state of the communicator or the module.
+ */
+
+#include "ompi_config.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/op/op.h"
+#include "coll_adapt.h"
+#include "coll_adapt_algorithms.h"
+#include "coll_adapt_context.h"
+#include "coll_adapt_topocache.h"
+#include "ompi/mca/coll/base/coll_base_util.h"
+
+static int blocks_start_ireduce(ompi_coll_adapt_block_t *block);
+static int blocks_start_ibcast(ompi_coll_adapt_block_t *block);
+
+/*
+ * Account for a finished operation, and finish the collective with the
+ * last one
+ */
+static void blocks_op_fini(ompi_coll_adapt_constant_blocks_context_t *con, int err)
+{
+    int num_ops_fini;
+
+    OPAL_THREAD_LOCK(&con->mutex);
+    if (MPI_SUCCESS != err) {
+        con->err = err;
+    }
+    num_ops_fini = ++con->num_ops_fini;
+    OPAL_THREAD_UNLOCK(&con->mutex);
+
+    if (num_ops_fini == con->num_ops) {
+        ompi_request_t *temp_req = con->request;
+        OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                             "[%d]: Blocks done, err %d\n", ompi_comm_rank(con->comm), con->err));
+        temp_req->req_status.MPI_ERROR = con->err;
+        OBJ_RELEASE(con);
+        ompi_request_complete(temp_req, 1);
+    }
+}
+
+/*
+ * Start the next block, if any
+ */
+static void blocks_start_next(ompi_coll_adapt_constant_blocks_context_t *con)
+{
+    ompi_coll_adapt_block_t *block;
+    bool last;
+    int err;
+
+    do {
+        block = NULL;
+        OPAL_THREAD_LOCK(&con->mutex);
+        if (con->next_block < con->num_blocks) {
+            block = &con->blocks[con->next_block++];
+        }
+        last = (con->next_block == con->num_blocks);
+        OPAL_THREAD_UNLOCK(&con->mutex);
+
+        if (NULL == block) {
+            return;
+        }
+        if (NULL != con->op) {
+            err = blocks_start_ireduce(block);
+        } else {
+            err = blocks_start_ibcast(block);
+        }
+        if (MPI_SUCCESS == err) {
+            return;
+        }
+        /* The operations of this block will never finish, start the next
+           one instead.  con stays alive as long as blocks remain. */
+        if (NULL != con->op) {
+            blocks_op_fini(con, err);
+        }
+        blocks_op_fini(con, err);
+    } while (!last);
+}
+
+/*
+ * Callback of the ibcast of a block
+ */
+static int ibcast_cb(ompi_request_t *req)
+{
+    ompi_coll_adapt_block_t *block = (ompi_coll_adapt_block_t *) req->req_complete_cb_data;
+    ompi_coll_adapt_constant_blocks_context_t *con = block->con;
+    int err = req->req_status.MPI_ERROR;
+
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                         "[%d]: Ibcast(cb) of block %d\n", ompi_comm_rank(con->comm),
+                         (int) (block - con->blocks)));
+    req->req_free(&req);
+    /* Without reduction, the ibcast is the first operation of the block */
+    if (NULL == con->op) {
+        blocks_start_next(con);
+    }
+    blocks_op_fini(con, err);
+    /* Call back function return 1 to signal that request has been free'd */
+    return 1;
+}
+
+/*
+ * Callback of the ireduce of a block
+ */
+static int ireduce_cb(ompi_request_t *req)
+{
+    ompi_coll_adapt_block_t *block = (ompi_coll_adapt_block_t *) req->req_complete_cb_data;
+    ompi_coll_adapt_constant_blocks_context_t *con = block->con;
+    int err = req->req_status.MPI_ERROR;
+
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                         "[%d]: Ireduce(cb) of block %d\n", ompi_comm_rank(con->comm),
+                         (int) (block - con->blocks)));
+    req->req_free(&req);
+    if (MPI_SUCCESS == err) {
+        err = blocks_start_ibcast(block);
+    }
+    if (MPI_SUCCESS != err) {
+        /* The ibcast will never finish */
+        blocks_op_fini(con, err);
+    }
+    blocks_start_next(con);
+    blocks_op_fini(con, err);
+    return 1;
+}
+
+static int blocks_start_ireduce(ompi_coll_adapt_block_t *block)
+{
+    ompi_coll_adapt_constant_blocks_context_t *con = block->con;
+    const char *sbuf = con->sbuf + block->disp;
+    ompi_request_t *req;
+    int err;
+
+    if (MPI_IN_PLACE == (void *) con->sbuf) {
+        /* The root reduces in place, the others from their result buffer */
+        sbuf = (ompi_comm_rank(con->comm) == block->root) ? MPI_IN_PLACE : con->rbuf + block->disp;
+    }
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                         "[%d]: Ireduce of block %d, root %d, count %d, tag %d\n",
+                         ompi_comm_rank(con->comm), (int) (block - con->blocks), block->root,
+                         block->count, block->ireduce_tag));
+    err = ompi_coll_adapt_ireduce_generic(sbuf, con->rbuf + block->disp, block->count,
+                                          con->datatype, con->op, block->root, con->comm,
+                                          &req, con->module, block->ireduce_tree,
+                                          mca_coll_adapt_component.adapt_ireduce_segment_size,
+                                          block->ireduce_tag);
+    if (MPI_SUCCESS != err) {
+        return err;
+    }
+    /* The callback may run right away */
+    ompi_request_set_callback(req, ireduce_cb, block);
+    return MPI_SUCCESS;
+}
+
+static int blocks_start_ibcast(ompi_coll_adapt_block_t *block)
+{
+    ompi_coll_adapt_constant_blocks_context_t *con = block->con;
+    ompi_request_t *req;
+    int err;
+
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                         "[%d]: Ibcast of block %d, root %d, count %d, tag %d\n",
+                         ompi_comm_rank(con->comm), (int) (block - con->blocks), block->root,
+                         block->count, block->ibcast_tag));
+    err = ompi_coll_adapt_ibcast_generic(con->rbuf + block->disp, block->count, con->datatype,
+                                         block->root, con->comm, &req, con->module,
+                                         block->ibcast_tree,
+                                         mca_coll_adapt_component.adapt_ibcast_segment_size,
+                                         block->ibcast_tag);
+    if (MPI_SUCCESS != err) {
+        return err;
+    }
+    /* The callback may run right away */
+    ompi_request_set_callback(req, ibcast_cb, block);
+    return MPI_SUCCESS;
+}
+
+/*
+ * Create the context of num_blocks blocks, for the caller to set their
+ * root, count and displacement.  The blocks are only broadcast when op
+ * is NULL.
+ */
+ompi_coll_adapt_constant_blocks_context_t *
+ompi_coll_adapt_blocks_new(int num_blocks, int max_blocks, const void *sbuf, void *rbuf,
+                           struct ompi_datatype_t *datatype, struct ompi_op_t *op,
+                           struct ompi_communicator_t *comm, mca_coll_base_module_t *module)
+{
+    ompi_coll_adapt_constant_blocks_context_t *con =
+        OBJ_NEW(ompi_coll_adapt_constant_blocks_context_t);
+
+    if (NULL == con) {
+        return NULL;
+    }
+    con->blocks = (ompi_coll_adapt_block_t *) calloc((num_blocks > 0) ? num_blocks : 1,
+                                                     sizeof(ompi_coll_adapt_block_t));
+    if (NULL == con->blocks) {
+        OBJ_RELEASE(con);
+        return NULL;
+    }
+    con->comm = comm;
+    con->datatype = datatype;
+    con->op = op;
+    con->sbuf = (char *) sbuf;
+    con->rbuf = (char *) rbuf;
+    con->num_blocks = num_blocks;
+    con->max_blocks = (max_blocks < 1) ? 1 : max_blocks;
+    con->next_block = 0;
+    con->num_ops_fini = 0;
+    con->num_ops = 0;
+    con->err = MPI_SUCCESS;
+    con->module = module;
+    return con;
+}
+
+/*
+ * Start the blocks of con, which the request completes.  Takes over con.
+ */
+int ompi_coll_adapt_blocks_start(ompi_coll_adapt_constant_blocks_context_t *con,
+                                 ompi_request_t **request)
+{
+    ompi_coll_base_nbc_request_t *temp_request;
+    int i, n, num_tags = 0, tag;
+
+    /* Set up request */
+    temp_request = OBJ_NEW(ompi_coll_base_nbc_request_t);
+    OMPI_REQUEST_INIT(&temp_request->super, false);
+    temp_request->super.req_state = OMPI_REQUEST_ACTIVE;
+    temp_request->super.req_type = OMPI_REQUEST_COLL;
+    temp_request->super.req_free = ompi_coll_adapt_request_free;
+    temp_request->super.req_status.MPI_SOURCE = 0;
+    temp_request->super.req_status.MPI_TAG = 0;
+    temp_request->super.req_status.MPI_ERROR = 0;
+    temp_request->super.req_status._cancelled = 0;
+    temp_request->super.req_status._ucount = 0;
+    *request = (ompi_request_t*)temp_request;
+    con->request = (ompi_request_t*)temp_request;
+
+    /* Drop the empty blocks, and count the tags of the others */
+    for (i = 0, n = 0; i < con->num_blocks; i++) {
+        if (0 == con->blocks[i].count) {
+            continue;
+        }
+        con->blocks[n] = con->blocks[i];
+        if (NULL != con->op) {
+            num_tags += ompi_coll_adapt_num_segs(con->blocks[n].count, con->datatype,
+                                                 mca_coll_adapt_component.adapt_ireduce_segment_size);
+        }
+        num_tags += ompi_coll_adapt_num_segs(con->blocks[n].count, con->datatype,
+                                             mca_coll_adapt_component.adapt_ibcast_segment_size);
+        n++;
+    }
+    con->num_blocks = n;
+    con->num_ops = (NULL != con->op) ? 2 * n : n;
+    if (0 == n) {
+        OBJ_RELEASE(con);
+        ompi_request_complete(&temp_request->super, 1);
+        return MPI_SUCCESS;
+    }
+
+    tag = ompi_coll_base_nbc_reserve_tags(con->comm, num_tags);
+    for (i = 0; i < n; i++) {
+        ompi_coll_adapt_block_t *block = &con->blocks[i];
+        block->con = con;
+        block->ibcast_tree = adapt_module_cached_topology(con->module, con->comm, block->root,
+                                                          mca_coll_adapt_component.adapt_ibcast_algorithm);
+        if (NULL != con->op) {
+            block->ireduce_tree = adapt_module_cached_topology(con->module, con->comm, block->root,
+                                                               mca_coll_adapt_component.adapt_ireduce_algorithm);
+            block->ireduce_tag = tag;
+            tag -= ompi_coll_adapt_num_segs(block->count, con->datatype,
+                                            mca_coll_adapt_component.adapt_ireduce_segment_size);
+        }
+        block->ibcast_tag = tag;
+        tag -= ompi_coll_adapt_num_segs(block->count, con->datatype,
+                                        mca_coll_adapt_component.adapt_ibcast_segment_size);
+    }
+
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                         "[%d]: Start %d blocks, %d at a time, %d tags\n",
+                         ompi_comm_rank(con->comm), n, con->max_blocks, num_tags));
+
+    /* Keep con alive until the first blocks are started, the last
+       operation may finish before this returns */
+    OBJ_RETAIN(con);
+    for (i = 0; i < con->max_blocks; i++) {
+        blocks_start_next(con);
+    }
+    OBJ_RELEASE(con);
+    return MPI_SUCCESS;
+}
@@ -150,6 +150,8 @@ static int adapt_register(void)
                                            &cs->adapt_context_free_list_inc);
     ompi_coll_adapt_ibcast_register();
     ompi_coll_adapt_ireduce_register();
+    ompi_coll_adapt_iallreduce_register();
+    ompi_coll_adapt_iallgather_register();
 
     return adapt_verify_mca_variables();
 }
@@ -27,6 +27,17 @@ static void adapt_constant_reduce_context_destruct(ompi_coll_adapt_constant_redu
     OBJ_DESTRUCT(&context->inbuf_list);
 }
 
+static void adapt_constant_blocks_context_construct(ompi_coll_adapt_constant_blocks_context_t *context)
+{
+    context->blocks = NULL;
+    OBJ_CONSTRUCT(&context->mutex, opal_mutex_t);
+}
+
+static void adapt_constant_blocks_context_destruct(ompi_coll_adapt_constant_blocks_context_t *context)
+{
+    free(context->blocks);
+    OBJ_DESTRUCT(&context->mutex);
+}
 
 OBJ_CLASS_INSTANCE(ompi_coll_adapt_bcast_context_t, opal_free_list_item_t,
                    NULL, NULL);
@@ -40,3 +51,7 @@ OBJ_CLASS_INSTANCE(ompi_coll_adapt_reduce_context_t, opal_free_list_item_t,
 OBJ_CLASS_INSTANCE(ompi_coll_adapt_constant_reduce_context_t, opal_object_t,
                    &adapt_constant_reduce_context_construct,
                    &adapt_constant_reduce_context_destruct);
+
+OBJ_CLASS_INSTANCE(ompi_coll_adapt_constant_blocks_context_t, opal_object_t,
+                   &adapt_constant_blocks_context_construct,
+                   &adapt_constant_blocks_context_destruct);
@@ -126,3 +126,47 @@ struct ompi_coll_adapt_reduce_context_s {
 };
 
 OBJ_CLASS_DECLARATION(ompi_coll_adapt_reduce_context_t);
+
+/* Block of an allreduce or allgather: an ireduce on the block (allreduce
+   only) followed by an ibcast of the block from the same root */
+struct ompi_coll_adapt_block_s {
+    int root;
+    int count;
+    /* Displacement of the block in the buffers, in bytes */
+    ptrdiff_t disp;
+    int ireduce_tag;
+    int ibcast_tag;
+    ompi_coll_tree_t *ireduce_tree;
+    ompi_coll_tree_t *ibcast_tree;
+    struct ompi_coll_adapt_constant_blocks_context_s *con;
+};
+
+typedef struct ompi_coll_adapt_block_s ompi_coll_adapt_block_t;
+
+/* Allreduce and allgather constant context */
+struct ompi_coll_adapt_constant_blocks_context_s {
+    opal_object_t super;
+    ompi_communicator_t *comm;
+    mca_coll_base_module_t *module;
+    ompi_datatype_t *datatype;
+    /* NULL when the blocks are only broadcast */
+    ompi_op_t *op;
+    char *sbuf;
+    char *rbuf;
+    int num_blocks;
+    ompi_coll_adapt_block_t *blocks;
+    /* Number of blocks in their first operation at the same time */
+    int max_blocks;
+    /* Next block to start */
+    int next_block;
+    /* Number of finished operations, out of num_ops */
+    int num_ops_fini;
+    int num_ops;
+    int err;
+    opal_mutex_t mutex;
+    ompi_request_t *request;
+};
+
+typedef struct ompi_coll_adapt_constant_blocks_context_s ompi_coll_adapt_constant_blocks_context_t;
+
+OBJ_CLASS_DECLARATION(ompi_coll_adapt_constant_blocks_context_t);
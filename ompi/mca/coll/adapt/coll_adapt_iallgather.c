@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "coll_adapt.h"
+#include "coll_adapt_algorithms.h"
+#include "coll_adapt_context.h"
+
+/*
+ * Set up MCA parameters of MPI_Allgather and MPI_Iallgather
+ */
+int ompi_coll_adapt_iallgather_register(void)
+{
+    mca_base_component_t *c = &mca_coll_adapt_component.super.collm_version;
+
+    mca_coll_adapt_component.adapt_iallgather_max_blocks = 8;
+    mca_base_component_var_register(c, "allgather_max_blocks",
+                                    "Maximum number of blocks being broadcast at the same time by allgather, which broadcasts the block of each rank from it with the trees and segments of bcast",
+                                    MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                    OPAL_INFO_LVL_5,
+                                    MCA_BASE_VAR_SCOPE_READONLY,
+                                    &mca_coll_adapt_component.adapt_iallgather_max_blocks);
+    return OMPI_SUCCESS;
+}
+
+int ompi_coll_adapt_iallgather(const void *sbuf, int scount, struct ompi_datatype_t *sdtype,
+                               void *rbuf, int rcount, struct ompi_datatype_t *rdtype,
+                               struct ompi_communicator_t *comm, ompi_request_t ** request,
+                               mca_coll_base_module_t * module)
+{
+    ompi_coll_adapt_constant_blocks_context_t *con;
+    int size = ompi_comm_size(comm), rank = ompi_comm_rank(comm), err;
+    ptrdiff_t lb, extent;
+
+    OPAL_OUTPUT_VERBOSE((10, mca_coll_adapt_component.adapt_output,
+                         "iallgather coll_adapt_allgather_max_blocks %d\n",
+                         mca_coll_adapt_component.adapt_iallgather_max_blocks));
+
+    if (OMPI_COLL_ADAPT_ALGORITHM_TUNED == mca_coll_adapt_component.adapt_ibcast_algorithm) {
+        mca_coll_adapt_module_t *adapt_module = (mca_coll_adapt_module_t *) module;
+        OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                    "ADAPT has no bcast tree for allgather. It needs to fall back on another component\n"));
+        return adapt_module->previous_iallgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                                 request, adapt_module->previous_iallgather_module);
+    }
+
+    ompi_datatype_get_extent(rdtype, &lb, &extent);
+    if (MPI_IN_PLACE != sbuf) {
+        err = ompi_datatype_sndrcv(sbuf, scount, sdtype,
+                                   (char *) rbuf + (ptrdiff_t) rank * rcount * extent,
+                                   rcount, rdtype);
+        if (MPI_SUCCESS != err) {
+            return err;
+        }
+    }
+
+    con = ompi_coll_adapt_blocks_new(size, mca_coll_adapt_component.adapt_iallgather_max_blocks,
+                                     MPI_IN_PLACE, rbuf, rdtype, NULL, comm, module);
+    if (NULL == con) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    for (int i = 0; i < size; i++) {
+        con->blocks[i].root = i;
+        con->blocks[i].count = rcount;
+        con->blocks[i].disp = (ptrdiff_t) i * rcount * extent;
+    }
+    return ompi_coll_adapt_blocks_start(con, request);
+}
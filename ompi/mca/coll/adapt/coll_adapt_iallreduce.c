@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2014-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/op/op.h"
+#include "coll_adapt.h"
+#include "coll_adapt_algorithms.h"
+#include "coll_adapt_context.h"
+
+/*
+ * Set up MCA parameters of MPI_Allreduce and MPI_Iallreduce
+ */
+int ompi_coll_adapt_iallreduce_register(void)
+{
+    mca_base_component_t *c = &mca_coll_adapt_component.super.collm_version;
+
+    mca_coll_adapt_component.adapt_iallreduce_algorithm = OMPI_COLL_ADAPT_ALLREDUCE_REDUCE_BCAST;
+    mca_base_component_var_register(c, "allreduce_algorithm",
+                                    "Algorithm of allreduce, 0: previous component, 1: pipelined reduce and bcast of blocks from rank 0, 2: reduce-scatter and allgather (one block reduced on and broadcast from each rank). The trees and segments are the ones of reduce and bcast",
+                                    MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                    OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
+                                    &mca_coll_adapt_component.adapt_iallreduce_algorithm);
+    if( (mca_coll_adapt_component.adapt_iallreduce_algorithm < 0) ||
+        (mca_coll_adapt_component.adapt_iallreduce_algorithm >= OMPI_COLL_ADAPT_ALLREDUCE_COUNT) ) {
+        mca_coll_adapt_component.adapt_iallreduce_algorithm = OMPI_COLL_ADAPT_ALLREDUCE_REDUCE_BCAST;
+    }
+
+    mca_coll_adapt_component.adapt_iallreduce_block_size = 1048576;
+    mca_base_component_var_register(c, "allreduce_block_size",
+                                    "Size in bytes of the blocks of the pipelined reduce and bcast allreduce, each block is broadcast as soon as it is reduced",
+                                    MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                    OPAL_INFO_LVL_5,
+                                    MCA_BASE_VAR_SCOPE_READONLY,
+                                    &mca_coll_adapt_component.adapt_iallreduce_block_size);
+
+    mca_coll_adapt_component.adapt_iallreduce_max_blocks = 4;
+    mca_base_component_var_register(c, "allreduce_max_blocks",
+                                    "Maximum number of blocks being reduced at the same time",
+                                    MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                    OPAL_INFO_LVL_5,
+                                    MCA_BASE_VAR_SCOPE_READONLY,
+                                    &mca_coll_adapt_component.adapt_iallreduce_max_blocks);
+    return OMPI_SUCCESS;
+}
+
+/* MPI_Allreduce and MPI_Iallreduce in the ADAPT module only work for commutative operations */
+int ompi_coll_adapt_iallreduce(const void *sbuf, void *rbuf, int count, struct ompi_datatype_t *dtype,
+                               struct ompi_op_t *op, struct ompi_communicator_t *comm,
+                               ompi_request_t ** request, mca_coll_base_module_t * module)
+{
+    mca_coll_adapt_module_t *adapt_module = (mca_coll_adapt_module_t *) module;
+    ompi_coll_adapt_constant_blocks_context_t *con;
+    int size = ompi_comm_size(comm), num_blocks, block_count = count, split, early, late;
+    bool scatter = (OMPI_COLL_ADAPT_ALLREDUCE_REDUCE_SCATTER_ALLGATHER ==
+                    mca_coll_adapt_component.adapt_iallreduce_algorithm);
+    ptrdiff_t lb, extent;
+    size_t type_size;
+
+    if (!ompi_op_is_commute(op) ||
+        OMPI_COLL_ADAPT_ALLREDUCE_PREVIOUS == mca_coll_adapt_component.adapt_iallreduce_algorithm ||
+        OMPI_COLL_ADAPT_ALGORITHM_TUNED == mca_coll_adapt_component.adapt_ireduce_algorithm ||
+        OMPI_COLL_ADAPT_ALGORITHM_TUNED == mca_coll_adapt_component.adapt_ibcast_algorithm) {
+        OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
+                    "ADAPT does not handle this allreduce (non-commutative operation, algorithm 0 or no trees). It needs to fall back on another component\n"));
+        return adapt_module->previous_iallreduce(sbuf, rbuf, count, dtype, op, comm, request,
+                                                 adapt_module->previous_iallreduce_module);
+    }
+
+    OPAL_OUTPUT_VERBOSE((10, mca_coll_adapt_component.adapt_output,
+                         "iallreduce algorithm %d, coll_adapt_allreduce_block_size %zu, coll_adapt_allreduce_max_blocks %d\n",
+                         mca_coll_adapt_component.adapt_iallreduce_algorithm,
+                         mca_coll_adapt_component.adapt_iallreduce_block_size,
+                         mca_coll_adapt_component.adapt_iallreduce_max_blocks));
+
+    ompi_datatype_get_extent(dtype, &lb, &extent);
+    if (scatter) {
+        /* One block per rank, the first count % size ones one element larger */
+        COLL_BASE_COMPUTE_BLOCKCOUNT(count, size, split, early, late);
+        num_blocks = size;
+    } else {
+        ompi_datatype_type_size(dtype, &type_size);
+        COLL_BASE_COMPUTED_SEGCOUNT(mca_coll_adapt_component.adapt_iallreduce_block_size,
+                                    type_size, block_count);
+        num_blocks = (0 == block_count) ? 0 : (count + block_count - 1) / block_count;
+        split = num_blocks;
+        early = late = block_count;
+    }
+
+    con = ompi_coll_adapt_blocks_new(num_blocks, mca_coll_adapt_component.adapt_iallreduce_max_blocks,
+                                     sbuf, rbuf, dtype, op, comm, module);
+    if (NULL == con) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    for (int i = 0, disp = 0; i < num_blocks; i++) {
+        con->blocks[i].root = scatter ? i : 0;
+        con->blocks[i].count = (i < split) ? early : late;
+        if (i == num_blocks - 1) {
+            con->blocks[i].count = count - disp;
+        }
+        con->blocks[i].disp = (ptrdiff_t) disp * extent;
+        disp += con->blocks[i].count;
+    }
+    return ompi_coll_adapt_blocks_start(con, request);
+}
@@ -21,9 +21,6 @@
 #include "opal/sys/atomic.h"
 #include "ompi/mca/pml/ob1/pml_ob1.h"
 
-static int ompi_coll_adapt_ibcast_generic(IBCAST_ARGS,
-                                   ompi_coll_tree_t * tree, size_t seg_size);
-
 /*
  * Set up MCA parameters of MPI_Bcast and MPI_IBcast
  */
@@ -33,7 +30,7 @@ int ompi_coll_adapt_ibcast_register(void)
 
     mca_coll_adapt_component.adapt_ibcast_algorithm = 1;
     mca_base_component_var_register(c, "bcast_algorithm",
-                                    "Algorithm of broadcast, 0: tuned, 1: binomial, 2: in_order_binomial, 3: binary, 4: pipeline, 5: chain, 6: linear", MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                    "Algorithm of broadcast, 0: tuned, 1: binomial, 2: in_order_binomial, 3: binary, 4: pipeline, 5: chain, 6: linear, 7: topo_binomial (node and package aware), 8: topo_chain", MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
                                     OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
                                     &mca_coll_adapt_component.adapt_ibcast_algorithm);
     if( (mca_coll_adapt_component.adapt_ibcast_algorithm < 0) ||
@@ -334,16 +331,19 @@ int ompi_coll_adapt_ibcast(void *buff, int count, struct ompi_datatype_t *dataty
         return OMPI_ERR_NOT_IMPLEMENTED;
     }
 
+    int num_segs = ompi_coll_adapt_num_segs(count, datatype,
+                                            mca_coll_adapt_component.adapt_ibcast_segment_size);
     return ompi_coll_adapt_ibcast_generic(buff, count, datatype, root, comm, request, module,
                                           adapt_module_cached_topology(module, comm, root, mca_coll_adapt_component.adapt_ibcast_algorithm),
-                                          mca_coll_adapt_component.adapt_ibcast_segment_size);
+                                          mca_coll_adapt_component.adapt_ibcast_segment_size,
+                                          ompi_coll_base_nbc_reserve_tags(comm, num_segs));
 }
 
 
 int ompi_coll_adapt_ibcast_generic(void *buff, int count, struct ompi_datatype_t *datatype, int root,
                                    struct ompi_communicator_t *comm, ompi_request_t ** request,
                                    mca_coll_base_module_t * module, ompi_coll_tree_t * tree,
-                                   size_t seg_size)
+                                   size_t seg_size, int tag)
 {
     int i, j, rank, err;
     /* The min of num_segs and SEND_NUM or RECV_NUM, in case the num_segs is less than SEND_NUM or RECV_NUM */
@@ -439,7 +439,7 @@ int ompi_coll_adapt_ibcast_generic(void *buff, int count, struct ompi_datatype_t
     con->mutex = mutex;
     con->request = (ompi_request_t*)temp_request;
     con->tree = tree;
-    con->ibcast_tag = ompi_coll_base_nbc_reserve_tags(comm, num_segs);
+    con->ibcast_tag = tag;
 
     OPAL_OUTPUT_VERBOSE((30, mca_coll_adapt_component.adapt_output,
                          "[%d]: Ibcast, root %d, tag %d\n", rank, root,
@@ -21,9 +21,6 @@
 #include "ompi/mca/pml/pml.h"
 #include "ompi/mca/coll/base/coll_base_topo.h"
 
-static int ompi_coll_adapt_ireduce_generic(IREDUCE_ARGS,
-                                           ompi_coll_tree_t * tree, size_t seg_size);
-
 /* MPI_Reduce and MPI_Ireduce in the ADAPT module only work for commutative operations */
 
 /*
@@ -35,7 +32,7 @@ int ompi_coll_adapt_ireduce_register(void)
 
     mca_coll_adapt_component.adapt_ireduce_algorithm = 1;
     mca_base_component_var_register(c, "reduce_algorithm",
-                                    "Algorithm of reduce, 1: binomial, 2: in_order_binomial, 3: binary, 4: pipeline, 5: chain, 6: linear", MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                    "Algorithm of reduce, 1: binomial, 2: in_order_binomial, 3: binary, 4: pipeline, 5: chain, 6: linear, 7: topo_binomial (node and package aware), 8: topo_chain", MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
                                     OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
                                     &mca_coll_adapt_component.adapt_ireduce_algorithm);
     if( (mca_coll_adapt_component.adapt_ireduce_algorithm < 0) ||
@@ -502,9 +499,12 @@ int ompi_coll_adapt_ireduce(const void *sbuf, void *rbuf, int count, struct ompi
     }
 
 
+    int num_segs = ompi_coll_adapt_num_segs(count, dtype,
+                                            mca_coll_adapt_component.adapt_ireduce_segment_size);
     return ompi_coll_adapt_ireduce_generic(sbuf, rbuf, count, dtype, op, root, comm, request, module,
                                            adapt_module_cached_topology(module, comm, root, mca_coll_adapt_component.adapt_ireduce_algorithm),
-                                           mca_coll_adapt_component.adapt_ireduce_segment_size);
+                                           mca_coll_adapt_component.adapt_ireduce_segment_size,
+                                           ompi_coll_base_nbc_reserve_tags(comm, num_segs));
 
 }
 
@@ -513,7 +513,7 @@ int ompi_coll_adapt_ireduce_generic(const void *sbuf, void *rbuf, int count,
                                     struct ompi_datatype_t *dtype, struct ompi_op_t *op, int root,
                                     struct ompi_communicator_t *comm, ompi_request_t ** request,
                                     mca_coll_base_module_t * module, ompi_coll_tree_t * tree,
-                                    size_t seg_size)
+                                    size_t seg_size, int tag)
 {
 
     ptrdiff_t extent, lower_bound, segment_increment;
@@ -598,7 +598,7 @@ int ompi_coll_adapt_ireduce_generic(const void *sbuf, void *rbuf, int count,
     con->rbuf = (char *) rbuf;
     con->root = root;
     con->distance = 0;
-    con->ireduce_tag = ompi_coll_base_nbc_reserve_tags(comm, num_segs);
+    con->ireduce_tag = tag;
     con->real_seg_size = real_seg_size;
 
     /* If the current process is not leaf */
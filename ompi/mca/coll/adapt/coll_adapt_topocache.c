@@ -67,6 +67,14 @@ static ompi_coll_tree_t *create_topology(
             }
             return tree;
         }
+        case OMPI_COLL_ADAPT_ALGORITHM_TOPO_BINOMIAL:
+        {
+            return ompi_coll_base_topo_build_topoaware_bmtree(comm, root);
+        }
+        case OMPI_COLL_ADAPT_ALGORITHM_TOPO_CHAIN:
+        {
+            return ompi_coll_base_topo_build_topoaware_chain(4, comm, root);
+        }
         default:
             printf("WARN: unknown topology %d\n", algorithm);
             return NULL;
@@ -34,6 +34,7 @@
 
 #include "ompi/communicator/communicator.h"
 #include "ompi/mca/coll/base/base.h"
+#include "ompi/mca/coll/base/coll_base_topo.h"
 
 #define CLOSE(comm, func)                                        \
     do {                                                         \
@@ -124,6 +125,7 @@ int mca_coll_base_comm_unselect(ompi_communicator_t * comm)
 
     CLOSE(comm, reduce_local);
 
+    ompi_coll_base_topo_destroy_locality(&comm->c_coll->coll_locality);
     free(comm->c_coll);
     comm->c_coll = NULL;
 
@@ -130,5 +130,21 @@ ompi_request_t** ompi_coll_base_comm_get_reqs(mca_coll_base_comm_t* data, int nr
     return data->mcct_reqs;
 }
 
-MCA_BASE_FRAMEWORK_DECLARE(ompi, coll, "Collectives", NULL, NULL, NULL,
+bool ompi_coll_base_topo_aware = false;
+
+static int mca_coll_base_register(mca_base_register_flag_t flags)
+{
+    ompi_coll_base_topo_aware = false;
+    (void) mca_base_var_register("ompi", "coll", "base", "topo_aware",
+                                 "Build the binomial, k-nomial, pipeline and chain trees of the "
+                                 "collectives from the node and package of the processes, so that "
+                                 "the fewest edges cross nodes and packages",
+                                 MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                 OPAL_INFO_LVL_6,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &ompi_coll_base_topo_aware);
+    return OMPI_SUCCESS;
+}
+
+MCA_BASE_FRAMEWORK_DECLARE(ompi, coll, "Collectives", mca_coll_base_register, NULL, NULL,
                            mca_coll_base_static_components, 0);
@@ -324,7 +324,9 @@ do {
         if( coll_comm->cached_bmtree ) { /* destroy previous binomial if defined */          \
             ompi_coll_base_topo_destroy_tree( &(coll_comm->cached_bmtree) );                \
         }                                                                                    \
-        coll_comm->cached_bmtree = ompi_coll_base_topo_build_bmtree( (OMPI_COMM), (ROOT) ); \
+        coll_comm->cached_bmtree = ompi_coll_base_topo_aware ?                              \
+            ompi_coll_base_topo_build_topoaware_bmtree( (OMPI_COMM), (ROOT) ) :             \
+            ompi_coll_base_topo_build_bmtree( (OMPI_COMM), (ROOT) );                        \
         coll_comm->cached_bmtree_root = (ROOT);                                              \
     }                                                                                        \
 } while (0)
@@ -352,7 +354,9 @@ do {
         if (coll_comm->cached_kmtree ) { /* destroy previous k-nomial tree if defined */     \
             ompi_coll_base_topo_destroy_tree(&(coll_comm->cached_kmtree));                  \
         }                                                                                    \
-        coll_comm->cached_kmtree = ompi_coll_base_topo_build_kmtree((OMPI_COMM), (ROOT), (RADIX)); \
+        coll_comm->cached_kmtree = ompi_coll_base_topo_aware ?                              \
+            ompi_coll_base_topo_build_topoaware_kmtree((OMPI_COMM), (ROOT), (RADIX)) :      \
+            ompi_coll_base_topo_build_kmtree((OMPI_COMM), (ROOT), (RADIX));                 \
         coll_comm->cached_kmtree_root = (ROOT);                                              \
         coll_comm->cached_kmtree_radix = (RADIX);                                              \
     }                                                                                        \
@@ -366,7 +370,9 @@ do {
         if (coll_comm->cached_pipeline) { /* destroy previous pipeline if defined */             \
             ompi_coll_base_topo_destroy_tree( &(coll_comm->cached_pipeline) );                  \
         }                                                                                        \
-        coll_comm->cached_pipeline = ompi_coll_base_topo_build_chain( 1, (OMPI_COMM), (ROOT) ); \
+        coll_comm->cached_pipeline = ompi_coll_base_topo_aware ?                                 \
+            ompi_coll_base_topo_build_topoaware_chain( 1, (OMPI_COMM), (ROOT) ) :                \
+            ompi_coll_base_topo_build_chain( 1, (OMPI_COMM), (ROOT) );                           \
         coll_comm->cached_pipeline_root = (ROOT);                                                \
     }                                                                                            \
 } while (0)
@@ -380,7 +386,9 @@ do {
         if( coll_comm->cached_chain) { /* destroy previous chain if defined */                   \
             ompi_coll_base_topo_destroy_tree( &(coll_comm->cached_chain) );                     \
         }                                                                                        \
-        coll_comm->cached_chain = ompi_coll_base_topo_build_chain((FANOUT), (OMPI_COMM), (ROOT)); \
+        coll_comm->cached_chain = ompi_coll_base_topo_aware ?                                    \
+            ompi_coll_base_topo_build_topoaware_chain((FANOUT), (OMPI_COMM), (ROOT)) :           \
+            ompi_coll_base_topo_build_chain((FANOUT), (OMPI_COMM), (ROOT));                      \
         coll_comm->cached_chain_root = (ROOT);                                                   \
         coll_comm->cached_chain_fanout = (FANOUT);                                               \
     }                                                                                            \
@@ -716,13 +716,20 @@ ompi_coll_base_reduce_intra_basic_linear(const void *sbuf, void *rbuf, int count
             inbuf = pml_buffer;
         }
 
-        /* Perform the reduction */
+        /* Perform the reduction. For MPI_IN_PLACE the final result is
+         * copied back to the user buffer in the same pass. */
 
-        ompi_op_reduce(op, inbuf, rbuf, count, dtype);
+        if (0 == i && NULL != inplace_temp_free) {
+            err = ompi_op_reduce_copy(op, inbuf, rbuf, (void *)sbuf, count, dtype);
+        } else {
+            ompi_op_reduce(op, inbuf, rbuf, count, dtype);
+        }
     }
 
     if (NULL != inplace_temp_free) {
-        err = ompi_datatype_copy_content_same_ddt(dtype, count, (char*)sbuf, rbuf);
+        if (1 == size) {
+            err = ompi_datatype_copy_content_same_ddt(dtype, count, (char*)sbuf, rbuf);
+        }
         free(inplace_temp_free);
     }
     if (NULL != free_buffer) {
@@ -731,7 +738,7 @@ ompi_coll_base_reduce_intra_basic_linear(const void *sbuf, void *rbuf, int count
 
     /* All done */
 
-    return MPI_SUCCESS;
+    return err;
 }
 
 /*
@@ -596,13 +596,11 @@ ompi_coll_base_reduce_scatter_intra_ring( const void *sbuf, void *rbuf, const in
     if (MPI_SUCCESS != ret) { line = __LINE__; goto error_hndl; }
 
     /* Apply operation on the last block (my block)
-       rbuf[rank] = inbuf[inbi] (op) rbuf[rank] */
+       rbuf[rank] = inbuf[inbi] (op) rbuf[rank]
+       and copy the result from tmprecv to rbuf in the same pass */
     tmprecv = accumbuf + (ptrdiff_t)displs[rank] * extent;
-    ompi_op_reduce(op, inbuf[inbi], tmprecv, rcounts[rank], dtype);
-
-    /* Copy result from tmprecv to rbuf */
-    ret = ompi_datatype_copy_content_same_ddt(dtype, rcounts[rank], (char *)rbuf, tmprecv);
-    if (ret < 0) { line = __LINE__; goto error_hndl; }
+    ret = ompi_op_reduce_copy(op, inbuf[inbi], tmprecv, rbuf, rcounts[rank], dtype);
+    if (MPI_SUCCESS != ret) { line = __LINE__; goto error_hndl; }
 
     if (NULL != displs) free(displs);
     if (NULL != accumbuf_free) free(accumbuf_free);
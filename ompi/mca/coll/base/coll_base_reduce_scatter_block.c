@@ -864,24 +864,37 @@ ompi_coll_base_reduce_scatter_block_intra_butterfly_pof2(
                                       comm, MPI_STATUS_IGNORE, rank);
         if (MPI_SUCCESS != err) { goto cleanup_and_return; }
 
+        /* The last round leaves rcount elements, which are copied to
+         * rbuf while they are reduced */
+        char *pcopy = ((mask << 1) < comm_size) ? NULL : (char *)rbuf;
         if (rank < peer) {
             /* precv = psend <op> precv */
-            ompi_op_reduce(op, psend + (ptrdiff_t)recv_index * extent,
-                           precv + (ptrdiff_t)recv_index * extent, nblocks, dtype);
+            if (NULL == pcopy) {
+                ompi_op_reduce(op, psend + (ptrdiff_t)recv_index * extent,
+                               precv + (ptrdiff_t)recv_index * extent, nblocks, dtype);
+            } else {
+                err = ompi_op_reduce_copy(op, psend + (ptrdiff_t)recv_index * extent,
+                                          precv + (ptrdiff_t)recv_index * extent, pcopy,
+                                          nblocks, dtype);
+                if (MPI_SUCCESS != err) { goto cleanup_and_return; }
+            }
             char *p = psend;
             psend = precv;
             precv = p;
         } else {
             /* psend = precv <op> psend */
-            ompi_op_reduce(op, precv + (ptrdiff_t)recv_index * extent,
-                           psend + (ptrdiff_t)recv_index * extent, nblocks, dtype);
+            if (NULL == pcopy) {
+                ompi_op_reduce(op, precv + (ptrdiff_t)recv_index * extent,
+                               psend + (ptrdiff_t)recv_index * extent, nblocks, dtype);
+            } else {
+                err = ompi_op_reduce_copy(op, precv + (ptrdiff_t)recv_index * extent,
+                                          psend + (ptrdiff_t)recv_index * extent, pcopy,
+                                          nblocks, dtype);
+                if (MPI_SUCCESS != err) { goto cleanup_and_return; }
+            }
         }
         send_index = recv_index;
     }
-    /* Copy the result to the rbuf */
-    err = ompi_datatype_copy_content_same_ddt(dtype, rcount, rbuf,
-                                              psend + (ptrdiff_t)recv_index * extent);
-    if (MPI_SUCCESS != err) { goto cleanup_and_return; }
 
 cleanup_and_return:
     if (tmpbuf[0])
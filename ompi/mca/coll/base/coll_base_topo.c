@@ -22,8 +22,12 @@
 
 #include "mpi.h"
 #include "opal/util/bit_ops.h"
+#include "opal/class/opal_hash_table.h"
+#include "opal/mca/hwloc/base/base.h"
+#include "opal/mca/pmix/pmix-internal.h"
 #include "ompi/constants.h"
 #include "ompi/communicator/communicator.h"
+#include "ompi/proc/proc.h"
 #include "ompi/mca/coll/base/coll_tags.h"
 #include "ompi/mca/coll/base/coll_base_functions.h"
 #include "coll_base_topo.h"
@@ -672,6 +676,415 @@ ompi_coll_base_topo_build_chain( int fanout,
     return chain;
 }
 
+/*
+ * Topology aware trees
+ */
+
+enum {
+    TOPO_SHAPE_TREE,
+    TOPO_SHAPE_BMTREE,
+    TOPO_SHAPE_KMTREE,
+    TOPO_SHAPE_CHAIN
+};
+
+/*
+ * The node of each rank comes from the PMIx node ids, the package of the
+ * ranks on the local node from their PMIx locality strings.  Both are
+ * identified by their lowest rank, so that all the processes (of a node
+ * for the packages) agree on them without communicating.
+ */
+static void topo_find_locality( struct ompi_communicator_t* comm,
+                                ompi_coll_topo_locality_t* locality )
+{
+    int size = ompi_comm_size(comm), rank = ompi_comm_rank(comm);
+    int32_t *node = NULL, *package = NULL;
+    char **where = NULL;
+    opal_hash_table_t nodes;
+    bool bound = true;
+    int i, j, rc;
+
+    node = (int32_t*)malloc(size * sizeof(int32_t));
+    package = (int32_t*)malloc(size * sizeof(int32_t));
+    where = (char**)calloc(size, sizeof(char*));
+    OBJ_CONSTRUCT(&nodes, opal_hash_table_t);
+    if( (NULL == node) || (NULL == package) || (NULL == where) ||
+        (OPAL_SUCCESS != opal_hash_table_init(&nodes, 64)) ) {
+        goto unknown;
+    }
+
+    for( i = 0; i < size; i++ ) {
+        ompi_proc_t *proc = ompi_comm_peer_lookup(comm, i);
+        uint32_t nodeid, *pnodeid = &nodeid;
+        void *first;
+
+        OPAL_MODEX_RECV_VALUE_OPTIONAL(rc, PMIX_NODEID, &proc->super.proc_name,
+                                       &pnodeid, PMIX_UINT32);
+        if( PMIX_SUCCESS != rc ) {
+            OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                         "coll:base:topo:find_locality no node id for rank %d", i));
+            goto unknown;
+        }
+        if( OPAL_SUCCESS == opal_hash_table_get_value_uint32(&nodes, nodeid, &first) ) {
+            node[i] = (int32_t)(intptr_t)first;
+        } else {
+            node[i] = i;
+            opal_hash_table_set_value_uint32(&nodes, nodeid, (void*)(intptr_t)i);
+        }
+    }
+
+    for( i = 0; i < size; i++ ) {
+        package[i] = -1;
+        if( node[i] != node[rank] ) continue;
+        OPAL_MODEX_RECV_VALUE_OPTIONAL(rc, PMIX_LOCALITY_STRING,
+                                       &ompi_comm_peer_lookup(comm, i)->super.proc_name,
+                                       &where[i], PMIX_STRING);
+        if( (PMIX_SUCCESS != rc) || (NULL == where[i]) ) {
+            bound = false;  /* the whole node is then one package */
+        }
+    }
+    for( i = 0; i < size; i++ ) {
+        if( node[i] != node[rank] ) continue;
+        package[i] = bound ? i : node[rank];
+        for( j = node[rank]; bound && j < i; j++ ) {
+            if( (package[j] == j) &&
+                OPAL_PROC_ON_LOCAL_SOCKET(opal_hwloc_compute_relative_locality(where[j], where[i])) ) {
+                package[i] = j;
+                break;
+            }
+        }
+    }
+
+    locality->node = node;
+    locality->package = package;
+    node = package = NULL;
+
+ unknown:
+    if( NULL != where ) {
+        for( i = 0; i < size; i++ ) free(where[i]);
+        free(where);
+    }
+    free(node);
+    free(package);
+    OBJ_DESTRUCT(&nodes);
+}
+
+ompi_coll_topo_locality_t*
+ompi_coll_base_topo_get_locality( struct ompi_communicator_t* comm )
+{
+    ompi_coll_topo_locality_t *locality;
+
+    if( (NULL == comm->c_coll) || OMPI_COMM_IS_INTER(comm) ) {
+        return NULL;
+    }
+    if( NULL != comm->c_coll->coll_locality ) {
+        return comm->c_coll->coll_locality;
+    }
+    locality = (ompi_coll_topo_locality_t*)calloc(1, sizeof(ompi_coll_topo_locality_t));
+    if( NULL == locality ) {
+        return NULL;
+    }
+    topo_find_locality(comm, locality);
+    /* cached even when unknown, so that we do not look for it again */
+    comm->c_coll->coll_locality = locality;
+    return locality;
+}
+
+void ompi_coll_base_topo_destroy_locality( ompi_coll_topo_locality_t** locality )
+{
+    if( (NULL == locality) || (NULL == *locality) ) {
+        return;
+    }
+    free((*locality)->node);
+    free((*locality)->package);
+    free(*locality);
+    *locality = NULL;
+}
+
+/*
+ * Parent and children of position pos among m positions, in a tree of
+ * the given shape rooted at position 0.  The positions play the role of
+ * the shifted ranks of the builders above.  Returns the number of
+ * children, only stored when next is not NULL; the parent of position 0
+ * is -1.
+ */
+static int topo_shape_links( int shape, int fanout, int m, int pos,
+                             int* prev, int* next )
+{
+    int nchilds = 0, mask, i;
+
+    *prev = -1;
+    if( m < 2 ) {
+        return 0;
+    }
+
+    switch( shape ) {
+    case TOPO_SHAPE_TREE: {
+        int level = calculate_level( fanout, pos );
+        int delta = pown( fanout, level );
+
+        for( i = 0; (i < fanout) && (pos + delta * (i+1) < m); i++ ) {
+            if( next ) next[nchilds] = pos + delta * (i+1);
+            nchilds++;
+        }
+        if( pos > 0 ) {
+            int slimit = calculate_num_nodes_up_to_level( fanout, level );
+            int sparent = pos;
+            if( sparent < fanout ) {
+                sparent = 0;
+            } else {
+                while( sparent >= slimit ) {
+                    sparent -= delta/fanout;
+                }
+            }
+            *prev = sparent;
+        }
+        break;
+    }
+    case TOPO_SHAPE_BMTREE:
+        for( mask = 1; mask <= pos; mask <<= 1 );
+        if( pos > 0 ) {
+            *prev = pos ^ (mask >> 1);
+        }
+        for( ; (mask < m) && (pos + mask < m); mask <<= 1 ) {
+            if( next ) next[nchilds] = pos + mask;
+            nchilds++;
+        }
+        break;
+    case TOPO_SHAPE_KMTREE:
+        for( mask = 1; mask < m; mask *= fanout ) {
+            if( pos % (fanout * mask) ) {
+                *prev = pos / (fanout * mask) * (fanout * mask);
+                break;
+            }
+        }
+        for( mask /= fanout; mask > 0; mask /= fanout ) {
+            for( i = 1; (i < fanout) && (pos + mask * i < m); i++ ) {
+                if( next ) next[nchilds] = pos + mask * i;
+                nchilds++;
+            }
+        }
+        break;
+    case TOPO_SHAPE_CHAIN: {
+        int maxchainlen, mark, head, len, column;
+
+        if( fanout > m - 1 ) {
+            fanout = m - 1;
+        }
+        if( 1 == fanout ) {
+            if( pos > 0 ) *prev = pos - 1;
+            if( pos + 1 < m ) {
+                if( next ) next[0] = pos + 1;
+                nchilds = 1;
+            }
+            break;
+        }
+        /* same columns as ompi_coll_base_topo_build_chain */
+        maxchainlen = (m-1) / fanout;
+        if( (m-1) % fanout != 0 ) {
+            maxchainlen++;
+            mark = (m-1) % fanout;
+        } else {
+            mark = fanout+1;
+        }
+        if( 0 == pos ) {
+            for( i = 0, head = 1; i < fanout; i++ ) {
+                if( i > 0 ) head += (i > mark) ? maxchainlen - 1 : maxchainlen;
+                if( next ) next[nchilds] = head;
+                nchilds++;
+            }
+            break;
+        }
+        if( pos-1 < (mark * maxchainlen) ) {
+            column = (pos-1) / maxchainlen;
+            head = 1 + column * maxchainlen;
+            len = maxchainlen;
+        } else {
+            column = mark + (pos-1-mark*maxchainlen) / (maxchainlen-1);
+            head = mark*maxchainlen + 1 + (column-mark) * (maxchainlen-1);
+            len = maxchainlen-1;
+        }
+        *prev = (pos == head) ? 0 : pos - 1;
+        if( (pos != head + len - 1) && (pos + 1 < m) ) {
+            if( next ) next[0] = pos + 1;
+            nchilds = 1;
+        }
+        break;
+    }
+    }
+    return nchilds;
+}
+
+static ompi_coll_tree_t*
+topo_build_rank_tree( int shape, int fanout,
+                      struct ompi_communicator_t* comm, int root )
+{
+    switch( shape ) {
+    case TOPO_SHAPE_TREE:   return ompi_coll_base_topo_build_tree(fanout, comm, root);
+    case TOPO_SHAPE_BMTREE: return ompi_coll_base_topo_build_bmtree(comm, root);
+    case TOPO_SHAPE_KMTREE: return ompi_coll_base_topo_build_kmtree(comm, root, fanout);
+    default:                return ompi_coll_base_topo_build_chain(fanout, comm, root);
+    }
+}
+
+static ompi_coll_tree_t*
+topo_build_topoaware( int shape, int fanout,
+                      struct ompi_communicator_t* comm, int root )
+{
+    ompi_coll_topo_locality_t *locality = ompi_coll_base_topo_get_locality(comm);
+    int size = ompi_comm_size(comm), rank = ompi_comm_rank(comm);
+    int *lists, *level[3], count[3] = {0, 0, 0}, pos[3] = {-1, -1, -1};
+    int i, l, prev, nchilds = 0, node_leader, package_leader;
+    int32_t *node, *package;
+    bool spread = false, has_parent = false;
+    ompi_coll_tree_t *tree;
+
+    if( (NULL == locality) || (NULL == locality->node) ) {
+        return topo_build_rank_tree(shape, fanout, comm, root);
+    }
+    node = locality->node;
+    package = locality->package;
+    for( i = 0; (i < size) && !spread; i++ ) {
+        spread = (node[i] != node[rank]) || (package[i] != package[rank]);
+    }
+    if( !spread ) {
+        /* a single package, nothing to gain */
+        return topo_build_rank_tree(shape, fanout, comm, root);
+    }
+
+    lists = (int*)malloc(3 * size * sizeof(int));
+    if( NULL == lists ) {
+        return NULL;
+    }
+    level[0] = lists;
+    level[1] = lists + size;
+    level[2] = lists + 2 * size;
+
+    /* the leaders of the nodes, the root leading its node */
+    level[0][count[0]++] = root;
+    for( i = 0; i < size; i++ ) {
+        if( (node[i] == i) && (i != node[root]) ) level[0][count[0]++] = i;
+    }
+    /* the leaders of the packages of my node */
+    node_leader = (node[rank] == node[root]) ? root : node[rank];
+    level[1][count[1]++] = node_leader;
+    for( i = 0; i < size; i++ ) {
+        if( (node[i] == node[rank]) && (package[i] == i) && (i != package[node_leader]) ) {
+            level[1][count[1]++] = i;
+        }
+    }
+    /* the processes of my package */
+    package_leader = (package[rank] == package[node_leader]) ? node_leader : package[rank];
+    level[2][count[2]++] = package_leader;
+    for( i = 0; i < size; i++ ) {
+        if( (node[i] == node[rank]) && (package[i] == package[rank]) && (i != package_leader) ) {
+            level[2][count[2]++] = i;
+        }
+    }
+
+    for( l = 0; l < 3; l++ ) {
+        for( i = 0; (i < count[l]) && (-1 == pos[l]); i++ ) {
+            if( level[l][i] == rank ) pos[l] = i;
+        }
+        if( -1 != pos[l] ) {
+            nchilds += topo_shape_links(shape, fanout, count[l], pos[l], &prev, NULL);
+        }
+    }
+
+    tree = (ompi_coll_tree_t*)malloc(COLL_TREE_SIZE(nchilds > MAXTREEFANOUT ? nchilds : MAXTREEFANOUT));
+    if( NULL == tree ) {
+        OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                     "coll:base:topo:build_topoaware PANIC out of memory"));
+        free(lists);
+        return NULL;
+    }
+    tree->tree_root     = root;
+    tree->tree_fanout   = fanout;
+    tree->tree_bmtree   = (TOPO_SHAPE_BMTREE == shape);
+    tree->tree_nextsize = 0;
+    /* each builder has its own idea of the parent of the root */
+    if( TOPO_SHAPE_BMTREE == shape ) {
+        tree->tree_prev = root;
+    } else if( TOPO_SHAPE_KMTREE == shape ) {
+        tree->tree_prev = MPI_PROC_NULL;
+    } else {
+        tree->tree_prev = -1;
+    }
+
+    /* the parent is in the highest level where I am not the leader, the
+       children of the highest levels first so that the longest edges
+       start first */
+    for( l = 0; l < 3; l++ ) {
+        int *next;
+        if( -1 == pos[l] ) continue;
+        next = &tree->tree_next[tree->tree_nextsize];
+        nchilds = topo_shape_links(shape, fanout, count[l], pos[l], &prev, next);
+        for( i = 0; i < nchilds; i++ ) {
+            next[i] = level[l][next[i]];
+        }
+        tree->tree_nextsize += nchilds;
+        if( (pos[l] > 0) && !has_parent ) {
+            tree->tree_prev = level[l][prev];
+            has_parent = true;
+        }
+    }
+    free(lists);
+    return tree;
+}
+
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_tree( int fanout,
+                                          struct ompi_communicator_t* comm,
+                                          int root )
+{
+    OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                 "coll:base:topo:build_topoaware_tree fo %d rt %d", fanout, root));
+    if( (fanout < 1) || (fanout > MAXTREEFANOUT) ) {
+        OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                     "coll:base:topo:build_topoaware_tree invalid fanout %d", fanout));
+        return NULL;
+    }
+    /* a tree of fanout 1 is a pipeline */
+    return topo_build_topoaware(1 == fanout ? TOPO_SHAPE_CHAIN : TOPO_SHAPE_TREE,
+                                fanout, comm, root);
+}
+
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_bmtree( struct ompi_communicator_t* comm,
+                                            int root )
+{
+    OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                 "coll:base:topo:build_topoaware_bmtree rt %d", root));
+    return topo_build_topoaware(TOPO_SHAPE_BMTREE, 2, comm, root);
+}
+
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_kmtree( struct ompi_communicator_t* comm,
+                                            int root, int radix )
+{
+    OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                 "coll:base:topo:build_topoaware_kmtree rt %d radix %d", root, radix));
+    if( radix < 2 ) {
+        radix = 2;
+    }
+    return topo_build_topoaware(TOPO_SHAPE_KMTREE, radix, comm, root);
+}
+
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_chain( int fanout,
+                                           struct ompi_communicator_t* comm,
+                                           int root )
+{
+    OPAL_OUTPUT((ompi_coll_base_framework.framework_output,
+                 "coll:base:topo:build_topoaware_chain fo %d rt %d", fanout, root));
+    if( fanout < 1 ) {
+        fanout = 1;
+    }
+    if( fanout > MAXTREEFANOUT ) {
+        fanout = MAXTREEFANOUT;
+    }
+    return topo_build_topoaware(TOPO_SHAPE_CHAIN, fanout, comm, root);
+}
+
 int ompi_coll_base_topo_dump_tree (ompi_coll_tree_t* tree, int rank)
 {
     int i;
@@ -64,6 +64,46 @@ ompi_coll_base_topo_build_chain( int fanout,
 
 int ompi_coll_base_topo_destroy_tree( ompi_coll_tree_t** tree );
 
+/*
+ * Topology aware trees.
+ *
+ * Same shapes as above, built level by level: a tree of the node leaders,
+ * then in each node a tree of the package leaders, then in each package
+ * a tree of its processes.  The edges between nodes are at the top of the
+ * tree, the edges inside a package at its leaves.  They fall back to the
+ * trees above when the locality of the processes is unknown or when the
+ * communicator fits in a single package.
+ */
+
+/* Build the trees of coll/base (binomial, k-nomial, chains) topology aware */
+OMPI_DECLSPEC extern bool ompi_coll_base_topo_aware;
+
+/* Where the processes of a communicator are, cached on the communicator */
+typedef struct ompi_coll_topo_locality_t {
+    int32_t *node;      /* lowest rank of the node of each rank, NULL if unknown */
+    int32_t *package;   /* lowest rank of the package of each rank on my node,
+                           -1 for the ranks on other nodes */
+} ompi_coll_topo_locality_t;
+
+ompi_coll_topo_locality_t*
+ompi_coll_base_topo_get_locality( struct ompi_communicator_t* comm );
+void ompi_coll_base_topo_destroy_locality( ompi_coll_topo_locality_t** locality );
+
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_tree( int fanout,
+                                          struct ompi_communicator_t* comm,
+                                          int root );
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_bmtree( struct ompi_communicator_t* comm,
+                                            int root );
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_kmtree( struct ompi_communicator_t* comm,
+                                            int root, int radix );
+ompi_coll_tree_t*
+ompi_coll_base_topo_build_topoaware_chain( int fanout,
+                                           struct ompi_communicator_t* comm,
+                                           int root );
+
 /* debugging stuff, will be removed later */
 int ompi_coll_base_topo_dump_tree (ompi_coll_tree_t* tree, int rank);
 
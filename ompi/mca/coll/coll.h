@@ -767,6 +767,9 @@ struct mca_coll_base_comm_coll_t {
 
     mca_coll_base_module_reduce_local_fn_t coll_reduce_local;
     mca_coll_base_module_2_3_0_t *coll_reduce_local_module;
+
+    /* node and package of the processes, see coll_base_topo.h */
+    struct ompi_coll_topo_locality_t *coll_locality;
 };
 typedef struct mca_coll_base_comm_coll_t mca_coll_base_comm_coll_t;
 
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ * @file
+ *
+ * Hierarchical collectives.
+ *
+ * The communicator is split, the first time one of its collectives is
+ * called, in a low communicator holding the processes of the node and
+ * up communicators holding the processes that have the same rank in
+ * their node, one per node.  A collective is then a few stages, each
+ * a collective on the low or on the up communicator (e.g. a broadcast
+ * is a broadcast between the nodes followed by a broadcast in each
+ * node), run segment by segment so that the stages on the two
+ * communicators overlap.
+ *
+ * In the blocking collectives the stages on the low communicator are
+ * the blocking collectives of the module selected for it (coll/sm if
+ * its priority was raised), while the stage on the up communicator in
+ * flight progresses in the background.  In the nonblocking ones all
+ * the stages are nonblocking and are driven by the progress engine.
+ *
+ * Communicators whose nodes do not all have the same number of
+ * processes, and non-commutative reductions on communicators whose
+ * processes are not numbered node by node, use the modules below.
+ */
+
+#ifndef MCA_COLL_HAN_EXPORT_H
+#define MCA_COLL_HAN_EXPORT_H
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "opal/mca/mca.h"
+#include "opal/class/opal_list.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/request/request.h"
+
+BEGIN_C_DECLS
+
+/*
+ * Structure to hold the han coll component.  First it holds the base
+ * coll component, and then holds a bunch of han-coll-component-specific
+ * stuff (e.g., current MCA param values).
+ */
+typedef struct mca_coll_han_component_t {
+    /* Base coll component */
+    mca_coll_base_component_2_0_0_t super;
+
+    /* MCA parameter: Priority of this component */
+    int han_priority;
+
+    /* MCA parameter: Output stream and verbose level */
+    int han_output;
+    int han_verbose;
+
+    /* MCA parameter: Size of the segments the stages are pipelined on */
+    size_t han_segment_size;
+
+    /* Nonblocking collectives in progress */
+    opal_list_t han_requests;
+    opal_mutex_t han_lock;
+    bool han_progress_registered;
+} mca_coll_han_component_t;
+
+/*
+ * Collectives of the modules selected before this one, used when the
+ * communicator or the operation does not suit a hierarchical algorithm.
+ */
+typedef enum mca_coll_han_colltype {
+    HAN_ALLGATHER = 0,
+    HAN_ALLREDUCE,
+    HAN_BCAST,
+    HAN_GATHER,
+    HAN_REDUCE,
+    HAN_SCATTER,
+    HAN_IALLGATHER,
+    HAN_IALLREDUCE,
+    HAN_IBCAST,
+    HAN_IGATHER,
+    HAN_IREDUCE,
+    HAN_ISCATTER,
+    HAN_COLLCOUNT
+} mca_coll_han_colltype_t;
+
+typedef struct mca_coll_han_collective_fallback_s {
+    union {
+        mca_coll_base_module_allgather_fn_t allgather;
+        mca_coll_base_module_allreduce_fn_t allreduce;
+        mca_coll_base_module_bcast_fn_t bcast;
+        mca_coll_base_module_gather_fn_t gather;
+        mca_coll_base_module_reduce_fn_t reduce;
+        mca_coll_base_module_scatter_fn_t scatter;
+        mca_coll_base_module_iallgather_fn_t iallgather;
+        mca_coll_base_module_iallreduce_fn_t iallreduce;
+        mca_coll_base_module_ibcast_fn_t ibcast;
+        mca_coll_base_module_igather_fn_t igather;
+        mca_coll_base_module_ireduce_fn_t ireduce;
+        mca_coll_base_module_iscatter_fn_t iscatter;
+    } previous_routine;
+    mca_coll_base_module_t *previous_module;
+} mca_coll_han_collective_fallback_t;
+
+#define previous_allgather   previous_routines[HAN_ALLGATHER].previous_routine.allgather
+#define previous_allreduce   previous_routines[HAN_ALLREDUCE].previous_routine.allreduce
+#define previous_bcast       previous_routines[HAN_BCAST].previous_routine.bcast
+#define previous_gather      previous_routines[HAN_GATHER].previous_routine.gather
+#define previous_reduce      previous_routines[HAN_REDUCE].previous_routine.reduce
+#define previous_scatter     previous_routines[HAN_SCATTER].previous_routine.scatter
+#define previous_iallgather  previous_routines[HAN_IALLGATHER].previous_routine.iallgather
+#define previous_iallreduce  previous_routines[HAN_IALLREDUCE].previous_routine.iallreduce
+#define previous_ibcast      previous_routines[HAN_IBCAST].previous_routine.ibcast
+#define previous_igather     previous_routines[HAN_IGATHER].previous_routine.igather
+#define previous_ireduce     previous_routines[HAN_IREDUCE].previous_routine.ireduce
+#define previous_iscatter    previous_routines[HAN_ISCATTER].previous_routine.iscatter
+
+#define previous_allgather_module   previous_routines[HAN_ALLGATHER].previous_module
+#define previous_allreduce_module   previous_routines[HAN_ALLREDUCE].previous_module
+#define previous_bcast_module       previous_routines[HAN_BCAST].previous_module
+#define previous_gather_module      previous_routines[HAN_GATHER].previous_module
+#define previous_reduce_module      previous_routines[HAN_REDUCE].previous_module
+#define previous_scatter_module     previous_routines[HAN_SCATTER].previous_module
+#define previous_iallgather_module  previous_routines[HAN_IALLGATHER].previous_module
+#define previous_iallreduce_module  previous_routines[HAN_IALLREDUCE].previous_module
+#define previous_ibcast_module      previous_routines[HAN_IBCAST].previous_module
+#define previous_igather_module     previous_routines[HAN_IGATHER].previous_module
+#define previous_ireduce_module     previous_routines[HAN_IREDUCE].previous_module
+#define previous_iscatter_module    previous_routines[HAN_ISCATTER].previous_module
+
+/* Coll han module per communicator */
+typedef struct mca_coll_han_module_t {
+    /* Base module */
+    mca_coll_base_module_t super;
+
+    /* To be able to fallback when the cases are not supported */
+    mca_coll_han_collective_fallback_t previous_routines[HAN_COLLCOUNT];
+
+    /* Whether the sub-communicators have been looked for */
+    bool enabled;
+    /* Whether the communicator suits the hierarchical algorithms */
+    bool usable;
+    /* Whether the processes are numbered node by node */
+    bool in_order;
+
+    /* Processes of my node */
+    struct ompi_communicator_t *low_comm;
+    /* Processes with my rank in low_comm, one per node, ordered as
+       the nodes */
+    struct ompi_communicator_t *up_comm;
+
+    /* Processes per node and number of nodes */
+    int low_size;
+    int up_size;
+
+    /* Rank of each process in its node and index of its node */
+    int *low_ranks;
+    int *up_ranks;
+} mca_coll_han_module_t;
+OBJ_CLASS_DECLARATION(mca_coll_han_module_t);
+
+/*
+ * The communicators the stages run on.  The up stages are started
+ * first so that they progress while a blocking low stage runs.
+ */
+enum {
+    HAN_LANE_UP = 0,
+    HAN_LANE_LOW,
+    HAN_LANE_COUNT
+};
+
+#define HAN_MAX_STAGES 3
+
+struct mca_coll_han_request_t;
+
+/**
+ * Start the operation of a stage on a segment.  *sub is set to the
+ * request of a nonblocking operation, or to NULL if the operation is
+ * already complete (or the process does not take part in the stage).
+ */
+typedef int (*mca_coll_han_stage_fn_t)(struct mca_coll_han_request_t *req, int seg,
+                                       ompi_request_t **sub);
+
+/**
+ * Local work once all the stages are complete.
+ */
+typedef int (*mca_coll_han_fini_fn_t)(struct mca_coll_han_request_t *req);
+
+typedef struct mca_coll_han_stage_t {
+    mca_coll_han_stage_fn_t start;
+    int lane;
+} mca_coll_han_stage_t;
+
+/**
+ * A hierarchical collective in progress.
+ *
+ * Stage k of segment i starts once stage k - 1 of segment i is
+ * complete.  Each communicator has a single operation in flight, and
+ * the operations on a communicator are started in the same order by
+ * all the processes: by i + k, then by k.
+ */
+typedef struct mca_coll_han_request_t {
+    ompi_request_t super;
+
+    mca_coll_han_module_t *module;
+    bool blocking;
+
+    int num_stages;
+    mca_coll_han_stage_t stages[HAN_MAX_STAGES];
+    mca_coll_han_fini_fn_t fini;
+    int num_segs;
+
+    /* Number of segments completed by each stage */
+    int stage_done[HAN_MAX_STAGES];
+    /* Per communicator: operation in flight and next one to start */
+    ompi_request_t *lane_req[HAN_LANE_COUNT];
+    int lane_key[HAN_LANE_COUNT];
+    int lane_stage[HAN_LANE_COUNT];
+
+    /* Arguments of the collective */
+    const void *sbuf;
+    void *rbuf;
+    int count, scount, rcount;
+    struct ompi_datatype_t *dtype, *sdtype, *rdtype;
+    struct ompi_op_t *op;
+    int root;
+
+    /* Elements per segment and their extent */
+    int seg_count;
+    ptrdiff_t extent;
+
+    /* Rank of the root in its node and index of its node */
+    int root_low, root_up;
+
+    /* Temporary buffer, allocated at tmp_base */
+    char *tmp;
+    char *tmp_base;
+} mca_coll_han_request_t;
+OBJ_CLASS_DECLARATION(mca_coll_han_request_t);
+
+/* Global component instance */
+OMPI_MODULE_DECLSPEC extern mca_coll_han_component_t mca_coll_han_component;
+
+/* HAN module functions */
+int mca_coll_han_init_query(bool enable_progress_threads, bool enable_mpi_threads);
+mca_coll_base_module_t *mca_coll_han_comm_query(struct ompi_communicator_t *comm, int *priority);
+
+/* Create the sub-communicators the first time a collective is called */
+int mca_coll_han_lazy_enable(mca_coll_han_module_t *han_module,
+                             struct ompi_communicator_t *comm);
+
+/* Requests */
+mca_coll_han_request_t *mca_coll_han_request_alloc(mca_coll_han_module_t *han_module,
+                                                   bool blocking);
+void mca_coll_han_request_set_segments(mca_coll_han_request_t *req,
+                                       struct ompi_datatype_t *dtype, int count);
+void mca_coll_han_request_add_stage(mca_coll_han_request_t *req,
+                                    mca_coll_han_stage_fn_t start, int lane);
+int mca_coll_han_request_alloc_tmp(mca_coll_han_request_t *req,
+                                   struct ompi_datatype_t *dtype, size_t count);
+int mca_coll_han_request_start(mca_coll_han_request_t *req, ompi_request_t **request);
+int mca_coll_han_progress(void);
+
+/* Number of elements in segment seg of the collective */
+static inline int mca_coll_han_seg_count(mca_coll_han_request_t *req, int seg)
+{
+    int left = req->count - seg * req->seg_count;
+    return left < req->seg_count ? left : req->seg_count;
+}
+
+/* Address of segment seg of buf */
+static inline char *mca_coll_han_seg_addr(mca_coll_han_request_t *req, const void *buf, int seg)
+{
+    return (char *) buf + (ptrdiff_t) seg * req->seg_count * req->extent;
+}
+
+/* Copy count elements of the blocks of every process between the node
+   order (node after node) and the rank order */
+int mca_coll_han_reorder(mca_coll_han_module_t *han_module, struct ompi_datatype_t *dtype,
+                         int count, char *rank_order, char *node_order, bool to_rank_order);
+
+/* Collective functions */
+int mca_coll_han_allgather_intra(const void *sbuf, int scount,
+                                 struct ompi_datatype_t *sdtype,
+                                 void *rbuf, int rcount,
+                                 struct ompi_datatype_t *rdtype,
+                                 struct ompi_communicator_t *comm,
+                                 mca_coll_base_module_t *module);
+int mca_coll_han_iallgather_intra(const void *sbuf, int scount,
+                                  struct ompi_datatype_t *sdtype,
+                                  void *rbuf, int rcount,
+                                  struct ompi_datatype_t *rdtype,
+                                  struct ompi_communicator_t *comm,
+                                  ompi_request_t **request,
+                                  mca_coll_base_module_t *module);
+int mca_coll_han_allreduce_intra(const void *sbuf, void *rbuf, int count,
+                                 struct ompi_datatype_t *dtype,
+                                 struct ompi_op_t *op,
+                                 struct ompi_communicator_t *comm,
+                                 mca_coll_base_module_t *module);
+int mca_coll_han_iallreduce_intra(const void *sbuf, void *rbuf, int count,
+                                  struct ompi_datatype_t *dtype,
+                                  struct ompi_op_t *op,
+                                  struct ompi_communicator_t *comm,
+                                  ompi_request_t **request,
+                                  mca_coll_base_module_t *module);
+int mca_coll_han_bcast_intra(void *buff, int count,
+                             struct ompi_datatype_t *datatype, int root,
+                             struct ompi_communicator_t *comm,
+                             mca_coll_base_module_t *module);
+int mca_coll_han_ibcast_intra(void *buff, int count,
+                              struct ompi_datatype_t *datatype, int root,
+                              struct ompi_communicator_t *comm,
+                              ompi_request_t **request,
+                              mca_coll_base_module_t *module);
+int mca_coll_han_gather_intra(const void *sbuf, int scount,
+                              struct ompi_datatype_t *sdtype,
+                              void *rbuf, int rcount,
+                              struct ompi_datatype_t *rdtype,
+                              int root, struct ompi_communicator_t *comm,
+                              mca_coll_base_module_t *module);
+int mca_coll_han_igather_intra(const void *sbuf, int scount,
+                               struct ompi_datatype_t *sdtype,
+                               void *rbuf, int rcount,
+                               struct ompi_datatype_t *rdtype,
+                               int root, struct ompi_communicator_t *comm,
+                               ompi_request_t **request,
+                               mca_coll_base_module_t *module);
+int mca_coll_han_reduce_intra(const void *sbuf, void *rbuf, int count,
+                              struct ompi_datatype_t *dtype,
+                              struct ompi_op_t *op, int root,
+                              struct ompi_communicator_t *comm,
+                              mca_coll_base_module_t *module);
+int mca_coll_han_ireduce_intra(const void *sbuf, void *rbuf, int count,
+                               struct ompi_datatype_t *dtype,
+                               struct ompi_op_t *op, int root,
+                               struct ompi_communicator_t *comm,
+                               ompi_request_t **request,
+                               mca_coll_base_module_t *module);
+int mca_coll_han_scatter_intra(const void *sbuf, int scount,
+                               struct ompi_datatype_t *sdtype,
+                               void *rbuf, int rcount,
+                               struct ompi_datatype_t *rdtype,
+                               int root, struct ompi_communicator_t *comm,
+                               mca_coll_base_module_t *module);
+int mca_coll_han_iscatter_intra(const void *sbuf, int scount,
+                                struct ompi_datatype_t *sdtype,
+                                void *rbuf, int rcount,
+                                struct ompi_datatype_t *rdtype,
+                                int root, struct ompi_communicator_t *comm,
+                                ompi_request_t **request,
+                                mca_coll_base_module_t *module);
+
+END_C_DECLS
+
+#endif /* MCA_COLL_HAN_EXPORT_H */
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
+#include "coll_han.h"
+
+/*
+ * Allgather: each node gathers its blocks on its leader, the leaders
+ * allgather them between the nodes and broadcast the whole buffer in
+ * their node.  The blocks are gathered node after node, in a temporary
+ * buffer when the processes are not numbered this way.
+ */
+
+/* Buffer the blocks are gathered in, node after node */
+static char *han_allgather_base(mca_coll_han_request_t *req)
+{
+    return req->module->in_order ? (char *) req->rbuf : req->tmp;
+}
+
+static int han_allgather_low_gather(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *low_comm = han_module->low_comm;
+    int rank = req->root;
+    const void *sbuf = req->sbuf;
+    int scount = req->scount;
+    struct ompi_datatype_t *sdtype = req->sdtype;
+    char *rbuf = NULL;
+
+    if (0 == ompi_comm_rank(low_comm)) {
+        rbuf = han_allgather_base(req) +
+            (ptrdiff_t) han_module->up_ranks[rank] * han_module->low_size * req->rcount * req->extent;
+    }
+    /* In place, the block of the leader is already where it is gathered
+       when the processes are numbered node by node */
+    if (MPI_IN_PLACE == sbuf && (NULL == rbuf || !han_module->in_order)) {
+        sbuf = (char *) req->rbuf + (ptrdiff_t) rank * req->rcount * req->extent;
+        scount = req->rcount;
+        sdtype = req->rdtype;
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_gather(sbuf, scount, sdtype, rbuf, req->rcount, req->rdtype,
+                                             0, low_comm, low_comm->c_coll->coll_gather_module);
+    }
+    return low_comm->c_coll->coll_igather(sbuf, scount, sdtype, rbuf, req->rcount, req->rdtype,
+                                          0, low_comm, sub, low_comm->c_coll->coll_igather_module);
+}
+
+static int han_allgather_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *up_comm = han_module->up_comm;
+
+    *sub = NULL;
+    if (0 != ompi_comm_rank(han_module->low_comm)) {
+        return OMPI_SUCCESS;
+    }
+    return up_comm->c_coll->coll_iallgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                                            han_allgather_base(req),
+                                            han_module->low_size * req->rcount, req->rdtype,
+                                            up_comm, sub, up_comm->c_coll->coll_iallgather_module);
+}
+
+static int han_allgather_low_bcast(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *low_comm = han_module->low_comm;
+    int ret, count = han_module->low_size * han_module->up_size * req->rcount;
+
+    if (0 == ompi_comm_rank(low_comm) && !han_module->in_order) {
+        ret = mca_coll_han_reorder(han_module, req->rdtype, req->rcount,
+                                   (char *) req->rbuf, req->tmp, true);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_bcast(req->rbuf, count, req->rdtype, 0, low_comm,
+                                            low_comm->c_coll->coll_bcast_module);
+    }
+    return low_comm->c_coll->coll_ibcast(req->rbuf, count, req->rdtype, 0, low_comm, sub,
+                                         low_comm->c_coll->coll_ibcast_module);
+}
+
+static int han_allgather(const void *sbuf, int scount, struct ompi_datatype_t *sdtype,
+                         void *rbuf, int rcount, struct ompi_datatype_t *rdtype,
+                         struct ompi_communicator_t *comm, bool blocking,
+                         ompi_request_t **request, mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+    ptrdiff_t lb;
+    int ret;
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->sbuf = sbuf;
+    req->scount = scount;
+    req->sdtype = sdtype;
+    req->rbuf = rbuf;
+    req->rcount = rcount;
+    req->rdtype = rdtype;
+    /* Where the block of this process is in rbuf */
+    req->root = ompi_comm_rank(comm);
+    ompi_datatype_get_extent(rdtype, &lb, &req->extent);
+
+    if (0 == ompi_comm_rank(han_module->low_comm) && !han_module->in_order) {
+        ret = mca_coll_han_request_alloc_tmp(req, rdtype, (size_t) ompi_comm_size(comm) * rcount);
+        if (OMPI_SUCCESS != ret) {
+            OBJ_RELEASE(req);
+            return ret;
+        }
+    }
+    mca_coll_han_request_add_stage(req, han_allgather_low_gather, HAN_LANE_LOW);
+    mca_coll_han_request_add_stage(req, han_allgather_up, HAN_LANE_UP);
+    mca_coll_han_request_add_stage(req, han_allgather_low_bcast, HAN_LANE_LOW);
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_allgather_intra(const void *sbuf, int scount,
+                                 struct ompi_datatype_t *sdtype,
+                                 void *rbuf, int rcount,
+                                 struct ompi_datatype_t *rdtype,
+                                 struct ompi_communicator_t *comm,
+                                 mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_allgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                              han_module->previous_allgather_module);
+    }
+    return han_allgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm, true, NULL,
+                         han_module);
+}
+
+int mca_coll_han_iallgather_intra(const void *sbuf, int scount,
+                                  struct ompi_datatype_t *sdtype,
+                                  void *rbuf, int rcount,
+                                  struct ompi_datatype_t *rdtype,
+                                  struct ompi_communicator_t *comm,
+                                  ompi_request_t **request,
+                                  mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_iallgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                               request, han_module->previous_iallgather_module);
+    }
+    return han_allgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm, false, request,
+                         han_module);
+}
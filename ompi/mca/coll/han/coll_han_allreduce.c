@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/op/op.h"
+#include "coll_han.h"
+
+/*
+ * Allreduce: each node reduces a segment on its leader (rank 0 in the
+ * node), the leaders allreduce it between the nodes and broadcast the
+ * result in their node.  The three stages of consecutive segments
+ * overlap.
+ */
+
+static int han_allreduce_low_reduce(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *low_comm = req->module->low_comm;
+    int count = mca_coll_han_seg_count(req, seg);
+    char *rbuf = mca_coll_han_seg_addr(req, req->rbuf, seg);
+    const void *sbuf = rbuf;
+
+    if (MPI_IN_PLACE != req->sbuf) {
+        sbuf = mca_coll_han_seg_addr(req, req->sbuf, seg);
+    } else if (0 == ompi_comm_rank(low_comm)) {
+        sbuf = MPI_IN_PLACE;
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_reduce(sbuf, rbuf, count, req->dtype, req->op, 0,
+                                             low_comm, low_comm->c_coll->coll_reduce_module);
+    }
+    return low_comm->c_coll->coll_ireduce(sbuf, rbuf, count, req->dtype, req->op, 0,
+                                          low_comm, sub, low_comm->c_coll->coll_ireduce_module);
+}
+
+static int han_allreduce_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *up_comm = req->module->up_comm;
+
+    *sub = NULL;
+    if (0 != ompi_comm_rank(req->module->low_comm)) {
+        return OMPI_SUCCESS;
+    }
+    return up_comm->c_coll->coll_iallreduce(MPI_IN_PLACE, mca_coll_han_seg_addr(req, req->rbuf, seg),
+                                            mca_coll_han_seg_count(req, seg), req->dtype,
+                                            req->op, up_comm, sub,
+                                            up_comm->c_coll->coll_iallreduce_module);
+}
+
+static int han_allreduce_low_bcast(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *low_comm = req->module->low_comm;
+    char *rbuf = mca_coll_han_seg_addr(req, req->rbuf, seg);
+    int count = mca_coll_han_seg_count(req, seg);
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_bcast(rbuf, count, req->dtype, 0, low_comm,
+                                            low_comm->c_coll->coll_bcast_module);
+    }
+    return low_comm->c_coll->coll_ibcast(rbuf, count, req->dtype, 0, low_comm, sub,
+                                         low_comm->c_coll->coll_ibcast_module);
+}
+
+static int han_allreduce(const void *sbuf, void *rbuf, int count,
+                         struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                         bool blocking, ompi_request_t **request,
+                         mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->sbuf = sbuf;
+    req->rbuf = rbuf;
+    req->dtype = dtype;
+    req->op = op;
+    mca_coll_han_request_set_segments(req, dtype, count);
+    mca_coll_han_request_add_stage(req, han_allreduce_low_reduce, HAN_LANE_LOW);
+    mca_coll_han_request_add_stage(req, han_allreduce_up, HAN_LANE_UP);
+    mca_coll_han_request_add_stage(req, han_allreduce_low_bcast, HAN_LANE_LOW);
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_allreduce_intra(const void *sbuf, void *rbuf, int count,
+                                 struct ompi_datatype_t *dtype,
+                                 struct ompi_op_t *op,
+                                 struct ompi_communicator_t *comm,
+                                 mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    /* Reducing node by node changes the order of the operands */
+    if (!han_module->usable || (!ompi_op_is_commute(op) && !han_module->in_order)) {
+        return han_module->previous_allreduce(sbuf, rbuf, count, dtype, op, comm,
+                                              han_module->previous_allreduce_module);
+    }
+    return han_allreduce(sbuf, rbuf, count, dtype, op, true, NULL, han_module);
+}
+
+int mca_coll_han_iallreduce_intra(const void *sbuf, void *rbuf, int count,
+                                  struct ompi_datatype_t *dtype,
+                                  struct ompi_op_t *op,
+                                  struct ompi_communicator_t *comm,
+                                  ompi_request_t **request,
+                                  mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable || (!ompi_op_is_commute(op) && !han_module->in_order)) {
+        return han_module->previous_iallreduce(sbuf, rbuf, count, dtype, op, comm, request,
+                                               han_module->previous_iallreduce_module);
+    }
+    return han_allreduce(sbuf, rbuf, count, dtype, op, false, request, han_module);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/coll.h"
+#include "coll_han.h"
+
+/*
+ * Broadcast: the up communicator of the root broadcasts each segment
+ * between the nodes, then each node broadcasts it from its leader.
+ */
+
+static int han_bcast_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *up_comm = req->module->up_comm;
+
+    *sub = NULL;
+    if (ompi_comm_rank(req->module->low_comm) != req->root_low) {
+        return OMPI_SUCCESS;
+    }
+    return up_comm->c_coll->coll_ibcast(mca_coll_han_seg_addr(req, req->rbuf, seg),
+                                        mca_coll_han_seg_count(req, seg), req->dtype,
+                                        req->root_up, up_comm, sub,
+                                        up_comm->c_coll->coll_ibcast_module);
+}
+
+static int han_bcast_low(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *low_comm = req->module->low_comm;
+    char *buf = mca_coll_han_seg_addr(req, req->rbuf, seg);
+    int count = mca_coll_han_seg_count(req, seg);
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_bcast(buf, count, req->dtype, req->root_low, low_comm,
+                                            low_comm->c_coll->coll_bcast_module);
+    }
+    return low_comm->c_coll->coll_ibcast(buf, count, req->dtype, req->root_low, low_comm, sub,
+                                         low_comm->c_coll->coll_ibcast_module);
+}
+
+static int han_bcast(void *buff, int count, struct ompi_datatype_t *datatype, int root,
+                     bool blocking, ompi_request_t **request,
+                     mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->rbuf = buff;
+    req->dtype = datatype;
+    req->root_low = han_module->low_ranks[root];
+    req->root_up = han_module->up_ranks[root];
+    mca_coll_han_request_set_segments(req, datatype, count);
+    mca_coll_han_request_add_stage(req, han_bcast_up, HAN_LANE_UP);
+    mca_coll_han_request_add_stage(req, han_bcast_low, HAN_LANE_LOW);
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_bcast_intra(void *buff, int count,
+                             struct ompi_datatype_t *datatype, int root,
+                             struct ompi_communicator_t *comm,
+                             mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_bcast(buff, count, datatype, root, comm,
+                                          han_module->previous_bcast_module);
+    }
+    return han_bcast(buff, count, datatype, root, true, NULL, han_module);
+}
+
+int mca_coll_han_ibcast_intra(void *buff, int count,
+                              struct ompi_datatype_t *datatype, int root,
+                              struct ompi_communicator_t *comm,
+                              ompi_request_t **request,
+                              mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_ibcast(buff, count, datatype, root, comm, request,
+                                           han_module->previous_ibcast_module);
+    }
+    return han_bcast(buff, count, datatype, root, false, request, han_module);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "opal/runtime/opal_progress.h"
+#include "ompi/constants.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/mca/coll/base/base.h"
+#include "coll_han.h"
+
+/*
+ * Public string showing the coll ompi_han component version number
+ */
+const char *mca_coll_han_component_version_string =
+    "Open MPI HAN collective MCA component version " OMPI_VERSION;
+
+/*
+ * Local functions
+ */
+static int han_open(void);
+static int han_close(void);
+static int han_register(void);
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+
+mca_coll_han_component_t mca_coll_han_component = {
+    /* First, fill in the super */
+    {
+        /* First, the mca_component_t struct containing meta
+           information about the component itself */
+        .collm_version = {
+            MCA_COLL_BASE_VERSION_2_0_0,
+
+            /* Component name and version */
+            .mca_component_name = "han",
+            MCA_BASE_MAKE_VERSION(component, OMPI_MAJOR_VERSION, OMPI_MINOR_VERSION,
+                                  OMPI_RELEASE_VERSION),
+
+            /* Component functions */
+            .mca_open_component = han_open,
+            .mca_close_component = han_close,
+            .mca_register_component_params = han_register,
+        },
+        .collm_data = {
+            /* The component is not checkpoint ready */
+            MCA_BASE_METADATA_PARAM_NONE
+        },
+
+        /* Initialization / querying functions */
+        .collm_init_query = mca_coll_han_init_query,
+        .collm_comm_query = mca_coll_han_comm_query,
+    },
+
+    /* han-component specific information */
+
+    0, /* (default) priority */
+
+    0, /* (default) output stream */
+    0, /* (default) verbose level */
+
+    /* default values for non-MCA parameters */
+    /* Not specifying values here gives us all 0's */
+};
+
+/* Open the component */
+static int han_open(void)
+{
+    mca_coll_han_component_t *cs = &mca_coll_han_component;
+
+    if (cs->han_verbose > 0) {
+        cs->han_output = opal_output_open(NULL);
+        opal_output_set_verbosity(cs->han_output, cs->han_verbose);
+    }
+
+    OBJ_CONSTRUCT(&cs->han_requests, opal_list_t);
+    OBJ_CONSTRUCT(&cs->han_lock, opal_mutex_t);
+    cs->han_progress_registered = false;
+
+    return OMPI_SUCCESS;
+}
+
+
+/* Shut down the component */
+static int han_close(void)
+{
+    mca_coll_han_component_t *cs = &mca_coll_han_component;
+
+    if (cs->han_progress_registered) {
+        opal_progress_unregister(mca_coll_han_progress);
+        cs->han_progress_registered = false;
+    }
+    OBJ_DESTRUCT(&cs->han_requests);
+    OBJ_DESTRUCT(&cs->han_lock);
+
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Register MCA params
+ */
+static int han_register(void)
+{
+    mca_base_component_t *c = &mca_coll_han_component.super.collm_version;
+    mca_coll_han_component_t *cs = &mca_coll_han_component;
+
+    /* Only useful on communicators spanning several nodes, and has to
+       be asked for */
+    cs->han_priority = 0;
+    (void) mca_base_component_var_register(c, "priority", "Priority of the han coll component",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &cs->han_priority);
+
+    cs->han_verbose = ompi_coll_base_framework.framework_verbose;
+    (void) mca_base_component_var_register(c, "verbose",
+                                           "Verbose level (default set to the collective framework verbosity)",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &cs->han_verbose);
+
+    cs->han_segment_size = 65536;
+    (void) mca_base_component_var_register(c, "segment_size",
+                                           "Size in bytes of the segments the intra-node and inter-node "
+                                           "stages of the bcast, reduce and allreduce are pipelined on "
+                                           "(0 to not pipeline)",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &cs->han_segment_size);
+
+    return OMPI_SUCCESS;
+}
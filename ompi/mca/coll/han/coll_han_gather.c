@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
+#include "coll_han.h"
+
+/*
+ * Gather: each node gathers its blocks on the process with the rank of
+ * the root in the node, then these gather them, node after node, on
+ * the root.  The leaders other than the root gather in a temporary
+ * buffer of their send type, and so does the root, of its receive
+ * type, when the processes are not numbered node by node.
+ *
+ * req->extent is the extent of the receive type on the root and of
+ * the send type on the other processes.
+ */
+
+static bool han_gather_is_root(mca_coll_han_request_t *req)
+{
+    return ompi_comm_rank(req->module->low_comm) == req->root_low &&
+        ompi_comm_rank(req->module->up_comm) == req->root_up;
+}
+
+/* Buffer the root gathers the blocks in, node after node */
+static char *han_gather_base(mca_coll_han_request_t *req)
+{
+    return req->module->in_order ? (char *) req->rbuf : req->tmp;
+}
+
+static int han_gather_low(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *low_comm = han_module->low_comm;
+    const void *sbuf = req->sbuf;
+    int scount = req->scount, rcount = req->rcount;
+    struct ompi_datatype_t *sdtype = req->sdtype, *rdtype = req->rdtype;
+    char *rbuf = NULL;
+
+    if (han_gather_is_root(req)) {
+        rbuf = han_gather_base(req) +
+            (ptrdiff_t) req->root_up * han_module->low_size * rcount * req->extent;
+        /* In place, the block of the root is already where it is
+           gathered when the processes are numbered node by node */
+        if (MPI_IN_PLACE == sbuf && !han_module->in_order) {
+            sbuf = (char *) req->rbuf + (ptrdiff_t) req->root * rcount * req->extent;
+            scount = rcount;
+            sdtype = rdtype;
+        }
+    } else if (ompi_comm_rank(low_comm) == req->root_low) {
+        rbuf = req->tmp;
+        rcount = scount;
+        rdtype = sdtype;
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_gather(sbuf, scount, sdtype, rbuf, rcount, rdtype,
+                                             req->root_low, low_comm,
+                                             low_comm->c_coll->coll_gather_module);
+    }
+    return low_comm->c_coll->coll_igather(sbuf, scount, sdtype, rbuf, rcount, rdtype,
+                                          req->root_low, low_comm, sub,
+                                          low_comm->c_coll->coll_igather_module);
+}
+
+static int han_gather_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *up_comm = han_module->up_comm;
+
+    *sub = NULL;
+    if (ompi_comm_rank(han_module->low_comm) != req->root_low) {
+        return OMPI_SUCCESS;
+    }
+    if (han_gather_is_root(req)) {
+        return up_comm->c_coll->coll_igather(MPI_IN_PLACE, 0, req->sdtype, han_gather_base(req),
+                                             han_module->low_size * req->rcount, req->rdtype,
+                                             req->root_up, up_comm, sub,
+                                             up_comm->c_coll->coll_igather_module);
+    }
+    return up_comm->c_coll->coll_igather(req->tmp, han_module->low_size * req->scount, req->sdtype,
+                                         NULL, 0, req->rdtype, req->root_up, up_comm, sub,
+                                         up_comm->c_coll->coll_igather_module);
+}
+
+static int han_gather_fini(mca_coll_han_request_t *req)
+{
+    if (han_gather_is_root(req) && !req->module->in_order) {
+        return mca_coll_han_reorder(req->module, req->rdtype, req->rcount,
+                                    (char *) req->rbuf, req->tmp, true);
+    }
+    return OMPI_SUCCESS;
+}
+
+static int han_gather(const void *sbuf, int scount, struct ompi_datatype_t *sdtype,
+                      void *rbuf, int rcount, struct ompi_datatype_t *rdtype, int root,
+                      struct ompi_communicator_t *comm, bool blocking,
+                      ompi_request_t **request, mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+    int ret = OMPI_SUCCESS;
+    ptrdiff_t lb;
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->sbuf = sbuf;
+    req->scount = scount;
+    req->sdtype = sdtype;
+    req->rbuf = rbuf;
+    req->rcount = rcount;
+    req->rdtype = rdtype;
+    req->root = root;
+    req->root_low = han_module->low_ranks[root];
+    req->root_up = han_module->up_ranks[root];
+
+    if (ompi_comm_rank(comm) == root) {
+        ompi_datatype_get_extent(rdtype, &lb, &req->extent);
+        if (!han_module->in_order) {
+            ret = mca_coll_han_request_alloc_tmp(req, rdtype,
+                                                 (size_t) ompi_comm_size(comm) * rcount);
+        }
+    } else {
+        ompi_datatype_get_extent(sdtype, &lb, &req->extent);
+        if (ompi_comm_rank(han_module->low_comm) == req->root_low) {
+            ret = mca_coll_han_request_alloc_tmp(req, sdtype,
+                                                 (size_t) han_module->low_size * scount);
+        }
+    }
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(req);
+        return ret;
+    }
+    mca_coll_han_request_add_stage(req, han_gather_low, HAN_LANE_LOW);
+    mca_coll_han_request_add_stage(req, han_gather_up, HAN_LANE_UP);
+    req->fini = han_gather_fini;
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_gather_intra(const void *sbuf, int scount,
+                              struct ompi_datatype_t *sdtype,
+                              void *rbuf, int rcount,
+                              struct ompi_datatype_t *rdtype,
+                              int root, struct ompi_communicator_t *comm,
+                              mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_gather(sbuf, scount, sdtype, rbuf, rcount, rdtype, root,
+                                           comm, han_module->previous_gather_module);
+    }
+    return han_gather(sbuf, scount, sdtype, rbuf, rcount, rdtype, root, comm, true, NULL,
+                      han_module);
+}
+
+int mca_coll_han_igather_intra(const void *sbuf, int scount,
+                               struct ompi_datatype_t *sdtype,
+                               void *rbuf, int rcount,
+                               struct ompi_datatype_t *rdtype,
+                               int root, struct ompi_communicator_t *comm,
+                               ompi_request_t **request,
+                               mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_igather(sbuf, scount, sdtype, rbuf, rcount, rdtype, root,
+                                            comm, request, han_module->previous_igather_module);
+    }
+    return han_gather(sbuf, scount, sdtype, rbuf, rcount, rdtype, root, comm, false, request,
+                      han_module);
+}
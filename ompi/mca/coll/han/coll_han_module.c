@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <stdlib.h>
+
+#include "mpi.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/group/group.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/mca/coll/base/base.h"
+#include "ompi/op/op.h"
+#include "coll_han.h"
+
+
+/*
+ * Module constructor
+ */
+static void han_module_construct(mca_coll_han_module_t *module)
+{
+    int i;
+
+    for (i = 0; i < HAN_COLLCOUNT; ++i) {
+        module->previous_routines[i].previous_module = NULL;
+    }
+    module->enabled = false;
+    module->usable = false;
+    module->in_order = false;
+    module->low_comm = NULL;
+    module->up_comm = NULL;
+    module->low_size = 0;
+    module->up_size = 0;
+    module->low_ranks = NULL;
+    module->up_ranks = NULL;
+}
+
+/*
+ * Module destructor
+ */
+static void han_module_destruct(mca_coll_han_module_t *module)
+{
+    int i;
+
+    for (i = 0; i < HAN_COLLCOUNT; ++i) {
+        if (NULL != module->previous_routines[i].previous_module) {
+            OBJ_RELEASE(module->previous_routines[i].previous_module);
+            module->previous_routines[i].previous_module = NULL;
+        }
+    }
+    if (NULL != module->low_comm) {
+        ompi_comm_free(&module->low_comm);
+    }
+    if (NULL != module->up_comm) {
+        ompi_comm_free(&module->up_comm);
+    }
+    free(module->low_ranks);
+    free(module->up_ranks);
+    module->low_ranks = NULL;
+    module->up_ranks = NULL;
+    module->enabled = false;
+}
+
+OBJ_CLASS_INSTANCE(mca_coll_han_module_t,
+                   mca_coll_base_module_t,
+                   han_module_construct,
+                   han_module_destruct);
+
+/*
+ * In this macro, the following variables are supposed to have been declared
+ * in the caller:
+ * . ompi_communicator_t *comm
+ * . mca_coll_han_module_t *han_module
+ */
+#define HAN_SAVE_PREV_COLL_API(__api)                                   \
+    do {                                                                \
+        han_module->previous_ ## __api            = comm->c_coll->coll_ ## __api; \
+        han_module->previous_ ## __api ## _module = comm->c_coll->coll_ ## __api ## _module; \
+        if (!comm->c_coll->coll_ ## __api || !comm->c_coll->coll_ ## __api ## _module) { \
+            opal_output_verbose(1, ompi_coll_base_framework.framework_output, \
+                                "(%d/%s): no underlying " # __api"; disqualifying myself", \
+                                comm->c_contextid, comm->c_name); \
+            return OMPI_ERROR;                                  \
+        }                                                       \
+        OBJ_RETAIN(han_module->previous_ ## __api ## _module);  \
+    } while(0)
+
+/*
+ * Init module on the communicator
+ */
+static int han_module_enable(mca_coll_base_module_t *module,
+                             struct ompi_communicator_t *comm)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t*) module;
+
+    HAN_SAVE_PREV_COLL_API(allgather);
+    HAN_SAVE_PREV_COLL_API(allreduce);
+    HAN_SAVE_PREV_COLL_API(bcast);
+    HAN_SAVE_PREV_COLL_API(gather);
+    HAN_SAVE_PREV_COLL_API(reduce);
+    HAN_SAVE_PREV_COLL_API(scatter);
+    HAN_SAVE_PREV_COLL_API(iallgather);
+    HAN_SAVE_PREV_COLL_API(iallreduce);
+    HAN_SAVE_PREV_COLL_API(ibcast);
+    HAN_SAVE_PREV_COLL_API(igather);
+    HAN_SAVE_PREV_COLL_API(ireduce);
+    HAN_SAVE_PREV_COLL_API(iscatter);
+
+    /* The sub-communicators are created by the first collective */
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Initial query function that is invoked during MPI_INIT, allowing
+ * this component to disqualify itself if it doesn't support the
+ * required level of thread support.  This function is invoked exactly
+ * once.
+ */
+int mca_coll_han_init_query(bool enable_progress_threads, bool enable_mpi_threads)
+{
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Invoked when there's a new communicator that has been created.
+ * Look at the communicator and decide which set of functions and
+ * priority we want to return.
+ */
+mca_coll_base_module_t *mca_coll_han_comm_query(struct ompi_communicator_t *comm,
+                                                int *priority)
+{
+    mca_coll_han_module_t *han_module;
+
+    /* If we're intercomm, or if all the processes are on this node.
+       This has to be the same answer on all the processes: whether
+       they have peers on their node depends on the process. */
+    if (OMPI_COMM_IS_INTER(comm) || 1 == ompi_comm_size(comm) ||
+        !ompi_group_have_remote_peers(comm->c_local_group)) {
+        opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                            "coll:han:comm_query (%d/%s): intercomm, "
+                            "comm is too small or on a single node; disqualifying myself",
+                            comm->c_contextid, comm->c_name);
+        return NULL;
+    }
+
+    /* Get the priority level attached to this module.
+       If priority is less than or equal to 0, then the module is unavailable. */
+    *priority = mca_coll_han_component.han_priority;
+    if (mca_coll_han_component.han_priority <= 0) {
+        opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                            "coll:han:comm_query (%d/%s): priority too low; "
+                            "disqualifying myself",
+                            comm->c_contextid, comm->c_name);
+        return NULL;
+    }
+
+    han_module = OBJ_NEW(mca_coll_han_module_t);
+    if (NULL == han_module) {
+        return NULL;
+    }
+
+    /* All is good -- return a module */
+    han_module->super.coll_module_enable = han_module_enable;
+    han_module->super.ft_event = NULL;
+    han_module->super.coll_allgather = mca_coll_han_allgather_intra;
+    han_module->super.coll_allgatherv = NULL;
+    han_module->super.coll_allreduce = mca_coll_han_allreduce_intra;
+    han_module->super.coll_alltoall = NULL;
+    han_module->super.coll_alltoallv = NULL;
+    han_module->super.coll_alltoallw = NULL;
+    han_module->super.coll_barrier = NULL;
+    han_module->super.coll_bcast = mca_coll_han_bcast_intra;
+    han_module->super.coll_exscan = NULL;
+    han_module->super.coll_gather = mca_coll_han_gather_intra;
+    han_module->super.coll_gatherv = NULL;
+    han_module->super.coll_reduce = mca_coll_han_reduce_intra;
+    han_module->super.coll_reduce_scatter = NULL;
+    han_module->super.coll_scan = NULL;
+    han_module->super.coll_scatter = mca_coll_han_scatter_intra;
+    han_module->super.coll_scatterv = NULL;
+    han_module->super.coll_iallgather = mca_coll_han_iallgather_intra;
+    han_module->super.coll_iallreduce = mca_coll_han_iallreduce_intra;
+    han_module->super.coll_ibcast = mca_coll_han_ibcast_intra;
+    han_module->super.coll_igather = mca_coll_han_igather_intra;
+    han_module->super.coll_ireduce = mca_coll_han_ireduce_intra;
+    han_module->super.coll_iscatter = mca_coll_han_iscatter_intra;
+
+    opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                        "coll:han:comm_query (%d/%s): pick me! pick me!",
+                        comm->c_contextid, comm->c_name);
+    return &(han_module->super);
+}
+
+/*
+ * Swap the collectives of this module in comm->c_coll with the
+ * previous ones: creating the sub-communicators calls collectives on
+ * the communicator, which must not come back here.
+ */
+#define HAN_SWAP_COLL_API(__api)                                        \
+    do {                                                                \
+        mca_coll_base_module_ ## __api ## _fn_t fn = comm->c_coll->coll_ ## __api; \
+        mca_coll_base_module_t *m = comm->c_coll->coll_ ## __api ## _module; \
+        comm->c_coll->coll_ ## __api = han_module->previous_ ## __api;  \
+        comm->c_coll->coll_ ## __api ## _module = han_module->previous_ ## __api ## _module; \
+        han_module->previous_ ## __api = fn;                            \
+        han_module->previous_ ## __api ## _module = m;                  \
+    } while (0)
+
+static void han_swap_coll_api(mca_coll_han_module_t *han_module,
+                              struct ompi_communicator_t *comm)
+{
+    HAN_SWAP_COLL_API(allgather);
+    HAN_SWAP_COLL_API(allreduce);
+    HAN_SWAP_COLL_API(bcast);
+    HAN_SWAP_COLL_API(gather);
+    HAN_SWAP_COLL_API(reduce);
+    HAN_SWAP_COLL_API(scatter);
+    HAN_SWAP_COLL_API(iallgather);
+    HAN_SWAP_COLL_API(iallreduce);
+    HAN_SWAP_COLL_API(ibcast);
+    HAN_SWAP_COLL_API(igather);
+    HAN_SWAP_COLL_API(ireduce);
+    HAN_SWAP_COLL_API(iscatter);
+}
+
+/*
+ * The up communicators span several nodes, so this module may have
+ * been selected on them; with one process per node it would only fall
+ * back, after creating sub-communicators of its own the first time,
+ * which must not happen while one of our collectives is in progress.
+ */
+static void han_disable_on(struct ompi_communicator_t *comm)
+{
+    mca_coll_han_module_t *module = NULL;
+
+    if (mca_coll_han_bcast_intra == comm->c_coll->coll_bcast) {
+        module = (mca_coll_han_module_t *) comm->c_coll->coll_bcast_module;
+    } else if (mca_coll_han_ibcast_intra == comm->c_coll->coll_ibcast) {
+        module = (mca_coll_han_module_t *) comm->c_coll->coll_ibcast_module;
+    } else if (mca_coll_han_iallreduce_intra == comm->c_coll->coll_iallreduce) {
+        module = (mca_coll_han_module_t *) comm->c_coll->coll_iallreduce_module;
+    }
+    if (NULL != module) {
+        module->enabled = true;
+        module->usable = false;
+    }
+}
+
+int mca_coll_han_lazy_enable(mca_coll_han_module_t *han_module,
+                             struct ompi_communicator_t *comm)
+{
+    int i, ret, rank, size, low_rank, leader, sizes[2], mine[2], *all = NULL;
+
+    /* Just make sure we haven't been here already */
+    if (han_module->enabled) {
+        return OMPI_SUCCESS;
+    }
+    han_module->enabled = true;
+
+    rank = ompi_comm_rank(comm);
+    size = ompi_comm_size(comm);
+
+    han_swap_coll_api(han_module, comm);
+
+    ret = ompi_comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, NULL, &han_module->low_comm);
+    if (OMPI_SUCCESS != ret) {
+        goto exit;
+    }
+    low_rank = ompi_comm_rank(han_module->low_comm);
+    han_module->low_size = ompi_comm_size(han_module->low_comm);
+
+    /* All the nodes have to hold the same number of processes, more
+       than one */
+    sizes[0] = han_module->low_size;
+    sizes[1] = -han_module->low_size;
+    ret = comm->c_coll->coll_allreduce(MPI_IN_PLACE, sizes, 2, MPI_INT, MPI_MAX, comm,
+                                       comm->c_coll->coll_allreduce_module);
+    if (OMPI_SUCCESS != ret) {
+        goto exit;
+    }
+    if (sizes[0] != -sizes[1] || 1 == sizes[0] || size == sizes[0]) {
+        opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                            "coll:han:enable (%d/%s): %d to %d processes per node; "
+                            "using the previous modules",
+                            comm->c_contextid, comm->c_name, -sizes[1], sizes[0]);
+        ompi_comm_free(&han_module->low_comm);
+        han_module->low_comm = NULL;
+        goto exit;
+    }
+
+    /* Order the nodes in the up communicators as their first process
+       in comm, so that they are the same in all of them */
+    leader = rank;
+    ret = han_module->low_comm->c_coll->coll_bcast(&leader, 1, MPI_INT, 0, han_module->low_comm,
+                                                   han_module->low_comm->c_coll->coll_bcast_module);
+    if (OMPI_SUCCESS != ret) {
+        goto exit;
+    }
+    ret = ompi_comm_split(comm, low_rank, leader, &han_module->up_comm, false);
+    if (OMPI_SUCCESS != ret) {
+        goto exit;
+    }
+    han_module->up_size = ompi_comm_size(han_module->up_comm);
+    han_disable_on(han_module->up_comm);
+
+    /* Where everyone is */
+    all = (int *) malloc(2 * size * sizeof(int));
+    han_module->low_ranks = (int *) malloc(size * sizeof(int));
+    han_module->up_ranks = (int *) malloc(size * sizeof(int));
+    if (NULL == all || NULL == han_module->low_ranks || NULL == han_module->up_ranks) {
+        ret = OMPI_ERR_OUT_OF_RESOURCE;
+        goto exit;
+    }
+    mine[0] = low_rank;
+    mine[1] = ompi_comm_rank(han_module->up_comm);
+    ret = comm->c_coll->coll_allgather(mine, 2, MPI_INT, all, 2, MPI_INT, comm,
+                                       comm->c_coll->coll_allgather_module);
+    if (OMPI_SUCCESS != ret) {
+        goto exit;
+    }
+    han_module->in_order = true;
+    for (i = 0; i < size; ++i) {
+        han_module->low_ranks[i] = all[2 * i];
+        han_module->up_ranks[i] = all[2 * i + 1];
+        if (i != all[2 * i + 1] * han_module->low_size + all[2 * i]) {
+            han_module->in_order = false;
+        }
+    }
+
+    han_module->usable = true;
+    opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                        "coll:han:enable (%d/%s): %d nodes of %d processes%s",
+                        comm->c_contextid, comm->c_name, han_module->up_size,
+                        han_module->low_size, han_module->in_order ? ", numbered in order" : "");
+
+ exit:
+    free(all);
+    han_swap_coll_api(han_module, comm);
+    return ret;
+}
+
+int mca_coll_han_reorder(mca_coll_han_module_t *han_module, struct ompi_datatype_t *dtype,
+                         int count, char *rank_order, char *node_order, bool to_rank_order)
+{
+    int i, ret, size = han_module->low_size * han_module->up_size;
+    ptrdiff_t lb, extent;
+    char *block, *pos;
+
+    ompi_datatype_get_extent(dtype, &lb, &extent);
+    extent *= count;
+    for (i = 0; i < size; ++i) {
+        block = rank_order + i * extent;
+        pos = node_order + (han_module->up_ranks[i] * han_module->low_size +
+                            han_module->low_ranks[i]) * extent;
+        ret = ompi_datatype_copy_content_same_ddt(dtype, count,
+                                                  to_rank_order ? block : pos,
+                                                  to_rank_order ? pos : block);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+    }
+    return OMPI_SUCCESS;
+}
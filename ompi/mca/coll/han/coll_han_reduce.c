@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/op/op.h"
+#include "coll_han.h"
+
+/*
+ * Reduce: each node reduces a segment on the process with the rank of
+ * the root in the node, then these reduce it between the nodes on the
+ * root.  The leaders other than the root reduce in a temporary buffer.
+ */
+
+static int han_reduce_low(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *low_comm = req->module->low_comm;
+    int count = mca_coll_han_seg_count(req, seg);
+    const void *sbuf = req->sbuf;
+    void *rbuf = NULL;
+
+    if (ompi_comm_rank(low_comm) == req->root_low) {
+        rbuf = mca_coll_han_seg_addr(req, NULL != req->tmp ? req->tmp : req->rbuf, seg);
+    }
+    if (MPI_IN_PLACE != sbuf) {
+        sbuf = mca_coll_han_seg_addr(req, sbuf, seg);
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_reduce(sbuf, rbuf, count, req->dtype, req->op,
+                                             req->root_low, low_comm,
+                                             low_comm->c_coll->coll_reduce_module);
+    }
+    return low_comm->c_coll->coll_ireduce(sbuf, rbuf, count, req->dtype, req->op,
+                                          req->root_low, low_comm, sub,
+                                          low_comm->c_coll->coll_ireduce_module);
+}
+
+static int han_reduce_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    struct ompi_communicator_t *up_comm = req->module->up_comm;
+    const void *sbuf = MPI_IN_PLACE;
+    void *rbuf = NULL;
+
+    *sub = NULL;
+    if (ompi_comm_rank(req->module->low_comm) != req->root_low) {
+        return OMPI_SUCCESS;
+    }
+    if (NULL != req->tmp) {
+        sbuf = mca_coll_han_seg_addr(req, req->tmp, seg);
+    } else {
+        rbuf = mca_coll_han_seg_addr(req, req->rbuf, seg);
+    }
+    return up_comm->c_coll->coll_ireduce(sbuf, rbuf, mca_coll_han_seg_count(req, seg),
+                                         req->dtype, req->op, req->root_up, up_comm, sub,
+                                         up_comm->c_coll->coll_ireduce_module);
+}
+
+static int han_reduce(const void *sbuf, void *rbuf, int count,
+                      struct ompi_datatype_t *dtype, struct ompi_op_t *op, int root,
+                      struct ompi_communicator_t *comm, bool blocking,
+                      ompi_request_t **request, mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+    int ret;
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->sbuf = sbuf;
+    req->rbuf = rbuf;
+    req->dtype = dtype;
+    req->op = op;
+    req->root_low = han_module->low_ranks[root];
+    req->root_up = han_module->up_ranks[root];
+    mca_coll_han_request_set_segments(req, dtype, count);
+
+    if (ompi_comm_rank(han_module->low_comm) == req->root_low &&
+        ompi_comm_rank(comm) != root) {
+        ret = mca_coll_han_request_alloc_tmp(req, dtype, count);
+        if (OMPI_SUCCESS != ret) {
+            OBJ_RELEASE(req);
+            return ret;
+        }
+    }
+    mca_coll_han_request_add_stage(req, han_reduce_low, HAN_LANE_LOW);
+    mca_coll_han_request_add_stage(req, han_reduce_up, HAN_LANE_UP);
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_reduce_intra(const void *sbuf, void *rbuf, int count,
+                              struct ompi_datatype_t *dtype,
+                              struct ompi_op_t *op, int root,
+                              struct ompi_communicator_t *comm,
+                              mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    /* Reducing node by node changes the order of the operands */
+    if (!han_module->usable || (!ompi_op_is_commute(op) && !han_module->in_order)) {
+        return han_module->previous_reduce(sbuf, rbuf, count, dtype, op, root, comm,
+                                           han_module->previous_reduce_module);
+    }
+    return han_reduce(sbuf, rbuf, count, dtype, op, root, comm, true, NULL, han_module);
+}
+
+int mca_coll_han_ireduce_intra(const void *sbuf, void *rbuf, int count,
+                               struct ompi_datatype_t *dtype,
+                               struct ompi_op_t *op, int root,
+                               struct ompi_communicator_t *comm,
+                               ompi_request_t **request,
+                               mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable || (!ompi_op_is_commute(op) && !han_module->in_order)) {
+        return han_module->previous_ireduce(sbuf, rbuf, count, dtype, op, root, comm, request,
+                                            han_module->previous_ireduce_module);
+    }
+    return han_reduce(sbuf, rbuf, count, dtype, op, root, comm, false, request, han_module);
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <stdlib.h>
+
+#include "opal/runtime/opal_progress.h"
+#include "opal/mca/threads/mutex.h"
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/request/request.h"
+#include "ompi/mca/coll/base/coll_base_functions.h"
+#include "coll_han.h"
+
+static void han_request_construct(mca_coll_han_request_t *req)
+{
+    req->tmp = NULL;
+    req->tmp_base = NULL;
+}
+
+static void han_request_destruct(mca_coll_han_request_t *req)
+{
+    free(req->tmp_base);
+}
+
+OBJ_CLASS_INSTANCE(mca_coll_han_request_t, ompi_request_t,
+                   han_request_construct, han_request_destruct);
+
+static int han_request_free(ompi_request_t **request)
+{
+    OMPI_REQUEST_FINI(*request);
+    (*request)->req_state = OMPI_REQUEST_INVALID;
+    OBJ_RELEASE(*request);
+    *request = MPI_REQUEST_NULL;
+    return OMPI_SUCCESS;
+}
+
+static int han_request_cancel(ompi_request_t *request, int complete)
+{
+    return MPI_ERR_REQUEST;
+}
+
+mca_coll_han_request_t *mca_coll_han_request_alloc(mca_coll_han_module_t *han_module,
+                                                   bool blocking)
+{
+    mca_coll_han_request_t *req = OBJ_NEW(mca_coll_han_request_t);
+    int i;
+
+    if (NULL == req) {
+        return NULL;
+    }
+
+    OMPI_REQUEST_INIT(&req->super, false);
+    req->super.req_state = OMPI_REQUEST_ACTIVE;
+    req->super.req_type = OMPI_REQUEST_COLL;
+    req->super.req_free = han_request_free;
+    req->super.req_cancel = han_request_cancel;
+    req->super.req_status.MPI_SOURCE = 0;
+    req->super.req_status.MPI_TAG = 0;
+    req->super.req_status.MPI_ERROR = OMPI_SUCCESS;
+    req->super.req_status._cancelled = 0;
+    req->super.req_status._ucount = 0;
+
+    req->module = han_module;
+    req->blocking = blocking;
+    req->num_stages = 0;
+    req->fini = NULL;
+    req->num_segs = 1;
+    for (i = 0; i < HAN_MAX_STAGES; ++i) {
+        req->stage_done[i] = 0;
+    }
+    for (i = 0; i < HAN_LANE_COUNT; ++i) {
+        req->lane_req[i] = NULL;
+        req->lane_key[i] = 0;
+        req->lane_stage[i] = 0;
+    }
+    req->count = req->seg_count = 0;
+    req->extent = 0;
+
+    return req;
+}
+
+/*
+ * Cut count elements of dtype in segments of the segment_size MCA
+ * parameter.
+ */
+void mca_coll_han_request_set_segments(mca_coll_han_request_t *req,
+                                       struct ompi_datatype_t *dtype, int count)
+{
+    int seg_count = count;
+    size_t typelng;
+    ptrdiff_t lb;
+
+    ompi_datatype_type_size(dtype, &typelng);
+    ompi_datatype_get_extent(dtype, &lb, &req->extent);
+    COLL_BASE_COMPUTED_SEGCOUNT(mca_coll_han_component.han_segment_size, typelng, seg_count);
+
+    req->count = count;
+    req->seg_count = seg_count;
+    req->num_segs = (0 == seg_count) ? 1 : (count + seg_count - 1) / seg_count;
+}
+
+void mca_coll_han_request_add_stage(mca_coll_han_request_t *req,
+                                    mca_coll_han_stage_fn_t start, int lane)
+{
+    assert(req->num_stages < HAN_MAX_STAGES);
+    req->stages[req->num_stages].start = start;
+    req->stages[req->num_stages].lane = lane;
+    ++req->num_stages;
+}
+
+int mca_coll_han_request_alloc_tmp(mca_coll_han_request_t *req,
+                                   struct ompi_datatype_t *dtype, size_t count)
+{
+    ptrdiff_t lb, extent, true_lb, true_extent;
+
+    if (0 == count) {
+        return OMPI_SUCCESS;
+    }
+    ompi_datatype_get_extent(dtype, &lb, &extent);
+    ompi_datatype_get_true_extent(dtype, &true_lb, &true_extent);
+    req->tmp_base = (char *) malloc(true_extent + (count - 1) * extent);
+    if (NULL == req->tmp_base) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->tmp = req->tmp_base - true_lb;
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Find the next operation of a lane: for key = 0, 1, ... the stages
+ * of the lane k in order, on segment key - k.  Returns false when the
+ * lane is done.
+ */
+static bool han_lane_peek(mca_coll_han_request_t *req, int lane, int *stage, int *seg)
+{
+    int last_key = req->num_segs - 1 + req->num_stages - 1;
+
+    for (; req->lane_key[lane] <= last_key; ++req->lane_key[lane], req->lane_stage[lane] = 0) {
+        for (; req->lane_stage[lane] < req->num_stages; ++req->lane_stage[lane]) {
+            int s = req->lane_key[lane] - req->lane_stage[lane];
+
+            if (req->stages[req->lane_stage[lane]].lane == lane &&
+                s >= 0 && s < req->num_segs) {
+                *stage = req->lane_stage[lane];
+                *seg = s;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*
+ * Start what can be started and account for what completed.  Returns
+ * true once all the stages are done (or one failed).
+ */
+static bool han_request_advance(mca_coll_han_request_t *req)
+{
+    bool progress = true;
+    int lane, stage, seg, ret;
+
+    while (progress && OMPI_SUCCESS == req->super.req_status.MPI_ERROR) {
+        progress = false;
+        for (lane = 0; lane < HAN_LANE_COUNT; ++lane) {
+            ompi_request_t *sub = req->lane_req[lane];
+
+            if (NULL != sub) {
+                if (!REQUEST_COMPLETE(sub)) {
+                    continue;
+                }
+                ret = sub->req_status.MPI_ERROR;
+                ompi_request_free(&sub);
+                req->lane_req[lane] = NULL;
+                if (OMPI_SUCCESS != ret) {
+                    req->super.req_status.MPI_ERROR = ret;
+                    break;
+                }
+                ++req->stage_done[req->lane_stage[lane]];
+                ++req->lane_stage[lane];
+                progress = true;
+            }
+
+            if (!han_lane_peek(req, lane, &stage, &seg) ||
+                (stage > 0 && req->stage_done[stage - 1] <= seg)) {
+                continue;
+            }
+            ret = req->stages[stage].start(req, seg, &sub);
+            if (OMPI_SUCCESS != ret) {
+                req->super.req_status.MPI_ERROR = ret;
+                break;
+            }
+            if (NULL == sub) {
+                ++req->stage_done[stage];
+                ++req->lane_stage[lane];
+            } else {
+                req->lane_req[lane] = sub;
+            }
+            progress = true;
+        }
+    }
+
+    if (OMPI_SUCCESS != req->super.req_status.MPI_ERROR) {
+        /* Let the operations in flight complete before giving up */
+        for (lane = 0; lane < HAN_LANE_COUNT; ++lane) {
+            if (NULL != req->lane_req[lane]) {
+                if (!REQUEST_COMPLETE(req->lane_req[lane])) {
+                    return false;
+                }
+                ompi_request_free(&req->lane_req[lane]);
+                req->lane_req[lane] = NULL;
+            }
+        }
+        return true;
+    }
+
+    return req->stage_done[req->num_stages - 1] == req->num_segs;
+}
+
+static int han_request_finish(mca_coll_han_request_t *req)
+{
+    int ret = req->super.req_status.MPI_ERROR;
+
+    if (OMPI_SUCCESS == ret && NULL != req->fini) {
+        ret = req->fini(req);
+        req->super.req_status.MPI_ERROR = ret;
+    }
+    free(req->tmp_base);
+    req->tmp_base = req->tmp = NULL;
+    return ret;
+}
+
+int mca_coll_han_progress(void)
+{
+    static bool in_progress = false;
+    mca_coll_han_component_t *cs = &mca_coll_han_component;
+    mca_coll_han_request_t *req, *next;
+    int completed = 0;
+
+    if (opal_list_is_empty(&cs->han_requests)) {
+        return 0;
+    }
+
+    /* Starting an operation may call the progress engine */
+    if (0 != OPAL_THREAD_TRYLOCK(&cs->han_lock)) {
+        return 0;
+    }
+    if (in_progress) {
+        OPAL_THREAD_UNLOCK(&cs->han_lock);
+        return 0;
+    }
+    in_progress = true;
+    OPAL_LIST_FOREACH_SAFE(req, next, &cs->han_requests, mca_coll_han_request_t) {
+        if (han_request_advance(req)) {
+            opal_list_remove_item(&cs->han_requests, &req->super.super.super);
+            (void) han_request_finish(req);
+            ompi_request_complete(&req->super, true);
+            ++completed;
+        }
+    }
+    in_progress = false;
+    OPAL_THREAD_UNLOCK(&cs->han_lock);
+
+    return completed;
+}
+
+int mca_coll_han_request_start(mca_coll_han_request_t *req, ompi_request_t **request)
+{
+    mca_coll_han_component_t *cs = &mca_coll_han_component;
+    int ret;
+
+    if (req->blocking) {
+        /* The low stages are run here, the up one in flight
+           progresses meanwhile */
+        while (!han_request_advance(req)) {
+            opal_progress();
+        }
+        ret = han_request_finish(req);
+        OBJ_RELEASE(req);
+        return ret;
+    }
+
+    *request = &req->super;
+    if (han_request_advance(req)) {
+        (void) han_request_finish(req);
+        ompi_request_complete(&req->super, true);
+        return OMPI_SUCCESS;
+    }
+
+    OPAL_THREAD_LOCK(&cs->han_lock);
+    opal_list_append(&cs->han_requests, &req->super.super.super);
+    if (!cs->han_progress_registered) {
+        cs->han_progress_registered = true;
+        opal_progress_register(mca_coll_han_progress);
+    }
+    OPAL_THREAD_UNLOCK(&cs->han_lock);
+
+    return OMPI_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
+#include "coll_han.h"
+
+/*
+ * Scatter: the root scatters the blocks of each node on the processes
+ * with its rank in their node, which scatter them in their node.  The
+ * blocks are scattered from a temporary buffer, node after node, when
+ * the processes are not numbered this way, and the leaders other than
+ * the root receive them in a temporary buffer of their receive type.
+ *
+ * req->extent is the extent of the send type on the root and of the
+ * receive type on the other processes.
+ */
+
+static bool han_scatter_is_root(mca_coll_han_request_t *req)
+{
+    return ompi_comm_rank(req->module->low_comm) == req->root_low &&
+        ompi_comm_rank(req->module->up_comm) == req->root_up;
+}
+
+/* Buffer the root scatters the blocks from, node after node */
+static char *han_scatter_base(mca_coll_han_request_t *req)
+{
+    return req->module->in_order ? (char *) req->sbuf : req->tmp;
+}
+
+static int han_scatter_up(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *up_comm = han_module->up_comm;
+    int ret;
+
+    *sub = NULL;
+    if (ompi_comm_rank(han_module->low_comm) != req->root_low) {
+        return OMPI_SUCCESS;
+    }
+    if (han_scatter_is_root(req)) {
+        if (!han_module->in_order) {
+            ret = mca_coll_han_reorder(han_module, req->sdtype, req->scount,
+                                       (char *) req->sbuf, req->tmp, false);
+            if (OMPI_SUCCESS != ret) {
+                return ret;
+            }
+        }
+        return up_comm->c_coll->coll_iscatter(han_scatter_base(req),
+                                              han_module->low_size * req->scount, req->sdtype,
+                                              MPI_IN_PLACE, 0, req->rdtype, req->root_up,
+                                              up_comm, sub, up_comm->c_coll->coll_iscatter_module);
+    }
+    return up_comm->c_coll->coll_iscatter(NULL, 0, req->sdtype, req->tmp,
+                                          han_module->low_size * req->rcount, req->rdtype,
+                                          req->root_up, up_comm, sub,
+                                          up_comm->c_coll->coll_iscatter_module);
+}
+
+static int han_scatter_low(mca_coll_han_request_t *req, int seg, ompi_request_t **sub)
+{
+    mca_coll_han_module_t *han_module = req->module;
+    struct ompi_communicator_t *low_comm = han_module->low_comm;
+    int scount = req->scount;
+    struct ompi_datatype_t *sdtype = req->sdtype;
+    const char *sbuf = NULL;
+
+    if (han_scatter_is_root(req)) {
+        sbuf = han_scatter_base(req) +
+            (ptrdiff_t) req->root_up * han_module->low_size * scount * req->extent;
+    } else if (ompi_comm_rank(low_comm) == req->root_low) {
+        sbuf = req->tmp;
+        scount = req->rcount;
+        sdtype = req->rdtype;
+    }
+
+    *sub = NULL;
+    if (req->blocking) {
+        return low_comm->c_coll->coll_scatter(sbuf, scount, sdtype, req->rbuf, req->rcount,
+                                              req->rdtype, req->root_low, low_comm,
+                                              low_comm->c_coll->coll_scatter_module);
+    }
+    return low_comm->c_coll->coll_iscatter(sbuf, scount, sdtype, req->rbuf, req->rcount,
+                                           req->rdtype, req->root_low, low_comm, sub,
+                                           low_comm->c_coll->coll_iscatter_module);
+}
+
+static int han_scatter(const void *sbuf, int scount, struct ompi_datatype_t *sdtype,
+                       void *rbuf, int rcount, struct ompi_datatype_t *rdtype, int root,
+                       struct ompi_communicator_t *comm, bool blocking,
+                       ompi_request_t **request, mca_coll_han_module_t *han_module)
+{
+    mca_coll_han_request_t *req = mca_coll_han_request_alloc(han_module, blocking);
+    int ret = OMPI_SUCCESS;
+    ptrdiff_t lb;
+
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    req->sbuf = sbuf;
+    req->scount = scount;
+    req->sdtype = sdtype;
+    req->rbuf = rbuf;
+    req->rcount = rcount;
+    req->rdtype = rdtype;
+    req->root = root;
+    req->root_low = han_module->low_ranks[root];
+    req->root_up = han_module->up_ranks[root];
+
+    if (ompi_comm_rank(comm) == root) {
+        ompi_datatype_get_extent(sdtype, &lb, &req->extent);
+        if (!han_module->in_order) {
+            ret = mca_coll_han_request_alloc_tmp(req, sdtype,
+                                                 (size_t) ompi_comm_size(comm) * scount);
+        }
+    } else {
+        ompi_datatype_get_extent(rdtype, &lb, &req->extent);
+        if (ompi_comm_rank(han_module->low_comm) == req->root_low) {
+            ret = mca_coll_han_request_alloc_tmp(req, rdtype,
+                                                 (size_t) han_module->low_size * rcount);
+        }
+    }
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(req);
+        return ret;
+    }
+    mca_coll_han_request_add_stage(req, han_scatter_up, HAN_LANE_UP);
+    mca_coll_han_request_add_stage(req, han_scatter_low, HAN_LANE_LOW);
+
+    return mca_coll_han_request_start(req, request);
+}
+
+int mca_coll_han_scatter_intra(const void *sbuf, int scount,
+                               struct ompi_datatype_t *sdtype,
+                               void *rbuf, int rcount,
+                               struct ompi_datatype_t *rdtype,
+                               int root, struct ompi_communicator_t *comm,
+                               mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_scatter(sbuf, scount, sdtype, rbuf, rcount, rdtype, root,
+                                            comm, han_module->previous_scatter_module);
+    }
+    return han_scatter(sbuf, scount, sdtype, rbuf, rcount, rdtype, root, comm, true, NULL,
+                       han_module);
+}
+
+int mca_coll_han_iscatter_intra(const void *sbuf, int scount,
+                                struct ompi_datatype_t *sdtype,
+                                void *rbuf, int rcount,
+                                struct ompi_datatype_t *rdtype,
+                                int root, struct ompi_communicator_t *comm,
+                                ompi_request_t **request,
+                                mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t *) module;
+    int ret;
+
+    ret = mca_coll_han_lazy_enable(han_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (!han_module->usable) {
+        return han_module->previous_iscatter(sbuf, scount, sdtype, rbuf, rcount, rdtype, root,
+                                             comm, request, han_module->previous_iscatter_module);
+    }
+    return han_scatter(sbuf, scount, sdtype, rbuf, rcount, rdtype, root, comm, false, request,
+                       han_module);
+}
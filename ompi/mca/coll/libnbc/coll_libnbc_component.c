@@ -72,6 +72,7 @@ static mca_base_var_enum_value_t ibcast_algorithms[] = {
     {2, "binomial"},
     {3, "chain"},
     {4, "knomial"},
+    {5, "topo_binomial"},
     {0, NULL}
 };
 
@@ -236,7 +237,7 @@ libnbc_register(void)
     (void) mca_base_var_enum_create("coll_libnbc_ibcast_algorithms", ibcast_algorithms, &new_enum);
     mca_base_component_var_register(&mca_coll_libnbc_component.super.collm_version,
                                     "ibcast_algorithm",
-                                    "Which ibcast algorithm is used: 0 ignore, 1 linear, 2 binomial, 3 chain, 4 knomial",
+                                    "Which ibcast algorithm is used: 0 ignore, 1 linear, 2 binomial, 3 chain, 4 knomial, 5 topo_binomial (binomial tree following the nodes and packages)",
                                     MCA_BASE_VAR_TYPE_INT, new_enum, 0, MCA_BASE_VAR_FLAG_SETTABLE,
                                     OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_ALL,
                                     &libnbc_ibcast_algorithm);
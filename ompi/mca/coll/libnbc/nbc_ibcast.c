@@ -19,6 +19,7 @@
  *
  */
 #include "nbc_internal.h"
+#include "ompi/mca/coll/base/coll_base_topo.h"
 
 static inline int bcast_sched_binomial(int rank, int p, int root, NBC_Schedule *schedule, void *buffer, int count,
                                        MPI_Datatype datatype);
@@ -28,6 +29,8 @@ static inline int bcast_sched_chain(int rank, int p, int root, NBC_Schedule *sch
                                     MPI_Datatype datatype, int fragsize, size_t size);
 static inline int bcast_sched_knomial(int rank, int comm_size, int root, NBC_Schedule *schedule, void *buf,
                                       int count, MPI_Datatype datatype, int knomial_radix);
+static inline int bcast_sched_tree(int rank, ompi_coll_tree_t *tree, NBC_Schedule *schedule, void *buf,
+                                   int count, MPI_Datatype datatype);
 
 #ifdef NBC_CACHE_SCHEDULE
 /* tree comparison function for schedule cache */
@@ -57,7 +60,7 @@ static int nbc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int ro
 #ifdef NBC_CACHE_SCHEDULE
   NBC_Bcast_args *args, *found, search;
 #endif
-  enum { NBC_BCAST_LINEAR, NBC_BCAST_BINOMIAL, NBC_BCAST_CHAIN, NBC_BCAST_KNOMIAL } alg;
+  enum { NBC_BCAST_LINEAR, NBC_BCAST_BINOMIAL, NBC_BCAST_CHAIN, NBC_BCAST_KNOMIAL, NBC_BCAST_TOPO } alg;
   ompi_coll_libnbc_module_t *libnbc_module = (ompi_coll_libnbc_module_t*) module;
 
   rank = ompi_comm_rank (comm);
@@ -107,6 +110,8 @@ static int nbc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int ro
       alg = NBC_BCAST_CHAIN;
     } else if (libnbc_ibcast_algorithm == 4 && libnbc_ibcast_knomial_radix > 1) {
       alg = NBC_BCAST_KNOMIAL;
+    } else if (libnbc_ibcast_algorithm == 5) {
+      alg = NBC_BCAST_TOPO;
     } else {
       alg = NBC_BCAST_LINEAR;
     }
@@ -139,6 +144,16 @@ static int nbc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int ro
       case NBC_BCAST_KNOMIAL:
         res = bcast_sched_knomial(rank, p, root, schedule, buffer, count, datatype, libnbc_ibcast_knomial_radix);
         break;
+      case NBC_BCAST_TOPO: {
+        ompi_coll_tree_t *tree = ompi_coll_base_topo_build_topoaware_bmtree(comm, root);
+        if (OPAL_UNLIKELY(NULL == tree)) {
+          res = OMPI_ERR_OUT_OF_RESOURCE;
+          break;
+        }
+        res = bcast_sched_tree(rank, tree, schedule, buffer, count, datatype);
+        ompi_coll_base_topo_destroy_tree(&tree);
+        break;
+      }
     }
 
     if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
@@ -408,6 +423,31 @@ cleanup_and_return:
     return res;
 }
 
+/*
+ * bcast_sched_tree:
+ *
+ * Description: Ibcast along a tree of coll/base, the binomial tree built
+ *              from the node and package of the processes for
+ *              NBC_BCAST_TOPO, which sends to the other nodes first and
+ *              to the other packages next.
+ */
+static inline int bcast_sched_tree(
+    int rank, ompi_coll_tree_t *tree, NBC_Schedule *schedule, void *buf,
+    int count, MPI_Datatype datatype)
+{
+    int res;
+
+    if (rank != tree->tree_root) {
+        res = NBC_Sched_recv(buf, false, count, datatype, tree->tree_prev, schedule, true);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) { return res; }
+    }
+    for (int i = 0; i < tree->tree_nextsize; i++) {
+        res = NBC_Sched_send(buf, false, count, datatype, tree->tree_next[i], schedule, false);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) { return res; }
+    }
+    return OMPI_SUCCESS;
+}
+
 static int nbc_bcast_inter_init(void *buffer, int count, MPI_Datatype datatype, int root,
                                 struct ompi_communicator_t *comm, ompi_request_t ** request,
                                 struct mca_coll_base_module_2_3_0_t *module, bool persistent) {
@@ -35,6 +35,12 @@ BEGIN_C_DECLS
 
 /*********************** LibPNBC_OSC tuning parameters ************************/
 
+/* radix of the k-nomial trees used by the persistent tree-based collectives */
+extern int libpnbc_osc_tree_radix;
+
+/* use a shared memory window and direct copies for the persistent alltoallv
+ * when all processes of the communicator are on the same node */
+extern bool libpnbc_osc_alltoallv_shm;
 
 /********************* end of LibPNBC_OSC tuning parameters ************************/
 
@@ -58,11 +64,55 @@ OBJ_CLASS_DECLARATION(ompi_coll_libpnbc_osc_module_t);
 
 int ompi_coll_libpnbc_osc_progress(void);
 
+int ompi_coll_libpnbc_osc_allgather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_allreduce_init(const void* sendbuf, void* recvbuf, int count,
+                        MPI_Datatype datatype, MPI_Op op,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
 int ompi_coll_libpnbc_osc_alltoallv_init(const void* sendbuf, const int *sendcounts, const int *sdispls,
                         MPI_Datatype sendtype, void* recvbuf, const int *recvcounts, const int *rdispls,
                         MPI_Datatype recvtype, struct ompi_communicator_t *comm, struct ompi_info_t *,
                         ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
 
+int ompi_coll_libpnbc_osc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int root,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_gather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_neighbor_allgather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_neighbor_allgatherv_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, const int *recvcounts, const int *rdispls, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_neighbor_alltoall_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_neighbor_alltoallv_init(const void* sendbuf, const int *sendcounts, const int *sdispls,
+                        MPI_Datatype sendtype, void* recvbuf, const int *recvcounts, const int *rdispls,
+                        MPI_Datatype recvtype, struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
+int ompi_coll_libpnbc_osc_scatter_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                        struct ompi_communicator_t *comm, struct ompi_info_t *info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module);
+
 
 END_C_DECLS
 
@@ -68,6 +68,9 @@ static mca_base_var_enum_value_t ibcast_algorithms[] = {
     {0, NULL}
 };
 
+int libpnbc_osc_tree_radix = 2;
+bool libpnbc_osc_alltoallv_shm = true;
+
 int libpnbc_osc_iexscan_algorithm = 0;             /* iexscan user forced algorithm */
 static mca_base_var_enum_value_t iexscan_algorithms[] = {
     {0, "ignore"},
@@ -243,6 +246,22 @@ libpnbc_osc_register(void)
                                            MCA_BASE_VAR_SCOPE_READONLY,
                                            &libpnbc_osc_ibcast_knomial_radix);
 
+    libpnbc_osc_tree_radix = 2;
+    (void) mca_base_component_var_register(&mca_coll_libpnbc_osc_component.super.collm_version,
+                                           "tree_radix", "k-nomial tree radix for the persistent bcast, gather, scatter and allgather (radix > 1, 2 is binomial)",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &libpnbc_osc_tree_radix);
+
+    libpnbc_osc_alltoallv_shm = true;
+    (void) mca_base_component_var_register(&mca_coll_libpnbc_osc_component.super.collm_version,
+                                           "alltoallv_shm", "Use a shared memory window and direct copies for the persistent alltoallv when all processes of the communicator are on the same node",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &libpnbc_osc_alltoallv_shm);
+
     libpnbc_osc_iexscan_algorithm = 0;
     (void) mca_base_var_enum_create("coll_libpnbc_osc_iexscan_algorithms", iexscan_algorithms, &new_enum);
     mca_base_component_var_register(&mca_coll_libpnbc_osc_component.super.collm_version,
@@ -368,28 +387,28 @@ libpnbc_osc_comm_query(struct ompi_communicator_t *comm,
         module->super.coll_ineighbor_alltoallv = NULL;
         module->super.coll_ineighbor_alltoallw = NULL;
 
-        module->super.coll_allgather_init = NULL;
+        module->super.coll_allgather_init = ompi_coll_libpnbc_osc_allgather_init;
         module->super.coll_allgatherv_init = NULL;
-        module->super.coll_allreduce_init = NULL;
+        module->super.coll_allreduce_init = ompi_coll_libpnbc_osc_allreduce_init;
         module->super.coll_alltoall_init = NULL;
         module->super.coll_alltoallv_init = ompi_coll_libpnbc_osc_alltoallv_init;
         module->super.coll_alltoallw_init = NULL;
         module->super.coll_barrier_init = NULL;
-        module->super.coll_bcast_init = NULL;
+        module->super.coll_bcast_init = ompi_coll_libpnbc_osc_bcast_init;
         module->super.coll_exscan_init = NULL;
-        module->super.coll_gather_init = NULL;
+        module->super.coll_gather_init = ompi_coll_libpnbc_osc_gather_init;
         module->super.coll_gatherv_init = NULL;
         module->super.coll_reduce_init = NULL;
         module->super.coll_reduce_scatter_init = NULL;
         module->super.coll_reduce_scatter_block_init = NULL;
         module->super.coll_scan_init = NULL;
-        module->super.coll_scatter_init = NULL;
+        module->super.coll_scatter_init = ompi_coll_libpnbc_osc_scatter_init;
         module->super.coll_scatterv_init = NULL;
 
-        module->super.coll_neighbor_allgather_init = NULL;
-        module->super.coll_neighbor_allgatherv_init = NULL;
-        module->super.coll_neighbor_alltoall_init = NULL;
-        module->super.coll_neighbor_alltoallv_init = NULL;
+        module->super.coll_neighbor_allgather_init = ompi_coll_libpnbc_osc_neighbor_allgather_init;
+        module->super.coll_neighbor_allgatherv_init = ompi_coll_libpnbc_osc_neighbor_allgatherv_init;
+        module->super.coll_neighbor_alltoall_init = ompi_coll_libpnbc_osc_neighbor_alltoall_init;
+        module->super.coll_neighbor_alltoallv_init = ompi_coll_libpnbc_osc_neighbor_alltoallv_init;
         module->super.coll_neighbor_alltoallw_init = NULL;
     }
 
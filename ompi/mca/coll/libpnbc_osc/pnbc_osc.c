@@ -40,6 +40,13 @@ int PNBC_OSC_Start(PNBC_OSC_Handle *handle) {
     return OMPI_ERR_BAD_PARAM;
   }
 
+  // every trigger must fire exactly once before this instance of the operation is complete
+  trigger_bitmap_arm(&(handle->schedule->trigger_bitmap));
+  handle->schedule->triggers_active = handle->schedule->triggers_length;
+
+  // fire the start trigger(s) - no communication happens here, it is all done by progress
+  handle->schedule->start_pending = !0;
+
   // change state of request to ACTIVE, permits progress for this request
   handle->super.req_state = OMPI_REQUEST_ACTIVE;
 
@@ -57,43 +64,35 @@ int PNBC_OSC_Start(PNBC_OSC_Handle *handle) {
  * to be called *only* from the progress thread !!! */
 int PNBC_OSC_Progress(PNBC_OSC_Handle *handle) {
   enum TRIGGER_ACTION_STATE state;
-
-  // assume trigger-based - old NBC-data way is an error
-  if (OPAL_UNLIKELY(NULL != handle->schedule->data)) {
-    return OMPI_ERR_BAD_PARAM;
-  }
-
-  // assume trigger-based - hybrid round-based is an error
-  if (OPAL_UNLIKELY(NULL != handle->schedule->rounds)) {
-    return OMPI_ERR_BAD_PARAM;
-  }
+  PNBC_OSC_Schedule *schedule = handle->schedule;
+  int fired = 0;
 
   // protection against progression error - should never happen
   if (OPAL_UNLIKELY(OMPI_REQUEST_ACTIVE != handle->super.req_state)) {
     return OMPI_ERR_BAD_PARAM;
   }
 
-  // test each triggerable in the schedule
-  for (int t=0;t<handle->schedule->triggers_length;++t) {
-    state = trigger_test(&(handle->schedule->triggers[t]));
-    if (OPAL_UNLIKELY(ACTION_PROBLEM == state)) {
-      return OMPI_ERR_NOT_SUPPORTED;
-    }
+  // test the triggers that have not yet fired during this start and whose flag or request is ready
+  state = trigger_bitmap_test(&(schedule->trigger_bitmap), schedule->triggers,
+                              schedule->flags, schedule->flags_seen,
+                              (void *const *)schedule->requests, &fired);
+  schedule->triggers_active -= fired;
+  if (OPAL_UNLIKELY(ACTION_PROBLEM == state)) {
+    return OMPI_ERR_NOT_SUPPORTED;
   }
 
   // test each trigger_array in the schedule
-  for (int t=0;t<handle->schedule->trigger_arrays_length;++t) {
-    state = trigger_test_all(&(handle->schedule->trigger_arrays[t]));
+  for (int t=0;t<schedule->trigger_arrays_length;++t) {
+    state = trigger_test_all(&(schedule->trigger_arrays[t]));
     if (OPAL_UNLIKELY(ACTION_PROBLEM == state)) {
       return OMPI_ERR_NOT_SUPPORTED;
     }
   }
 
-  // check new state of this request (will eventually have been changed by a trigger)
-  if (OMPI_REQUEST_ACTIVE == handle->super.req_state) {
+  // this instance of the operation is complete when all triggers have fired
+  if (0 == schedule->triggers_active) {
     return PNBC_OSC_SUCCESS;
   } else {
     return PNBC_OSC_CONTINUE;
   }
 }
-
@@ -0,0 +1,35 @@
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_action_accumulate.h"
+
+static enum TRIGGER_ACTION_STATE action_all_accumulate(accumulate_args_t *accumulate_args){
+  int ret = ACTION_SUCCESS;
+
+PNBC_OSC_DEBUG(5,"*buf: %p, origin count: %i, origin type: %p, target: %i, target count: %i, target type: %p, target displ: %lu)\n",
+                     accumulate_args->buf, accumulate_args->origin_count, accumulate_args->origin_datatype,
+                     accumulate_args->target, accumulate_args->target_count,
+                     accumulate_args->target_datatype, accumulate_args->target_displ);
+
+  ret = accumulate_args->win->w_osc_module->osc_raccumulate(accumulate_args->buf,
+                                                            accumulate_args->origin_count,
+                                                            accumulate_args->origin_datatype,
+                                                            accumulate_args->target,
+                                                            accumulate_args->target_displ,
+                                                            accumulate_args->target_count,
+                                                            accumulate_args->target_datatype,
+                                                            accumulate_args->op,
+                                                            accumulate_args->win,
+                                                            accumulate_args->request);
+
+  if (OMPI_SUCCESS != ret) {
+    PNBC_OSC_Error("Error in osc_raccumulate(%p, %i, %p, %i, %lu, %i, %p) (%i)",
+                   accumulate_args->buf, accumulate_args->origin_count,
+                   accumulate_args->origin_datatype, accumulate_args->target,
+                   accumulate_args->target_displ, accumulate_args->target_count,
+                   accumulate_args->target_datatype, ret);
+    ret = ACTION_PROBLEM;
+  }
+
+  return ret;
+}
+
+trigger_action_all_cb_fn_t action_all_accumulate_p = (trigger_action_all_cb_fn_t)action_all_accumulate;
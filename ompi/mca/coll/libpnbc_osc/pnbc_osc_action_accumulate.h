@@ -0,0 +1,26 @@
+#ifndef PNBC_OSC_ACTION_ACCUMULATE_H
+#define PNBC_OSC_ACTION_ACCUMULATE_H
+
+#include "pnbc_osc_trigger_common.h"
+#include "ompi/request/request.h"
+#include "ompi/win/win.h"
+
+struct accumulate_args_t {
+  const void *buf;
+  int origin_count;
+  MPI_Datatype origin_datatype;
+  int target;
+  MPI_Aint target_displ;
+  int target_count;
+  MPI_Datatype target_datatype;
+  MPI_Op op;
+  MPI_Win win;
+  MPI_Request *request;
+};
+typedef struct accumulate_args_t accumulate_args_t;
+
+
+//static enum TRIGGER_ACTION_STATE action_all_accumulate(accumulate_args_t *accumulate_args);
+extern trigger_action_all_cb_fn_t action_all_accumulate_p;
+
+#endif
@@ -1,14 +1,24 @@
 #ifndef PNBC_OSC_ACTION_COMMON_H
 #define PNBC_OSC_ACTION_COMMON_H
 
+#include "pnbc_osc_action_accumulate.h"
+#include "pnbc_osc_action_copy.h"
 #include "pnbc_osc_action_decrement.h"
 #include "pnbc_osc_action_get.h"
 #include "pnbc_osc_action_put.h"
+#include "pnbc_osc_action_reduce.h"
+#include "pnbc_osc_action_sequence.h"
+#include "pnbc_osc_action_signal.h"
 
 union any_args_t {
+  accumulate_args_t accumulate_args;
+  copy_args_t copy_args;
   dec_args_t dec_args;
   get_args_t get_args;
   put_args_t put_args;
+  reduce_args_t reduce_args;
+  seq_args_t seq_args;
+  signal_args_t signal_args;
 };
 typedef union any_args_t any_args_t;
 
@@ -0,0 +1,29 @@
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_action_copy.h"
+
+static enum TRIGGER_ACTION_STATE action_all_copy(copy_args_t *copy_args) {
+  int ret = ACTION_SUCCESS;
+
+PNBC_OSC_DEBUG(5,"*src: %p, srccount: %i, srctype: %p, *tgt: %p, tgtcount: %i, tgttype: %p)\n",
+                     copy_args->src, copy_args->srccount, copy_args->srctype,
+                     copy_args->tgt, copy_args->tgtcount, copy_args->tgttype);
+
+  ret = ompi_datatype_sndrcv(copy_args->src, copy_args->srccount, copy_args->srctype,
+                             copy_args->tgt, copy_args->tgtcount, copy_args->tgttype);
+  if (OMPI_SUCCESS != ret) {
+    PNBC_OSC_Error("Error in ompi_datatype_sndrcv(%p, %i, %p, %p, %i, %p) (%i)",
+                   copy_args->src, copy_args->srccount, copy_args->srctype,
+                   copy_args->tgt, copy_args->tgtcount, copy_args->tgttype, ret);
+    ret = ACTION_PROBLEM;
+  }
+
+  return ret;
+}
+
+trigger_action_all_cb_fn_t action_all_copy_p = (trigger_action_all_cb_fn_t)action_all_copy;
+
+static enum TRIGGER_ACTION_STATE action_one_copy(int index, copy_args_t *copy_args) {
+  return action_all_copy(copy_args);
+}
+
+trigger_action_one_cb_fn_t action_one_copy_p = (trigger_action_one_cb_fn_t)action_one_copy;
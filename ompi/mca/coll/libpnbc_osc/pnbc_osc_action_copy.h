@@ -0,0 +1,23 @@
+#ifndef PNBC_OSC_ACTION_COPY_H
+#define PNBC_OSC_ACTION_COPY_H
+
+#include "pnbc_osc_trigger_common.h"
+#include "ompi/datatype/ompi_datatype.h"
+
+struct copy_args_t {
+  const void *src;
+  int srccount;
+  MPI_Datatype srctype;
+  void *tgt;
+  int tgtcount;
+  MPI_Datatype tgttype;
+};
+typedef struct copy_args_t copy_args_t;
+
+//static enum TRIGGER_ACTION_STATE action_all_copy(copy_args_t *copy_args);
+extern trigger_action_all_cb_fn_t action_all_copy_p;
+
+//static enum TRIGGER_ACTION_STATE action_one_copy(int index, copy_args_t *copy_args);
+extern trigger_action_one_cb_fn_t action_one_copy_p;
+
+#endif
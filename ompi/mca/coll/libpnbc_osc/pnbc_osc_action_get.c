@@ -26,6 +26,7 @@ PNBC_OSC_DEBUG(5,"*buf: %p, origin count: %i, origin type: %p, target: %i, targe
                        get_args->target, get_args->target_displ,
                        get_args->target_count, get_args->target_datatype,
                        ret);
+        ret = ACTION_PROBLEM;
       }
 
 #ifdef PNBC_OSC_TIMING
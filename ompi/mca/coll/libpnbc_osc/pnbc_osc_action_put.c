@@ -25,6 +25,7 @@ PNBC_OSC_DEBUG(5,"*buf: %p, origin count: %i, origin type: %p, target: %i, targe
 		   put_args->origin_datatype, put_args->target, 
 		   put_args->target_displ, put_args->target_count, 
 		   put_args->target_datatype, ret);
+    ret = ACTION_PROBLEM;
   }
 
 
@@ -0,0 +1,35 @@
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_action_reduce.h"
+
+static enum TRIGGER_ACTION_STATE action_all_reduce(reduce_args_t *reduce_args) {
+  int ret = ACTION_SUCCESS;
+
+PNBC_OSC_DEBUG(5,"*source: %p, *target: %p, *copy target: %p, count: %i, type: %p, op: %p)\n",
+                     reduce_args->source, reduce_args->target, reduce_args->copy_target,
+                     reduce_args->count, reduce_args->datatype, reduce_args->op);
+
+  ompi_op_reduce(reduce_args->op, reduce_args->source, reduce_args->target,
+                 reduce_args->count, reduce_args->datatype);
+
+  if (NULL != reduce_args->copy_target) {
+    ret = ompi_datatype_copy_content_same_ddt(reduce_args->datatype, reduce_args->count,
+                                              (char*)reduce_args->copy_target,
+                                              (char*)reduce_args->target);
+    if (OMPI_SUCCESS != ret) {
+      PNBC_OSC_Error("Error in ompi_datatype_copy_content_same_ddt(%p, %i, %p, %p) (%i)",
+                     reduce_args->datatype, reduce_args->count,
+                     reduce_args->copy_target, reduce_args->target, ret);
+      ret = ACTION_PROBLEM;
+    }
+  }
+
+  return ret;
+}
+
+trigger_action_all_cb_fn_t action_all_reduce_p = (trigger_action_all_cb_fn_t)action_all_reduce;
+
+static enum TRIGGER_ACTION_STATE action_one_reduce(int index, reduce_args_t *reduce_args) {
+  return action_all_reduce(reduce_args);
+}
+
+trigger_action_one_cb_fn_t action_one_reduce_p = (trigger_action_one_cb_fn_t)action_one_reduce;
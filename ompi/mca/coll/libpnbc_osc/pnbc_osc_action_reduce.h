@@ -0,0 +1,26 @@
+#ifndef PNBC_OSC_ACTION_REDUCE_H
+#define PNBC_OSC_ACTION_REDUCE_H
+
+#include "pnbc_osc_trigger_common.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/op/op.h"
+
+// target = source op target, then copied to copy_target (if non-NULL)
+// the copy lets a schedule compute 'local op remote' for non-commutative ops
+struct reduce_args_t {
+  void *source;
+  void *target;
+  void *copy_target;
+  int count;
+  MPI_Datatype datatype;
+  MPI_Op op;
+};
+typedef struct reduce_args_t reduce_args_t;
+
+//static enum TRIGGER_ACTION_STATE action_all_reduce(reduce_args_t *reduce_args);
+extern trigger_action_all_cb_fn_t action_all_reduce_p;
+
+//static enum TRIGGER_ACTION_STATE action_one_reduce(int index, reduce_args_t *reduce_args);
+extern trigger_action_one_cb_fn_t action_one_reduce_p;
+
+#endif
@@ -0,0 +1,21 @@
+#include "pnbc_osc_action_sequence.h"
+
+static enum TRIGGER_ACTION_STATE action_all_sequence(seq_args_t *seq_args) {
+  int ret = ACTION_SUCCESS;
+
+  for (int a=0;a<seq_args->num_actions;++a) {
+    ret = seq_args->actions[a](seq_args->cbstates[a]);
+    if (ACTION_SUCCESS != ret)
+      break;
+  }
+
+  return ret;
+}
+
+trigger_action_all_cb_fn_t action_all_sequence_p = (trigger_action_all_cb_fn_t)action_all_sequence;
+
+static enum TRIGGER_ACTION_STATE action_one_sequence(int index, seq_args_t *seq_args) {
+  return action_all_sequence(seq_args);
+}
+
+trigger_action_one_cb_fn_t action_one_sequence_p = (trigger_action_one_cb_fn_t)action_one_sequence;
@@ -0,0 +1,30 @@
+#ifndef PNBC_OSC_ACTION_SEQUENCE_H
+#define PNBC_OSC_ACTION_SEQUENCE_H
+
+#include "pnbc_osc_trigger_common.h"
+
+#define PNBC_OSC_SEQUENCE_MAX_ACTIONS 4
+
+// performs several actions, in order, for one trigger
+// e.g. start a put and then decrement the counter of a dependent trigger
+struct seq_args_t {
+  int num_actions;
+  trigger_action_all_cb_fn_t actions[PNBC_OSC_SEQUENCE_MAX_ACTIONS];
+  void *cbstates[PNBC_OSC_SEQUENCE_MAX_ACTIONS];
+};
+typedef struct seq_args_t seq_args_t;
+
+static inline void action_sequence_append(seq_args_t *seq_args,
+                                          trigger_action_all_cb_fn_t action, void *cbstate) {
+  seq_args->actions[seq_args->num_actions] = action;
+  seq_args->cbstates[seq_args->num_actions] = cbstate;
+  ++seq_args->num_actions;
+}
+
+//static enum TRIGGER_ACTION_STATE action_all_sequence(seq_args_t *seq_args);
+extern trigger_action_all_cb_fn_t action_all_sequence_p;
+
+//static enum TRIGGER_ACTION_STATE action_one_sequence(int index, seq_args_t *seq_args);
+extern trigger_action_one_cb_fn_t action_one_sequence_p;
+
+#endif
@@ -0,0 +1,13 @@
+#include "opal/sys/atomic.h"
+#include "pnbc_osc_action_signal.h"
+
+// the shared memory counterpart of an accumulate of 1 into the flags window:
+// every load and store made before the signal (e.g. the copy out of the data
+// of the process that is signalled) completes before the flag is incremented
+static enum TRIGGER_ACTION_STATE action_all_signal_int(signal_args_t *const signal_args) {
+  opal_atomic_mb();
+  opal_atomic_add_fetch_32((opal_atomic_int32_t*)signal_args, 1);
+  return ACTION_SUCCESS;
+}
+
+trigger_action_all_cb_fn_t action_all_signal_int_p = (trigger_action_all_cb_fn_t)action_all_signal_int;
@@ -0,0 +1,12 @@
+#ifndef PNBC_OSC_ACTION_SIGNAL_H
+#define PNBC_OSC_ACTION_SIGNAL_H
+
+#include "pnbc_osc_trigger_common.h"
+
+// the flag of another process in a shared memory segment
+typedef FLAG_t signal_args_t;
+
+//static enum TRIGGER_ACTION_STATE action_all_signal_int(signal_args_t *signal_args);
+extern trigger_action_all_cb_fn_t action_all_signal_int_p;
+
+#endif
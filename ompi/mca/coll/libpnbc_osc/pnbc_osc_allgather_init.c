@@ -0,0 +1,173 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_action_common.h"
+#include "pnbc_osc_helper_win.h"
+#include "pnbc_osc_helper_tree.h"
+
+static inline int pnbc_osc_allgather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                              void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                              struct ompi_communicator_t *comm, MPI_Info info,
+                              ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent);
+
+int ompi_coll_libpnbc_osc_allgather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+
+    int res = pnbc_osc_allgather_init(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                                      comm, info, request, module, true);
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+        return res;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+// k-nomial tree gather to rank 0 followed by a k-nomial tree broadcast from rank 0,
+// both working on one scratch buffer that holds the packed blocks of all processes
+// in rank order; every process finally unpacks the whole buffer into recvbuf
+static int pnbc_osc_allgather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                  struct ompi_communicator_t *comm, MPI_Info info,
+                  ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent)
+{
+  int res;
+  char inplace;
+  MPI_Aint rcvext;
+  size_t rcvsize, blk, tmpsize;
+  PNBC_OSC_Schedule *schedule;
+  PNBC_OSC_Pull_step *steps = NULL;
+  MPI_Aint *addrs_other = NULL;
+  copy_args_t start_copy, unpack;
+  int crank, csize, radix, nsteps = 0, ntreeslots;
+  MPI_Win win = MPI_WIN_NULL;
+  ompi_coll_libpnbc_osc_module_t *libpnbc_osc_module = (ompi_coll_libpnbc_osc_module_t*) module;
+
+  crank = ompi_comm_rank(comm);
+  csize = ompi_comm_size(comm);
+
+  PNBC_OSC_IN_PLACE(sendbuf, recvbuf, inplace);
+
+  res = ompi_datatype_type_extent(recvtype, &rcvext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+  ompi_datatype_type_size(recvtype, &rcvsize);
+  blk = rcvsize * recvcount;
+
+  if (0 == blk) {
+    return nbc_get_noop_request(persistent, request);
+  }
+
+  radix = (1 < libpnbc_osc_tree_radix) ? libpnbc_osc_tree_radix : 2;
+  ntreeslots = pnbc_osc_tree_num_slots(csize, radix);
+  tmpsize = csize * blk;
+
+  schedule = OBJ_NEW(PNBC_OSC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  // packed blocks of all processes, allocated once and reused by every start
+  schedule->tmpbuf = malloc(tmpsize);
+  // gather: one step for each child and one to the parent,
+  // bcast: one step from the parent and one for each child, then one unpack step
+  steps = (PNBC_OSC_Pull_step*)malloc((2 * ntreeslots + 3) * sizeof(PNBC_OSC_Pull_step));
+  addrs_other = (MPI_Aint*)malloc(csize * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == schedule->tmpbuf || NULL == steps || NULL == addrs_other)) {
+    res = OMPI_ERR_OUT_OF_RESOURCE;
+    goto cleanup;
+  }
+
+  // the gather uses the first half of the flag slots, the broadcast the second half
+  res = PNBC_OSC_Sched_pull_alloc(schedule, 2 * ntreeslots + 3, 2 * ntreeslots);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    goto cleanup;
+  }
+
+  // expose the packed blocks and the flags, learn the addresses of everyone else's
+  res = pnbc_osc_win_create_and_exchange(comm, info, schedule->tmpbuf, 0, tmpsize, schedule,
+                                         addrs_other, &win);
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  // a child only reads the broadcast data after its parent has finished reading
+  // the gathered data from it, so the two phases can share the scratch buffer
+  res = pnbc_osc_tree_gather_steps(crank, csize, 0, radix, 0, schedule->tmpbuf, blk, true,
+                                   addrs_other, steps, &nsteps);
+  if (OPAL_LIKELY(OMPI_SUCCESS == res)) {
+    res = pnbc_osc_tree_bcast_steps(crank, csize, 0, radix, ntreeslots, schedule->tmpbuf,
+                                    (int)tmpsize, MPI_BYTE, addrs_other, steps, &nsteps);
+  }
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in allgather tree steps (%i)", res);
+    goto cleanup;
+  }
+
+  unpack = (copy_args_t){ .src = schedule->tmpbuf, .srccount = (int)tmpsize, .srctype = MPI_PACKED,
+                          .tgt = recvbuf, .tgtcount = csize * recvcount, .tgttype = recvtype };
+  steps[nsteps++] = (PNBC_OSC_Pull_step){ .from = MPI_PROC_NULL, .to = MPI_PROC_NULL,
+                                          .done_unblocks = -1, .fin_copy = &unpack };
+
+  // every start packs our own contribution into our block
+  if (inplace) {
+    start_copy = (copy_args_t){ .src = (char*)recvbuf + (MPI_Aint)crank * recvcount * rcvext,
+                                .srccount = recvcount, .srctype = recvtype };
+  } else {
+    start_copy = (copy_args_t){ .src = sendbuf, .srccount = sendcount, .srctype = sendtype };
+  }
+  start_copy.tgt = (char*)schedule->tmpbuf + crank * blk;
+  start_copy.tgtcount = (int)blk;
+  start_copy.tgttype = MPI_PACKED;
+
+  res = PNBC_OSC_Sched_pull_steps(schedule, win, steps, nsteps, 2 * ntreeslots, false, &start_copy);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Sched_pull_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Schedule_request_win(schedule, comm, win, libpnbc_osc_module, persistent, request);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Schedule_request_win (%i)", res);
+    goto cleanup;
+  }
+
+  free(steps);
+  free(addrs_other);
+
+  return OMPI_SUCCESS;
+
+ cleanup:
+  if (MPI_WIN_NULL != win) {
+    win->w_osc_module->osc_unlock_all(win);
+    ompi_win_free(win);
+  }
+  free(steps);
+  free(addrs_other);
+  OBJ_RELEASE(schedule);
+  return res;
+}
@@ -0,0 +1,333 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_action_common.h"
+#include "pnbc_osc_helper_info.h"
+#include "pnbc_osc_helper_win.h"
+#include "ompi/op/op.h"
+
+static inline int pnbc_osc_allreduce_init(const void* sendbuf, void* recvbuf, int count,
+                              MPI_Datatype datatype, MPI_Op op,
+                              struct ompi_communicator_t *comm, MPI_Info info,
+                              ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent);
+
+int ompi_coll_libpnbc_osc_allreduce_init(const void* sendbuf, void* recvbuf, int count,
+                        MPI_Datatype datatype, MPI_Op op,
+                        struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+
+    int res = pnbc_osc_allreduce_init(sendbuf, recvbuf, count, datatype, op,
+                                      comm, info, request, module, true);
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+        return res;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+typedef enum {
+  algo_recursive_doubling,
+  algo_ring,
+} allreduce_sched_algo;
+
+// recursive doubling: log2(p) pull-and-reduce steps with a partner, plus a
+// fold-in step before and a copy-out step after for the processes beyond the
+// largest power of two; works for non-commutative operations
+static inline int allreduce_sched_recursive_doubling(int crank, int csize, void *recvbuf, void *tmpbuf,
+                                                     int count, MPI_Datatype datatype, MPI_Op op,
+                                                     const MPI_Aint *addrs_other,
+                                                     PNBC_OSC_Pull_step *steps, int *nsteps, int *nslots);
+
+// ring: p-1 pull-and-reduce steps (reduce-scatter) then p-1 pull steps (allgather),
+// each step moves one block of count/p elements; needs a commutative operation
+static inline int allreduce_sched_ring(int crank, int csize, void *recvbuf, void *tmpbuf,
+                                       int count, MPI_Datatype datatype, MPI_Aint ext, MPI_Op op,
+                                       const MPI_Aint *addrs_other,
+                                       PNBC_OSC_Pull_step *steps, int *nsteps, int *nslots);
+
+static inline int allreduce_sched_steps(allreduce_sched_algo algo, int csize) {
+  int log2size = 0;
+
+  switch (algo) {
+    case algo_ring:
+      return 2 * (csize - 1);
+    case algo_recursive_doubling:
+    default:
+      for (int adjsize = 1;adjsize <= csize;adjsize <<= 1)
+        ++log2size;
+      // log2(largest power of two) recursive doubling steps, plus a fold-in and a copy-out step
+      return log2size + 1;
+  }
+}
+
+static int pnbc_osc_allreduce_init(const void* sendbuf, void* recvbuf, int count,
+                  MPI_Datatype datatype, MPI_Op op,
+                  struct ompi_communicator_t *comm, MPI_Info info,
+                  ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent)
+{
+  int res;
+  char inplace;
+  MPI_Aint ext;
+  ptrdiff_t gap = 0;
+  size_t span;
+  PNBC_OSC_Schedule *schedule;
+  PNBC_OSC_Pull_step *steps = NULL;
+  MPI_Aint *addrs_other = NULL;
+  copy_args_t start_copy;
+  int crank, csize, nsteps, nslots, max_steps;
+  MPI_Win win = MPI_WIN_NULL;
+  ompi_coll_libpnbc_osc_module_t *libpnbc_osc_module = (ompi_coll_libpnbc_osc_module_t*) module;
+
+  PNBC_OSC_IN_PLACE(sendbuf, recvbuf, inplace);
+
+  if (0 == count) {
+    return nbc_get_noop_request(persistent, request);
+  }
+
+  res = ompi_datatype_type_extent (datatype, &ext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+  span = opal_datatype_span(&datatype->super, count, &gap);
+
+  crank = ompi_comm_rank(comm);
+  csize = ompi_comm_size(comm);
+
+  allreduce_sched_algo algo = algo_recursive_doubling;
+
+  if ( check_config_value_equal("allreduce_algo_requested", info, "recursive_doubling") )
+    algo = algo_recursive_doubling;
+  if ( check_config_value_equal("allreduce_algo_requested", info, "ring") )
+    algo = algo_ring;
+
+  // the ring needs a commutative operation and at least one element per block
+  if (algo_ring == algo && (!ompi_op_is_commute(op) || count < csize)) {
+    PNBC_OSC_DEBUG(5, "[pnbc_allreduce_init] ring not possible (commute %d, count %d), using recursive doubling\n",
+                   ompi_op_is_commute(op), count);
+    algo = algo_recursive_doubling;
+  }
+
+  schedule = OBJ_NEW(PNBC_OSC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  // scratch space for incoming data, allocated once and reused by every start
+  schedule->tmpbuf = malloc(span);
+  max_steps = allreduce_sched_steps(algo, csize);
+  steps = (PNBC_OSC_Pull_step*)malloc(max_steps * sizeof(PNBC_OSC_Pull_step));
+  addrs_other = (MPI_Aint*)malloc(csize * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == schedule->tmpbuf || NULL == steps || NULL == addrs_other)) {
+    res = OMPI_ERR_OUT_OF_RESOURCE;
+    goto cleanup;
+  }
+
+  // flag slots are the same at all processes, so they only depend on the algorithm
+  nslots = max_steps;
+  res = PNBC_OSC_Sched_pull_alloc(schedule, max_steps, nslots);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    goto cleanup;
+  }
+
+  // expose recvbuf and the flags, learn the addresses of everyone else's
+  res = pnbc_osc_win_create_and_exchange(comm, info, recvbuf, gap, span, schedule, addrs_other, &win);
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  switch (algo) {
+    case algo_ring:
+      res = allreduce_sched_ring(crank, csize, recvbuf, (char*)schedule->tmpbuf - gap,
+                                 count, datatype, ext, op, addrs_other,
+                                 steps, &nsteps, &nslots);
+      break;
+    case algo_recursive_doubling:
+      res = allreduce_sched_recursive_doubling(crank, csize, recvbuf, (char*)schedule->tmpbuf - gap,
+                                               count, datatype, op, addrs_other,
+                                               steps, &nsteps, &nslots);
+      break;
+  }
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in allreduce_sched (%i)", res);
+    goto cleanup;
+  }
+
+  // every start copies the input into recvbuf, which is then reduced in place
+  start_copy.src = sendbuf;
+  start_copy.srccount = count;
+  start_copy.srctype = datatype;
+  start_copy.tgt = recvbuf;
+  start_copy.tgtcount = count;
+  start_copy.tgttype = datatype;
+
+  res = PNBC_OSC_Sched_pull_steps(schedule, win, steps, nsteps, nslots, false,
+                                  inplace ? NULL : &start_copy);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Sched_pull_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Schedule_request_win(schedule, comm, win, libpnbc_osc_module, persistent, request);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Schedule_request_win (%i)", res);
+    goto cleanup;
+  }
+
+  // the step descriptions and remote addresses are now stored in the action arguments
+  free(steps);
+  free(addrs_other);
+
+  return OMPI_SUCCESS;
+
+ cleanup:
+  if (MPI_WIN_NULL != win) {
+    win->w_osc_module->osc_unlock_all(win);
+    ompi_win_free(win);
+  }
+  free(steps);
+  free(addrs_other);
+  OBJ_RELEASE(schedule);
+  return res;
+}
+
+static inline int allreduce_sched_recursive_doubling(int crank, int csize, void *recvbuf, void *tmpbuf,
+                                                     int count, MPI_Datatype datatype, MPI_Op op,
+                                                     const MPI_Aint *addrs_other,
+                                                     PNBC_OSC_Pull_step *steps, int *nsteps, int *nslots) {
+  int adjsize, extra_ranks, newrank, log2size = 0, s = 0;
+  int slot_fold, slot_copy;
+
+  for (adjsize = 1;adjsize <= csize;adjsize <<= 1)
+    ++log2size;
+  adjsize >>= 1;
+  --log2size;
+  extra_ranks = csize - adjsize;
+
+  // slot 0 folds extra processes in, slots 1..log2size are the recursive doubling,
+  // the last slot copies the result back out to the extra processes
+  slot_fold = 0;
+  slot_copy = log2size + 1;
+  *nslots = log2size + 2;
+
+  if (crank < 2 * extra_ranks) {
+    if (0 == crank % 2) {
+      // fold-in: the odd neighbour reads our input, then we wait for it to finish reading
+      steps[s] = (PNBC_OSC_Pull_step){ .slot = slot_fold, .from = MPI_PROC_NULL, .to = crank + 1,
+                                       .reduce_tgt = NULL, .fin_waits_done = true, .done_unblocks = -1 };
+      ++s;
+      // copy-out: read the final result from the odd neighbour straight into recvbuf
+      steps[s] = (PNBC_OSC_Pull_step){ .slot = slot_copy, .from = crank + 1,
+                                       .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, crank + 1),
+                                       .tgt = recvbuf, .count = count, .datatype = datatype,
+                                       .to = MPI_PROC_NULL, .reduce_tgt = NULL,
+                                       .fin_waits_done = false, .done_unblocks = -1 };
+      ++s;
+      *nsteps = s;
+      return OMPI_SUCCESS;
+    }
+    // fold-in: read the input of the even neighbour and reduce it (lower rank first)
+    steps[s] = (PNBC_OSC_Pull_step){ .slot = slot_fold, .from = crank - 1,
+                                     .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, crank - 1),
+                                     .tgt = tmpbuf, .count = count, .datatype = datatype,
+                                     .to = MPI_PROC_NULL, .reduce_tgt = recvbuf, .op = op,
+                                     .reduce_reversed = false,
+                                     .fin_waits_done = false, .done_unblocks = -1 };
+    ++s;
+    newrank = crank / 2;
+  } else {
+    newrank = crank - extra_ranks;
+  }
+
+  for (int k = 0;k < log2size;++k) {
+    int newpeer = newrank ^ (1 << k);
+    int peer = (newpeer < extra_ranks) ? (newpeer * 2 + 1) : (newpeer + extra_ranks);
+
+    // exchange-and-reduce with peer: the reduction overwrites recvbuf, so the
+    // step can only finish when peer has also finished reading our recvbuf
+    steps[s] = (PNBC_OSC_Pull_step){ .slot = 1 + k, .from = peer,
+                                     .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, peer),
+                                     .tgt = tmpbuf, .count = count, .datatype = datatype,
+                                     .to = peer, .reduce_tgt = recvbuf, .op = op,
+                                     .reduce_reversed = (peer > crank),
+                                     .fin_waits_done = true, .done_unblocks = -1 };
+    ++s;
+  }
+
+  if (crank < 2 * extra_ranks) {
+    // copy-out: the even neighbour reads our result, we must not restart before it has
+    steps[s] = (PNBC_OSC_Pull_step){ .slot = slot_copy, .from = MPI_PROC_NULL, .to = crank - 1,
+                                     .reduce_tgt = NULL, .fin_waits_done = true, .done_unblocks = -1 };
+    ++s;
+  }
+
+  *nsteps = s;
+  return OMPI_SUCCESS;
+}
+
+static inline int allreduce_sched_ring(int crank, int csize, void *recvbuf, void *tmpbuf,
+                                       int count, MPI_Datatype datatype, MPI_Aint ext, MPI_Op op,
+                                       const MPI_Aint *addrs_other,
+                                       PNBC_OSC_Pull_step *steps, int *nsteps, int *nslots) {
+  int left = (crank - 1 + csize) % csize;
+  int right = (crank + 1) % csize;
+  int block_count = count / csize;
+  int block_extra = count % csize;
+
+  // block b has block_count (+1 for the first block_extra blocks) elements
+#define ALLREDUCE_RING_BLOCK_COUNT(b) (block_count + ((b) < block_extra ? 1 : 0))
+#define ALLREDUCE_RING_BLOCK_DISPL(b) (((MPI_Aint)(b) * block_count + ((b) < block_extra ? (b) : block_extra)) * ext)
+
+  // reduce-scatter: in step j, read block (rank-j-1) from left, which left has just
+  // reduced, and reduce it into our own copy of that block; afterwards we own block rank+1
+  for (int j = 0;j < csize - 1;++j) {
+    int b = (crank - j - 1 + 2 * csize) % csize;
+    steps[j] = (PNBC_OSC_Pull_step){ .slot = j, .from = left,
+                                     .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, left) + ALLREDUCE_RING_BLOCK_DISPL(b),
+                                     .tgt = (char*)tmpbuf + ALLREDUCE_RING_BLOCK_DISPL(b),
+                                     .count = ALLREDUCE_RING_BLOCK_COUNT(b), .datatype = datatype,
+                                     .to = right, .reduce_tgt = (char*)recvbuf + ALLREDUCE_RING_BLOCK_DISPL(b),
+                                     .op = op, .reduce_reversed = false,
+                                     // right reads block rank-j in this step, which we overwrite in allgather step j
+                                     .fin_waits_done = false, .done_unblocks = csize - 1 + j };
+  }
+
+  // allgather: in step t, read the final block (rank-t) from left straight into recvbuf
+  for (int t = 0;t < csize - 1;++t) {
+    int b = (crank - t + csize) % csize;
+    steps[csize - 1 + t] = (PNBC_OSC_Pull_step){ .slot = csize - 1 + t, .from = left,
+                                     .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, left) + ALLREDUCE_RING_BLOCK_DISPL(b),
+                                     .tgt = (char*)recvbuf + ALLREDUCE_RING_BLOCK_DISPL(b),
+                                     .count = ALLREDUCE_RING_BLOCK_COUNT(b), .datatype = datatype,
+                                     .to = right, .reduce_tgt = NULL,
+                                     .fin_waits_done = false, .done_unblocks = -1 };
+  }
+
+#undef ALLREDUCE_RING_BLOCK_COUNT
+#undef ALLREDUCE_RING_BLOCK_DISPL
+
+  *nsteps = 2 * (csize - 1);
+  *nslots = 2 * (csize - 1);
+  return OMPI_SUCCESS;
+}
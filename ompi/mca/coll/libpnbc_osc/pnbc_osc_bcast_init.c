@@ -0,0 +1,130 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_action_common.h"
+#include "pnbc_osc_helper_win.h"
+#include "pnbc_osc_helper_tree.h"
+
+static inline int pnbc_osc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int root,
+                              struct ompi_communicator_t *comm, MPI_Info info,
+                              ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent);
+
+int ompi_coll_libpnbc_osc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int root,
+                        struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+
+    int res = pnbc_osc_bcast_init(buffer, count, datatype, root,
+                                  comm, info, request, module, true);
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+        return res;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+// k-nomial tree: every process reads the whole buffer from its parent, straight
+// into its own buffer, and then lets all of its children read it from there
+static int pnbc_osc_bcast_init(void *buffer, int count, MPI_Datatype datatype, int root,
+                  struct ompi_communicator_t *comm, MPI_Info info,
+                  ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent)
+{
+  int res;
+  ptrdiff_t gap = 0;
+  size_t span;
+  PNBC_OSC_Schedule *schedule;
+  PNBC_OSC_Pull_step *steps = NULL;
+  MPI_Aint *addrs_other = NULL;
+  int crank, csize, radix, nsteps = 0, nslots;
+  MPI_Win win = MPI_WIN_NULL;
+  ompi_coll_libpnbc_osc_module_t *libpnbc_osc_module = (ompi_coll_libpnbc_osc_module_t*) module;
+
+  crank = ompi_comm_rank(comm);
+  csize = ompi_comm_size(comm);
+
+  if (0 == count || 1 == csize) {
+    return nbc_get_noop_request(persistent, request);
+  }
+
+  span = opal_datatype_span(&datatype->super, count, &gap);
+  radix = (1 < libpnbc_osc_tree_radix) ? libpnbc_osc_tree_radix : 2;
+  nslots = pnbc_osc_tree_num_slots(csize, radix);
+
+  schedule = OBJ_NEW(PNBC_OSC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  // one step from the parent, one step for each child
+  steps = (PNBC_OSC_Pull_step*)malloc((1 + nslots) * sizeof(PNBC_OSC_Pull_step));
+  addrs_other = (MPI_Aint*)malloc(csize * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == steps || NULL == addrs_other)) {
+    res = OMPI_ERR_OUT_OF_RESOURCE;
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Sched_pull_alloc(schedule, 1 + nslots, nslots);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    goto cleanup;
+  }
+
+  // expose the user buffer and the flags, learn the addresses of everyone else's
+  res = pnbc_osc_win_create_and_exchange(comm, info, buffer, gap, span, schedule, addrs_other, &win);
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  res = pnbc_osc_tree_bcast_steps(crank, csize, root, radix, 0, buffer, count, datatype,
+                                  addrs_other, steps, &nsteps);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in pnbc_osc_tree_bcast_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Sched_pull_steps(schedule, win, steps, nsteps, nslots, false, NULL);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Sched_pull_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Schedule_request_win(schedule, comm, win, libpnbc_osc_module, persistent, request);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Schedule_request_win (%i)", res);
+    goto cleanup;
+  }
+
+  free(steps);
+  free(addrs_other);
+
+  return OMPI_SUCCESS;
+
+ cleanup:
+  if (MPI_WIN_NULL != win) {
+    win->w_osc_module->osc_unlock_all(win);
+    ompi_win_free(win);
+  }
+  free(steps);
+  free(addrs_other);
+  OBJ_RELEASE(schedule);
+  return res;
+}
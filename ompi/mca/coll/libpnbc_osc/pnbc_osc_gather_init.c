@@ -0,0 +1,186 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_action_common.h"
+#include "pnbc_osc_helper_win.h"
+#include "pnbc_osc_helper_tree.h"
+
+static inline int pnbc_osc_gather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                              void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                              struct ompi_communicator_t *comm, MPI_Info info,
+                              ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent);
+
+int ompi_coll_libpnbc_osc_gather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                        struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+
+    int res = pnbc_osc_gather_init(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype,
+                                   root, comm, info, request, module, true);
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+        return res;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+// k-nomial tree: every process packs its block into a scratch buffer, reads the
+// packed subtrees of its children next to it and then lets its parent read the
+// whole lot; the root finally unpacks everything into recvbuf (in rank order)
+static int pnbc_osc_gather_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void* recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                  struct ompi_communicator_t *comm, MPI_Info info,
+                  ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module, bool persistent)
+{
+  int res;
+  char inplace;
+  MPI_Aint rcvext = 0;
+  size_t blk, tmpsize;
+  PNBC_OSC_Schedule *schedule;
+  PNBC_OSC_Pull_step *steps = NULL;
+  MPI_Aint *addrs_other = NULL;
+  copy_args_t start_copy, unpack[2];
+  int crank, csize, vrank, radix, nsteps = 0, nslots;
+  MPI_Win win = MPI_WIN_NULL;
+  ompi_coll_libpnbc_osc_module_t *libpnbc_osc_module = (ompi_coll_libpnbc_osc_module_t*) module;
+
+  crank = ompi_comm_rank(comm);
+  csize = ompi_comm_size(comm);
+
+  PNBC_OSC_IN_PLACE(sendbuf, recvbuf, inplace);
+
+  // all blocks have the same size, the packed size of one contribution
+  if (crank == root) {
+    size_t rcvsize;
+    res = ompi_datatype_type_extent(recvtype, &rcvext);
+    if (MPI_SUCCESS != res) {
+      PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+      return res;
+    }
+    ompi_datatype_type_size(recvtype, &rcvsize);
+    blk = rcvsize * recvcount;
+  } else {
+    size_t sndsize;
+    ompi_datatype_type_size(sendtype, &sndsize);
+    blk = sndsize * sendcount;
+  }
+
+  if (0 == blk) {
+    return nbc_get_noop_request(persistent, request);
+  }
+
+  radix = (1 < libpnbc_osc_tree_radix) ? libpnbc_osc_tree_radix : 2;
+  nslots = pnbc_osc_tree_num_slots(csize, radix);
+  vrank = PNBC_OSC_TREE_VRANK(crank, root, csize);
+  tmpsize = pnbc_osc_tree_subtree_size(vrank, csize, radix) * blk;
+
+  schedule = OBJ_NEW(PNBC_OSC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  // packed blocks of our subtree, in virtual rank order, allocated once and reused by every start
+  schedule->tmpbuf = malloc(tmpsize);
+  // one step for each child, one step to the parent, two unpack steps at the root
+  steps = (PNBC_OSC_Pull_step*)malloc((nslots + 3) * sizeof(PNBC_OSC_Pull_step));
+  addrs_other = (MPI_Aint*)malloc(csize * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == schedule->tmpbuf || NULL == steps || NULL == addrs_other)) {
+    res = OMPI_ERR_OUT_OF_RESOURCE;
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Sched_pull_alloc(schedule, nslots + 3, nslots);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    goto cleanup;
+  }
+
+  // expose the packed blocks and the flags, learn the addresses of everyone else's
+  res = pnbc_osc_win_create_and_exchange(comm, info, schedule->tmpbuf, 0, tmpsize, schedule,
+                                         addrs_other, &win);
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  res = pnbc_osc_tree_gather_steps(crank, csize, root, radix, 0, schedule->tmpbuf, blk, false,
+                                   addrs_other, steps, &nsteps);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in pnbc_osc_tree_gather_steps (%i)", res);
+    goto cleanup;
+  }
+
+  if (crank == root) {
+    // virtual ranks 0..csize-root-1 are ranks root..csize-1, the rest are ranks 0..root-1
+    unpack[0] = (copy_args_t){ .src = schedule->tmpbuf, .srccount = (int)((csize - root) * blk),
+                               .srctype = MPI_PACKED,
+                               .tgt = (char*)recvbuf + (MPI_Aint)root * recvcount * rcvext,
+                               .tgtcount = (csize - root) * recvcount, .tgttype = recvtype };
+    steps[nsteps++] = (PNBC_OSC_Pull_step){ .from = MPI_PROC_NULL, .to = MPI_PROC_NULL,
+                                            .done_unblocks = -1, .fin_copy = &unpack[0] };
+    if (0 < root) {
+      unpack[1] = (copy_args_t){ .src = (char*)schedule->tmpbuf + (csize - root) * blk,
+                                 .srccount = (int)(root * blk), .srctype = MPI_PACKED,
+                                 .tgt = recvbuf, .tgtcount = root * recvcount, .tgttype = recvtype };
+      steps[nsteps++] = (PNBC_OSC_Pull_step){ .from = MPI_PROC_NULL, .to = MPI_PROC_NULL,
+                                              .done_unblocks = -1, .fin_copy = &unpack[1] };
+    }
+  }
+
+  // every start packs our own contribution as the first block
+  if (inplace) {
+    start_copy = (copy_args_t){ .src = (char*)recvbuf + (MPI_Aint)root * recvcount * rcvext,
+                                .srccount = recvcount, .srctype = recvtype };
+  } else {
+    start_copy = (copy_args_t){ .src = sendbuf, .srccount = sendcount, .srctype = sendtype };
+  }
+  start_copy.tgt = schedule->tmpbuf;
+  start_copy.tgtcount = (int)blk;
+  start_copy.tgttype = MPI_PACKED;
+
+  res = PNBC_OSC_Sched_pull_steps(schedule, win, steps, nsteps, nslots, false, &start_copy);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Sched_pull_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Schedule_request_win(schedule, comm, win, libpnbc_osc_module, persistent, request);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Schedule_request_win (%i)", res);
+    goto cleanup;
+  }
+
+  free(steps);
+  free(addrs_other);
+
+  return OMPI_SUCCESS;
+
+ cleanup:
+  if (MPI_WIN_NULL != win) {
+    win->w_osc_module->osc_unlock_all(win);
+    ompi_win_free(win);
+  }
+  free(steps);
+  free(addrs_other);
+  OBJ_RELEASE(schedule);
+  return res;
+}
@@ -0,0 +1,110 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_helper_neighbor.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/mca/topo/base/base.h"
+
+int pnbc_osc_comm_neighbors(ompi_communicator_t *comm, int **sources, int *indegree,
+                            int **destinations, int *outdegree) {
+    int res;
+
+    *sources = *destinations = NULL;
+
+    res = mca_topo_base_neighbor_count(comm, indegree, outdegree);
+    if (OMPI_SUCCESS != res) {
+        return res;
+    }
+
+    *sources = (int*)malloc((*indegree + *outdegree + 1) * sizeof(int));
+    if (OPAL_UNLIKELY(NULL == *sources)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    *destinations = *sources + *indegree;
+
+    if (OMPI_COMM_IS_CART(comm)) {
+        // the lower and then the upper neighbour in every dimension, MPI_PROC_NULL at the edges
+        for (int dim = 0, i = 0;dim < comm->c_topo->mtc.cart->ndims;++dim) {
+            int rpeer, speer;
+            mca_topo_base_cart_shift(comm, dim, 1, &rpeer, &speer);
+            (*sources)[i] = (*destinations)[i] = rpeer; i++;
+            (*sources)[i] = (*destinations)[i] = speer; i++;
+        }
+    } else if (OMPI_COMM_IS_GRAPH(comm)) {
+        mca_topo_base_graph_neighbors(comm, ompi_comm_rank(comm), *indegree, *sources);
+        memcpy(*destinations, *sources, *indegree * sizeof(int));
+    } else if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        mca_topo_base_dist_graph_neighbors(comm, *indegree, *sources, MPI_UNWEIGHTED,
+                                           *outdegree, *destinations, MPI_UNWEIGHTED);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+int pnbc_osc_neighbor_exchange(ompi_communicator_t *comm, int nslots,
+                               const int *sources, int indegree,
+                               const int *destinations, int outdegree,
+                               const MPI_Aint *block_addrs, MPI_Aint *in_addrs, MPI_Aint *out_addrs) {
+    MPI_Aint *addrs_local;
+    ompi_request_t **reqs;
+    int res = OMPI_SUCCESS, nreqs = 0;
+
+    addrs_local = (MPI_Aint*)malloc((2 * outdegree + indegree + 1) * sizeof(MPI_Aint));
+    reqs = (ompi_request_t**)malloc((2 * (indegree + outdegree) + 1) * sizeof(ompi_request_t*));
+    if (OPAL_UNLIKELY(NULL == addrs_local || NULL == reqs)) {
+        free(addrs_local);
+        free(reqs);
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    // messages on the same edge and tag are matched in order, so are multiple edges
+    for (int i = 0;i < indegree && OMPI_SUCCESS == res;++i) {
+        PNBC_OSC_NEIGHBOR_ADDR_BUF(in_addrs, i) = in_addrs[2 * i + 1] = 0;
+        if (MPI_PROC_NULL == sources[i]) continue;
+        res = MCA_PML_CALL(irecv(&in_addrs[2 * i], 2, MPI_AINT, sources[i],
+                                 PNBC_OSC_NEIGHBOR_TAG_FORWARD, comm, &reqs[nreqs++]));
+    }
+    for (int j = 0;j < outdegree && OMPI_SUCCESS == res;++j) {
+        out_addrs[j] = 0;
+        if (MPI_PROC_NULL == destinations[j]) continue;
+        res = MCA_PML_CALL(irecv(&out_addrs[j], 1, MPI_AINT, destinations[j],
+                                 PNBC_OSC_NEIGHBOR_TAG_BACKWARD, comm, &reqs[nreqs++]));
+    }
+    for (int j = 0;j < outdegree && OMPI_SUCCESS == res;++j) {
+        if (MPI_PROC_NULL == destinations[j]) continue;
+        addrs_local[2 * j] = block_addrs[j];
+        addrs_local[2 * j + 1] = nslots + j;
+        res = MCA_PML_CALL(isend(&addrs_local[2 * j], 2, MPI_AINT, destinations[j],
+                                 PNBC_OSC_NEIGHBOR_TAG_FORWARD, MCA_PML_BASE_SEND_STANDARD,
+                                 comm, &reqs[nreqs++]));
+    }
+    for (int i = 0;i < indegree && OMPI_SUCCESS == res;++i) {
+        if (MPI_PROC_NULL == sources[i]) continue;
+        addrs_local[2 * outdegree + i] = i;
+        res = MCA_PML_CALL(isend(&addrs_local[2 * outdegree + i], 1, MPI_AINT, sources[i],
+                                 PNBC_OSC_NEIGHBOR_TAG_BACKWARD, MCA_PML_BASE_SEND_STANDARD,
+                                 comm, &reqs[nreqs++]));
+    }
+
+    if (OMPI_SUCCESS == res) {
+        res = ompi_request_wait_all(nreqs, reqs, MPI_STATUSES_IGNORE);
+    }
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in neighbour address exchange (%i)", res);
+    }
+
+    free(addrs_local);
+    free(reqs);
+    return res;
+}
@@ -0,0 +1,59 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#ifndef PNBC_OSC_HELPER_NEIGHBOR_H
+#define PNBC_OSC_HELPER_NEIGHBOR_H
+
+#include "pnbc_osc_internal.h"
+#include "ompi/mca/coll/base/coll_tags.h"
+
+/* neighbourhood collectives only ever talk to the sources and destinations of
+ * the topology of the communicator, so nothing here is allocated, exchanged or
+ * tested per process of the communicator: all of it is O(indegree + outdegree)
+ *
+ * exchange step k uses flag slot k: its RTS flag is set by sources[k], its DONE
+ * flag by destinations[k]; the k-th edge from a to b is paired with the k-th
+ * edge into b from a, as the point-to-point messages of libnbc would match */
+
+#define PNBC_OSC_NEIGHBOR_TAG_FORWARD   MCA_COLL_BASE_TAG_NEIGHBOR_BASE
+#define PNBC_OSC_NEIGHBOR_TAG_BACKWARD  (MCA_COLL_BASE_TAG_NEIGHBOR_BASE - 1)
+
+/* sources and destinations of the topology of comm (cart, graph or dist graph)
+ * in the order used by the neighbourhood collectives, MPI_PROC_NULL included;
+ * both are allocated in one block, the caller must free *sources */
+int pnbc_osc_comm_neighbors(ompi_communicator_t *comm, int **sources, int *indegree,
+                            int **destinations, int *outdegree);
+
+/* tells every destination j where to read its block (block_addrs[j], in the
+ * dynamic data window) and which of our flags is its DONE flag, and tells every
+ * source i which of our flags is its RTS flag; receives the same from them,
+ * 2 entries per source in in_addrs and 1 entry per destination in out_addrs */
+int pnbc_osc_neighbor_exchange(ompi_communicator_t *comm, int nslots,
+                               const int *sources, int indegree,
+                               const int *destinations, int outdegree,
+                               const MPI_Aint *block_addrs, MPI_Aint *in_addrs, MPI_Aint *out_addrs);
+
+#define PNBC_OSC_NEIGHBOR_ADDR_BUF(in_addrs, i)    ((in_addrs)[2 * (i)])
+#define PNBC_OSC_NEIGHBOR_FLAG_DONE(in_addrs, i)   ((int)(in_addrs)[2 * (i) + 1])
+
+/* persistent exchange with the neighbours of comm: block j of the send data goes
+ * to destinations[j], block i of the receive data comes from sources[i];
+ * the displacements are in bytes, so that every flavour can be expressed */
+int pnbc_osc_neighbor_init(const void *sendbuf, const int *sendcounts, const MPI_Aint *sdispls,
+                           MPI_Datatype sendtype, void *recvbuf, const int *recvcounts,
+                           const MPI_Aint *rdispls, MPI_Datatype recvtype,
+                           struct ompi_communicator_t *comm, MPI_Info info,
+                           ompi_request_t **request, struct mca_coll_base_module_2_3_0_t *module,
+                           bool persistent);
+
+#endif
@@ -0,0 +1,196 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_helper_win.h"
+#include "pnbc_osc_helper_tree.h"
+
+int pnbc_osc_tree_num_slots(int size, int radix) {
+    int levels = 0;
+
+    for (long span = 1; span < size; span *= radix) {
+        ++levels;
+    }
+    return levels * (radix - 1);
+}
+
+int pnbc_osc_tree_subtree_size(int vrank, int size, int radix) {
+    long span = 1;
+
+    if (0 == vrank) {
+        return size;
+    }
+    // the subtree spans radix^level ranks, where level is the lowest non-zero digit of vrank
+    while (0 == (vrank / span) % radix) {
+        span *= radix;
+    }
+    return (int)((vrank + span <= size) ? span : size - vrank);
+}
+
+int pnbc_osc_tree_parent(int vrank, int radix, int *slot) {
+    long span = 1;
+    int level = 0, digit;
+
+    if (0 == vrank) {
+        *slot = -1;
+        return -1;
+    }
+    while (0 == (digit = (vrank / span) % radix)) {
+        span *= radix;
+        ++level;
+    }
+    *slot = level * (radix - 1) + (digit - 1);
+    return (int)(vrank - digit * span);
+}
+
+int pnbc_osc_tree_children(int vrank, int size, int radix, int *children, int *slots) {
+    long span = 1;
+    int level = 0, nchildren = 0;
+
+    // children hang off every level below the lowest non-zero digit of vrank
+    while (span < size && (0 == vrank || 0 == (vrank / span) % radix)) {
+        span *= radix;
+        ++level;
+    }
+
+    // largest subtrees first, so that they can start forwarding as early as possible
+    for (span /= radix, --level; level >= 0; span /= radix, --level) {
+        for (int digit = 1; digit < radix; ++digit) {
+            long child = vrank + digit * span;
+            if (child >= size) {
+                break;
+            }
+            children[nchildren] = (int)child;
+            slots[nchildren] = level * (radix - 1) + (digit - 1);
+            ++nchildren;
+        }
+    }
+
+    return nchildren;
+}
+
+int pnbc_osc_tree_bcast_steps(int crank, int csize, int root, int radix, int slot_base,
+                              void *buf, int count, MPI_Datatype datatype,
+                              const MPI_Aint *addrs_other,
+                              PNBC_OSC_Pull_step *steps, int *nsteps) {
+    int vrank = PNBC_OSC_TREE_VRANK(crank, root, csize);
+    int nchildren, parent, slot, s = *nsteps;
+    int *children, *slots;
+
+    children = (int*)malloc(2 * (pnbc_osc_tree_num_slots(csize, radix) + 1) * sizeof(int));
+    if (OPAL_UNLIKELY(NULL == children)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    slots = children + pnbc_osc_tree_num_slots(csize, radix) + 1;
+
+    parent = pnbc_osc_tree_parent(vrank, radix, &slot);
+    if (0 <= parent) {
+        parent = PNBC_OSC_TREE_RANK(parent, root, csize);
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slot, .from = parent,
+                                           .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, parent),
+                                           .tgt = buf, .count = count, .datatype = datatype,
+                                           .to = MPI_PROC_NULL, .done_unblocks = -1 };
+    }
+
+    // the children read concurrently, completion of the request waits for all their DONEs
+    nchildren = pnbc_osc_tree_children(vrank, csize, radix, children, slots);
+    for (int i = 0; i < nchildren; ++i) {
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slots[i], .from = MPI_PROC_NULL,
+                                           .to = PNBC_OSC_TREE_RANK(children[i], root, csize),
+                                           .done_unblocks = -1 };
+    }
+
+    free(children);
+    *nsteps = s;
+    return OMPI_SUCCESS;
+}
+
+int pnbc_osc_tree_gather_steps(int crank, int csize, int root, int radix, int slot_base,
+                               char *tmpbuf, size_t blk, bool absolute,
+                               const MPI_Aint *addrs_other,
+                               PNBC_OSC_Pull_step *steps, int *nsteps) {
+    int vrank = PNBC_OSC_TREE_VRANK(crank, root, csize);
+    int nchildren, parent, slot, s = *nsteps;
+    int *children, *slots;
+
+    children = (int*)malloc(2 * (pnbc_osc_tree_num_slots(csize, radix) + 1) * sizeof(int));
+    if (OPAL_UNLIKELY(NULL == children)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    slots = children + pnbc_osc_tree_num_slots(csize, radix) + 1;
+
+    // read the subtrees of all children at the same time
+    nchildren = pnbc_osc_tree_children(vrank, csize, radix, children, slots);
+    for (int i = 0; i < nchildren; ++i) {
+        int child = PNBC_OSC_TREE_RANK(children[i], root, csize);
+        size_t local = (size_t)(absolute ? children[i] : children[i] - vrank) * blk;
+        size_t remote = absolute ? (size_t)children[i] * blk : 0;
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slots[i], .from = child,
+                                           .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, child) + remote,
+                                           .tgt = tmpbuf + local,
+                                           .count = (int)(pnbc_osc_tree_subtree_size(children[i], csize, radix) * blk),
+                                           .datatype = MPI_BYTE, .to = MPI_PROC_NULL, .done_unblocks = -1,
+                                           .overlap_next = (i + 1 < nchildren) };
+    }
+
+    // then let the parent read the whole subtree
+    parent = pnbc_osc_tree_parent(vrank, radix, &slot);
+    if (0 <= parent) {
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slot, .from = MPI_PROC_NULL,
+                                           .to = PNBC_OSC_TREE_RANK(parent, root, csize),
+                                           .done_unblocks = -1 };
+    }
+
+    free(children);
+    *nsteps = s;
+    return OMPI_SUCCESS;
+}
+
+int pnbc_osc_tree_scatter_steps(int crank, int csize, int root, int radix, int slot_base,
+                                char *tmpbuf, size_t blk, const copy_args_t *fin_copy,
+                                const MPI_Aint *addrs_other,
+                                PNBC_OSC_Pull_step *steps, int *nsteps) {
+    int vrank = PNBC_OSC_TREE_VRANK(crank, root, csize);
+    int nchildren, parent, slot, s = *nsteps;
+    int *children, *slots;
+
+    children = (int*)malloc(2 * (pnbc_osc_tree_num_slots(csize, radix) + 1) * sizeof(int));
+    if (OPAL_UNLIKELY(NULL == children)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    slots = children + pnbc_osc_tree_num_slots(csize, radix) + 1;
+
+    // our subtree starts at offset (vrank - parent) * blk in the buffer of the parent
+    parent = pnbc_osc_tree_parent(vrank, radix, &slot);
+    if (0 <= parent) {
+        int from = PNBC_OSC_TREE_RANK(parent, root, csize);
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slot, .from = from,
+                                           .from_displ = PNBC_OSC_WIN_ADDR_BUF(addrs_other, from) +
+                                                         (MPI_Aint)((vrank - parent) * blk),
+                                           .tgt = tmpbuf,
+                                           .count = (int)(pnbc_osc_tree_subtree_size(vrank, csize, radix) * blk),
+                                           .datatype = MPI_BYTE, .to = MPI_PROC_NULL, .done_unblocks = -1,
+                                           .fin_copy = fin_copy };
+    }
+
+    nchildren = pnbc_osc_tree_children(vrank, csize, radix, children, slots);
+    for (int i = 0; i < nchildren; ++i) {
+        steps[s++] = (PNBC_OSC_Pull_step){ .slot = slot_base + slots[i], .from = MPI_PROC_NULL,
+                                           .to = PNBC_OSC_TREE_RANK(children[i], root, csize),
+                                           .done_unblocks = -1 };
+    }
+
+    free(children);
+    *nsteps = s;
+    return OMPI_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#ifndef PNBC_OSC_HELPER_TREE_H
+#define PNBC_OSC_HELPER_TREE_H
+
+#include "pnbc_osc_internal.h"
+
+/* k-nomial trees over the virtual ranks 0..size-1, rooted at virtual rank 0
+ * (virtual rank = (rank - root + size) % size); radix 2 gives a binomial tree
+ *
+ * the subtree of every process is a contiguous range of virtual ranks that
+ * starts with the process itself, and every parent/child relation has a slot
+ * number in [0, pnbc_osc_tree_num_slots) that is unique amongst the children
+ * of the parent, so it can index the RTS/DONE flags of a pull step */
+
+/* number of slots, which is also the largest possible number of children */
+int pnbc_osc_tree_num_slots(int size, int radix);
+
+/* number of virtual ranks in the subtree of vrank */
+int pnbc_osc_tree_subtree_size(int vrank, int size, int radix);
+
+/* virtual rank of the parent of vrank (-1 for the root) and the slot of vrank */
+int pnbc_osc_tree_parent(int vrank, int radix, int *slot);
+
+/* fills children and slots (largest subtree first), returns the number of children */
+int pnbc_osc_tree_children(int vrank, int size, int radix, int *children, int *slots);
+
+/* appends the pull steps of a broadcast of buf down the tree:
+ * read buf from the parent (identical layout), then let each child read it */
+int pnbc_osc_tree_bcast_steps(int crank, int csize, int root, int radix, int slot_base,
+                              void *buf, int count, MPI_Datatype datatype,
+                              const MPI_Aint *addrs_other,
+                              PNBC_OSC_Pull_step *steps, int *nsteps);
+
+/* appends the pull steps of a gather of packed blocks of blk bytes up the tree:
+ * read the subtree of every child concurrently, then let the parent read ours
+ * the block of virtual rank v is at (v - vrank) * blk in tmpbuf, or at v * blk
+ * if absolute is set, which requires a buffer for the whole communicator */
+int pnbc_osc_tree_gather_steps(int crank, int csize, int root, int radix, int slot_base,
+                               char *tmpbuf, size_t blk, bool absolute,
+                               const MPI_Aint *addrs_other,
+                               PNBC_OSC_Pull_step *steps, int *nsteps);
+
+/* appends the pull steps of a scatter of packed blocks of blk bytes down the tree:
+ * read our subtree from the parent into tmpbuf (own block first) and do fin_copy,
+ * then let each child read its subtree */
+int pnbc_osc_tree_scatter_steps(int crank, int csize, int root, int radix, int slot_base,
+                                char *tmpbuf, size_t blk, const copy_args_t *fin_copy,
+                                const MPI_Aint *addrs_other,
+                                PNBC_OSC_Pull_step *steps, int *nsteps);
+
+#define PNBC_OSC_TREE_VRANK(rank, root, size) (((rank) - (root) + (size)) % (size))
+#define PNBC_OSC_TREE_RANK(vrank, root, size) (((vrank) + (root)) % (size))
+
+#endif
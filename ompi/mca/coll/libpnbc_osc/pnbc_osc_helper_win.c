@@ -0,0 +1,197 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2011-2017 Sandia National Laboratories.  All rights reserved.
+ * Copyright (c) 2015-2018 Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * Copyright (c) 2015-2017 Research Organization for Information Science
+ *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2017      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * Copyright (c) 2016-2017 IBM Corporation. All rights reserved.
+ * Copyright (c) 2018      Amazon.com, Inc. or its affiliates.  All Rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_helper_win.h"
+#include "opal/align.h"
+
+int pnbc_osc_win_allocate_flags(ompi_communicator_t *comm, ompi_info_t *info,
+                                PNBC_OSC_Schedule *schedule) {
+    size_t size = (schedule->num_flags + 1) * sizeof(FLAG_t);
+    FLAG_t *base = NULL;
+    int res;
+
+    // the flags window memory is allocated by the osc component, so that remote
+    // atomics on it can be done by the network (or by the owner's cpu for osc/sm)
+    // rather than by an active-message handler; displacements count flags
+    res = ompi_win_allocate(size, sizeof(FLAG_t), &info->super, comm, &base, &schedule->flags_win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in win_allocate for flags (%i)", res);
+        schedule->flags_win = MPI_WIN_NULL;
+        return res;
+    }
+
+    // the flags (local counters included) move into the window memory before anyone signals
+    memset(base, 0, size);
+    free(schedule->flags);
+    schedule->flags = base;
+
+    res = schedule->flags_win->w_osc_module->osc_lock_all(MPI_MODE_NOCHECK, schedule->flags_win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in osc_lock_all for flags (%i)", res);
+        schedule->flags = NULL;
+        ompi_win_free(schedule->flags_win);
+        schedule->flags_win = MPI_WIN_NULL;
+        return res;
+    }
+
+    PNBC_OSC_DEBUG(10, "[pnbc_osc_win_allocate_flags] allocates %i flags at %p\n",
+                   schedule->num_flags, (void*)base);
+
+    return OMPI_SUCCESS;
+}
+
+int pnbc_osc_win_allocate_shared(ompi_communicator_t *comm, ompi_info_t *info,
+                                 PNBC_OSC_Schedule *schedule, size_t data_size, char **data) {
+    int csize = ompi_comm_size(comm);
+    size_t flags_size, size;
+    char *base = NULL;
+    int res;
+
+    // a whole number of cache lines per segment: the segments of osc/sm follow each
+    // other, so this keeps the flags of every process on lines of their own
+    flags_size = OPAL_ALIGN((schedule->num_flags + 1) * sizeof(FLAG_t), PNBC_OSC_CACHE_LINE, size_t);
+    size = flags_size + OPAL_ALIGN(data_size, PNBC_OSC_CACHE_LINE, size_t);
+
+    schedule->shm_bases = (char**)malloc(csize * sizeof(char*));
+    if (OPAL_UNLIKELY(NULL == schedule->shm_bases)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    res = ompi_win_allocate_shared(size, 1, &info->super, comm, &base, &schedule->flags_win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in win_allocate_shared (%i)", res);
+        schedule->flags_win = MPI_WIN_NULL;
+        goto shm_error;
+    }
+
+    // every other process is only ever accessed through these, never through the window
+    for (int r = 0;r < csize;++r) {
+        size_t rsize;
+        int disp_unit;
+        res = schedule->flags_win->w_osc_module->osc_win_shared_query(schedule->flags_win, r, &rsize,
+                                                                      &disp_unit, &schedule->shm_bases[r]);
+        if (OMPI_SUCCESS != res) {
+            PNBC_OSC_Error ("MPI Error in win_shared_query (%i)", res);
+            goto shm_error;
+        }
+    }
+
+    // the flags (local counters included) move into the segment before anyone signals
+    memset(base, 0, flags_size);
+    free(schedule->flags);
+    schedule->flags = (FLAG_t*)base;
+    *data = base + flags_size;
+
+    res = schedule->flags_win->w_osc_module->osc_lock_all(MPI_MODE_NOCHECK, schedule->flags_win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in osc_lock_all for flags (%i)", res);
+        schedule->flags = NULL;
+        goto shm_error;
+    }
+
+    PNBC_OSC_DEBUG(10, "[pnbc_osc_win_allocate_shared] allocates %i flags and %lu bytes at %p\n",
+                   schedule->num_flags, (unsigned long)data_size, (void*)base);
+
+    return OMPI_SUCCESS;
+
+ shm_error:
+    if (MPI_WIN_NULL != schedule->flags_win) {
+        ompi_win_free(schedule->flags_win);
+        schedule->flags_win = MPI_WIN_NULL;
+    }
+    free(schedule->shm_bases);
+    schedule->shm_bases = NULL;
+    return res;
+}
+
+int pnbc_osc_win_create(ompi_communicator_t *comm, ompi_info_t *info,
+                        void *buf, ptrdiff_t gap, size_t span,
+                        PNBC_OSC_Schedule *schedule, ompi_win_t **win) {
+    int res;
+
+    // create a dynamic window - data here will be accessed by remote processes
+    res = ompi_win_create_dynamic(&info->super, comm, win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in win_create_dynamic (%i)", res);
+        return res;
+    }
+
+    if (0 < span) {
+        res = (*win)->w_osc_module->osc_win_attach(*win, (char*)buf + gap, span);
+        if (OMPI_SUCCESS != res) {
+            PNBC_OSC_Error ("MPI Error in win_attach (%i)", res);
+            goto win_error;
+        }
+        PNBC_OSC_DEBUG(10, "[pnbc_osc_win_create] attaches buffer %p (gap %ld) of size %lu bytes\n",
+                       buf, (long)gap, (unsigned long)span);
+    }
+
+    // lock the window at all other processes, for the lifetime of the request
+    res = (*win)->w_osc_module->osc_lock_all(MPI_MODE_NOCHECK, *win);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in osc_lock_all (%i)", res);
+        goto win_error;
+    }
+
+    res = pnbc_osc_win_allocate_flags(comm, info, schedule);
+    if (OMPI_SUCCESS != res) {
+        (*win)->w_osc_module->osc_unlock_all(*win);
+        goto win_error;
+    }
+
+    return OMPI_SUCCESS;
+
+ win_error:
+    ompi_win_free(*win);
+    *win = MPI_WIN_NULL;
+    return res;
+}
+
+int pnbc_osc_win_create_and_exchange(ompi_communicator_t *comm, ompi_info_t *info,
+                                     void *buf, ptrdiff_t gap, size_t span,
+                                     PNBC_OSC_Schedule *schedule,
+                                     MPI_Aint *addrs_other, ompi_win_t **win) {
+    MPI_Aint addr_local;
+    int res;
+
+    res = pnbc_osc_win_create(comm, info, buf, gap, span, schedule, win);
+    if (OMPI_SUCCESS != res) {
+        return res;
+    }
+
+    // swap local addresses for remote addresses
+    addr_local = (MPI_Aint)buf;
+    res = comm->c_coll->coll_allgather(&addr_local, 1, MPI_AINT,
+                                       addrs_other, 1, MPI_AINT,
+                                       comm, comm->c_coll->coll_allgather_module);
+    if (OMPI_SUCCESS != res) {
+        PNBC_OSC_Error ("MPI Error in allgather for window addresses (%i)", res);
+        (*win)->w_osc_module->osc_unlock_all(*win);
+        ompi_win_free(*win);
+        *win = MPI_WIN_NULL;
+        return res;
+    }
+
+    return OMPI_SUCCESS;
+}
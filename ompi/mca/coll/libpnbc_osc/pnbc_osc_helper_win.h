@@ -0,0 +1,66 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2011-2017 Sandia National Laboratories.  All rights reserved.
+ * Copyright (c) 2015-2018 Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * Copyright (c) 2015-2017 Research Organization for Information Science
+ *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2017      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * Copyright (c) 2016-2017 IBM Corporation. All rights reserved.
+ * Copyright (c) 2018      Amazon.com, Inc. or its affiliates.  All Rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ * $HEADER$
+*/
+
+#ifndef PNBC_OSC_HELPER_WIN_H
+#define PNBC_OSC_HELPER_WIN_H
+
+#include "pnbc_osc_internal.h"
+
+/* creates a dynamic window over comm and attaches [buf+gap, buf+gap+span),
+ * allocates the flags window of the schedule, then gathers the address of buf
+ * from every process into addrs_other (1 entry per rank); both windows are in a
+ * passive target epoch that lasts until the request is freed
+ *
+ * remote processes may signal the flags as soon as they return from this
+ * (collective) call, which zeroes them before the addresses are exchanged */
+int pnbc_osc_win_create_and_exchange(ompi_communicator_t *comm, ompi_info_t *info,
+                                     void *buf, ptrdiff_t gap, size_t span,
+                                     PNBC_OSC_Schedule *schedule,
+                                     MPI_Aint *addrs_other, ompi_win_t **win);
+
+/* as above, but without exchanging any addresses: the caller must tell the
+ * processes that access the window where buf is and which flags to signal,
+ * e.g. only its neighbours, once this (collective) call has returned */
+int pnbc_osc_win_create(ompi_communicator_t *comm, ompi_info_t *info,
+                        void *buf, ptrdiff_t gap, size_t span,
+                        PNBC_OSC_Schedule *schedule, ompi_win_t **win);
+
+/* replaces the flags of the schedule with the memory of a window allocated
+ * over comm, zeroed and locked at all processes (called by pnbc_osc_win_create)
+ * the flags are never written by the origin of a signal, only atomically
+ * incremented, so nothing needs a flush or a new epoch to see them */
+int pnbc_osc_win_allocate_flags(ompi_communicator_t *comm, ompi_info_t *info,
+                                PNBC_OSC_Schedule *schedule);
+
+/* allocates the flags window of the schedule in shared memory instead, with
+ * data_size more bytes after the flags for data that the other processes copy
+ * directly (*data); the schedule learns the segment of every process, which
+ * must all be on this node, so that pull steps need no RMA at all
+ * the flags are exposed flag_stride apart, which must be set before they are
+ * allocated (PNBC_OSC_SHM_FLAG_STRIDE), and they are zeroed by this call */
+int pnbc_osc_win_allocate_shared(ompi_communicator_t *comm, ompi_info_t *info,
+                                 PNBC_OSC_Schedule *schedule, size_t data_size, char **data);
+
+#define PNBC_OSC_WIN_ADDR_BUF(addrs, rank)   ((addrs)[rank])
+
+#endif
@@ -200,6 +200,25 @@ int PNBC_OSC_Sched_unpack (void *inbuf, char tmpinbuf, int count, MPI_Datatype d
 int PNBC_OSC_Sched_barrier (PNBC_OSC_Schedule *schedule);
 int PNBC_OSC_Sched_commit (PNBC_OSC_Schedule *schedule);
 
+/* allocate triggers, flags, requests and action arguments for a trigger-based schedule */
+int PNBC_OSC_Sched_trigger_alloc (PNBC_OSC_Schedule *schedule, int num_triggers,
+                                  int num_rma_flags, int num_local_flags,
+                                  int num_requests, int num_args);
+
+/* allocate a trigger-based schedule for nsteps pull steps using nslots flag slots */
+int PNBC_OSC_Sched_pull_alloc (PNBC_OSC_Schedule *schedule, int nsteps, int nslots);
+
+/* create the triggers for nsteps pull steps, run in order after the (optional) start copy,
+ * the RTS/DONE flags of the peers are at the slot of the step in their flags window,
+ * or, with peer_flags, at the indices held by the steps themselves */
+int PNBC_OSC_Sched_pull_steps (PNBC_OSC_Schedule *schedule, MPI_Win win,
+                               PNBC_OSC_Pull_step *steps, int nsteps, int nslots,
+                               bool peer_flags, const copy_args_t *start_copy);
+
+/* build the scan order used by progress, once all triggers have been created
+ * (called by PNBC_OSC_Sched_pull_steps) */
+int PNBC_OSC_Sched_trigger_index (PNBC_OSC_Schedule *schedule);
+
 
 int PNBC_OSC_Schedule_request(PNBC_OSC_Schedule *schedule, ompi_communicator_t *comm,
                               ompi_coll_libpnbc_osc_module_t *module, bool persistent,
@@ -0,0 +1,80 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_helper_neighbor.h"
+#include "ompi/mca/topo/base/base.h"
+
+// every edge carries the same count, block j of the data is at j * count * extent
+int ompi_coll_libpnbc_osc_neighbor_alltoall_init(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                        void* recvbuf, int recvcount, MPI_Datatype recvtype,
+                        struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+  int res, indegree, outdegree, *counts;
+  MPI_Aint sendext, recvext, *displs;
+
+  res = ompi_datatype_type_extent (sendtype, &sendext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+
+  res = ompi_datatype_type_extent (recvtype, &recvext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+
+  res = mca_topo_base_neighbor_count (comm, &indegree, &outdegree);
+  if (OMPI_SUCCESS != res) {
+    return res;
+  }
+
+  // counts and displacements in bytes, destinations first
+  counts = (int*)malloc((outdegree + indegree + 1) * sizeof(int));
+  displs = (MPI_Aint*)malloc((outdegree + indegree + 1) * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == counts || NULL == displs)) {
+    free(counts);
+    free(displs);
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+  for (int j = 0;j < outdegree;++j) {
+    counts[j] = sendcount;
+    displs[j] = (MPI_Aint)j * sendcount * sendext;
+  }
+  for (int i = 0;i < indegree;++i) {
+    counts[outdegree + i] = recvcount;
+    displs[outdegree + i] = (MPI_Aint)i * recvcount * recvext;
+  }
+
+  res = pnbc_osc_neighbor_init(sendbuf, counts, displs, sendtype,
+                               recvbuf, counts + outdegree, displs + outdegree, recvtype,
+                               comm, info, request, module, true);
+  free(counts);
+  free(displs);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    return res;
+  }
+
+  return OMPI_SUCCESS;
+}
@@ -0,0 +1,309 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2006      The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2006      The Technical University of Chemnitz. All
+ *                         rights reserved.
+ * Copyright (c) 2014-2018 Research Organization for Information Science
+ *                         and Technology (RIST).  All rights reserved.
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC. All rights
+ *                         reserved.
+ * Copyright (c) 2017      IBM Corporation.  All rights reserved.
+ * Copyright (c) 2018      FUJITSU LIMITED.  All rights reserved.
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * Author(s): Daniel Holmes  EPCC, The University of Edinburgh
+ *
+ */
+#include "pnbc_osc_debug.h"
+#include "pnbc_osc_internal.h"
+#include "pnbc_osc_action_common.h"
+#include "pnbc_osc_helper_win.h"
+#include "pnbc_osc_helper_neighbor.h"
+#include "ompi/mca/topo/base/base.h"
+
+int ompi_coll_libpnbc_osc_neighbor_alltoallv_init(const void* sendbuf, const int *sendcounts, const int *sdispls,
+                        MPI_Datatype sendtype, void* recvbuf, const int *recvcounts, const int *rdispls,
+                        MPI_Datatype recvtype, struct ompi_communicator_t *comm, MPI_Info info,
+                        ompi_request_t ** request, struct mca_coll_base_module_2_3_0_t *module) {
+  int res, indegree, outdegree;
+  MPI_Aint sendext, recvext, *displs;
+
+  res = ompi_datatype_type_extent (sendtype, &sendext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+
+  res = ompi_datatype_type_extent (recvtype, &recvext);
+  if (MPI_SUCCESS != res) {
+    PNBC_OSC_Error("MPI Error in ompi_datatype_type_extent() (%i)", res);
+    return res;
+  }
+
+  res = mca_topo_base_neighbor_count (comm, &indegree, &outdegree);
+  if (OMPI_SUCCESS != res) {
+    return res;
+  }
+
+  // the displacements in bytes, destinations first
+  displs = (MPI_Aint*)malloc((outdegree + indegree + 1) * sizeof(MPI_Aint));
+  if (OPAL_UNLIKELY(NULL == displs)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+  for (int j = 0;j < outdegree;++j) {
+    displs[j] = (MPI_Aint)sdispls[j] * sendext;
+  }
+  for (int i = 0;i < indegree;++i) {
+    displs[outdegree + i] = (MPI_Aint)rdispls[i] * recvext;
+  }
+
+  res = pnbc_osc_neighbor_init(sendbuf, sendcounts, displs, sendtype,
+                               recvbuf, recvcounts, displs + outdegree, recvtype,
+                               comm, info, request, module, true);
+  free(displs);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    return res;
+  }
+
+  return OMPI_SUCCESS;
+}
+
+// consecutive edges that send the same block (e.g. allgather) share its packed copy
+static inline bool pnbc_osc_neighbor_shares_block(int j, const int *destinations,
+                                                  const int *sendcounts, const MPI_Aint *sdispls) {
+  return 0 < j && MPI_PROC_NULL != destinations[j - 1] &&
+         sdispls[j] == sdispls[j - 1] && sendcounts[j] == sendcounts[j - 1];
+}
+
+// exchange step k reads block k of the receive data from sources[k] and lets
+// destinations[k] read block k of the send data; a destination reads its block
+// as plain bytes, straight out of sendbuf when the layout of every block is
+// contiguous, otherwise from a staging buffer that is packed at every start;
+// incoming blocks go straight into recvbuf when the layout is contiguous,
+// otherwise into a staging buffer, unpacked locally when they have arrived
+int pnbc_osc_neighbor_init(const void *sendbuf, const int *sendcounts, const MPI_Aint *sdispls,
+                           MPI_Datatype sendtype, void *recvbuf, const int *recvcounts,
+                           const MPI_Aint *rdispls, MPI_Datatype recvtype,
+                           struct ompi_communicator_t *comm, MPI_Info info,
+                           ompi_request_t **request, struct mca_coll_base_module_2_3_0_t *module,
+                           bool persistent)
+{
+  int res;
+  bool send_staged = false;
+  ptrdiff_t send_lb, recv_lb, true_extent, gap, span;
+  size_t sendsize, recvsize, send_stage_size = 0, recv_stage_size = 0;
+  PNBC_OSC_Schedule *schedule = NULL;
+  PNBC_OSC_Pull_step *steps = NULL;
+  copy_args_t *copies = NULL;
+  MPI_Aint *addrs = NULL, *block_addrs, *in_addrs, *out_addrs;
+  size_t *stage_offsets = NULL, *send_offsets, *recv_offsets;
+  int *sources = NULL, *destinations, indegree, outdegree, nslots, nsteps = 0;
+  MPI_Win win = MPI_WIN_NULL;
+  char *send_stage, *recv_stage;
+  ptrdiff_t send_lo = PTRDIFF_MAX, send_hi = PTRDIFF_MIN;
+  ompi_coll_libpnbc_osc_module_t *libpnbc_osc_module = (ompi_coll_libpnbc_osc_module_t*) module;
+
+  res = pnbc_osc_comm_neighbors (comm, &sources, &indegree, &destinations, &outdegree);
+  if (OMPI_SUCCESS != res) {
+    free(sources);
+    return res;
+  }
+
+  nslots = (indegree > outdegree) ? indegree : outdegree;
+  if (0 == nslots) {
+    free(sources);
+    return nbc_get_noop_request(persistent, request);
+  }
+
+  ompi_datatype_get_true_extent (sendtype, &send_lb, &true_extent);
+  ompi_datatype_get_true_extent (recvtype, &recv_lb, &true_extent);
+  ompi_datatype_type_size (sendtype, &sendsize);
+  ompi_datatype_type_size (recvtype, &recvsize);
+
+  schedule = OBJ_NEW(PNBC_OSC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    free(sources);
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  // at most one pack step per destination and one exchange step per slot
+  steps = (PNBC_OSC_Pull_step*)malloc((outdegree + nslots) * sizeof(PNBC_OSC_Pull_step));
+  copies = (copy_args_t*)malloc((outdegree + indegree + 1) * sizeof(copy_args_t));
+  addrs = (MPI_Aint*)malloc((2 * outdegree + 2 * indegree + 1) * sizeof(MPI_Aint));
+  stage_offsets = (size_t*)malloc((outdegree + indegree + 1) * sizeof(size_t));
+  if (OPAL_UNLIKELY(NULL == steps || NULL == copies || NULL == addrs || NULL == stage_offsets)) {
+    res = OMPI_ERR_OUT_OF_RESOURCE;
+    goto cleanup;
+  }
+  block_addrs = &addrs[0];
+  out_addrs = &addrs[outdegree];
+  in_addrs = &addrs[2 * outdegree];
+  send_offsets = &stage_offsets[0];
+  recv_offsets = &stage_offsets[outdegree];
+
+  // the send side is staged as a whole, unless every block can be read where it is
+  for (int j = 0;j < outdegree;++j) {
+    if (MPI_PROC_NULL == destinations[j] || 0 == sendcounts[j] * sendsize) continue;
+    if (!ompi_datatype_is_contiguous_memory_layout(sendtype, sendcounts[j])) {
+      send_staged = true;
+    }
+  }
+
+  // lay out the staging buffers, one packed block per edge
+  for (int j = 0;j < outdegree;++j) {
+    if (pnbc_osc_neighbor_shares_block(j, destinations, sendcounts, sdispls)) {
+      send_offsets[j] = send_offsets[j - 1];
+      continue;
+    }
+    send_offsets[j] = send_stage_size;
+    if (send_staged && MPI_PROC_NULL != destinations[j]) {
+      send_stage_size += sendcounts[j] * sendsize;
+    }
+  }
+  for (int i = 0;i < indegree;++i) {
+    recv_offsets[i] = recv_stage_size;
+    if (MPI_PROC_NULL == sources[i]) continue;
+    if (!ompi_datatype_is_contiguous_memory_layout(recvtype, recvcounts[i])) {
+      recv_stage_size += recvcounts[i] * recvsize;
+    }
+  }
+  // allocated once here, reused by every start
+  if (0 < send_stage_size + recv_stage_size) {
+    schedule->tmpbuf = malloc(send_stage_size + recv_stage_size);
+    if (OPAL_UNLIKELY(NULL == schedule->tmpbuf)) {
+      res = OMPI_ERR_OUT_OF_RESOURCE;
+      goto cleanup;
+    }
+  }
+  send_stage = (char*)schedule->tmpbuf;
+  recv_stage = send_stage + send_stage_size;
+
+  // record where each destination has to read its block from, and which part of sendbuf to expose
+  for (int j = 0;j < outdegree;++j) {
+    block_addrs[j] = 0;
+    if (MPI_PROC_NULL == destinations[j] || 0 == sendcounts[j] * sendsize) continue;
+    if (send_staged) {
+      block_addrs[j] = (MPI_Aint)(send_stage + send_offsets[j]);
+    } else {
+      block_addrs[j] = (MPI_Aint)((const char*)sendbuf + sdispls[j] + send_lb);
+      span = opal_datatype_span(&sendtype->super, sendcounts[j], &gap);
+      if (sdispls[j] + gap < send_lo) send_lo = sdispls[j] + gap;
+      if (sdispls[j] + gap + span > send_hi) send_hi = sdispls[j] + gap + span;
+    }
+  }
+
+  res = PNBC_OSC_Sched_pull_alloc(schedule, outdegree + nslots, nslots);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    goto cleanup;
+  }
+
+  // expose the send data and the flags, then swap addresses with the neighbours only
+  if (send_staged) {
+    res = pnbc_osc_win_create(comm, info, send_stage, 0, send_stage_size, schedule, &win);
+  } else {
+    res = pnbc_osc_win_create(comm, info, (void*)sendbuf, (send_lo < send_hi) ? send_lo : 0,
+                              (send_lo < send_hi) ? (size_t)(send_hi - send_lo) : 0,
+                              schedule, &win);
+  }
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  res = pnbc_osc_neighbor_exchange(comm, nslots, sources, indegree, destinations, outdegree,
+                                   block_addrs, in_addrs, out_addrs);
+  if (OMPI_SUCCESS != res) {
+    goto cleanup;
+  }
+
+  // pack steps: fill the send staging buffer before telling anyone that it is ready
+  for (int j = 0;j < outdegree && send_staged;++j) {
+    if (MPI_PROC_NULL == destinations[j] || 0 == sendcounts[j] * sendsize) continue;
+    if (pnbc_osc_neighbor_shares_block(j, destinations, sendcounts, sdispls)) continue;
+    copies[j] = (copy_args_t){ .src = (const char*)sendbuf + sdispls[j],
+                               .srccount = sendcounts[j], .srctype = sendtype,
+                               .tgt = send_stage + send_offsets[j],
+                               .tgtcount = (int)(sendcounts[j] * sendsize), .tgttype = MPI_PACKED };
+    steps[nsteps++] = (PNBC_OSC_Pull_step){ .from = MPI_PROC_NULL, .to = MPI_PROC_NULL,
+                                            .done_unblocks = -1, .fin_copy = &copies[j] };
+  }
+
+  // exchange steps: all neighbours at once
+  for (int k = 0;k < nslots;++k) {
+    bool recv_contig = true;
+    size_t recvbytes = 0;
+    int from = MPI_PROC_NULL, to = MPI_PROC_NULL;
+
+    if (k < indegree && MPI_PROC_NULL != sources[k]) {
+      recvbytes = recvcounts[k] * recvsize;
+      recv_contig = ompi_datatype_is_contiguous_memory_layout(recvtype, recvcounts[k]);
+      if (0 < recvbytes) from = sources[k];
+    }
+    if (k < outdegree && MPI_PROC_NULL != destinations[k] && 0 < sendcounts[k] * sendsize) {
+      to = destinations[k];
+    }
+
+    if (MPI_PROC_NULL == from && MPI_PROC_NULL == to) continue;
+
+    if (MPI_PROC_NULL != from) {
+      copies[outdegree + k] = (copy_args_t){ .src = recv_stage + recv_offsets[k],
+                                             .srccount = (int)recvbytes, .srctype = MPI_PACKED,
+                                             .tgt = (char*)recvbuf + rdispls[k],
+                                             .tgtcount = recvcounts[k], .tgttype = recvtype };
+    }
+    steps[nsteps++] = (PNBC_OSC_Pull_step){ .slot = k, .from = from,
+                                            .from_displ = (MPI_PROC_NULL == from) ? 0 : PNBC_OSC_NEIGHBOR_ADDR_BUF(in_addrs, k),
+                                            .from_done_flag = (MPI_PROC_NULL == from) ? 0 : PNBC_OSC_NEIGHBOR_FLAG_DONE(in_addrs, k),
+                                            .tgt = recv_contig ? (char*)recvbuf + rdispls[k] + recv_lb
+                                                               : recv_stage + recv_offsets[k],
+                                            .count = (int)recvbytes, .datatype = MPI_BYTE,
+                                            .to = to, .to_rts_flag = (MPI_PROC_NULL == to) ? 0 : (int)out_addrs[k],
+                                            .done_unblocks = -1, .overlap_next = true,
+                                            .fin_copy = (recv_contig || MPI_PROC_NULL == from) ? NULL : &copies[outdegree + k] };
+    PNBC_OSC_DEBUG(10, "[pnbc_neighbor_init] slot %d reads %lu bytes from %d (%s), is read by %d (%s)\n",
+                   k, (unsigned long)recvbytes, from, recv_contig ? "direct" : "staged",
+                   to, send_staged ? "staged" : "direct");
+  }
+  if (0 < nsteps) {
+    steps[nsteps - 1].overlap_next = false;
+  }
+
+  res = PNBC_OSC_Sched_pull_steps(schedule, win, steps, nsteps, nslots, true, NULL);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Sched_pull_steps (%i)", res);
+    goto cleanup;
+  }
+
+  res = PNBC_OSC_Schedule_request_win(schedule, comm, win, libpnbc_osc_module, persistent, request);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    PNBC_OSC_Error ("MPI Error in PNBC_OSC_Schedule_request_win (%i)", res);
+    goto cleanup;
+  }
+
+  // the step descriptions, copies and remote addresses are now stored in the action arguments
+  free(steps);
+  free(copies);
+  free(addrs);
+  free(stage_offsets);
+  free(sources);
+
+  return OMPI_SUCCESS;
+
+ cleanup:
+  if (MPI_WIN_NULL != win) {
+    win->w_osc_module->osc_unlock_all(win);
+    ompi_win_free(win);
+  }
+  free(steps);
+  free(copies);
+  free(addrs);
+  free(stage_offsets);
+  free(sources);
+  OBJ_RELEASE(schedule);
+  return res;
+}
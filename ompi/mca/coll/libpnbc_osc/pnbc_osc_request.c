@@ -1,5 +1,6 @@
 #include "pnbc_osc_request.h"
 #include "pnbc_osc_debug.h"
+#include "ompi/win/win.h"
 
 int PNBC_OSC_Start(ompi_coll_libpnbc_osc_request_t *handle);
 void PNBC_OSC_Free (ompi_coll_libpnbc_osc_request_t* handle);
@@ -24,6 +25,11 @@ request_construct(ompi_coll_libpnbc_osc_request_t *request)
     request->super.req_start = request_start;
     request->super.req_cancel = request_cancel;
     request->super.req_free = request_free;
+    request->schedule = NULL;
+    request->req_count = 0;
+    request->req_array = NULL;
+    request->win = MPI_WIN_NULL;
+    request->tmpbuf = NULL;
 }
 
 static void
@@ -37,14 +43,6 @@ request_destruct(ompi_coll_libpnbc_osc_request_t *request)
     }
     free(request->req_array);
   }
-  if (MPI_WIN_NULL == request->win) {
-    MPI_Win_unlock_all(request->win);
-    OBJ_DESTRUCT(request->win);
-  }
-  if (MPI_WIN_NULL == request->winflag) {
-    MPI_Win_unlock_all(request->winflag);
-    OBJ_DESTRUCT(request->winflag);
-  }
   if (NULL != request->tmpbuf)
     free(request->tmpbuf);
 }
@@ -118,6 +116,14 @@ request_free(struct ompi_request_t **ompi_req)
 
 void PNBC_OSC_Free (ompi_coll_libpnbc_osc_request_t* handle) {
 
+  if (MPI_WIN_NULL != handle->win) {
+    /* close the passive target epoch opened at init, then free the window
+     * before the schedule that owns the memory attached to it */
+    handle->win->w_osc_module->osc_unlock_all(handle->win);
+    ompi_win_free(handle->win);
+    handle->win = MPI_WIN_NULL;
+  }
+
   if (NULL != handle->schedule) {
     /* release schedule */
     OBJ_RELEASE (handle->schedule);
@@ -43,7 +43,6 @@ struct ompi_coll_libpnbc_osc_request_t {
     ompi_request_t **req_array;
     ompi_coll_libpnbc_osc_module_t *comminfo;
     MPI_Win win;
-    MPI_Win winflag;
     void *tmpbuf; /* temporary buffer e.g. used for Reduce */
 };
 typedef struct ompi_coll_libpnbc_osc_request_t ompi_coll_libpnbc_osc_request_t;
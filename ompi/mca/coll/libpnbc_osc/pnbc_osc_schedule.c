@@ -27,17 +27,67 @@
 #include "pnbc_osc_debug.h"
 #include "pnbc_osc_internal.h"
 #include "pnbc_osc_schedule.h"
+#include "pnbc_osc_helper_win.h"
+
+static const int PNBC_OSC_FLAG_SIGNAL = 1;
 
 static void PNBC_OSC_Schedule_constructor (PNBC_OSC_Schedule *schedule) {
   /* initial total size of the schedule */
   schedule->size = sizeof (int);
   schedule->current_round_offset = 0;
   schedule->data = calloc (1, schedule->size);
+
+  /* empty trigger-based schedule */
+  schedule->triggers_active = 0;
+  schedule->triggers_length = 0;
+  schedule->triggers = NULL;
+  memset (&schedule->trigger_bitmap, 0, sizeof (schedule->trigger_bitmap));
+  schedule->trigger_arrays_length = 0;
+  schedule->trigger_arrays = NULL;
+  schedule->start_pending = 0;
+  schedule->flags = NULL;
+  schedule->flags_seen = NULL;
+  schedule->flags_win = MPI_WIN_NULL;
+  schedule->flag_stride = 1;
+  schedule->shm_bases = NULL;
+  schedule->flags_length = 0;
+  schedule->num_flags = 0;
+  schedule->requests = NULL;
+  schedule->num_requests = 0;
+  schedule->action_args_list = NULL;
+  schedule->tmpbuf = NULL;
+  schedule->number_of_rounds = 0;
+  schedule->restart_round = 0;
 }
 
 static void PNBC_OSC_Schedule_destructor (PNBC_OSC_Schedule *schedule) {
   free (schedule->data);
   schedule->data = NULL;
+
+  free (schedule->triggers);
+  schedule->triggers = NULL;
+  trigger_bitmap_free (&schedule->trigger_bitmap);
+  free (schedule->trigger_arrays);
+  schedule->trigger_arrays = NULL;
+  if (MPI_WIN_NULL != schedule->flags_win) {
+    // the flags are the memory of the window
+    schedule->flags_win->w_osc_module->osc_unlock_all (schedule->flags_win);
+    ompi_win_free (schedule->flags_win);
+    schedule->flags_win = MPI_WIN_NULL;
+  } else {
+    free (schedule->flags);
+  }
+  schedule->flags = NULL;
+  free (schedule->flags_seen);
+  schedule->flags_seen = NULL;
+  free (schedule->shm_bases);
+  schedule->shm_bases = NULL;
+  free (schedule->requests);
+  schedule->requests = NULL;
+  free (schedule->action_args_list);
+  schedule->action_args_list = NULL;
+  free (schedule->tmpbuf);
+  schedule->tmpbuf = NULL;
 }
 
 OBJ_CLASS_INSTANCE(PNBC_OSC_Schedule, opal_object_t,
@@ -263,6 +313,306 @@ int PNBC_OSC_Sched_win_free ( PNBC_OSC_Schedule *schedule, bool barrier) {
   return OMPI_SUCCESS;
 }
 
+/* this function allocates the storage for a trigger-based schedule
+ * the first num_rma_flags flags are exposed to remote processes via the window,
+ * the remaining num_local_flags flags are counters that are only used locally
+ * (the flags move into the memory of the flags window, if one is allocated) */
+int PNBC_OSC_Sched_trigger_alloc (PNBC_OSC_Schedule *schedule, int num_triggers,
+                                  int num_rma_flags, int num_local_flags,
+                                  int num_requests, int num_args) {
+  schedule->triggers = calloc (num_triggers, sizeof (triggerable_t));
+  schedule->flags = calloc (num_rma_flags + num_local_flags + 1, sizeof (FLAG_t));
+  schedule->flags_seen = calloc (num_rma_flags + num_local_flags + 1, sizeof (FLAG_t));
+  schedule->requests = calloc (num_requests + 1, sizeof (MPI_Request));
+  schedule->action_args_list = calloc (num_args + 1, sizeof (any_args_t));
+  if (OPAL_UNLIKELY((0 < num_triggers && NULL == schedule->triggers) || NULL == schedule->flags ||
+                    NULL == schedule->flags_seen || NULL == schedule->requests || NULL == schedule->action_args_list)) {
+    PNBC_OSC_Error ("Could not allocate the triggers of PNBC_OSC schedule");
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  schedule->triggers_length = num_triggers;
+  schedule->flags_length = num_rma_flags * sizeof (FLAG_t);
+  schedule->num_flags = num_rma_flags + num_local_flags;
+  schedule->num_requests = num_requests;
+
+  PNBC_OSC_DEBUG(10, "allocated schedule %p with %i triggers, %i flags (%i exposed), %i requests\n",
+                 schedule, num_triggers, num_rma_flags + num_local_flags, num_rma_flags, num_requests);
+
+  return OMPI_SUCCESS;
+}
+
+/* this function allocates a trigger-based schedule for pull steps
+ * flags:    [RTS per slot][DONE per slot] exposed (flag_stride apart), then
+ *           [send, get, fin counters per step] local
+ * requests: [RTS put per step][data get per step][DONE put per step]
+ * triggers: one for start, at most eight per step
+ * args:     at most nine per step, plus the start sequence and copy */
+int PNBC_OSC_Sched_pull_alloc (PNBC_OSC_Schedule *schedule, int nsteps, int nslots) {
+  return PNBC_OSC_Sched_trigger_alloc (schedule, 8 * nsteps + 1, 2 * nslots * schedule->flag_stride, 3 * nsteps,
+                                       3 * nsteps, 9 * nsteps + 2);
+}
+
+/* a signal atomically adds one to a flag of the target, so it is never lost or
+ * overwritten, however early it arrives, and needs no flush or epoch of its own */
+static inline void PNBC_OSC_Sched_flag_signal_args (accumulate_args_t *args, MPI_Win win, int target,
+                                                    int target_flag, MPI_Request *request) {
+  args->buf = &PNBC_OSC_FLAG_SIGNAL;
+  args->origin_count = 1;
+  args->origin_datatype = MPI_INT;
+  args->target = target;
+  args->target_displ = target_flag;
+  args->target_count = 1;
+  args->target_datatype = MPI_INT;
+  args->op = MPI_SUM;
+  args->win = win;
+  args->request = request;
+}
+
+/* this function creates the triggers for a sequence of pull steps */
+int PNBC_OSC_Sched_pull_steps (PNBC_OSC_Schedule *schedule, MPI_Win win,
+                               PNBC_OSC_Pull_step *steps, int nsteps, int nslots,
+                               bool peer_flags, const copy_args_t *start_copy) {
+  const int stride = schedule->flag_stride;
+  const bool shm = (NULL != schedule->shm_bases);
+  FLAG_t *flags_rts = &(schedule->flags[0 * nslots * stride]); // signalled remotely by 'from'
+  FLAG_t *flags_done = &(schedule->flags[1 * nslots * stride]); // signalled remotely by 'to'
+  FLAG_t *seen_rts = &(schedule->flags_seen[0 * nslots * stride]);
+  FLAG_t *seen_done = &(schedule->flags_seen[1 * nslots * stride]);
+  FLAG_t *send_deps = &(schedule->flags[2 * nslots * stride + 0 * nsteps]);
+  FLAG_t *get_deps = &(schedule->flags[2 * nslots * stride + 1 * nsteps]);
+  FLAG_t *fin_deps = &(schedule->flags[2 * nslots * stride + 2 * nsteps]);
+  MPI_Request *requests_rts = &(schedule->requests[0 * nsteps]);
+  MPI_Request *requests_get = &(schedule->requests[1 * nsteps]);
+  MPI_Request *requests_done = &(schedule->requests[2 * nsteps]);
+  any_args_t *args = schedule->action_args_list;
+  triggerable_t *triggers = schedule->triggers;
+  int *extra_get_deps, *extra_send_deps, *join;
+  seq_args_t *seq;
+  int t = 0, a = 0;
+
+  if (OPAL_UNLIKELY(MPI_WIN_NULL == schedule->flags_win)) {
+    PNBC_OSC_Error ("PNBC_OSC pull steps need the flags window of the schedule");
+    return OMPI_ERR_BAD_PARAM;
+  }
+
+  // some steps cannot get their data before a DONE for an earlier step has arrived
+  extra_get_deps = calloc (3 * (nsteps + 1), sizeof (int));
+  if (OPAL_UNLIKELY(NULL == extra_get_deps)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+  extra_send_deps = extra_get_deps + (nsteps + 1);
+  join = extra_send_deps + (nsteps + 1);
+  for (int i = 0 ; i < nsteps ; ++i) {
+    if (0 <= steps[i].done_unblocks) {
+      ++extra_get_deps[steps[i].done_unblocks];
+    }
+  }
+
+  // the end of every overlapped step is joined at the first step after its run
+  for (int i = nsteps - 1 ; i >= 0 ; --i) {
+    join[i] = (i + 1 < nsteps && steps[i].overlap_next) ? join[i + 1] : i + 1;
+    if (steps[i].overlap_next && join[i] < nsteps) {
+      ++extra_send_deps[join[i]];
+    }
+  }
+
+  // start - triggered by: local start
+  //         action: copy the local input (if needed) and begin the first step
+  seq = &(args[a++].seq_args);
+  seq->num_actions = 0;
+  if (NULL != start_copy) {
+    args[a].copy_args = *start_copy;
+    action_sequence_append (seq, action_all_copy_p, &(args[a++].copy_args));
+  }
+  if (0 < nsteps) {
+    action_sequence_append (seq, action_all_decrement_int_p, &send_deps[0]);
+  }
+  trigger_init_flag (&triggers[t++], &(schedule->start_pending), action_all_sequence_p, seq);
+
+  for (int i = 0 ; i < nsteps ; ++i) {
+    PNBC_OSC_Pull_step *step = &steps[i];
+    bool has_from = (MPI_PROC_NULL != step->from);
+    bool has_to = (MPI_PROC_NULL != step->to);
+    bool fin_waits_done = has_to && step->fin_waits_done;
+    bool overlap = step->overlap_next && i + 1 < nsteps;
+
+    // send - triggered by: end of previous step (or start)
+    //        action: signal RTS to 'to', the local data for this step is ready
+    seq = &(args[a++].seq_args);
+    seq->num_actions = 0;
+    if (has_to) {
+      int flag = peer_flags ? step->to_rts_flag : (0 * nslots + step->slot) * stride;
+      if (shm) {
+        action_sequence_append (seq, action_all_signal_int_p,
+                                (FLAG_t*)schedule->shm_bases[step->to] + flag);
+      } else {
+        accumulate_args_t *signal = &(args[a++].accumulate_args);
+        PNBC_OSC_Sched_flag_signal_args (signal, schedule->flags_win, step->to, flag, &requests_rts[i]);
+        action_sequence_append (seq, action_all_accumulate_p, signal);
+        trigger_init_request (&triggers[t++], &requests_rts[i], action_all_noop, NULL);
+      }
+    }
+    action_sequence_append (seq, action_all_decrement_int_p, &get_deps[i]);
+    trigger_init_counter (&triggers[t++], &send_deps[i], 1 + extra_send_deps[i],
+                          action_all_sequence_p, seq);
+
+    if (has_from && shm) {
+      int flag = peer_flags ? step->from_done_flag : (1 * nslots + step->slot) * stride;
+      copy_args_t *copy;
+
+      // rts - triggered by: shared memory signal from 'from'
+      //       action: update get dependency counter
+      trigger_init_signal (&triggers[t++], &flags_rts[step->slot * stride], &seen_rts[step->slot * stride],
+                           action_all_decrement_int_p, &get_deps[i]);
+
+      // get - triggered by: rts, send (and DONE for an earlier step, if required)
+      //       action: copy DATA out of the segment of 'from', signal DONE to 'from',
+      //               update fin dependency counter (and begin the next step, if overlapped)
+      copy = &(args[a++].copy_args);
+      copy->src = schedule->shm_bases[step->from] + step->from_displ;
+      copy->srccount = copy->tgtcount = step->count;
+      copy->srctype = copy->tgttype = step->datatype;
+      copy->tgt = step->tgt;
+      seq = &(args[a++].seq_args);
+      seq->num_actions = 0;
+      action_sequence_append (seq, action_all_copy_p, copy);
+      action_sequence_append (seq, action_all_signal_int_p, (FLAG_t*)schedule->shm_bases[step->from] + flag);
+      action_sequence_append (seq, action_all_decrement_int_p, &fin_deps[i]);
+      if (overlap) {
+        action_sequence_append (seq, action_all_decrement_int_p, &send_deps[i + 1]);
+      }
+      trigger_init_counter (&triggers[t++], &get_deps[i], 2 + extra_get_deps[i],
+                            action_all_sequence_p, seq);
+    } else if (has_from) {
+      get_args_t *get;
+      accumulate_args_t *signal;
+
+      // rts - triggered by: remote rma signal from 'from'
+      //       action: update get dependency counter
+      trigger_init_signal (&triggers[t++], &flags_rts[step->slot * stride], &seen_rts[step->slot * stride],
+                           action_all_decrement_int_p, &get_deps[i]);
+
+      // get - triggered by: rts, send (and DONE for an earlier step, if required)
+      //       action: get DATA from 'from'
+      get = &(args[a++].get_args);
+      get->buf = step->tgt;
+      get->origin_count = get->target_count = step->count;
+      get->origin_datatype = get->target_datatype = step->datatype;
+      get->target = step->from;
+      get->target_displ = step->from_displ;
+      get->win = win;
+      get->request = &requests_get[i];
+      if (overlap) {
+        seq = &(args[a++].seq_args);
+        seq->num_actions = 0;
+        action_sequence_append (seq, action_all_get_p, get);
+        action_sequence_append (seq, action_all_decrement_int_p, &send_deps[i + 1]);
+        trigger_init_counter (&triggers[t++], &get_deps[i], 2 + extra_get_deps[i],
+                              action_all_sequence_p, seq);
+      } else {
+        trigger_init_counter (&triggers[t++], &get_deps[i], 2 + extra_get_deps[i],
+                              action_all_get_p, get);
+      }
+
+      // got - triggered by: local test of the get request
+      //       action: signal DONE to 'from' and update fin dependency counter
+      seq = &(args[a++].seq_args);
+      seq->num_actions = 0;
+      signal = &(args[a++].accumulate_args);
+      PNBC_OSC_Sched_flag_signal_args (signal, schedule->flags_win, step->from,
+                                       peer_flags ? step->from_done_flag : (1 * nslots + step->slot) * stride,
+                                       &requests_done[i]);
+      action_sequence_append (seq, action_all_accumulate_p, signal);
+      action_sequence_append (seq, action_all_decrement_int_p, &fin_deps[i]);
+      trigger_init_request (&triggers[t++], &requests_get[i], action_all_sequence_p, seq);
+      trigger_init_request (&triggers[t++], &requests_done[i], action_all_noop, NULL);
+    } else if (overlap) {
+      // nothing to get - the step can finish and the next one start as soon as it has been reached
+      seq = &(args[a++].seq_args);
+      seq->num_actions = 0;
+      action_sequence_append (seq, action_all_decrement_int_p, &fin_deps[i]);
+      action_sequence_append (seq, action_all_decrement_int_p, &send_deps[i + 1]);
+      trigger_init_counter (&triggers[t++], &get_deps[i], 1 + extra_get_deps[i],
+                            action_all_sequence_p, seq);
+    } else {
+      // nothing to get - the step can finish as soon as it has been reached
+      trigger_init_counter (&triggers[t++], &get_deps[i], 1 + extra_get_deps[i],
+                            action_all_decrement_int_p, &fin_deps[i]);
+    }
+
+    if (has_to) {
+      // done - triggered by: remote rma signal from 'to'
+      //        action: update whichever dependency counter is waiting for it
+      if (fin_waits_done) {
+        trigger_init_signal (&triggers[t++], &flags_done[step->slot * stride], &seen_done[step->slot * stride],
+                             action_all_decrement_int_p, &fin_deps[i]);
+      } else if (0 <= step->done_unblocks) {
+        trigger_init_signal (&triggers[t++], &flags_done[step->slot * stride], &seen_done[step->slot * stride],
+                             action_all_decrement_int_p, &get_deps[step->done_unblocks]);
+      } else {
+        trigger_init_signal (&triggers[t++], &flags_done[step->slot * stride], &seen_done[step->slot * stride],
+                             action_all_noop, NULL);
+      }
+    }
+
+    // fin - triggered by: got (and done, if required)
+    //       action: reduce and copy (if required) and begin the next step (or join)
+    seq = &(args[a++].seq_args);
+    seq->num_actions = 0;
+    if (NULL != step->reduce_tgt) {
+      reduce_args_t *reduce = &(args[a++].reduce_args);
+      reduce->count = step->count;
+      reduce->datatype = step->datatype;
+      reduce->op = step->op;
+      if (step->reduce_reversed) {
+        reduce->source = step->reduce_tgt;
+        reduce->target = step->tgt;
+        reduce->copy_target = step->reduce_tgt;
+      } else {
+        reduce->source = step->tgt;
+        reduce->target = step->reduce_tgt;
+        reduce->copy_target = NULL;
+      }
+      action_sequence_append (seq, action_all_reduce_p, reduce);
+    }
+    if (NULL != step->fin_copy) {
+      args[a].copy_args = *step->fin_copy;
+      action_sequence_append (seq, action_all_copy_p, &(args[a++].copy_args));
+    }
+    if (join[i] < nsteps) {
+      action_sequence_append (seq, action_all_decrement_int_p, &send_deps[join[i]]);
+    }
+    trigger_init_counter (&triggers[t++], &fin_deps[i], 1 + (fin_waits_done ? 1 : 0),
+                          action_all_sequence_p, seq);
+  }
+
+  schedule->triggers_length = t;
+  free (extra_get_deps);
+
+  PNBC_OSC_DEBUG(10, "created %i triggers for %i pull steps in schedule %p\n", t, nsteps, schedule);
+
+  return PNBC_OSC_Sched_trigger_index (schedule);
+}
+
+/* this function builds the scan order of the triggers, once all of them have been created
+ * progress finds the ready triggers by scanning the flags and requests arrays
+ * rather than by calling the test of every trigger that has not fired yet */
+int PNBC_OSC_Sched_trigger_index (PNBC_OSC_Schedule *schedule) {
+  trigger_bitmap_free (&schedule->trigger_bitmap);
+  if (0 != trigger_bitmap_init (&schedule->trigger_bitmap, schedule->triggers, schedule->triggers_length,
+                                schedule->flags, schedule->flags_seen, schedule->num_flags,
+                                (void **) schedule->requests, schedule->num_requests)) {
+    PNBC_OSC_Error ("Could not allocate the trigger index of PNBC_OSC schedule");
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
+
+  PNBC_OSC_DEBUG(10, "indexed schedule %p, %i of %i triggers are tested one by one\n",
+                 schedule, schedule->trigger_bitmap.num_other, schedule->triggers_length);
+
+  return OMPI_SUCCESS;
+}
+
 /* this function ends a round of a schedule */
 int PNBC_OSC_Sched_barrier (PNBC_OSC_Schedule *schedule) {
   return PNBC_OSC_Schedule_round_append (schedule, NULL, 0, true);
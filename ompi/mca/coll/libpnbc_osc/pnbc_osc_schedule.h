@@ -32,6 +32,7 @@
 #include "pnbc_osc_trigger_common.h"
 #include "pnbc_osc_trigger_single.h"
 #include "pnbc_osc_trigger_array.h"
+#include "pnbc_osc_trigger_bitmap.h"
 #include "pnbc_osc_action_common.h"
 
 BEGIN_C_DECLS
@@ -131,6 +132,45 @@ struct PNBC_OSC_Round_request_based {
 };
 typedef struct PNBC_OSC_Round_request_based PNBC_OSC_Round_request_based;
 
+/* exposed flags that are signalled through shared memory are a cache line apart,
+ * so that the processes signalling different flags of one process never share a line */
+#define PNBC_OSC_CACHE_LINE 64
+#define PNBC_OSC_SHM_FLAG_STRIDE ((int)(PNBC_OSC_CACHE_LINE / sizeof(FLAG_t)))
+
+/* struct describing one step of a pull-based trigger schedule
+ *   - when the previous step is finished (or at start), tell 'to' that it may read (RTS)
+ *   - when 'from' has told us that its data is ready, get it into tgt
+ *   - when the get is complete, tell 'from' that we have finished reading (DONE)
+ *   - finish the step, optionally reducing tgt into reduce_tgt and then doing fin_copy
+ * either peer may be MPI_PROC_NULL; the flags of a step are at index 'slot',
+ * which must refer to the same step at the reading and the read process
+ * a run of steps with overlap_next set is started back-to-back as soon as each
+ * get has been issued; the step after the run waits for all of them to finish
+ * the flags of the peers are found at the same slot in their flags, unless the
+ * schedule is built with peer_flags, when each step gives their indices itself
+ * with a shared flags window, from_displ is the offset of the data in the
+ * segment of 'from', which is copied directly, and signals are plain atomics
+*/
+struct PNBC_OSC_Pull_step {
+  int slot;                   // index of the RTS/DONE flags used by this step
+  int from;                   // process to read from (MPI_PROC_NULL: no get)
+  MPI_Aint from_displ;        // window displacement of the data to read
+  void *tgt;                  // local destination of the data to read
+  int count;
+  MPI_Datatype datatype;
+  int to;                     // process that reads from us in this step (MPI_PROC_NULL: none)
+  void *reduce_tgt;           // if non-NULL, reduce_tgt = tgt op reduce_tgt at the end of the step
+  MPI_Op op;
+  bool reduce_reversed;       // compute reduce_tgt = reduce_tgt op tgt instead
+  bool fin_waits_done;        // the end of the step must wait for DONE from 'to'
+  int done_unblocks;          // index of a later step whose get must wait for DONE from 'to', or -1
+  bool overlap_next;          // start the next step once our get has been issued
+  const copy_args_t *fin_copy; // if non-NULL, local copy done at the end of the step
+  int to_rts_flag;            // with peer_flags: index of the RTS flag at 'to'
+  int from_done_flag;         // with peer_flags: index of the DONE flag at 'from'
+};
+typedef struct PNBC_OSC_Pull_step PNBC_OSC_Pull_step;
+
 /* struct holding the entire Schedule
    legacy NBC schedule will use heap memory pointed to by *data
    modern PNBC schedules will use the flexible rounds array
@@ -144,12 +184,21 @@ struct PNBC_OSC_Schedule {
   int triggers_active;                  // for trigger-based schedule
   int triggers_length;                  // for trigger-based schedule
   triggerable_t *triggers;              // for trigger-based schedule
+  triggerable_bitmap trigger_bitmap;    // scan order of triggers, built once the triggers are complete
   int trigger_arrays_length;            // for trigger-based schedule
   triggerable_array *trigger_arrays;    // for trigger-based schedule
+  FLAG_t start_pending;                 // set by start, triggers the first action(s)
   FLAG_t *flags;                        // for trigger-based schedule
+  FLAG_t *flags_seen;                   // signals consumed so far, one per element of flags
+  MPI_Win flags_win;                    // window allocated for flags, remote processes signal into it
+  int flag_stride;                      // distance between the exposed flags, in elements of flags
+  char **shm_bases;                     // with a shared flags window: the segment of every process
   int flags_length;                     // for tracking size of flags array
-  MPI_Request **requests;               // for trigger-based schedule
+  int num_flags;                        // number of elements of flags, exposed and local
+  MPI_Request *requests;                // for trigger-based schedule
+  int num_requests;                     // number of elements of requests
   any_args_t *action_args_list;         // for trigger-based schedule
+  void *tmpbuf;                         // scratch space allocated at init, reused by every start
   int number_of_rounds;                 // length of array: rounds
   int restart_round;                    // index into array: rounds
   PNBC_OSC_Round *rounds[];             // list of rounds (polymorphic)
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pnbc_osc_trigger_bitmap.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static inline int trigger_bitmap_ctz(uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  int n = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// flags may be written by remote RMA operations; the scans are only ever called
+// through this translation unit's external functions, so memory is re-read every time
+void trigger_bitmap_scan_differ(const FLAG_t *flags, const FLAG_t *seen, int num_flags,
+                                uint64_t *differ) {
+  int i = 0;
+
+  memset(differ, 0, TRIGGER_BITMAP_WORDS(num_flags) * sizeof(uint64_t));
+#if defined(__AVX2__)
+  for ( ; i + 8 <= num_flags ; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(flags + i));
+    __m256i s = _mm256_loadu_si256((const __m256i*)(seen + i));
+    int eq = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, s)));
+    differ[i >> 6] |= (uint64_t)(~eq & 0xff) << (i & 63);
+  }
+#elif defined(__SSE2__)
+  for ( ; i + 4 <= num_flags ; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(flags + i));
+    __m128i s = _mm_loadu_si128((const __m128i*)(seen + i));
+    int eq = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, s)));
+    differ[i >> 6] |= (uint64_t)(~eq & 0xf) << (i & 63);
+  }
+#endif
+  for ( ; i < num_flags ; ++i) {
+    if (flags[i] != seen[i]) {
+      differ[i >> 6] |= UINT64_C(1) << (i & 63);
+    }
+  }
+}
+
+void trigger_bitmap_scan_nonnull(void *const *slots, int num_slots, uint64_t *nonnull) {
+  int i = 0;
+
+  memset(nonnull, 0, TRIGGER_BITMAP_WORDS(num_slots) * sizeof(uint64_t));
+#if defined(__AVX2__) && UINTPTR_MAX == UINT64_MAX
+  const __m256i zero = _mm256_setzero_si256();
+  for ( ; i + 4 <= num_slots ; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(slots + i));
+    int eq = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, zero)));
+    nonnull[i >> 6] |= (uint64_t)(~eq & 0xf) << (i & 63);
+  }
+#endif
+  for ( ; i < num_slots ; ++i) {
+    if (NULL != slots[i]) {
+      nonnull[i >> 6] |= UINT64_C(1) << (i & 63);
+    }
+  }
+}
+
+int trigger_bitmap_init(triggerable_bitmap *bitmap, triggerable_t *triggers, int num_triggers,
+                        FLAG_t *flags, const FLAG_t *seen, int num_flags,
+                        void **requests, int num_requests) {
+  int flag_words = TRIGGER_BITMAP_WORDS(num_flags);
+  int request_words = TRIGGER_BITMAP_WORDS(num_requests);
+  int other_words = TRIGGER_BITMAP_WORDS(num_triggers);
+  int scratch_words = (flag_words > request_words) ? flag_words : request_words;
+
+  memset(bitmap, 0, sizeof(*bitmap));
+  bitmap->flag_trigger = malloc((num_flags + num_requests + num_triggers + 1) * sizeof(int));
+  bitmap->flag_byzero = calloc(3 * flag_words + 2 * request_words + other_words + scratch_words + 1,
+                               sizeof(uint64_t));
+  if (NULL == bitmap->flag_trigger || NULL == bitmap->flag_byzero) {
+    trigger_bitmap_free(bitmap);
+    return -1;
+  }
+  bitmap->num_flags = num_flags;
+  bitmap->num_requests = num_requests;
+  bitmap->request_trigger = bitmap->flag_trigger + num_flags;
+  bitmap->other_trigger = bitmap->request_trigger + num_requests;
+  bitmap->flag_armed = bitmap->flag_byzero + flag_words;
+  bitmap->flag_pending = bitmap->flag_armed + flag_words;
+  bitmap->request_armed = bitmap->flag_pending + flag_words;
+  bitmap->request_pending = bitmap->request_armed + request_words;
+  bitmap->other_pending = bitmap->request_pending + request_words;
+  bitmap->ready = bitmap->other_pending + other_words;
+
+  // at most one trigger per element goes into the bitmaps, any others are tested one by one
+  for (int t = 0 ; t < num_triggers ; ++t) {
+    triggerable_t *thing = &triggers[t];
+    uint64_t bit;
+    int i;
+
+    if ((thing->test == (trigger_test_all_fn_t)triggered_all_bynonzero_int ||
+         thing->test == (trigger_test_all_fn_t)triggered_all_byzero_int ||
+         thing->test == (trigger_test_all_fn_t)triggered_all_bysignal_int) &&
+        thing->trigger >= flags && thing->trigger < flags + num_flags &&
+        (thing->test != (trigger_test_all_fn_t)triggered_all_bysignal_int ||
+         (const FLAG_t*)thing->test_cbstate == seen + (thing->trigger - flags))) {
+      i = (int)(thing->trigger - flags);
+      bit = UINT64_C(1) << (i & 63);
+      if (!(bitmap->flag_armed[i >> 6] & bit)) {
+        bitmap->flag_armed[i >> 6] |= bit;
+        if (thing->test == (trigger_test_all_fn_t)triggered_all_byzero_int) {
+          bitmap->flag_byzero[i >> 6] |= bit;
+        }
+        bitmap->flag_trigger[i] = t;
+        continue;
+      }
+    } else if (thing->test == (trigger_test_all_fn_t)triggered_all_byrequest_flag &&
+               (void**)thing->test_cbstate >= requests &&
+               (void**)thing->test_cbstate < requests + num_requests) {
+      i = (int)((void**)thing->test_cbstate - requests);
+      bit = UINT64_C(1) << (i & 63);
+      if (!(bitmap->request_armed[i >> 6] & bit)) {
+        bitmap->request_armed[i >> 6] |= bit;
+        bitmap->request_trigger[i] = t;
+        continue;
+      }
+    }
+    bitmap->other_trigger[bitmap->num_other++] = t;
+  }
+
+  return 0;
+}
+
+void trigger_bitmap_free(triggerable_bitmap *bitmap) {
+  free(bitmap->flag_trigger);
+  free(bitmap->flag_byzero);
+  memset(bitmap, 0, sizeof(*bitmap));
+}
+
+void trigger_bitmap_arm(triggerable_bitmap *bitmap) {
+  int other_words = TRIGGER_BITMAP_WORDS(bitmap->num_other);
+
+  memcpy(bitmap->flag_pending, bitmap->flag_armed,
+         TRIGGER_BITMAP_WORDS(bitmap->num_flags) * sizeof(uint64_t));
+  memcpy(bitmap->request_pending, bitmap->request_armed,
+         TRIGGER_BITMAP_WORDS(bitmap->num_requests) * sizeof(uint64_t));
+  for (int w = 0 ; w < other_words ; ++w) {
+    bitmap->other_pending[w] = ~UINT64_C(0);
+  }
+  if (bitmap->num_other & 63) {
+    bitmap->other_pending[other_words - 1] = (UINT64_C(1) << (bitmap->num_other & 63)) - 1;
+  }
+}
+
+// tests the triggers for the set bits of candidates, clears the pending bit of each that fires
+static inline enum TRIGGER_ACTION_STATE trigger_bitmap_fire(triggerable_t *triggers, const int *map,
+                                                            uint64_t *pending, uint64_t candidates,
+                                                            int *fired) {
+  while (candidates) {
+    int bit = trigger_bitmap_ctz(candidates);
+    enum TRIGGER_ACTION_STATE ret = trigger_test(&triggers[map[bit]]);
+    candidates &= candidates - 1;
+    if (ACTION_PROBLEM == ret) {
+      return ret;
+    }
+    if (ACTION_SUCCESS == ret) {
+      *pending &= ~(UINT64_C(1) << bit);
+      ++(*fired);
+    }
+  }
+  return TRIGGER_PENDING;
+}
+
+enum TRIGGER_ACTION_STATE trigger_bitmap_test(triggerable_bitmap *bitmap, triggerable_t *triggers,
+                                              const FLAG_t *flags, const FLAG_t *seen,
+                                              void *const *requests, int *fired) {
+  int flag_words = TRIGGER_BITMAP_WORDS(bitmap->num_flags);
+  int request_words = TRIGGER_BITMAP_WORDS(bitmap->num_requests);
+  int other_words = TRIGGER_BITMAP_WORDS(bitmap->num_other);
+  int total = 0, pass;
+
+  // an action usually makes the trigger of the next action ready (e.g. by decrementing
+  // a local counter), so keep going while anything fires
+  do {
+    pass = 0;
+
+    trigger_bitmap_scan_differ(flags, seen, bitmap->num_flags, bitmap->ready);
+    for (int w = 0 ; w < flag_words ; ++w) {
+      uint64_t candidates = (bitmap->ready[w] ^ bitmap->flag_byzero[w]) & bitmap->flag_pending[w];
+      if (candidates &&
+          ACTION_PROBLEM == trigger_bitmap_fire(triggers, bitmap->flag_trigger + 64 * w,
+                                                &bitmap->flag_pending[w], candidates, &pass)) {
+        return ACTION_PROBLEM;
+      }
+    }
+
+    trigger_bitmap_scan_nonnull(requests, bitmap->num_requests, bitmap->ready);
+    for (int w = 0 ; w < request_words ; ++w) {
+      uint64_t candidates = bitmap->ready[w] & bitmap->request_pending[w];
+      if (candidates &&
+          ACTION_PROBLEM == trigger_bitmap_fire(triggers, bitmap->request_trigger + 64 * w,
+                                                &bitmap->request_pending[w], candidates, &pass)) {
+        return ACTION_PROBLEM;
+      }
+    }
+
+    for (int w = 0 ; w < other_words ; ++w) {
+      if (bitmap->other_pending[w] &&
+          ACTION_PROBLEM == trigger_bitmap_fire(triggers, bitmap->other_trigger + 64 * w,
+                                                &bitmap->other_pending[w], bitmap->other_pending[w],
+                                                &pass)) {
+        return ACTION_PROBLEM;
+      }
+    }
+
+    total += pass;
+  } while (0 < pass);
+
+  *fired += total;
+  return (0 < total) ? ACTION_SUCCESS : TRIGGER_PENDING;
+}
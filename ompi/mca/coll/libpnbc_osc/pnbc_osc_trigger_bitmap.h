@@ -0,0 +1,58 @@
+#ifndef PNBC_OSC_TRIGGER_BITMAP_H
+#define PNBC_OSC_TRIGGER_BITMAP_H
+
+#include <stdint.h>
+#include "pnbc_osc_trigger_common.h"
+#include "pnbc_osc_trigger_single.h"
+
+#define TRIGGER_BITMAP_WORDS(n) (((n) + 63) / 64)
+
+// structure-of-arrays view of the triggerables of a schedule
+// most triggers watch one element of the flags array or of the request slot
+// array of their schedule; a flag is ready when it differs from its element of
+// the seen array (the signals consumed so far, zero for flags that are not
+// signalled, so that counters and plain flags are compared against zero); instead of calling the test of every trigger, both
+// arrays are scanned contiguously (several elements per instruction where the
+// target supports it) and only the triggers whose element is ready are tested
+// triggers that watch anything else are tested one by one, as before
+struct triggerable_bitmap {
+  int        num_flags;
+  int        num_requests;
+  int        num_other;
+  int       *flag_trigger;      // index of the trigger watching each flag
+  int       *request_trigger;   // index of the trigger watching each request slot
+  int       *other_trigger;     // indices of the remaining triggers
+  uint64_t  *flag_byzero;       // bit set: the flag is a counter, it is ready when equal to seen
+  uint64_t  *flag_armed;        // bit set: a trigger watches the flag
+  uint64_t  *request_armed;     // bit set: a trigger watches the request slot
+  uint64_t  *flag_pending;      // bit set: the watching trigger has not fired in this start
+  uint64_t  *request_pending;
+  uint64_t  *other_pending;
+  uint64_t  *ready;             // scratch space for the scans
+};
+typedef struct triggerable_bitmap triggerable_bitmap;
+
+// sorts the triggers by what they watch, returns non-zero if out of memory
+int trigger_bitmap_init(triggerable_bitmap *bitmap, triggerable_t *triggers, int num_triggers,
+                        FLAG_t *flags, const FLAG_t *seen, int num_flags,
+                        void **requests, int num_requests);
+
+void trigger_bitmap_free(triggerable_bitmap *bitmap);
+
+// every trigger must fire once more before the bitmap is idle again
+void trigger_bitmap_arm(triggerable_bitmap *bitmap);
+
+// tests (and fires) the pending triggers whose element is ready, repeatedly
+// until no more fire; *fired is increased by the number of triggers that fired
+enum TRIGGER_ACTION_STATE trigger_bitmap_test(triggerable_bitmap *bitmap, triggerable_t *triggers,
+                                              const FLAG_t *flags, const FLAG_t *seen,
+                                              void *const *requests, int *fired);
+
+// sets bit i of the result iff flags[i] differs from seen[i]
+void trigger_bitmap_scan_differ(const FLAG_t *flags, const FLAG_t *seen, int num_flags,
+                                uint64_t *differ);
+
+// sets bit i of the result iff slots[i] is not NULL
+void trigger_bitmap_scan_nonnull(void *const *slots, int num_slots, uint64_t *nonnull);
+
+#endif
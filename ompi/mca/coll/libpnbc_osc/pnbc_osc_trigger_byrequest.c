@@ -5,24 +5,21 @@
 // some built-in tests resets and actions for 'all' in triggerable_array
 // also usable with triggerable_single
 
-
+// cbstate is the address of the request slot filled in by a put or get action
+// an empty slot means the action has not been done yet; a completed request
+// is freed by the test and the slot is emptied, so it can only trigger once
 int triggered_all_byrequest_flag(FLAG_t *trigger, void *cbstate) {
-  ompi_request_t **request = *((ompi_request_t***)cbstate);
-  int *flag = (int*)trigger;
-  ompi_request_default_test(request, flag, MPI_STATUS_IGNORE);
-  if (!flag)
-    return ACTION_SUCCESS;
-  else
-    return TRIGGER_PENDING;
+  ompi_request_t **request = (ompi_request_t**)cbstate;
+  int flag = 0;
+  if (NULL == *request || MPI_REQUEST_NULL == *request)
+    return 0;
+  ompi_request_test(request, &flag, MPI_STATUS_IGNORE);
+  if (flag)
+    *request = NULL;
+  return flag;
 }
 
 int triggered_one_byrequest_flag(FLAG_t *trigger, int index, void *cbstate) {
-  ompi_request_t **request = ((ompi_request_t***)cbstate)[index];
-  int *flag = (int*)trigger;
-  ompi_request_default_test(request, flag, MPI_STATUS_IGNORE);
-  if (!flag)
-    return ACTION_SUCCESS;
-  else
-    return TRIGGER_PENDING;
+  return triggered_all_byrequest_flag(trigger, &((ompi_request_t**)cbstate)[index]);
 }
 
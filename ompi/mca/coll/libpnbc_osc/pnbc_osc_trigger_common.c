@@ -3,17 +3,38 @@
 // some built-in tests resets and actions for 'all' in triggerable_array
 // also usable with triggerable_single
 
+// flags may be written by remote RMA operations, so always re-read memory
 int triggered_all_bynonzero_int(FLAG_t *trigger, void *cbstate) {
-  return (*(int*)trigger);
+  return (*(volatile int*)trigger);
 }
 int triggered_all_byzero_int(FLAG_t *trigger, void *cbstate) {
-  return !(*(int*)trigger);
+  return !(*(volatile int*)trigger);
+}
+
+// signals are only ever added to the flag, by remote atomic increments, and the
+// flag is never written locally; cbstate is the number of signals consumed so far
+// (wrap-around safe), each successful test consumes exactly one signal
+int triggered_all_bysignal_int(FLAG_t *trigger, void *cbstate) {
+  FLAG_t *seen = (FLAG_t*)cbstate;
+  if (0 < (int)((unsigned int)(*(volatile int*)trigger) - (unsigned int)(*seen))) {
+#if defined(__GNUC__)
+    // whatever the signalling process did before the signal is visible after it
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+#endif
+    ++(*seen);
+    return !0;
+  }
+  return 0;
 }
 
 void reset_all_to_zero_int(FLAG_t *trigger, FLAG_t value) {
   *(int*)trigger = 0;
 }
 
+void reset_all_to_value_int(FLAG_t *trigger, FLAG_t value) {
+  *(int*)trigger = value;
+}
+
 enum TRIGGER_ACTION_STATE action_all_noop(void *cbstate) {
   return ACTION_SUCCESS;
 }
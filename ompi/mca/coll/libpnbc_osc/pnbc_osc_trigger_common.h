@@ -38,7 +38,9 @@ typedef void
 int triggered_all_bynonzero_int(FLAG_t *trigger, void *cbstate);
 int triggered_all_byzero_int(FLAG_t *trigger, void *cbstate);
 int triggered_all_byrequest_flag(FLAG_t *trigger, void *cbstate);
+int triggered_all_bysignal_int(FLAG_t *trigger, void *cbstate);
 void reset_all_to_zero_int(FLAG_t *trigger, FLAG_t value);
+void reset_all_to_value_int(FLAG_t *trigger, FLAG_t value);
 enum TRIGGER_ACTION_STATE action_all_noop(void *cbstate);
 
 /* some more built-in trigger functions */
@@ -1,4 +1,6 @@
 #include "pnbc_osc_trigger_single.h"
+#include <stddef.h>
+
 
 void trigger_reset(triggerable_t *thing) {
   thing->reset(thing->trigger, thing->reset_value);
@@ -18,3 +20,53 @@ enum TRIGGER_ACTION_STATE trigger_action(triggerable_t *thing) {
   return thing->action(thing->action_cbstate);
 }
 
+
+void trigger_init_counter(triggerable_t *thing, FLAG_t *counter, FLAG_t deps,
+                          trigger_action_all_cb_fn_t action, void *action_cbstate) {
+  thing->test = (trigger_test_all_fn_t)triggered_all_byzero_int;
+  thing->test_cbstate = NULL;
+  thing->trigger = counter;
+  thing->action = action;
+  thing->action_cbstate = action_cbstate;
+  thing->reset = reset_all_to_value_int;
+  thing->reset_value = deps;
+  thing->auto_reset = !0;
+  trigger_reset(thing);
+}
+
+void trigger_init_flag(triggerable_t *thing, FLAG_t *flag,
+                       trigger_action_all_cb_fn_t action, void *action_cbstate) {
+  thing->test = (trigger_test_all_fn_t)triggered_all_bynonzero_int;
+  thing->test_cbstate = NULL;
+  thing->trigger = flag;
+  thing->action = action;
+  thing->action_cbstate = action_cbstate;
+  thing->reset = reset_all_to_zero_int;
+  thing->reset_value = 0;
+  thing->auto_reset = !0;
+  // no reset here: the flag may already be exposed to remote processes
+}
+
+void trigger_init_signal(triggerable_t *thing, FLAG_t *flag, FLAG_t *seen,
+                         trigger_action_all_cb_fn_t action, void *action_cbstate) {
+  thing->test = (trigger_test_all_fn_t)triggered_all_bysignal_int;
+  thing->test_cbstate = seen;
+  thing->trigger = flag;
+  thing->action = action;
+  thing->action_cbstate = action_cbstate;
+  thing->reset = NULL;
+  thing->reset_value = 0;
+  thing->auto_reset = 0;
+}
+
+void trigger_init_request(triggerable_t *thing, void *request,
+                          trigger_action_all_cb_fn_t action, void *action_cbstate) {
+  thing->test = (trigger_test_all_fn_t)triggered_all_byrequest_flag;
+  thing->test_cbstate = request;
+  thing->trigger = NULL;
+  thing->action = action;
+  thing->action_cbstate = action_cbstate;
+  thing->reset = NULL;
+  thing->reset_value = 0;
+  thing->auto_reset = 0;
+}
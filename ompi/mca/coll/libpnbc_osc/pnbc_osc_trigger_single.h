@@ -21,4 +21,24 @@ enum TRIGGER_ACTION_STATE trigger_test(triggerable_t *thing);
 
 enum TRIGGER_ACTION_STATE trigger_action(triggerable_t *thing);
 
+/* helpers that fill in the built-in trigger kinds used by the persistent schedules */
+
+// fires when *counter reaches zero, auto-resets the counter to deps
+void trigger_init_counter(triggerable_t *thing, FLAG_t *counter, FLAG_t deps,
+                          trigger_action_all_cb_fn_t action, void *action_cbstate);
+
+// fires when a remote process writes a non-zero value into *flag, auto-resets it to zero
+// the flag must be zero before it is first exposed to remote processes
+void trigger_init_flag(triggerable_t *thing, FLAG_t *flag,
+                       trigger_action_all_cb_fn_t action, void *action_cbstate);
+
+// fires once for every signal (atomic increment) a remote process adds to *flag,
+// counting the signals consumed in *seen; neither is ever reset
+void trigger_init_signal(triggerable_t *thing, FLAG_t *flag, FLAG_t *seen,
+                         trigger_action_all_cb_fn_t action, void *action_cbstate);
+
+// fires when the request stored in *request (by a put or get action) has completed
+void trigger_init_request(triggerable_t *thing, void *request,
+                          trigger_action_all_cb_fn_t action, void *action_cbstate);
+
 #endif
@@ -25,11 +25,14 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
 #include "mpi.h"
 #include "ompi/mca/mca.h"
 #include "opal/datatype/opal_convertor.h"
 #include "opal/mca/common/sm/common_sm.h"
 #include "ompi/mca/coll/coll.h"
+#include "ompi/datatype/ompi_datatype.h"
 
 BEGIN_C_DECLS
 
@@ -192,9 +195,24 @@ BEGIN_C_DECLS
         /* Data that hangs off the communicator */
 	mca_coll_sm_comm_t *sm_comm_data;
 
-        /* Underlying reduce function and module */
+        /* Underlying functions and modules, used for the cases this
+           module does not handle */
+	mca_coll_base_module_allgather_fn_t previous_allgather;
+	mca_coll_base_module_t *previous_allgather_module;
+	mca_coll_base_module_allgatherv_fn_t previous_allgatherv;
+	mca_coll_base_module_t *previous_allgatherv_module;
+	mca_coll_base_module_alltoall_fn_t previous_alltoall;
+	mca_coll_base_module_t *previous_alltoall_module;
+	mca_coll_base_module_exscan_fn_t previous_exscan;
+	mca_coll_base_module_t *previous_exscan_module;
+	mca_coll_base_module_gather_fn_t previous_gather;
+	mca_coll_base_module_t *previous_gather_module;
 	mca_coll_base_module_reduce_fn_t previous_reduce;
 	mca_coll_base_module_t *previous_reduce_module;
+	mca_coll_base_module_scan_fn_t previous_scan;
+	mca_coll_base_module_t *previous_scan_module;
+	mca_coll_base_module_scatter_fn_t previous_scatter;
+	mca_coll_base_module_t *previous_scatter_module;
     } mca_coll_sm_module_t;
     OBJ_CLASS_DECLARATION(mca_coll_sm_module_t);
 
@@ -230,6 +248,13 @@ BEGIN_C_DECLS
 				     struct ompi_datatype_t *rdtype,
 				     struct ompi_communicator_t *comm,
 				     mca_coll_base_module_t *module);
+    int mca_coll_sm_allgather_blocks(const void *sbuf, int scount,
+				     struct ompi_datatype_t *sdtype,
+				     void *rbuf, int rcount,
+				     const int *rcounts, const int *disps,
+				     struct ompi_datatype_t *rdtype,
+				     struct ompi_communicator_t *comm,
+				     mca_coll_base_module_t *module);
     int mca_coll_sm_allreduce_intra(const void *sbuf, void *rbuf, int count,
 				    struct ompi_datatype_t *dtype,
 				    struct ompi_op_t *op,
@@ -270,14 +295,14 @@ BEGIN_C_DECLS
 				 struct ompi_op_t *op,
 				 struct ompi_communicator_t *comm,
 				 mca_coll_base_module_t *module);
-    int mca_coll_sm_gather_intra(void *sbuf, int scount,
+    int mca_coll_sm_gather_intra(const void *sbuf, int scount,
 				 struct ompi_datatype_t *sdtype, void *rbuf,
 				 int rcount, struct ompi_datatype_t *rdtype,
 				 int root, struct ompi_communicator_t *comm,
 				 mca_coll_base_module_t *module);
-    int mca_coll_sm_gatherv_intra(void *sbuf, int scount,
+    int mca_coll_sm_gatherv_intra(const void *sbuf, int scount,
 				  struct ompi_datatype_t *sdtype, void *rbuf,
-				  int *rcounts, int *disps,
+				  const int *rcounts, const int *disps,
 				  struct ompi_datatype_t *rdtype, int root,
 				  struct ompi_communicator_t *comm,
 				  mca_coll_base_module_t *module);
@@ -294,7 +319,7 @@ BEGIN_C_DECLS
 				     struct ompi_communicator_t *comm,
 				     mca_coll_base_module_t *module);
     int mca_coll_sm_reduce_scatter_intra(const void *sbuf, void *rbuf,
-					 int *rcounts,
+					 const int *rcounts,
 					 struct ompi_datatype_t *dtype,
 					 struct ompi_op_t *op,
 					 struct ompi_communicator_t *comm,
@@ -304,6 +329,11 @@ BEGIN_C_DECLS
 			       struct ompi_op_t *op,
 			       struct ompi_communicator_t *comm,
 			       mca_coll_base_module_t *module);
+    int mca_coll_sm_scan_fragments(const void *sbuf, void *rbuf, int count,
+				   struct ompi_datatype_t *dtype,
+				   struct ompi_op_t *op, bool exclusive,
+				   struct ompi_communicator_t *comm,
+				   mca_coll_base_module_t *module);
     int mca_coll_sm_scatter_intra(const void *sbuf, int scount,
 				  struct ompi_datatype_t *sdtype, void *rbuf,
 				  int rcount, struct ompi_datatype_t *rdtype,
@@ -450,6 +480,117 @@ extern uint32_t mca_coll_sm_one;
         *ptr = 0; \
     } while (0)
 
+/**
+ * Macro for a process to tell all the others that its fragment of
+ * the segment is ready.  The value is the operation number plus one,
+ * written to the last word of the process' control buffer, which the
+ * fan in macros above never touch.  It is never reset since any
+ * number of processes may be reading it.  Used in all-to-all
+ * operations.
+ */
+#define PEER_NOTIFY_READY(rank, index, op_count) \
+    *((size_t volatile *) \
+      (((char*) (index)->mcbmi_control) + \
+       (mca_coll_sm_component.sm_control_size * ((rank) + 1)) - \
+       sizeof(size_t))) = (size_t) (op_count) + 1
+
+/**
+ * Macro to wait for a process to tell that its fragment of the
+ * segment is ready for this operation.  Used in all-to-all
+ * operations.
+ */
+#define WAIT_FOR_PEER_READY(rank, index, op_count, label) \
+    do { \
+        size_t volatile *ptr = (size_t volatile *) \
+            (((char*) (index)->mcbmi_control) + \
+             (mca_coll_sm_component.sm_control_size * ((rank) + 1)) - \
+             sizeof(size_t)); \
+        SPIN_CONDITION((size_t) (op_count) + 1 == *ptr, label); \
+        opal_atomic_rmb(); \
+    } while (0)
+
+/**
+ * Whether the control buffers can hold one fan in word per process
+ * plus the ready word of the all-to-all operations.
+ */
+#define CONTROL_FITS(size) \
+    ((size_t) ((size) + 1) * sizeof(size_t) <= \
+     (size_t) mca_coll_sm_component.sm_control_size)
+
+/**
+ * Pack len bytes of the packed representation of (buf, count, dtype),
+ * starting at the packed offset, to dst.
+ */
+static inline int mca_coll_sm_pack_at(void *dst, const void *buf, int count,
+                                      struct ompi_datatype_t *dtype,
+                                      size_t offset, size_t len)
+{
+    opal_convertor_t convertor;
+    struct iovec iov;
+    uint32_t iov_count = 1;
+    ptrdiff_t lb, extent;
+    int ret;
+
+    if (ompi_datatype_is_contiguous_memory_layout(dtype, count)) {
+        ompi_datatype_get_true_extent(dtype, &lb, &extent);
+        memcpy(dst, (char *) buf + lb + offset, len);
+        return OMPI_SUCCESS;
+    }
+
+    OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+    ret = opal_convertor_copy_and_prepare_for_send(ompi_mpi_local_convertor,
+                                                   &(dtype->super), count,
+                                                   buf, 0, &convertor);
+    if (OMPI_SUCCESS == ret) {
+        ret = opal_convertor_set_position(&convertor, &offset);
+    }
+    if (OMPI_SUCCESS == ret) {
+        iov.iov_base = dst;
+        iov.iov_len = len;
+        ret = opal_convertor_pack(&convertor, &iov, &iov_count, &len) < 0 ?
+            OMPI_ERROR : OMPI_SUCCESS;
+    }
+    OBJ_DESTRUCT(&convertor);
+    return ret;
+}
+
+/**
+ * Unpack len bytes from src to the packed representation of (buf,
+ * count, dtype), starting at the packed offset.
+ */
+static inline int mca_coll_sm_unpack_at(const void *src, void *buf, int count,
+                                        struct ompi_datatype_t *dtype,
+                                        size_t offset, size_t len)
+{
+    opal_convertor_t convertor;
+    struct iovec iov;
+    uint32_t iov_count = 1;
+    ptrdiff_t lb, extent;
+    int ret;
+
+    if (ompi_datatype_is_contiguous_memory_layout(dtype, count)) {
+        ompi_datatype_get_true_extent(dtype, &lb, &extent);
+        memcpy((char *) buf + lb + offset, src, len);
+        return OMPI_SUCCESS;
+    }
+
+    OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+    ret = opal_convertor_copy_and_prepare_for_recv(ompi_mpi_local_convertor,
+                                                   &(dtype->super), count,
+                                                   buf, 0, &convertor);
+    if (OMPI_SUCCESS == ret) {
+        ret = opal_convertor_set_position(&convertor, &offset);
+    }
+    if (OMPI_SUCCESS == ret) {
+        iov.iov_base = (IOVBASE_TYPE *) src;
+        iov.iov_len = len;
+        ret = opal_convertor_unpack(&convertor, &iov, &iov_count, &len) < 0 ?
+            OMPI_ERROR : OMPI_SUCCESS;
+    }
+    OBJ_DESTRUCT(&convertor);
+    return ret;
+}
+
 END_C_DECLS
 
 #endif /* MCA_COLL_SM_EXPORT_H */
@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -21,6 +24,7 @@
 #include "ompi_config.h"
 
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
 #include "coll_sm.h"
 
 
@@ -37,5 +41,14 @@ int mca_coll_sm_allgather_intra(const void *sbuf, int scount,
                                 struct ompi_communicator_t *comm,
                                 mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+
+    if (!CONTROL_FITS(ompi_comm_size(comm))) {
+        return sm_module->previous_allgather(sbuf, scount, sdtype,
+                                             rbuf, rcount, rdtype, comm,
+                                             sm_module->previous_allgather_module);
+    }
+
+    return mca_coll_sm_allgather_blocks(sbuf, scount, sdtype, rbuf, rcount,
+                                        NULL, NULL, rdtype, comm, module);
 }
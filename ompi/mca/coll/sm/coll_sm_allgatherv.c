@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -20,12 +23,190 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/datatype/opal_convertor.h"
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
 #include "coll_sm.h"
 
 
+/**
+ * Shared memory allgather(v) of blocks of rdtype elements; block p
+ * holds rcounts[p] elements at displacement disps[p], or rcount
+ * elements at displacement p * rcount if rcounts is NULL.
+ *
+ * Process 0 claims each set of segments for everyone, and everyone
+ * releases it.  For each segment, every process copies the next
+ * fragment of its own block in its part of the segment, tells the
+ * others it is there, and copies out the fragments of all the other
+ * processes, starting with the next one so that they are not all
+ * reading from the same process at the same time.  Processes with
+ * smaller blocks simply run out of fragments earlier.
+ */
+int mca_coll_sm_allgather_blocks(const void *sbuf, int scount,
+                                 struct ompi_datatype_t *sdtype,
+                                 void *rbuf, int rcount,
+                                 const int *rcounts, const int *disps,
+                                 struct ompi_datatype_t *rdtype,
+                                 struct ompi_communicator_t *comm,
+                                 mca_coll_base_module_t *module)
+{
+    struct iovec iov;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int i, ret, rank, size, peer;
+    int flag_num, segment_num, max_segment_num;
+    uint32_t op_count;
+    size_t rsize, fragment_size, offset, total_size, max_size, max_data, len;
+    ptrdiff_t rextent;
+    mca_coll_sm_in_use_flag_t *flag;
+    opal_convertor_t convertor;
+    mca_coll_sm_data_index_t *index;
+    char *block;
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    size = ompi_comm_size(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+
+    ompi_datatype_type_size(rdtype, &rsize);
+    ompi_datatype_type_extent(rdtype, &rextent);
+
+#define BLOCK_COUNT(p) ((NULL == rcounts) ? rcount : rcounts[p])
+#define BLOCK_ADDR(p) \
+    ((char *) rbuf + rextent * ((NULL == rcounts) ? (ptrdiff_t) (p) * rcount : disps[p]))
+
+    /* Put my own block in place */
+
+    block = BLOCK_ADDR(rank);
+    if (MPI_IN_PLACE != sbuf) {
+        ret = ompi_datatype_sndrcv(sbuf, scount, sdtype,
+                                   block, BLOCK_COUNT(rank), rdtype);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+    }
+
+    max_size = 0;
+    for (peer = 0; peer < size; ++peer) {
+        total_size = (size_t) BLOCK_COUNT(peer) * rsize;
+        if (total_size > max_size) {
+            max_size = total_size;
+        }
+    }
+    if (0 == max_size) {
+        return OMPI_SUCCESS;
+    }
+
+    /* Everyone sends from its block in the receive buffer */
+
+    OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+    if (OMPI_SUCCESS !=
+        (ret =
+         opal_convertor_copy_and_prepare_for_send(ompi_mpi_local_convertor,
+                                                  &(rdtype->super),
+                                                  BLOCK_COUNT(rank),
+                                                  block,
+                                                  0,
+                                                  &convertor))) {
+        OBJ_DESTRUCT(&convertor);
+        return ret;
+    }
+    opal_convertor_get_packed_size(&convertor, &total_size);
+
+    offset = 0;
+    do {
+        flag_num = (data->mcb_operation_count %
+                    mca_coll_sm_component.sm_comm_num_in_use_flags);
+        op_count = data->mcb_operation_count++;
+
+        FLAG_SETUP(flag_num, flag, data);
+        if (0 == rank) {
+            FLAG_WAIT_FOR_IDLE(flag, allgather_claim_label);
+            FLAG_RETAIN(flag, size, op_count);
+        } else {
+            FLAG_WAIT_FOR_OP(flag, op_count, allgather_wait_label);
+            opal_atomic_rmb();
+        }
+
+        /* Loop over all the segments in this set */
+
+        segment_num =
+            flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        max_segment_num =
+            (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        do {
+            index = &(data->mcb_data_index[segment_num]);
+
+            /* Copy my next fragment in and tell everyone */
+            if (offset < total_size) {
+                max_data = fragment_size;
+                COPY_FRAGMENT_IN(convertor, index, rank, iov, max_data);
+
+                /* Wait for the write to absolutely complete */
+                opal_atomic_wmb();
+                PEER_NOTIFY_READY(rank, index, op_count);
+            }
+
+            /* Copy the fragments of the others out */
+            for (i = 1; i < size; ++i) {
+                peer = (rank + i) % size;
+                len = (size_t) BLOCK_COUNT(peer) * rsize;
+                if (offset >= len) {
+                    continue;
+                }
+                len -= offset;
+                if (len > fragment_size) {
+                    len = fragment_size;
+                }
+
+                WAIT_FOR_PEER_READY(peer, index, op_count, allgather_peer_label);
+                ret = mca_coll_sm_unpack_at(index->mcbmi_data + peer * fragment_size,
+                                            BLOCK_ADDR(peer), BLOCK_COUNT(peer),
+                                            rdtype, offset, len);
+                if (OMPI_SUCCESS != ret) {
+                    /* Should not happen: the datatype was fine a
+                       moment ago */
+                    OBJ_DESTRUCT(&convertor);
+                    return ret;
+                }
+            }
+
+            offset += fragment_size;
+            ++segment_num;
+        } while (offset < max_size && segment_num < max_segment_num);
+
+        /* Wait for all copy-out reads to complete before I say I'm
+           done with the segments */
+        opal_atomic_mb();
+
+        /* We're finished with this set of segments */
+        FLAG_RELEASE(flag);
+    } while (offset < max_size);
+
+#undef BLOCK_COUNT
+#undef BLOCK_ADDR
+
+    OBJ_DESTRUCT(&convertor);
+
+    return OMPI_SUCCESS;
+}
+
+
 /*
- *	allgatherv_intra
+ *	allgatherv
  *
  *	Function:	- allgatherv
  *	Accepts:	- same as MPI_Allgatherv()
@@ -36,7 +217,16 @@ int mca_coll_sm_allgatherv_intra(const void *sbuf, int scount,
                                  void * rbuf, const int *rcounts, const int *disps,
                                  struct ompi_datatype_t *rdtype,
                                  struct ompi_communicator_t *comm,
-                                mca_coll_base_module_t *module)
+                                 mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+
+    if (!CONTROL_FITS(ompi_comm_size(comm))) {
+        return sm_module->previous_allgatherv(sbuf, scount, sdtype,
+                                              rbuf, rcounts, disps, rdtype, comm,
+                                              sm_module->previous_allgatherv_module);
+    }
+
+    return mca_coll_sm_allgather_blocks(sbuf, scount, sdtype, rbuf, 0,
+                                        rcounts, disps, rdtype, comm, module);
 }
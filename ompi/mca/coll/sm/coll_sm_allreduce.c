@@ -12,6 +12,9 @@
  * Copyright (c) 2009      Cisco Systems, Inc.  All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -22,16 +25,34 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
 #include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/op/op.h"
 #include "coll_sm.h"
 
 
+/*
+ * Local functions
+ */
+static int allreduce_slices(const void *sbuf, void *rbuf, int count,
+                            struct ompi_datatype_t *dtype,
+                            struct ompi_op_t *op,
+                            struct ompi_communicator_t *comm,
+                            mca_coll_base_module_t *module);
+
+
 /**
  * Shared memory allreduce.
  *
- * For the moment, all we're doing is a reduce to root==0 and then a
- * broadcast.  It is possible that we'll do something better someday.
+ * If the datatype has a contiguous layout, every process reduces its
+ * own slice of each fragment straight from the fragments of the
+ * others (a reduce-scatter), and then gathers the slices of the
+ * others (an allgather); see allreduce_slices().  Otherwise, this is
+ * a reduce to root==0 and then a broadcast.
  */
 int mca_coll_sm_allreduce_intra(const void *sbuf, void *rbuf, int count,
                                 struct ompi_datatype_t *dtype,
@@ -40,6 +61,16 @@ int mca_coll_sm_allreduce_intra(const void *sbuf, void *rbuf, int count,
                                 mca_coll_base_module_t *module)
 {
     int ret;
+    size_t size;
+
+    ompi_datatype_type_size(dtype, &size);
+    if (count > 0 && size > 0 &&
+        (int) size <= mca_coll_sm_component.sm_fragment_size &&
+        mca_coll_sm_component.sm_segs_per_inuse_flag >= 2 &&
+        ompi_datatype_is_contiguous_memory_layout(dtype, count) &&
+        CONTROL_FITS(ompi_comm_size(comm))) {
+        return allreduce_slices(sbuf, rbuf, count, dtype, op, comm, module);
+    }
 
     /* Note that only the root can pass MPI_IN_PLACE to MPI_REDUCE, so
        have slightly different logic for that case. */
@@ -60,3 +91,152 @@ int mca_coll_sm_allreduce_intra(const void *sbuf, void *rbuf, int count,
     return (ret == OMPI_SUCCESS) ?
         mca_coll_sm_bcast_intra(rbuf, count, dtype, 0, comm, module) : ret;
 }
+
+
+/**
+ * Reduce-scatter/allgather allreduce.
+ *
+ * Process 0 claims each set of segments for everyone, and everyone
+ * releases it.  The segments are used in pairs: every process copies
+ * the next fragment of its data in its part of the first segment and
+ * tells the others.  The elements of the fragment are split in as
+ * many slices as processes.  Each process reduces its slice of the
+ * fragments of all the processes, in order, into its receive buffer,
+ * copies the result to its part of the second segment and tells the
+ * others, then copies the slices of the others out of the second
+ * segment.  The reduction work is thus spread over all the processes
+ * instead of being done by the root, and goes through the op
+ * component kernels (e.g., op/avx) for intrinsic operations.
+ */
+static int allreduce_slices(const void *sbuf, void *rbuf, int count,
+                            struct ompi_datatype_t *dtype,
+                            struct ompi_op_t *op,
+                            struct ompi_communicator_t *comm,
+                            mca_coll_base_module_t *module)
+{
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int i, ret, rank, size, peer;
+    int flag_num, segment_num, max_segment_num;
+    uint32_t op_count;
+    size_t dsize, segment_ddt_count, fragment_size, num, done;
+    size_t slice, slice_rem, first, len;
+    ptrdiff_t lb, extent;
+    mca_coll_sm_in_use_flag_t *flag;
+    mca_coll_sm_data_index_t *in, *out;
+    char *target;
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    size = ompi_comm_size(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+
+    ompi_datatype_type_size(dtype, &dsize);
+    ompi_datatype_get_true_extent(dtype, &lb, &extent);
+    segment_ddt_count = fragment_size / dsize;
+    if (MPI_IN_PLACE == sbuf) {
+        sbuf = rbuf;
+    }
+
+/* First element of the slice of process p */
+#define SLICE_FIRST(p) ((p) * slice + ((size_t) (p) < slice_rem ? (size_t) (p) : slice_rem))
+
+    done = 0;
+    do {
+        flag_num = (data->mcb_operation_count %
+                    mca_coll_sm_component.sm_comm_num_in_use_flags);
+        op_count = data->mcb_operation_count++;
+
+        FLAG_SETUP(flag_num, flag, data);
+        if (0 == rank) {
+            FLAG_WAIT_FOR_IDLE(flag, allreduce_claim_label);
+            FLAG_RETAIN(flag, size, op_count);
+        } else {
+            FLAG_WAIT_FOR_OP(flag, op_count, allreduce_wait_label);
+            opal_atomic_rmb();
+        }
+
+        /* Loop over all the pairs of segments in this set */
+
+        segment_num =
+            flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        max_segment_num =
+            (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag - 1;
+        do {
+            in = &(data->mcb_data_index[segment_num]);
+            out = &(data->mcb_data_index[segment_num + 1]);
+            num = count - done;
+            if (num > segment_ddt_count) {
+                num = segment_ddt_count;
+            }
+            slice = num / size;
+            slice_rem = num % size;
+
+            /* Share my fragment.  This comes first since the receive
+               buffer may be the send buffer. */
+            memcpy(in->mcbmi_data + rank * fragment_size,
+                   (const char *) sbuf + lb + done * dsize, num * dsize);
+            opal_atomic_wmb();
+            PEER_NOTIFY_READY(rank, in, op_count);
+
+            /* Reduce my slice: (0 op (1 op (... op size - 1))) */
+            first = SLICE_FIRST(rank);
+            len = SLICE_FIRST(rank + 1) - first;
+            target = (char *) rbuf + (done + first) * dsize;
+            if (len > 0) {
+                peer = size - 1;
+                WAIT_FOR_PEER_READY(peer, in, op_count, allreduce_last_label);
+                memcpy(target + lb, in->mcbmi_data + peer * fragment_size +
+                       first * dsize, len * dsize);
+                for (--peer; peer >= 0; --peer) {
+                    WAIT_FOR_PEER_READY(peer, in, op_count, allreduce_in_label);
+                    ompi_op_reduce(op, in->mcbmi_data + peer * fragment_size +
+                                   first * dsize - lb, target, len, dtype);
+                }
+
+                /* Share the result */
+                memcpy(out->mcbmi_data + rank * fragment_size + first * dsize,
+                       target + lb, len * dsize);
+                opal_atomic_wmb();
+                PEER_NOTIFY_READY(rank, out, op_count);
+            }
+
+            /* Copy the slices of the others out, starting with the
+               next process */
+            for (i = 1; i < size; ++i) {
+                peer = (rank + i) % size;
+                first = SLICE_FIRST(peer);
+                len = SLICE_FIRST(peer + 1) - first;
+                if (0 == len) {
+                    continue;
+                }
+                WAIT_FOR_PEER_READY(peer, out, op_count, allreduce_out_label);
+                memcpy((char *) rbuf + lb + (done + first) * dsize,
+                       out->mcbmi_data + peer * fragment_size + first * dsize,
+                       len * dsize);
+            }
+
+            done += num;
+            segment_num += 2;
+        } while (done < (size_t) count && segment_num < max_segment_num);
+
+        /* Wait for all the reads to complete before I say I'm done
+           with the segments */
+        opal_atomic_mb();
+
+        /* We're finished with this set of segments */
+        FLAG_RELEASE(flag);
+    } while (done < (size_t) count);
+
+#undef SLICE_FIRST
+
+    return OMPI_SUCCESS;
+}
@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -20,22 +23,174 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/datatype/opal_convertor.h"
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
 #include "coll_sm.h"
 
 
-/*
- *	alltoall_intra
+/**
+ * Shared memory alltoall.
  *
- *	Function:	- MPI_Alltoall
- *	Accepts:	- same as MPI_Alltoall()
- *	Returns:	- MPI_SUCCESS or an MPI error code
+ * Every process streams the blocks it sends to the others, in the
+ * order rank + 1, rank + 2, ... (modulo the communicator size), one
+ * fragment per segment.  Process 0 claims each set of segments for
+ * everyone, and everyone releases it.  For each segment, every
+ * process copies the next fragment of its stream in its part of the
+ * segment, tells the others it is there, and copies out of the
+ * fragments of the others the pieces of the blocks sent to it.  Since
+ * all the streams have the same order relative to the sender, each
+ * process reads from a few different processes in each segment.
  */
 int mca_coll_sm_alltoall_intra(const void *sbuf, int scount,
-                               struct ompi_datatype_t *sdtype, void *rbuf,
-                               int rcount, struct ompi_datatype_t *rdtype,
+                               struct ompi_datatype_t *sdtype,
+                               void* rbuf, int rcount,
+                               struct ompi_datatype_t *rdtype,
                                struct ompi_communicator_t *comm,
-                                mca_coll_base_module_t *module)
+                               mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int i, ret, rank, size, peer, block_num;
+    int flag_num, segment_num, max_segment_num;
+    uint32_t op_count;
+    size_t block_size, fragment_size, offset, total_size, start, end, len;
+    ptrdiff_t sextent, rextent;
+    mca_coll_sm_in_use_flag_t *flag;
+    mca_coll_sm_data_index_t *index;
+    char *frag;
+
+    size = ompi_comm_size(comm);
+
+    /* The blocks are exchanged in place by the underlying module */
+    if (MPI_IN_PLACE == sbuf || !CONTROL_FITS(size)) {
+        return sm_module->previous_alltoall(sbuf, scount, sdtype,
+                                            rbuf, rcount, rdtype, comm,
+                                            sm_module->previous_alltoall_module);
+    }
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+
+    ompi_datatype_type_size(rdtype, &block_size);
+    block_size *= rcount;
+    ompi_datatype_type_extent(sdtype, &sextent);
+    ompi_datatype_type_extent(rdtype, &rextent);
+    sextent *= scount;
+    rextent *= rcount;
+
+    /* My own block */
+    ret = ompi_datatype_sndrcv((char *) sbuf + rank * sextent, scount, sdtype,
+                               (char *) rbuf + rank * rextent, rcount, rdtype);
+    if (OMPI_SUCCESS != ret || 0 == block_size) {
+        return ret;
+    }
+
+    total_size = block_size * (size - 1);
+    offset = 0;
+    do {
+        flag_num = (data->mcb_operation_count %
+                    mca_coll_sm_component.sm_comm_num_in_use_flags);
+        op_count = data->mcb_operation_count++;
+
+        FLAG_SETUP(flag_num, flag, data);
+        if (0 == rank) {
+            FLAG_WAIT_FOR_IDLE(flag, alltoall_claim_label);
+            FLAG_RETAIN(flag, size, op_count);
+        } else {
+            FLAG_WAIT_FOR_OP(flag, op_count, alltoall_wait_label);
+            opal_atomic_rmb();
+        }
+
+        /* Loop over all the segments in this set */
+
+        segment_num =
+            flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        max_segment_num =
+            (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        do {
+            index = &(data->mcb_data_index[segment_num]);
+            end = offset + fragment_size;
+            if (end > total_size) {
+                end = total_size;
+            }
+
+            /* Copy the pieces of my stream in this fragment */
+            frag = index->mcbmi_data + rank * fragment_size;
+            for (start = offset; start < end; start += len) {
+                block_num = start / block_size;
+                len = (block_num + 1) * block_size - start;
+                if (len > end - start) {
+                    len = end - start;
+                }
+                peer = (rank + 1 + block_num) % size;
+                ret = mca_coll_sm_pack_at(frag + (start - offset),
+                                          (char *) sbuf + peer * sextent,
+                                          scount, sdtype,
+                                          start - block_num * block_size, len);
+                if (OMPI_SUCCESS != ret) {
+                    return ret;
+                }
+            }
+
+            /* Wait for the write to absolutely complete */
+            opal_atomic_wmb();
+            PEER_NOTIFY_READY(rank, index, op_count);
+
+            /* Copy out the pieces of my blocks in the fragments of the
+               others */
+            for (i = 1; i < size; ++i) {
+                peer = (rank - i + size) % size;
+                block_num = i - 1;
+                start = block_num * block_size;
+                if (start < offset) {
+                    start = offset;
+                }
+                len = (block_num + 1) * block_size;
+                if (len > end) {
+                    len = end;
+                }
+                if (start >= len) {
+                    continue;
+                }
+                len -= start;
+
+                WAIT_FOR_PEER_READY(peer, index, op_count, alltoall_peer_label);
+                ret = mca_coll_sm_unpack_at(index->mcbmi_data + peer * fragment_size +
+                                            (start - offset),
+                                            (char *) rbuf + peer * rextent,
+                                            rcount, rdtype,
+                                            start - block_num * block_size, len);
+                if (OMPI_SUCCESS != ret) {
+                    return ret;
+                }
+            }
+
+            offset = end;
+            ++segment_num;
+        } while (offset < total_size && segment_num < max_segment_num);
+
+        /* Wait for all copy-out reads to complete before I say I'm
+           done with the segments */
+        opal_atomic_mb();
+
+        /* We're finished with this set of segments */
+        FLAG_RELEASE(flag);
+    } while (offset < total_size);
+
+    return OMPI_SUCCESS;
 }
@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -21,13 +24,15 @@
 #include "ompi_config.h"
 
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
 #include "coll_sm.h"
 
 
 /*
- *	exscan_intra
+ *	exscan
  *
- *	Function:	- basic exscan operation
+ *	Function:	- exscan
  *	Accepts:	- same arguments as MPI_Exscan()
  *	Returns:	- MPI_SUCCESS or error code
  */
@@ -37,5 +42,18 @@ int mca_coll_sm_exscan_intra(const void *sbuf, void *rbuf, int count,
                              struct ompi_communicator_t *comm,
                              mca_coll_base_module_t *module)
 {
-  return OMPI_ERR_NOT_IMPLEMENTED;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    size_t size;
+
+    ompi_datatype_type_size(dtype, &size);
+    if (0 == count || 0 == size ||
+        (int) size > mca_coll_sm_component.sm_fragment_size ||
+        !ompi_datatype_is_contiguous_memory_layout(dtype, count) ||
+        !CONTROL_FITS(ompi_comm_size(comm))) {
+        return sm_module->previous_exscan(sbuf, rbuf, count, dtype, op, comm,
+                                          sm_module->previous_exscan_module);
+    }
+
+    return mca_coll_sm_scan_fragments(sbuf, rbuf, count, dtype, op, true,
+                                      comm, module);
 }
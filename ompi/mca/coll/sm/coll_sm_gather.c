@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -20,16 +23,24 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/datatype/opal_convertor.h"
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
 #include "coll_sm.h"
 
 
-/*
- *      gather
+/**
+ * Shared memory gather.
  *
- *      Function:       - shared memory gather
- *      Accepts:        - same as MPI_Gather()
- *      Returns:        - MPI_SUCCESS or error code
+ * The root claims each set of segments, as in the reduction.  For
+ * each segment, the non-root processes copy the next fragment of
+ * their data in their part of the segment and tell the root, which
+ * copies the fragments out to its receive buffer as they come.
  */
 int mca_coll_sm_gather_intra(const void *sbuf, int scount,
                              struct ompi_datatype_t *sdtype, void *rbuf,
@@ -37,5 +48,172 @@ int mca_coll_sm_gather_intra(const void *sbuf, int scount,
                              int root, struct ompi_communicator_t *comm,
                              mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    struct iovec iov;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int i, ret, rank, size, peer;
+    int flag_num, segment_num, max_segment_num;
+    size_t fragment_size, total_size, max_data, len, bytes;
+    ptrdiff_t rextent;
+    mca_coll_sm_in_use_flag_t *flag;
+    opal_convertor_t convertor;
+    mca_coll_sm_data_index_t *index;
+
+    size = ompi_comm_size(comm);
+    if (!CONTROL_FITS(size)) {
+        return sm_module->previous_gather(sbuf, scount, sdtype,
+                                          rbuf, rcount, rdtype, root, comm,
+                                          sm_module->previous_gather_module);
+    }
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+    bytes = 0;
+
+    /*********************************************************************
+     * Root
+     *********************************************************************/
+
+    if (root == rank) {
+        ompi_datatype_type_size(rdtype, &total_size);
+        total_size *= rcount;
+        ompi_datatype_type_extent(rdtype, &rextent);
+        rextent *= rcount;
+
+        if (MPI_IN_PLACE != sbuf) {
+            ret = ompi_datatype_sndrcv(sbuf, scount, sdtype,
+                                       (char *) rbuf + rank * rextent,
+                                       rcount, rdtype);
+            if (OMPI_SUCCESS != ret) {
+                return ret;
+            }
+        }
+        if (0 == total_size) {
+            return OMPI_SUCCESS;
+        }
+
+        do {
+            flag_num = (data->mcb_operation_count %
+                        mca_coll_sm_component.sm_comm_num_in_use_flags);
+
+            FLAG_SETUP(flag_num, flag, data);
+            FLAG_WAIT_FOR_IDLE(flag, gather_root_flag_label);
+            FLAG_RETAIN(flag, size, data->mcb_operation_count);
+            ++data->mcb_operation_count;
+
+            /* Loop over all the segments in this set */
+
+            segment_num =
+                flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            max_segment_num =
+                (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            do {
+                index = &(data->mcb_data_index[segment_num]);
+                len = total_size - bytes;
+                if (len > fragment_size) {
+                    len = fragment_size;
+                }
+
+                /* Copy the fragments out as they come, starting with
+                   the process after me */
+                for (i = 1; i < size; ++i) {
+                    peer = (rank + i) % size;
+                    PARENT_WAIT_FOR_NOTIFY_SPECIFIC(peer, rank, index, max_data,
+                                                    gather_root_peer_label);
+                    opal_atomic_rmb();
+                    ret = mca_coll_sm_unpack_at(index->mcbmi_data + peer * fragment_size,
+                                                (char *) rbuf + peer * rextent,
+                                                rcount, rdtype, bytes, len);
+                    if (OMPI_SUCCESS != ret) {
+                        return ret;
+                    }
+                }
+
+                bytes += len;
+                ++segment_num;
+            } while (bytes < total_size && segment_num < max_segment_num);
+
+            /* Wait for all copy-out reads to complete before I say
+               I'm done with the segments */
+            opal_atomic_mb();
+
+            /* We're finished with this set of segments */
+            FLAG_RELEASE(flag);
+        } while (bytes < total_size);
+    }
+
+    /*********************************************************************
+     * Non-root
+     *********************************************************************/
+
+    else {
+        OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+        if (OMPI_SUCCESS !=
+            (ret =
+             opal_convertor_copy_and_prepare_for_send(ompi_mpi_local_convertor,
+                                                      &(sdtype->super),
+                                                      scount,
+                                                      sbuf,
+                                                      0,
+                                                      &convertor))) {
+            OBJ_DESTRUCT(&convertor);
+            return ret;
+        }
+        opal_convertor_get_packed_size(&convertor, &total_size);
+
+        while (bytes < total_size) {
+            flag_num = (data->mcb_operation_count %
+                        mca_coll_sm_component.sm_comm_num_in_use_flags);
+
+            /* Wait for the root to mark this set of segments as
+               ours */
+            FLAG_SETUP(flag_num, flag, data);
+            FLAG_WAIT_FOR_OP(flag, data->mcb_operation_count, gather_nonroot_flag_label);
+            ++data->mcb_operation_count;
+
+            /* Loop over all the segments in this set */
+
+            segment_num =
+                flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            max_segment_num =
+                (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            do {
+                index = &(data->mcb_data_index[segment_num]);
+
+                /* Copy from the user's buffer to my shared mem
+                   segment */
+                max_data = fragment_size;
+                COPY_FRAGMENT_IN(convertor, index, rank, iov, max_data);
+                bytes += max_data;
+
+                /* Wait for the write to complete before notifying
+                   the root */
+                opal_atomic_wmb();
+
+                /* Tell my parent (always the root) that the data is
+                   ready */
+                CHILD_NOTIFY_PARENT(rank, root, index, max_data);
+
+                ++segment_num;
+            } while (bytes < total_size && segment_num < max_segment_num);
+
+            /* We're finished with this set of segments */
+            FLAG_RELEASE(flag);
+        }
+
+        OBJ_DESTRUCT(&convertor);
+    }
+
+    /* All done */
+
+    return OMPI_SUCCESS;
 }
@@ -81,6 +81,28 @@ static int bootstrap_comm(ompi_communicator_t *comm,
 static int mca_coll_sm_module_disable(mca_coll_base_module_t *module,
                           struct ompi_communicator_t *comm);
 
+/*
+ * Release the underlying functions
+ */
+#define RELEASE_PREVIOUS(module, name)                          \
+    if (NULL != (module)->previous_ ## name ## _module) {       \
+        (module)->previous_ ## name = NULL;                     \
+        OBJ_RELEASE((module)->previous_ ## name ## _module);    \
+        (module)->previous_ ## name ## _module = NULL;          \
+    }
+
+static void release_previous(mca_coll_sm_module_t *module)
+{
+    RELEASE_PREVIOUS(module, allgather);
+    RELEASE_PREVIOUS(module, allgatherv);
+    RELEASE_PREVIOUS(module, alltoall);
+    RELEASE_PREVIOUS(module, exscan);
+    RELEASE_PREVIOUS(module, gather);
+    RELEASE_PREVIOUS(module, reduce);
+    RELEASE_PREVIOUS(module, scan);
+    RELEASE_PREVIOUS(module, scatter);
+}
+
 /*
  * Module constructor
  */
@@ -88,8 +110,22 @@ static void mca_coll_sm_module_construct(mca_coll_sm_module_t *module)
 {
     module->enabled = false;
     module->sm_comm_data = NULL;
+    module->previous_allgather = NULL;
+    module->previous_allgather_module = NULL;
+    module->previous_allgatherv = NULL;
+    module->previous_allgatherv_module = NULL;
+    module->previous_alltoall = NULL;
+    module->previous_alltoall_module = NULL;
+    module->previous_exscan = NULL;
+    module->previous_exscan_module = NULL;
+    module->previous_gather = NULL;
+    module->previous_gather_module = NULL;
     module->previous_reduce = NULL;
     module->previous_reduce_module = NULL;
+    module->previous_scan = NULL;
+    module->previous_scan_module = NULL;
+    module->previous_scatter = NULL;
+    module->previous_scatter_module = NULL;
     module->super.coll_module_disable = mca_coll_sm_module_disable;
 }
 
@@ -111,10 +147,7 @@ static void mca_coll_sm_module_destruct(mca_coll_sm_module_t *module)
         free(c);
     }
 
-    /* It should always be non-NULL, but just in case */
-    if (NULL != module->previous_reduce_module) {
-        OBJ_RELEASE(module->previous_reduce_module);
-    }
+    release_previous(module);
 
     module->enabled = false;
 }
@@ -124,12 +157,7 @@ static void mca_coll_sm_module_destruct(mca_coll_sm_module_t *module)
  */
 static int mca_coll_sm_module_disable(mca_coll_base_module_t *module, struct ompi_communicator_t *comm)
 {
-    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
-    if (NULL != sm_module->previous_reduce_module) {
-	sm_module->previous_reduce = NULL;
-        OBJ_RELEASE(sm_module->previous_reduce_module);
-	sm_module->previous_reduce_module = NULL;
-    }
+    release_previous((mca_coll_sm_module_t*) module);
     return OMPI_SUCCESS;
 }
 
@@ -196,21 +224,21 @@ mca_coll_sm_comm_query(struct ompi_communicator_t *comm, int *priority)
     /* All is good -- return a module */
     sm_module->super.coll_module_enable = sm_module_enable;
     sm_module->super.ft_event        = mca_coll_sm_ft_event;
-    sm_module->super.coll_allgather  = NULL;
-    sm_module->super.coll_allgatherv = NULL;
+    sm_module->super.coll_allgather  = mca_coll_sm_allgather_intra;
+    sm_module->super.coll_allgatherv = mca_coll_sm_allgatherv_intra;
     sm_module->super.coll_allreduce  = mca_coll_sm_allreduce_intra;
-    sm_module->super.coll_alltoall   = NULL;
+    sm_module->super.coll_alltoall   = mca_coll_sm_alltoall_intra;
     sm_module->super.coll_alltoallv  = NULL;
     sm_module->super.coll_alltoallw  = NULL;
     sm_module->super.coll_barrier    = mca_coll_sm_barrier_intra;
     sm_module->super.coll_bcast      = mca_coll_sm_bcast_intra;
-    sm_module->super.coll_exscan     = NULL;
-    sm_module->super.coll_gather     = NULL;
+    sm_module->super.coll_exscan     = mca_coll_sm_exscan_intra;
+    sm_module->super.coll_gather     = mca_coll_sm_gather_intra;
     sm_module->super.coll_gatherv    = NULL;
     sm_module->super.coll_reduce     = mca_coll_sm_reduce_intra;
     sm_module->super.coll_reduce_scatter = NULL;
-    sm_module->super.coll_scan       = NULL;
-    sm_module->super.coll_scatter    = NULL;
+    sm_module->super.coll_scan       = mca_coll_sm_scan_intra;
+    sm_module->super.coll_scatter    = mca_coll_sm_scatter_intra;
     sm_module->super.coll_scatterv   = NULL;
 
     opal_output_verbose(10, ompi_coll_base_framework.framework_output,
@@ -226,15 +254,42 @@ mca_coll_sm_comm_query(struct ompi_communicator_t *comm, int *priority)
 static int sm_module_enable(mca_coll_base_module_t *module,
                             struct ompi_communicator_t *comm)
 {
-    if (NULL == comm->c_coll->coll_reduce ||
-        NULL == comm->c_coll->coll_reduce_module) {
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    const char *msg = NULL;
+
+    /* Save the functions of the modules selected so far, used for the
+       cases this module does not handle.  This has to happen here:
+       by the time of the lazy enable they may be ours. */
+#define CHECK_AND_RETAIN(name)                                          \
+    if (NULL == comm->c_coll->coll_ ## name ||                          \
+        NULL == comm->c_coll->coll_ ## name ## _module) {               \
+        msg = #name;                                                    \
+    } else if (NULL == msg) {                                           \
+        sm_module->previous_ ## name = comm->c_coll->coll_ ## name;     \
+        sm_module->previous_ ## name ## _module =                       \
+            comm->c_coll->coll_ ## name ## _module;                     \
+        OBJ_RETAIN(sm_module->previous_ ## name ## _module);            \
+    }
+
+    CHECK_AND_RETAIN(allgather);
+    CHECK_AND_RETAIN(allgatherv);
+    CHECK_AND_RETAIN(alltoall);
+    CHECK_AND_RETAIN(exscan);
+    CHECK_AND_RETAIN(gather);
+    CHECK_AND_RETAIN(reduce);
+    CHECK_AND_RETAIN(scan);
+    CHECK_AND_RETAIN(scatter);
+#undef CHECK_AND_RETAIN
+
+    if (NULL != msg) {
         opal_output_verbose(10, ompi_coll_base_framework.framework_output,
-                            "coll:sm:enable (%d/%s): no underlying reduce; disqualifying myself",
-                            comm->c_contextid, comm->c_name);
+                            "coll:sm:enable (%d/%s): no underlying %s; disqualifying myself",
+                            comm->c_contextid, comm->c_name, msg);
+        release_previous(sm_module);
         return OMPI_ERROR;
     }
 
-    /* We do everything lazily in ompi_coll_sm_enable() */
+    /* We do everything else lazily in ompi_coll_sm_enable() */
     return OMPI_SUCCESS;
 }
 
@@ -459,11 +514,6 @@ int ompi_coll_sm_lazy_enable(mca_coll_base_module_t *module,
                c->sm_control_size);
     }
 
-    /* Save previous component's reduce information */
-    sm_module->previous_reduce = comm->c_coll->coll_reduce;
-    sm_module->previous_reduce_module = comm->c_coll->coll_reduce_module;
-    OBJ_RETAIN(sm_module->previous_reduce_module);
-
     /* Indicate that we have successfully attached and setup */
     opal_atomic_add (&(data->sm_bootstrap_meta->module_seg->seg_inited), 1);
 
@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -20,14 +23,148 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/op/op.h"
 #include "coll_sm.h"
 
 
+/**
+ * Shared memory inclusive (or exclusive) prefix reduction.
+ *
+ * Process 0 claims each set of segments for everyone, and everyone
+ * releases it.  For each segment, every process but the last copies
+ * the next fragment of its data in its part of the segment and tells
+ * the others.  It then reduces the fragments of the processes before
+ * it, in order, into its receive buffer: the result is (0 op (1 op
+ * (... op rank))), which only relies on the associativity of the
+ * operation.  Only datatypes with a contiguous layout are handled:
+ * the fragments are used as operands as they are.
+ */
+int mca_coll_sm_scan_fragments(const void *sbuf, void *rbuf, int count,
+                               struct ompi_datatype_t *dtype,
+                               struct ompi_op_t *op, bool exclusive,
+                               struct ompi_communicator_t *comm,
+                               mca_coll_base_module_t *module)
+{
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int ret, rank, size, peer, first;
+    int flag_num, segment_num, max_segment_num;
+    uint32_t op_count;
+    size_t dsize, segment_ddt_count, fragment_size, num, done;
+    ptrdiff_t lb, extent;
+    mca_coll_sm_in_use_flag_t *flag;
+    mca_coll_sm_data_index_t *index;
+    const char *src;
+    char *target;
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    size = ompi_comm_size(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+
+    ompi_datatype_type_size(dtype, &dsize);
+    ompi_datatype_get_true_extent(dtype, &lb, &extent);
+    segment_ddt_count = fragment_size / dsize;
+    if (MPI_IN_PLACE == sbuf) {
+        sbuf = rbuf;
+    }
+
+    /* The last process to get data from the others */
+    first = exclusive ? rank - 1 : rank;
+
+    done = 0;
+    do {
+        flag_num = (data->mcb_operation_count %
+                    mca_coll_sm_component.sm_comm_num_in_use_flags);
+        op_count = data->mcb_operation_count++;
+
+        FLAG_SETUP(flag_num, flag, data);
+        if (0 == rank) {
+            FLAG_WAIT_FOR_IDLE(flag, scan_claim_label);
+            FLAG_RETAIN(flag, size, op_count);
+        } else {
+            FLAG_WAIT_FOR_OP(flag, op_count, scan_wait_label);
+            opal_atomic_rmb();
+        }
+
+        /* Loop over all the segments in this set */
+
+        segment_num =
+            flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        max_segment_num =
+            (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+        do {
+            index = &(data->mcb_data_index[segment_num]);
+            num = count - done;
+            if (num > segment_ddt_count) {
+                num = segment_ddt_count;
+            }
+            src = (const char *) sbuf + lb + done * dsize;
+            target = (char *) rbuf + done * dsize;
+
+            /* Share my fragment with the processes after me.  This
+               comes first since the receive buffer may be the send
+               buffer. */
+            if (rank < size - 1) {
+                memcpy(index->mcbmi_data + rank * fragment_size, src,
+                       num * dsize);
+                opal_atomic_wmb();
+                PEER_NOTIFY_READY(rank, index, op_count);
+            }
+
+            if (first >= 0) {
+                peer = first;
+                if (exclusive) {
+                    WAIT_FOR_PEER_READY(peer, index, op_count, exscan_first_label);
+                    memcpy(target + lb, index->mcbmi_data + peer * fragment_size,
+                           num * dsize);
+                    --peer;
+                } else if (src != target + lb) {
+                    memcpy(target + lb, src, num * dsize);
+                }
+
+                for (; peer >= 0; --peer) {
+                    WAIT_FOR_PEER_READY(peer, index, op_count, scan_peer_label);
+                    ompi_op_reduce(op, index->mcbmi_data + peer * fragment_size - lb,
+                                   target, num, dtype);
+                }
+            }
+
+            done += num;
+            ++segment_num;
+        } while (done < (size_t) count && segment_num < max_segment_num);
+
+        /* Wait for all the reads to complete before I say I'm done
+           with the segments */
+        opal_atomic_mb();
+
+        /* We're finished with this set of segments */
+        FLAG_RELEASE(flag);
+    } while (done < (size_t) count);
+
+    return OMPI_SUCCESS;
+}
+
+
 /*
  *	scan
  *
- *	Function:	- basic scan operation
+ *	Function:	- scan
  *	Accepts:	- same arguments as MPI_Scan()
  *	Returns:	- MPI_SUCCESS or error code
  */
@@ -37,5 +174,18 @@ int mca_coll_sm_scan_intra(const void *sbuf, void *rbuf, int count,
                            struct ompi_communicator_t *comm,
                            mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    size_t size;
+
+    ompi_datatype_type_size(dtype, &size);
+    if (0 == count || 0 == size ||
+        (int) size > mca_coll_sm_component.sm_fragment_size ||
+        !ompi_datatype_is_contiguous_memory_layout(dtype, count) ||
+        !CONTROL_FITS(ompi_comm_size(comm))) {
+        return sm_module->previous_scan(sbuf, rbuf, count, dtype, op, comm,
+                                        sm_module->previous_scan_module);
+    }
+
+    return mca_coll_sm_scan_fragments(sbuf, rbuf, count, dtype, op, false,
+                                      comm, module);
 }
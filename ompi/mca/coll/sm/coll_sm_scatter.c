@@ -11,6 +11,9 @@
  *                         All rights reserved.
  * Copyright (c) 2015      Research Organization for Information Science
  *                         and Technology (RIST). All rights reserved.
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
  * $COPYRIGHT$
  *
  * Additional copyrights may follow
@@ -20,16 +23,26 @@
 
 #include "ompi_config.h"
 
+#include <string.h>
+
+#include "opal/datatype/opal_convertor.h"
+#include "opal/sys/atomic.h"
 #include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/coll/coll.h"
 #include "coll_sm.h"
 
 
-/*
- *      scatter
+/**
+ * Shared memory scatter.
  *
- *      Function:       - shared memory reduce
- *      Accepts:        - same as MPI_Scatter()
- *      Returns:        - MPI_SUCCESS or error code
+ * The root claims each set of segments, as in the broadcast.  For
+ * each segment, it copies the next fragment of the data of every
+ * other process in the part of the segment of that process, and
+ * writes the data size into its control buffer.  The non-root
+ * processes wait for the size to appear and copy the fragment out to
+ * their receive buffer.
  */
 int mca_coll_sm_scatter_intra(const void *sbuf, int scount,
                               struct ompi_datatype_t *sdtype, void *rbuf,
@@ -37,5 +50,162 @@ int mca_coll_sm_scatter_intra(const void *sbuf, int scount,
                               int root, struct ompi_communicator_t *comm,
                               mca_coll_base_module_t *module)
 {
-    return OMPI_ERR_NOT_IMPLEMENTED;
+    struct iovec iov;
+    mca_coll_sm_module_t *sm_module = (mca_coll_sm_module_t*) module;
+    mca_coll_sm_comm_t *data;
+    int i, ret, rank, size, peer;
+    int flag_num, segment_num, max_segment_num;
+    size_t fragment_size, total_size, max_data, len, bytes;
+    ptrdiff_t sextent;
+    mca_coll_sm_in_use_flag_t *flag;
+    opal_convertor_t convertor;
+    mca_coll_sm_data_index_t *index;
+
+    size = ompi_comm_size(comm);
+    if (!CONTROL_FITS(size)) {
+        return sm_module->previous_scatter(sbuf, scount, sdtype,
+                                           rbuf, rcount, rdtype, root, comm,
+                                           sm_module->previous_scatter_module);
+    }
+
+    /* Lazily enable the module the first time we invoke a collective
+       on it */
+    if (!sm_module->enabled) {
+        if (OMPI_SUCCESS != (ret = ompi_coll_sm_lazy_enable(module, comm))) {
+            return ret;
+        }
+    }
+    data = sm_module->sm_comm_data;
+
+    rank = ompi_comm_rank(comm);
+    fragment_size = mca_coll_sm_component.sm_fragment_size;
+    bytes = 0;
+
+    /*********************************************************************
+     * Root
+     *********************************************************************/
+
+    if (root == rank) {
+        ompi_datatype_type_size(sdtype, &total_size);
+        total_size *= scount;
+        ompi_datatype_type_extent(sdtype, &sextent);
+        sextent *= scount;
+
+        if (MPI_IN_PLACE != rbuf) {
+            ret = ompi_datatype_sndrcv((char *) sbuf + rank * sextent,
+                                       scount, sdtype, rbuf, rcount, rdtype);
+            if (OMPI_SUCCESS != ret) {
+                return ret;
+            }
+        }
+
+        while (bytes < total_size) {
+            flag_num = (data->mcb_operation_count++ %
+                        mca_coll_sm_component.sm_comm_num_in_use_flags);
+
+            FLAG_SETUP(flag_num, flag, data);
+            FLAG_WAIT_FOR_IDLE(flag, scatter_root_label);
+            FLAG_RETAIN(flag, size - 1, data->mcb_operation_count - 1);
+
+            /* Loop over all the segments in this set */
+
+            segment_num =
+                flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            max_segment_num =
+                (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            do {
+                index = &(data->mcb_data_index[segment_num]);
+                len = total_size - bytes;
+                if (len > fragment_size) {
+                    len = fragment_size;
+                }
+
+                for (i = 1; i < size; ++i) {
+                    peer = (rank + i) % size;
+                    ret = mca_coll_sm_pack_at(index->mcbmi_data + peer * fragment_size,
+                                              (char *) sbuf + peer * sextent,
+                                              scount, sdtype, bytes, len);
+                    if (OMPI_SUCCESS != ret) {
+                        return ret;
+                    }
+
+                    /* Wait for the write to absolutely complete */
+                    opal_atomic_wmb();
+
+                    /* Tell the process that its fragment is ready;
+                       the first word of its control buffer is the one
+                       its parent writes in a fan out */
+                    CHILD_NOTIFY_PARENT(0, peer, index, len);
+                }
+
+                bytes += len;
+                ++segment_num;
+            } while (bytes < total_size && segment_num < max_segment_num);
+        }
+    }
+
+    /*********************************************************************
+     * Non-root
+     *********************************************************************/
+
+    else {
+        OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+        if (OMPI_SUCCESS !=
+            (ret =
+             opal_convertor_copy_and_prepare_for_recv(ompi_mpi_local_convertor,
+                                                      &(rdtype->super),
+                                                      rcount,
+                                                      rbuf,
+                                                      0,
+                                                      &convertor))) {
+            OBJ_DESTRUCT(&convertor);
+            return ret;
+        }
+        opal_convertor_get_packed_size(&convertor, &total_size);
+
+        while (bytes < total_size) {
+            flag_num = (data->mcb_operation_count %
+                        mca_coll_sm_component.sm_comm_num_in_use_flags);
+
+            /* Wait for the root to mark this set of segments as
+               ours */
+            FLAG_SETUP(flag_num, flag, data);
+            FLAG_WAIT_FOR_OP(flag, data->mcb_operation_count, scatter_nonroot_label1);
+            ++data->mcb_operation_count;
+
+            /* Loop over all the segments in this set */
+
+            segment_num =
+                flag_num * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            max_segment_num =
+                (flag_num + 1) * mca_coll_sm_component.sm_segs_per_inuse_flag;
+            do {
+                index = &(data->mcb_data_index[segment_num]);
+
+                /* Wait for the root to tell me that the fragment is
+                   ready */
+                CHILD_WAIT_FOR_NOTIFY(rank, index, max_data, scatter_nonroot_label2);
+                opal_atomic_rmb();
+
+                /* Copy to my output buffer */
+                COPY_FRAGMENT_OUT(convertor, rank, index, iov, max_data);
+
+                bytes += max_data;
+                ++segment_num;
+            } while (bytes < total_size && segment_num < max_segment_num);
+
+            /* Wait for all copy-out writes to complete before I say
+               I'm done with the segments */
+            opal_atomic_wmb();
+
+            /* We're finished with this set of segments */
+            FLAG_RELEASE(flag);
+        }
+
+        OBJ_DESTRUCT(&convertor);
+    }
+
+    /* All done */
+
+    return OMPI_SUCCESS;
 }
@@ -184,6 +184,40 @@ int ompi_coll_tuned_scan_intra_check_forced_init (coll_tuned_force_algorithm_mca
 
 int mca_coll_tuned_ft_event(int state);
 
+/* online algorithm selection */
+#define COLL_TUNED_ONLINE_BUCKETS 32
+#define COLL_TUNED_ONLINE_MAX_CANDIDATES 16
+
+/* the selection for the messages of one power of 2 size */
+struct coll_tuned_online_bucket_t {
+    int    algorithm;   /* locked in algorithm, -1 while learning */
+    int    calls;       /* calls made while learning */
+    double times[COLL_TUNED_ONLINE_MAX_CANDIDATES];  /* usec spent in each candidate */
+};
+typedef struct coll_tuned_online_bucket_t coll_tuned_online_bucket_t;
+
+/* allocated on the first call of a collective on each communicator */
+struct coll_tuned_online_t {
+    int ncandidates;
+    int candidates[COLL_TUNED_ONLINE_MAX_CANDIDATES];
+    coll_tuned_online_bucket_t buckets[COLL_TUNED_ONLINE_BUCKETS];
+};
+typedef struct coll_tuned_online_t coll_tuned_online_t;
+
+/* what the end of a call needs to know about its beginning */
+struct coll_tuned_online_call_t {
+    int      coll;
+    int      bucket;
+    int      candidate;  /* -1 once the bucket is decided */
+    uint64_t start;
+};
+typedef struct coll_tuned_online_call_t coll_tuned_online_call_t;
+
+extern int ompi_coll_tuned_online_trials;
+
+int ompi_coll_tuned_online_register(void);
+bool ompi_coll_tuned_online_supported(int coll);
+
 struct mca_coll_tuned_component_t {
 	/** Base coll component */
 	mca_coll_base_component_2_0_0_t super;
@@ -217,8 +251,22 @@ struct mca_coll_tuned_module_t {
 
     /* the communicator rules for each MPI collective for ONLY my comsize */
     ompi_coll_com_rule_t *com_rules[COLLCOUNT];
+
+    /* the online selection state of each MPI collective, NULL until first used */
+    coll_tuned_online_t *online[COLLCOUNT];
 };
 typedef struct mca_coll_tuned_module_t mca_coll_tuned_module_t;
 OBJ_CLASS_DECLARATION(mca_coll_tuned_module_t);
 
+/* Returns the algorithm to run, or -1 to fall back to the fixed decision */
+int ompi_coll_tuned_online_begin(mca_coll_tuned_module_t *tuned_module, int coll,
+                                 size_t dsize, struct ompi_communicator_t *comm,
+                                 coll_tuned_online_call_t *call);
+/* Accounts for the call and, after the last trial, agrees on the algorithm */
+int ompi_coll_tuned_online_end(mca_coll_tuned_module_t *tuned_module,
+                               coll_tuned_online_call_t *call, int ret,
+                               struct ompi_communicator_t *comm,
+                               mca_coll_base_module_t *module);
+void ompi_coll_tuned_online_free(mca_coll_tuned_module_t *tuned_module);
+
 #endif  /* MCA_COLL_TUNED_EXPORT_H */
@@ -207,6 +207,9 @@ static int tuned_register(void)
     ompi_coll_tuned_exscan_intra_check_forced_init(&ompi_coll_tuned_forced_params[EXSCAN]);
     ompi_coll_tuned_scan_intra_check_forced_init(&ompi_coll_tuned_forced_params[SCAN]);
 
+    /* online selection param and its MPI_T decisions */
+    ompi_coll_tuned_online_register();
+
     return OMPI_SUCCESS;
 }
 
@@ -276,8 +279,15 @@ mca_coll_tuned_module_construct(mca_coll_tuned_module_t *module)
     for( int i = 0; i < COLLCOUNT; i++ ) {
         tuned_module->user_forced[i].algorithm = 0;
         tuned_module->com_rules[i] = NULL;
+        tuned_module->online[i] = NULL;
     }
 }
 
+static void
+mca_coll_tuned_module_destruct(mca_coll_tuned_module_t *module)
+{
+    ompi_coll_tuned_online_free(module);
+}
+
 OBJ_CLASS_INSTANCE(mca_coll_tuned_module_t, mca_coll_base_module_t,
-                   mca_coll_tuned_module_construct, NULL);
+                   mca_coll_tuned_module_construct, mca_coll_tuned_module_destruct);
@@ -30,6 +30,7 @@
 #include "ompi/mca/coll/base/base.h"
 #include "ompi/mca/coll/coll.h"
 #include "ompi/mca/coll/base/coll_tags.h"
+#include "ompi/op/op.h"
 #include "coll_tuned.h"
 
 /*
@@ -40,6 +41,8 @@
  * Else
  *      use forced rules (-coll_tuned_dynamic_ALG_intra_algorithm = algorithm-number)
  * Else
+ *      use the online selection if enabled (-coll_tuned_online_trials = calls)
+ * Else
  *      use fixed (compiled) rule set (or nested ifs)
  *
  */
@@ -88,6 +91,25 @@ ompi_coll_tuned_allreduce_intra_dec_dynamic (const void *sbuf, void *rbuf, int c
                                                        tuned_module->user_forced[ALLREDUCE].tree_fanout,
                                                        tuned_module->user_forced[ALLREDUCE].segsize);
     }
+
+    /* the online selection only tries algorithms that need commutative operations */
+    if (ompi_coll_tuned_online_trials > 0 && ompi_op_is_commute(op)) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+        size_t dsize;
+
+        ompi_datatype_type_size (dtype, &dsize);
+        dsize *= count;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, ALLREDUCE, dsize, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_allreduce_intra_do_this(sbuf, rbuf, count, dtype, op, comm, module,
+                                                          alg,
+                                                          tuned_module->user_forced[ALLREDUCE].tree_fanout,
+                                                          tuned_module->user_forced[ALLREDUCE].segsize);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
     return ompi_coll_tuned_allreduce_intra_dec_fixed (sbuf, rbuf, count, dtype, op,
                                                       comm, module);
 }
@@ -143,6 +165,26 @@ int ompi_coll_tuned_alltoall_intra_dec_dynamic(const void *sbuf, int scount,
                                                       tuned_module->user_forced[ALLTOALL].segsize,
                                                       tuned_module->user_forced[ALLTOALL].max_requests);
     }
+
+    if (ompi_coll_tuned_online_trials > 0) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+        size_t dsize;
+
+        ompi_datatype_type_size (rdtype, &dsize);
+        dsize *= (ptrdiff_t)ompi_comm_size(comm) * (ptrdiff_t)rcount;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, ALLTOALL, dsize, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_alltoall_intra_do_this(sbuf, scount, sdtype,
+                                                         rbuf, rcount, rdtype,
+                                                         comm, module, alg,
+                                                         tuned_module->user_forced[ALLTOALL].tree_fanout,
+                                                         tuned_module->user_forced[ALLTOALL].segsize,
+                                                         tuned_module->user_forced[ALLTOALL].max_requests);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
     return ompi_coll_tuned_alltoall_intra_dec_fixed (sbuf, scount, sdtype,
                                                      rbuf, rcount, rdtype,
                                                      comm, module);
@@ -232,6 +274,17 @@ int ompi_coll_tuned_barrier_intra_dec_dynamic(struct ompi_communicator_t *comm,
                                                      tuned_module->user_forced[BARRIER].tree_fanout,
                                                      tuned_module->user_forced[BARRIER].segsize);
     }
+
+    if (ompi_coll_tuned_online_trials > 0) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, BARRIER, 0, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_barrier_intra_do_this(comm, module, alg, 0, 0);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
     return ompi_coll_tuned_barrier_intra_dec_fixed (comm, module);
 }
 
@@ -279,6 +332,24 @@ int ompi_coll_tuned_bcast_intra_dec_dynamic(void *buf, int count,
                                                    tuned_module->user_forced[BCAST].chain_fanout,
                                                    tuned_module->user_forced[BCAST].segsize);
     }
+
+    if (ompi_coll_tuned_online_trials > 0) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+        size_t dsize;
+
+        ompi_datatype_type_size (dtype, &dsize);
+        dsize *= count;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, BCAST, dsize, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_bcast_intra_do_this(buf, count, dtype,
+                                                      root, comm, module, alg,
+                                                      tuned_module->user_forced[BCAST].chain_fanout,
+                                                      tuned_module->user_forced[BCAST].segsize);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
     return ompi_coll_tuned_bcast_intra_dec_fixed (buf, count, dtype, root,
                                                   comm, module);
 }
@@ -331,6 +402,26 @@ int ompi_coll_tuned_reduce_intra_dec_dynamic( const void *sbuf, void *rbuf,
                                                     tuned_module->user_forced[REDUCE].segsize,
                                                     tuned_module->user_forced[REDUCE].max_requests);
     }
+
+    /* the online selection only tries algorithms that need commutative operations */
+    if (ompi_coll_tuned_online_trials > 0 && ompi_op_is_commute(op)) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+        size_t dsize;
+
+        ompi_datatype_type_size (dtype, &dsize);
+        dsize *= count;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, REDUCE, dsize, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_reduce_intra_do_this(sbuf, rbuf, count, dtype,
+                                                       op, root, comm, module, alg,
+                                                       tuned_module->user_forced[REDUCE].chain_fanout,
+                                                       tuned_module->user_forced[REDUCE].segsize,
+                                                       tuned_module->user_forced[REDUCE].max_requests);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
     return ompi_coll_tuned_reduce_intra_dec_fixed (sbuf, rbuf, count, dtype,
                                                    op, root, comm, module);
 }
@@ -495,6 +586,25 @@ int ompi_coll_tuned_allgather_intra_dec_dynamic(const void *sbuf, int scount,
                                                        tuned_module->user_forced[ALLGATHER].segsize);
     }
 
+    if (ompi_coll_tuned_online_trials > 0) {
+        coll_tuned_online_call_t call;
+        int alg, ret;
+        size_t dsize;
+
+        ompi_datatype_type_size (rdtype, &dsize);
+        dsize *= (ptrdiff_t)ompi_comm_size(comm) * (ptrdiff_t)rcount;
+
+        alg = ompi_coll_tuned_online_begin(tuned_module, ALLGATHER, dsize, comm, &call);
+        if (alg >= 0) {
+            ret = ompi_coll_tuned_allgather_intra_do_this(sbuf, scount, sdtype,
+                                                          rbuf, rcount, rdtype,
+                                                          comm, module, alg,
+                                                          tuned_module->user_forced[ALLGATHER].tree_fanout,
+                                                          tuned_module->user_forced[ALLGATHER].segsize);
+            return ompi_coll_tuned_online_end(tuned_module, &call, ret, comm, module);
+        }
+    }
+
     /* Use default decision */
     return ompi_coll_tuned_allgather_intra_dec_fixed (sbuf, scount, sdtype,
                                                       rbuf, rcount, rdtype,
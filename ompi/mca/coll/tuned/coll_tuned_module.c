@@ -157,6 +157,9 @@ ompi_coll_tuned_forced_getvalues( enum COLLTYPE type,
         if( 0 != (TMOD)->user_forced[(TYPE)].algorithm ) {              \
             need_dynamic_decision = 1;                                  \
         }                                                               \
+        if( ompi_coll_tuned_online_supported(TYPE) ) {                  \
+            need_dynamic_decision = 1;                                  \
+        }                                                               \
         if( NULL != mca_coll_tuned_component.all_base_rules ) {         \
             (TMOD)->com_rules[(TYPE)]                                   \
                 = ompi_coll_tuned_get_com_rule_ptr( mca_coll_tuned_component.all_base_rules, \
@@ -0,0 +1,302 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Online algorithm selection
+ *
+ * When coll_tuned_online_trials is set, the dynamic decision functions
+ * of the supported collectives learn the best algorithm of each
+ * communicator for each message size bucket (a power of 2 of the
+ * message size as computed for the rule files).  The first calls of
+ * a bucket run every candidate algorithm, 0 (the fixed decision) first,
+ * online_trials times each.  The call that ends the trials agrees on
+ * the winner: the ranks allreduce the maximum of the time they spent
+ * in each candidate and all lock in the candidate of the smallest
+ * maximum.  As the calls of a communicator happen in the same order and
+ * with the same message size on all its processes, they all run the
+ * same candidates on the same calls without any other communication.
+ *
+ * The decisions are exported through the coll_tuned_<coll>_online_decisions
+ * MPI_T performance variables bound to communicators, one entry per
+ * bucket, so they can be turned into a rule file.
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "opal/mca/base/mca_base_pvar.h"
+#include "opal/mca/timer/base/base.h"
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/mca/coll/base/base.h"
+#include "ompi/op/op.h"
+#include "coll_tuned.h"
+
+int ompi_coll_tuned_online_trials = 0;
+
+static const struct {
+    int coll;
+    const char *name;
+} online_collectives[] = {
+    { ALLGATHER, "allgather" },
+    { ALLREDUCE, "allreduce" },
+    { ALLTOALL, "alltoall" },
+    { BARRIER, "barrier" },
+    { BCAST, "bcast" },
+    { REDUCE, "reduce" }
+};
+#define ONLINE_NCOLLS ((int) (sizeof(online_collectives) / sizeof(online_collectives[0])))
+
+bool ompi_coll_tuned_online_supported(int coll)
+{
+    if (ompi_coll_tuned_online_trials <= 0) {
+        return false;
+    }
+    for (int i = 0; i < ONLINE_NCOLLS; i++) {
+        if (online_collectives[i].coll == coll) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Algorithms a collective cannot always run on a communicator of this size */
+static bool online_candidate_valid(int coll, int algorithm, int comsize)
+{
+    switch (coll) {
+    case ALLGATHER:
+        return 6 != algorithm || 2 == comsize;  /* two_proc */
+    case ALLTOALL:
+        return 5 != algorithm || 2 == comsize;  /* two_proc */
+    case BARRIER:
+        return 5 != algorithm || 2 == comsize;  /* two_proc */
+    }
+    return true;
+}
+
+static coll_tuned_online_t *online_state(mca_coll_tuned_module_t *tuned_module, int coll,
+                                         struct ompi_communicator_t *comm)
+{
+    coll_tuned_online_t *online = tuned_module->online[coll];
+    int comsize = ompi_comm_size(comm);
+
+    if (NULL != online) {
+        return online;
+    }
+    online = (coll_tuned_online_t *) calloc(1, sizeof(coll_tuned_online_t));
+    if (NULL == online) {
+        return NULL;
+    }
+    for (int alg = 0; alg < ompi_coll_tuned_forced_max_algorithms[coll] &&
+             online->ncandidates < COLL_TUNED_ONLINE_MAX_CANDIDATES; alg++) {
+        if (online_candidate_valid(coll, alg, comsize)) {
+            online->candidates[online->ncandidates++] = alg;
+        }
+    }
+    for (int b = 0; b < COLL_TUNED_ONLINE_BUCKETS; b++) {
+        online->buckets[b].algorithm = -1;
+    }
+    tuned_module->online[coll] = online;
+    return online;
+}
+
+static int online_bucket(size_t dsize)
+{
+    int bucket = 0;
+
+    while (dsize > 1 && bucket < COLL_TUNED_ONLINE_BUCKETS - 1) {
+        dsize >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+int ompi_coll_tuned_online_begin(mca_coll_tuned_module_t *tuned_module, int coll,
+                                 size_t dsize, struct ompi_communicator_t *comm,
+                                 coll_tuned_online_call_t *call)
+{
+    coll_tuned_online_t *online;
+    coll_tuned_online_bucket_t *bucket;
+
+    if (ompi_comm_size(comm) < 2 ||
+        NULL == (online = online_state(tuned_module, coll, comm))) {
+        return -1;
+    }
+    call->coll = coll;
+    call->bucket = online_bucket(dsize);
+    bucket = &online->buckets[call->bucket];
+    if (bucket->algorithm >= 0) {
+        call->candidate = -1;
+        return bucket->algorithm;
+    }
+    call->candidate = bucket->calls / ompi_coll_tuned_online_trials;
+    call->start = opal_timer_base_get_usec();
+    return online->candidates[call->candidate];
+}
+
+int ompi_coll_tuned_online_end(mca_coll_tuned_module_t *tuned_module,
+                               coll_tuned_online_call_t *call, int ret,
+                               struct ompi_communicator_t *comm,
+                               mca_coll_base_module_t *module)
+{
+    coll_tuned_online_t *online = tuned_module->online[call->coll];
+    coll_tuned_online_bucket_t *bucket = &online->buckets[call->bucket];
+    int best = 0;
+
+    if (call->candidate < 0 || MPI_SUCCESS != ret) {
+        return ret;
+    }
+    /* The first call of a candidate pays for its setup (trees, buffers) */
+    if (1 == ompi_coll_tuned_online_trials ||
+        0 != bucket->calls % ompi_coll_tuned_online_trials) {
+        bucket->times[call->candidate] += (double) (opal_timer_base_get_usec() - call->start);
+    }
+    if (++bucket->calls < online->ncandidates * ompi_coll_tuned_online_trials) {
+        return ret;
+    }
+
+    /* All the trials are done: the slowest process sets the time of a candidate */
+    ret = ompi_coll_tuned_allreduce_intra_dec_fixed(MPI_IN_PLACE, bucket->times,
+                                                    online->ncandidates, MPI_DOUBLE,
+                                                    MPI_MAX, comm, module);
+    if (MPI_SUCCESS != ret) {
+        return ret;
+    }
+    for (int c = 1; c < online->ncandidates; c++) {
+        if (bucket->times[c] < bucket->times[best]) {
+            best = c;
+        }
+    }
+    bucket->algorithm = online->candidates[best];
+    OPAL_OUTPUT((ompi_coll_tuned_stream,
+                 "coll:tuned:online comm %u collective %d messages of %lu bytes or more: algorithm %d",
+                 ompi_comm_get_cid(comm), call->coll,
+                 call->bucket ? 1ul << call->bucket : 0ul, bucket->algorithm));
+    return ret;
+}
+
+void ompi_coll_tuned_online_free(mca_coll_tuned_module_t *tuned_module)
+{
+    for (int i = 0; i < COLLCOUNT; i++) {
+        if (NULL != tuned_module->online[i]) {
+            free(tuned_module->online[i]);
+            tuned_module->online[i] = NULL;
+        }
+    }
+}
+
+/*
+ * MPI_T performance variables
+ */
+
+/* The tuned module running a collective on a communicator, if any */
+static mca_coll_tuned_module_t *online_module(struct ompi_communicator_t *comm, int coll)
+{
+    mca_coll_base_comm_coll_t *c_coll = comm->c_coll;
+
+    if (NULL == c_coll) {
+        return NULL;
+    }
+    switch (coll) {
+    case ALLGATHER:
+        if (ompi_coll_tuned_allgather_intra_dec_dynamic == c_coll->coll_allgather) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_allgather_module;
+        }
+        break;
+    case ALLREDUCE:
+        if (ompi_coll_tuned_allreduce_intra_dec_dynamic == c_coll->coll_allreduce) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_allreduce_module;
+        }
+        break;
+    case ALLTOALL:
+        if (ompi_coll_tuned_alltoall_intra_dec_dynamic == c_coll->coll_alltoall) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_alltoall_module;
+        }
+        break;
+    case BARRIER:
+        if (ompi_coll_tuned_barrier_intra_dec_dynamic == c_coll->coll_barrier) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_barrier_module;
+        }
+        break;
+    case BCAST:
+        if (ompi_coll_tuned_bcast_intra_dec_dynamic == c_coll->coll_bcast) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_bcast_module;
+        }
+        break;
+    case REDUCE:
+        if (ompi_coll_tuned_reduce_intra_dec_dynamic == c_coll->coll_reduce) {
+            return (mca_coll_tuned_module_t *) c_coll->coll_reduce_module;
+        }
+        break;
+    }
+    return NULL;
+}
+
+static int online_decisions_get(const mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    mca_coll_tuned_module_t *tuned_module = online_module((struct ompi_communicator_t *) obj_handle,
+                                                          (int) (intptr_t) pvar->ctx);
+    coll_tuned_online_t *online = NULL;
+    int *decisions = (int *) value;
+
+    if (NULL != tuned_module) {
+        online = tuned_module->online[(int) (intptr_t) pvar->ctx];
+    }
+    for (int b = 0; b < COLL_TUNED_ONLINE_BUCKETS; b++) {
+        decisions[b] = NULL != online ? online->buckets[b].algorithm : -1;
+    }
+    return OMPI_SUCCESS;
+}
+
+static int online_decisions_notify(mca_base_pvar_t *pvar, mca_base_pvar_event_t event,
+                                   void *obj_handle, int *count)
+{
+    if (MCA_BASE_PVAR_HANDLE_BIND == event) {
+        *count = COLL_TUNED_ONLINE_BUCKETS;
+    }
+    return OMPI_SUCCESS;
+}
+
+int ompi_coll_tuned_online_register(void)
+{
+    char name[64], desc[512];
+
+    ompi_coll_tuned_online_trials = 0;
+    (void) mca_base_component_var_register(&mca_coll_tuned_component.super.collm_version,
+                                           "online_trials",
+                                           "Number of calls each candidate algorithm is timed for on each communicator and message size (power of 2) before the fastest one is locked in for the allgather, allreduce, alltoall, barrier, bcast and reduce collectives. Only used with dynamic rules, after the rule file and the forced algorithms. 0 disables the online selection",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &ompi_coll_tuned_online_trials);
+
+    for (int i = 0; i < ONLINE_NCOLLS; i++) {
+        const char *coll_name = online_collectives[i].name;
+
+        snprintf(name, sizeof(name), "%s_online_decisions", coll_name);
+        snprintf(desc, sizeof(desc), "Algorithm selected online for %s on the communicator "
+                 "for each message size: entry i covers messages from 2^i bytes (0 for entry 0) "
+                 "to 2^(i+1) bytes excluded, -1 while the selection is pending", coll_name);
+        (void) mca_base_component_pvar_register(&mca_coll_tuned_component.super.collm_version,
+                                                name, desc, OPAL_INFO_LVL_6,
+                                                MCA_BASE_PVAR_CLASS_GENERIC,
+                                                MCA_BASE_VAR_TYPE_INT, NULL,
+                                                MCA_BASE_VAR_BIND_MPI_COMM,
+                                                MCA_BASE_PVAR_FLAG_READONLY |
+                                                MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                                online_decisions_get, NULL,
+                                                online_decisions_notify,
+                                                (void *) (intptr_t) online_collectives[i].coll);
+    }
+    return OMPI_SUCCESS;
+}
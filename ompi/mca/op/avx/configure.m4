@@ -132,6 +132,35 @@ AC_DEFUN([MCA_ompi_op_avx_CONFIG],[
                   CFLAGS="$op_avx_cflags_save"
                  ])
            #
+           # The short float kernels convert from and to half precision, which is not part of
+           # AVX2 but of F16C. Add -mf16c to the AVX2 flags if the compiler needs it.
+           #
+           AS_IF([test $op_avx2_support -eq 1],
+                 [AC_MSG_CHECKING([for F16C support (with the AVX2 flags)])
+                  op_avx_cflags_save="$CFLAGS"
+                  CFLAGS="$CFLAGS $MCA_BUILD_OP_AVX2_FLAGS"
+                  AC_LINK_IFELSE(
+                      [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                               [[
+    __m256 vA = _mm256_cvtph_ps(_mm_setzero_si128());
+    __m128i vB = _mm256_cvtps_ph(vA, 0)
+                               ]])],
+                      [AC_MSG_RESULT([yes])],
+                      [AC_MSG_RESULT([no])
+                       AC_MSG_CHECKING([for F16C support (with -mf16c)])
+                       CFLAGS="$CFLAGS -mf16c"
+                       AC_LINK_IFELSE(
+                           [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                    [[
+    __m256 vA = _mm256_cvtph_ps(_mm_setzero_si128());
+    __m128i vB = _mm256_cvtps_ph(vA, 0)
+                                    ]])],
+                           [MCA_BUILD_OP_AVX2_FLAGS="$MCA_BUILD_OP_AVX2_FLAGS -mf16c"
+                            AC_MSG_RESULT([yes])],
+                           [AC_MSG_RESULT([no])])])
+                  CFLAGS="$op_avx_cflags_save"
+                 ])
+           #
            # What about early AVX support. The rest of the logic is slightly different as
            # we need to include some of the SSE4.1 and SSE3 instructions. So, we first check
            # if we can compile AVX code without a flag, then we validate that we have support
@@ -16,6 +16,7 @@
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
+#include <limits.h>
 #include "opal/util/output.h"
 
 #include "ompi/op/op.h"
@@ -35,6 +36,34 @@
 #error This file should not be compiled in this conditions
 #endif
 
+/*
+ * The short float kernels need the half precision conversions, that is
+ * AVX512F or F16C. They are only generated when the short float of the
+ * shortfloat extension is an IEEE half precision.
+ */
+#if defined(HAVE_SHORT_FLOAT)
+typedef short float ompi_op_avx_short_float_t;
+#define OMPI_OP_AVX_SHORT_FLOAT_TYPE 1
+#elif defined(HAVE_OPAL_SHORT_FLOAT_T) && (2 == SIZEOF_OPAL_SHORT_FLOAT_T)
+typedef opal_short_float_t ompi_op_avx_short_float_t;
+#define OMPI_OP_AVX_SHORT_FLOAT_TYPE 1
+#else
+#define OMPI_OP_AVX_SHORT_FLOAT_TYPE 0
+#endif
+
+#if OMPI_OP_AVX_SHORT_FLOAT_TYPE && \
+    (defined(GENERATE_AVX512_CODE) || (defined(GENERATE_AVX2_CODE) && defined(__F16C__)))
+#define OMPI_OP_AVX_HAVE_SHORT_FLOAT 1
+#else
+#define OMPI_OP_AVX_HAVE_SHORT_FLOAT 0
+#endif
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT && \
+    (defined(HAVE_SHORT_FLOAT__COMPLEX) || defined(HAVE_OPAL_SHORT_FLOAT_COMPLEX_T))
+#define OMPI_OP_AVX_HAVE_SHORT_FLOAT_COMPLEX 1
+#else
+#define OMPI_OP_AVX_HAVE_SHORT_FLOAT_COMPLEX 0
+#endif
+
 /*
  * Concatenate preprocessor tokens A and B without expanding macro definitions
  * (however, if invoked from a macro, macro arguments are expanded).
@@ -446,6 +475,262 @@ static void OP_CONCAT(ompi_op_avx_2buff_##op##_double,PREPEND)(const void *_in,
 }
 
 
+/*
+ * Short float (IEEE half precision) is only a storage format for the vector
+ * units: the values are widened to single precision, combined, and rounded
+ * back to half precision. For a single add, mul, max or min this gives the
+ * same result as the scalar half precision code.
+ */
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC(op)                              \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float);                     \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in)); \
+            __m512 vecB = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)out)); \
+            in += types_per_step;                                       \
+            __m512 res = _mm512_##op##_ps(vecA, vecB);                  \
+            _mm256_storeu_si256((__m256i*)out,                          \
+                                _mm512_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX2_CODE) && defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__)
+#define OP_AVX_F16C_SHORT_FLOAT_FUNC(op)                                \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG | OMPI_OP_AVX_HAS_F16C_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(float);                     \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in)); \
+            __m256 vecB = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)out)); \
+            in += types_per_step;                                       \
+            __m256 res = _mm256_##op##_ps(vecA, vecB);                  \
+            _mm_storeu_si128((__m128i*)out,                             \
+                             _mm256_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_F16C_SHORT_FLOAT_FUNC(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__) */
+
+#define OP_AVX_SHORT_FLOAT_FUNC(op)                                     \
+static void OP_CONCAT(ompi_op_avx_2buff_##op##_short_float,PREPEND)(const void *_in, void *_out, int *count, \
+                                                                    struct ompi_datatype_t **dtype, \
+                                                                    struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_short_float_t *in = (ompi_op_avx_short_float_t*)_in,    \
+                              *out = (ompi_op_avx_short_float_t*)_out;  \
+    OP_AVX_AVX512_SHORT_FLOAT_FUNC(op);                                 \
+    OP_AVX_F16C_SHORT_FLOAT_FUNC(op);                                   \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > 8) ? 8 : left_over;                 \
+        switch(how_much) {                                              \
+        case 8: out[7] = current_func(out[7], in[7]);                   \
+        case 7: out[6] = current_func(out[6], in[6]);                   \
+        case 6: out[5] = current_func(out[5], in[5]);                   \
+        case 5: out[4] = current_func(out[4], in[4]);                   \
+        case 4: out[3] = current_func(out[3], in[3]);                   \
+        case 3: out[2] = current_func(out[2], in[2]);                   \
+        case 2: out[1] = current_func(out[1], in[1]);                   \
+        case 1: out[0] = current_func(out[0], in[0]);                   \
+        }                                                               \
+        left_over -= how_much;                                          \
+        out += how_much;                                                \
+        in += how_much;                                                 \
+    }                                                                   \
+}
+#else
+#define OP_AVX_SHORT_FLOAT_FUNC(op)
+#endif  /* OMPI_OP_AVX_HAVE_SHORT_FLOAT */
+
+/*
+ * The sum of complex numbers is the sum of their real and imaginary parts,
+ * so it is delegated to the kernel of the underlying real type. The count
+ * is split to keep the number of reals within an int.
+ */
+#define OP_AVX_COMPLEX_SUM_FUNC(name, rname, rtype)                     \
+static void OP_CONCAT(ompi_op_avx_2buff_add_##name,PREPEND)(const void *_in, void *_out, int *count, \
+                                                            struct ompi_datatype_t **dtype, \
+                                                            struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int left_over = *count;                                             \
+    rtype *in = (rtype*)_in, *out = (rtype*)_out;                       \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > (INT_MAX / 2)) ? (INT_MAX / 2) : left_over; \
+        int reals = 2 * how_much;                                       \
+        OP_CONCAT(ompi_op_avx_2buff_add_##rname,PREPEND)(in, out, &reals, dtype, module); \
+        left_over -= how_much;                                          \
+        out += reals;                                                   \
+        in += reals;                                                    \
+    }                                                                   \
+}
+
+/*
+ * Complex product (out * in), computed on interleaved (re, im) pairs as
+ *   (out.re * in.re, out.im * in.re) -/+ (out.im * in.im, out.re * in.im)
+ * which is the textbook formula used by the compiler for finite values. A
+ * NaN in the result means that C99 Annex G may have to recover an infinity,
+ * in which case the whole step is redone one complex at a time.
+ *
+ * The leftovers go through the same instructions on a single complex, as
+ * the compiler is free to contract its own expansion of the product into
+ * fused multiply-adds, which round differently than the vector loops.
+ */
+static inline float _Complex ompi_op_avx_mul_c_float_complex(float _Complex a, float _Complex b)
+{
+    float _Complex r;
+    __m128 vecA = _mm_castpd_ps(_mm_load_sd((double*)&b));
+    __m128 vecB = _mm_castpd_ps(_mm_load_sd((double*)&a));
+    __m128 res = _mm_addsub_ps(_mm_mul_ps(vecB, _mm_moveldup_ps(vecA)),
+                               _mm_mul_ps(_mm_shuffle_ps(vecB, vecB, 0xB1), _mm_movehdup_ps(vecA)));
+    if( 0 != (0x3 & _mm_movemask_ps(_mm_cmpunord_ps(res, res))) ) {
+        return a * b;
+    }
+    _mm_store_sd((double*)&r, _mm_castps_pd(res));
+    return r;
+}
+
+static inline double _Complex ompi_op_avx_mul_c_double_complex(double _Complex a, double _Complex b)
+{
+    double _Complex r;
+    __m128d vecA = _mm_loadu_pd((double*)&b);
+    __m128d vecB = _mm_loadu_pd((double*)&a);
+    __m128d res = _mm_addsub_pd(_mm_mul_pd(vecB, _mm_movedup_pd(vecA)),
+                                _mm_mul_pd(_mm_shuffle_pd(vecB, vecB, 0x1), _mm_unpackhi_pd(vecA, vecA)));
+    if( 0 != _mm_movemask_pd(_mm_cmpunord_pd(res, res)) ) {
+        return a * b;
+    }
+    _mm_storeu_pd((double*)&r, res);
+    return r;
+}
+
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#define OP_AVX_AVX512_FLOAT_COMPLEX_MUL_FUNC()                          \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float _Complex);            \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_loadu_ps((float*)in);                  \
+            __m512 vecB = _mm512_loadu_ps((float*)out);                 \
+            __m512 re = _mm512_mul_ps(vecB, _mm512_moveldup_ps(vecA));  \
+            __m512 im = _mm512_mul_ps(_mm512_permute_ps(vecB, 0xB1), _mm512_movehdup_ps(vecA)); \
+            __m512 res = _mm512_mask_sub_ps(_mm512_add_ps(re, im), 0x5555, re, im); \
+            if( 0 == _mm512_cmp_ps_mask(res, res, _CMP_UNORD_Q) ) {     \
+                _mm512_storeu_ps((float*)out, res);                     \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_float_complex(out[k], in[k]); \
+            }                                                           \
+            in += types_per_step;                                       \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#define OP_AVX_AVX512_DOUBLE_COMPLEX_MUL_FUNC()                         \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(double _Complex);           \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512d vecA = _mm512_loadu_pd((double*)in);                \
+            __m512d vecB = _mm512_loadu_pd((double*)out);               \
+            __m512d re = _mm512_mul_pd(vecB, _mm512_movedup_pd(vecA)); \
+            __m512d im = _mm512_mul_pd(_mm512_permute_pd(vecB, 0x55), _mm512_permute_pd(vecA, 0xFF)); \
+            __m512d res = _mm512_mask_sub_pd(_mm512_add_pd(re, im), 0x55, re, im); \
+            if( 0 == _mm512_cmp_pd_mask(res, res, _CMP_UNORD_Q) ) {     \
+                _mm512_storeu_pd((double*)out, res);                    \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_double_complex(out[k], in[k]); \
+            }                                                           \
+            in += types_per_step;                                       \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX512_FLOAT_COMPLEX_MUL_FUNC() {}
+#define OP_AVX_AVX512_DOUBLE_COMPLEX_MUL_FUNC() {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX_CODE) && defined(OMPI_MCA_OP_HAVE_AVX) && (1 == OMPI_MCA_OP_HAVE_AVX)
+#define OP_AVX_AVX_FLOAT_COMPLEX_MUL_FUNC()                             \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG) ) {             \
+        types_per_step = (256 / 8) / sizeof(float _Complex);            \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_loadu_ps((float*)in);                  \
+            __m256 vecB = _mm256_loadu_ps((float*)out);                 \
+            __m256 res = _mm256_addsub_ps(_mm256_mul_ps(vecB, _mm256_moveldup_ps(vecA)), \
+                                          _mm256_mul_ps(_mm256_permute_ps(vecB, 0xB1), \
+                                                        _mm256_movehdup_ps(vecA))); \
+            if( 0 == _mm256_movemask_ps(_mm256_cmp_ps(res, res, _CMP_UNORD_Q)) ) { \
+                _mm256_storeu_ps((float*)out, res);                     \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_float_complex(out[k], in[k]); \
+            }                                                           \
+            in += types_per_step;                                       \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#define OP_AVX_AVX_DOUBLE_COMPLEX_MUL_FUNC()                            \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG) ) {             \
+        types_per_step = (256 / 8) / sizeof(double _Complex);           \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256d vecA = _mm256_loadu_pd((double*)in);                \
+            __m256d vecB = _mm256_loadu_pd((double*)out);               \
+            __m256d res = _mm256_addsub_pd(_mm256_mul_pd(vecB, _mm256_movedup_pd(vecA)), \
+                                           _mm256_mul_pd(_mm256_permute_pd(vecB, 0x5), \
+                                                         _mm256_permute_pd(vecA, 0xF))); \
+            if( 0 == _mm256_movemask_pd(_mm256_cmp_pd(res, res, _CMP_UNORD_Q)) ) { \
+                _mm256_storeu_pd((double*)out, res);                    \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_double_complex(out[k], in[k]); \
+            }                                                           \
+            in += types_per_step;                                       \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX_FLOAT_COMPLEX_MUL_FUNC() {}
+#define OP_AVX_AVX_DOUBLE_COMPLEX_MUL_FUNC() {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX) && (1 == OMPI_MCA_OP_HAVE_AVX) */
+
+#define OP_AVX_COMPLEX_MUL_FUNC(name, type, TYPE)                       \
+static void OP_CONCAT(ompi_op_avx_2buff_mul_##name,PREPEND)(const void *_in, void *_out, int *count, \
+                                                            struct ompi_datatype_t **dtype, \
+                                                            struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    type *in = (type*)_in, *out = (type*)_out;                          \
+    OP_AVX_AVX512_##TYPE##_COMPLEX_MUL_FUNC();                          \
+    OP_AVX_AVX_##TYPE##_COMPLEX_MUL_FUNC();                             \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > 8) ? 8 : left_over;                 \
+        switch(how_much) {                                              \
+        case 8: out[7] = ompi_op_avx_mul_##name(out[7], in[7]);         \
+        case 7: out[6] = ompi_op_avx_mul_##name(out[6], in[6]);         \
+        case 6: out[5] = ompi_op_avx_mul_##name(out[5], in[5]);         \
+        case 5: out[4] = ompi_op_avx_mul_##name(out[4], in[4]);         \
+        case 4: out[3] = ompi_op_avx_mul_##name(out[3], in[3]);         \
+        case 3: out[2] = ompi_op_avx_mul_##name(out[2], in[2]);         \
+        case 2: out[1] = ompi_op_avx_mul_##name(out[1], in[1]);         \
+        case 1: out[0] = ompi_op_avx_mul_##name(out[0], in[0]);         \
+        }                                                               \
+        left_over -= how_much;                                          \
+        out += how_much;                                                \
+        in += how_much;                                                 \
+    }                                                                   \
+}
+
 /*************************************************************************
  * Max
  *************************************************************************/
@@ -465,6 +750,7 @@ static void OP_CONCAT(ompi_op_avx_2buff_##op##_double,PREPEND)(const void *_in,
     /* Floating point */
     OP_AVX_FLOAT_FUNC(max)
     OP_AVX_DOUBLE_FUNC(max)
+    OP_AVX_SHORT_FLOAT_FUNC(max)
 
 /*************************************************************************
  * Min
@@ -485,6 +771,7 @@ static void OP_CONCAT(ompi_op_avx_2buff_##op##_double,PREPEND)(const void *_in,
     /* Floating point */
     OP_AVX_FLOAT_FUNC(min)
     OP_AVX_DOUBLE_FUNC(min)
+    OP_AVX_SHORT_FLOAT_FUNC(min)
 
 /*************************************************************************
  * Sum
@@ -503,6 +790,14 @@ static void OP_CONCAT(ompi_op_avx_2buff_##op##_double,PREPEND)(const void *_in,
     /* Floating point */
     OP_AVX_FLOAT_FUNC(add)
     OP_AVX_DOUBLE_FUNC(add)
+    OP_AVX_SHORT_FLOAT_FUNC(add)
+
+    /* Complex */
+    OP_AVX_COMPLEX_SUM_FUNC(c_float_complex, float, float)
+    OP_AVX_COMPLEX_SUM_FUNC(c_double_complex, double, double)
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT_COMPLEX
+    OP_AVX_COMPLEX_SUM_FUNC(c_short_float_complex, short_float, ompi_op_avx_short_float_t)
+#endif
 
 /*************************************************************************
  * Product
@@ -523,6 +818,11 @@ static void OP_CONCAT(ompi_op_avx_2buff_##op##_double,PREPEND)(const void *_in,
     /* Floating point */
     OP_AVX_FLOAT_FUNC(mul)
     OP_AVX_DOUBLE_FUNC(mul)
+    OP_AVX_SHORT_FLOAT_FUNC(mul)
+
+    /* Complex */
+    OP_AVX_COMPLEX_MUL_FUNC(c_float_complex, float _Complex, FLOAT)
+    OP_AVX_COMPLEX_MUL_FUNC(c_double_complex, double _Complex, DOUBLE)
 
 /*************************************************************************
  * Bitwise AND
@@ -980,6 +1280,225 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     }                                                                   \
 }
 
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op)                            \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float);                     \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in1)); \
+            __m512 vecB = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in2)); \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            __m512 res = _mm512_##op##_ps(vecA, vecB);                  \
+            _mm256_storeu_si256((__m256i*)out,                          \
+                                _mm512_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX2_CODE) && defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__)
+#define OP_AVX_F16C_SHORT_FLOAT_FUNC_3(op)                              \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG | OMPI_OP_AVX_HAS_F16C_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(float);                     \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in1)); \
+            __m256 vecB = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in2)); \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            __m256 res = _mm256_##op##_ps(vecA, vecB);                  \
+            _mm_storeu_si128((__m128i*)out,                             \
+                             _mm256_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_F16C_SHORT_FLOAT_FUNC_3(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__) */
+
+#define OP_AVX_SHORT_FLOAT_FUNC_3(op)                                   \
+static void OP_CONCAT(ompi_op_avx_3buff_##op##_short_float,PREPEND)(const void *_in1, const void *_in2, \
+                                                                    void *_out, int *count, \
+                                                                    struct ompi_datatype_t **dtype, \
+                                                                    struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_short_float_t *in1 = (ompi_op_avx_short_float_t*)_in1,  \
+                              *in2 = (ompi_op_avx_short_float_t*)_in2,  \
+                              *out = (ompi_op_avx_short_float_t*)_out;  \
+    OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op);                               \
+    OP_AVX_F16C_SHORT_FLOAT_FUNC_3(op);                                 \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > 8) ? 8 : left_over;                 \
+        switch(how_much) {                                              \
+        case 8: out[7] = current_func(in1[7], in2[7]);                  \
+        case 7: out[6] = current_func(in1[6], in2[6]);                  \
+        case 6: out[5] = current_func(in1[5], in2[5]);                  \
+        case 5: out[4] = current_func(in1[4], in2[4]);                  \
+        case 4: out[3] = current_func(in1[3], in2[3]);                  \
+        case 3: out[2] = current_func(in1[2], in2[2]);                  \
+        case 2: out[1] = current_func(in1[1], in2[1]);                  \
+        case 1: out[0] = current_func(in1[0], in2[0]);                  \
+        }                                                               \
+        left_over -= how_much;                                          \
+        out += how_much;                                                \
+        in1 += how_much;                                                \
+        in2 += how_much;                                                \
+    }                                                                   \
+}
+#else
+#define OP_AVX_SHORT_FLOAT_FUNC_3(op)
+#endif  /* OMPI_OP_AVX_HAVE_SHORT_FLOAT */
+
+#define OP_AVX_COMPLEX_SUM_FUNC_3(name, rname, rtype)                   \
+static void OP_CONCAT(ompi_op_avx_3buff_add_##name,PREPEND)(const void *_in1, const void *_in2, \
+                                                            void *_out, int *count, \
+                                                            struct ompi_datatype_t **dtype, \
+                                                            struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int left_over = *count;                                             \
+    rtype *in1 = (rtype*)_in1, *in2 = (rtype*)_in2, *out = (rtype*)_out; \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > (INT_MAX / 2)) ? (INT_MAX / 2) : left_over; \
+        int reals = 2 * how_much;                                       \
+        OP_CONCAT(ompi_op_avx_3buff_add_##rname,PREPEND)(in1, in2, out, &reals, dtype, module); \
+        left_over -= how_much;                                          \
+        out += reals;                                                   \
+        in1 += reals;                                                   \
+        in2 += reals;                                                   \
+    }                                                                   \
+}
+
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#define OP_AVX_AVX512_FLOAT_COMPLEX_MUL_FUNC_3()                        \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float _Complex);            \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_loadu_ps((float*)in2);                 \
+            __m512 vecB = _mm512_loadu_ps((float*)in1);                 \
+            __m512 re = _mm512_mul_ps(vecB, _mm512_moveldup_ps(vecA));  \
+            __m512 im = _mm512_mul_ps(_mm512_permute_ps(vecB, 0xB1), _mm512_movehdup_ps(vecA)); \
+            __m512 res = _mm512_mask_sub_ps(_mm512_add_ps(re, im), 0x5555, re, im); \
+            if( 0 == _mm512_cmp_ps_mask(res, res, _CMP_UNORD_Q) ) {     \
+                _mm512_storeu_ps((float*)out, res);                     \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_float_complex(in1[k], in2[k]); \
+            }                                                           \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#define OP_AVX_AVX512_DOUBLE_COMPLEX_MUL_FUNC_3()                       \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(double _Complex);           \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512d vecA = _mm512_loadu_pd((double*)in2);               \
+            __m512d vecB = _mm512_loadu_pd((double*)in1);               \
+            __m512d re = _mm512_mul_pd(vecB, _mm512_movedup_pd(vecA)); \
+            __m512d im = _mm512_mul_pd(_mm512_permute_pd(vecB, 0x55), _mm512_permute_pd(vecA, 0xFF)); \
+            __m512d res = _mm512_mask_sub_pd(_mm512_add_pd(re, im), 0x55, re, im); \
+            if( 0 == _mm512_cmp_pd_mask(res, res, _CMP_UNORD_Q) ) {     \
+                _mm512_storeu_pd((double*)out, res);                    \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_double_complex(in1[k], in2[k]); \
+            }                                                           \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX512_FLOAT_COMPLEX_MUL_FUNC_3() {}
+#define OP_AVX_AVX512_DOUBLE_COMPLEX_MUL_FUNC_3() {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX_CODE) && defined(OMPI_MCA_OP_HAVE_AVX) && (1 == OMPI_MCA_OP_HAVE_AVX)
+#define OP_AVX_AVX_FLOAT_COMPLEX_MUL_FUNC_3()                           \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG) ) {             \
+        types_per_step = (256 / 8) / sizeof(float _Complex);            \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_loadu_ps((float*)in2);                 \
+            __m256 vecB = _mm256_loadu_ps((float*)in1);                 \
+            __m256 res = _mm256_addsub_ps(_mm256_mul_ps(vecB, _mm256_moveldup_ps(vecA)), \
+                                          _mm256_mul_ps(_mm256_permute_ps(vecB, 0xB1), \
+                                                        _mm256_movehdup_ps(vecA))); \
+            if( 0 == _mm256_movemask_ps(_mm256_cmp_ps(res, res, _CMP_UNORD_Q)) ) { \
+                _mm256_storeu_ps((float*)out, res);                     \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_float_complex(in1[k], in2[k]); \
+            }                                                           \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#define OP_AVX_AVX_DOUBLE_COMPLEX_MUL_FUNC_3()                          \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX_FLAG) ) {             \
+        types_per_step = (256 / 8) / sizeof(double _Complex);           \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256d vecA = _mm256_loadu_pd((double*)in2);               \
+            __m256d vecB = _mm256_loadu_pd((double*)in1);               \
+            __m256d res = _mm256_addsub_pd(_mm256_mul_pd(vecB, _mm256_movedup_pd(vecA)), \
+                                           _mm256_mul_pd(_mm256_permute_pd(vecB, 0x5), \
+                                                         _mm256_permute_pd(vecA, 0xF))); \
+            if( 0 == _mm256_movemask_pd(_mm256_cmp_pd(res, res, _CMP_UNORD_Q)) ) { \
+                _mm256_storeu_pd((double*)out, res);                    \
+            } else {                                                    \
+                for( int k = 0; k < types_per_step; k++ )               \
+                    out[k] = ompi_op_avx_mul_c_double_complex(in1[k], in2[k]); \
+            }                                                           \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX_FLOAT_COMPLEX_MUL_FUNC_3() {}
+#define OP_AVX_AVX_DOUBLE_COMPLEX_MUL_FUNC_3() {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX) && (1 == OMPI_MCA_OP_HAVE_AVX) */
+
+#define OP_AVX_COMPLEX_MUL_FUNC_3(name, type, TYPE)                     \
+static void OP_CONCAT(ompi_op_avx_3buff_mul_##name,PREPEND)(const void *_in1, const void *_in2, \
+                                                            void *_out, int *count, \
+                                                            struct ompi_datatype_t **dtype, \
+                                                            struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    type *in1 = (type*)_in1, *in2 = (type*)_in2, *out = (type*)_out;    \
+    OP_AVX_AVX512_##TYPE##_COMPLEX_MUL_FUNC_3();                        \
+    OP_AVX_AVX_##TYPE##_COMPLEX_MUL_FUNC_3();                           \
+    while( left_over > 0 ) {                                            \
+        int how_much = (left_over > 8) ? 8 : left_over;                 \
+        switch(how_much) {                                              \
+        case 8: out[7] = ompi_op_avx_mul_##name(in1[7], in2[7]);        \
+        case 7: out[6] = ompi_op_avx_mul_##name(in1[6], in2[6]);        \
+        case 6: out[5] = ompi_op_avx_mul_##name(in1[5], in2[5]);        \
+        case 5: out[4] = ompi_op_avx_mul_##name(in1[4], in2[4]);        \
+        case 4: out[3] = ompi_op_avx_mul_##name(in1[3], in2[3]);        \
+        case 3: out[2] = ompi_op_avx_mul_##name(in1[2], in2[2]);        \
+        case 2: out[1] = ompi_op_avx_mul_##name(in1[1], in2[1]);        \
+        case 1: out[0] = ompi_op_avx_mul_##name(in1[0], in2[0]);        \
+        }                                                               \
+        left_over -= how_much;                                          \
+        out += how_much;                                                \
+        in1 += how_much;                                                \
+        in2 += how_much;                                                \
+    }                                                                   \
+}
+
 /*************************************************************************
  * Max
  *************************************************************************/
@@ -1000,6 +1519,7 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     /* Floating point */
     OP_AVX_FLOAT_FUNC_3(max)
     OP_AVX_DOUBLE_FUNC_3(max)
+    OP_AVX_SHORT_FLOAT_FUNC_3(max)
 
 /*************************************************************************
  * Min
@@ -1020,6 +1540,7 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     /* Floating point */
     OP_AVX_FLOAT_FUNC_3(min)
     OP_AVX_DOUBLE_FUNC_3(min)
+    OP_AVX_SHORT_FLOAT_FUNC_3(min)
 
 /*************************************************************************
  * Sum
@@ -1039,6 +1560,14 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     /* Floating point */
     OP_AVX_FLOAT_FUNC_3(add)
     OP_AVX_DOUBLE_FUNC_3(add)
+    OP_AVX_SHORT_FLOAT_FUNC_3(add)
+
+    /* Complex */
+    OP_AVX_COMPLEX_SUM_FUNC_3(c_float_complex, float, float)
+    OP_AVX_COMPLEX_SUM_FUNC_3(c_double_complex, double, double)
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT_COMPLEX
+    OP_AVX_COMPLEX_SUM_FUNC_3(c_short_float_complex, short_float, ompi_op_avx_short_float_t)
+#endif
 
 /*************************************************************************
  * Product
@@ -1059,6 +1588,11 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     /* Floating point */
     OP_AVX_FLOAT_FUNC_3(mul)
     OP_AVX_DOUBLE_FUNC_3(mul)
+    OP_AVX_SHORT_FLOAT_FUNC_3(mul)
+
+    /* Complex */
+    OP_AVX_COMPLEX_MUL_FUNC_3(c_float_complex, float _Complex, FLOAT)
+    OP_AVX_COMPLEX_MUL_FUNC_3(c_double_complex, double _Complex, DOUBLE)
 
 /*************************************************************************
  * Bitwise AND
@@ -1139,11 +1673,28 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
 #define FLOAT(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_float,PREPEND)
 #define DOUBLE(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_double,PREPEND)
 
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT
+#define SHORT_FLOAT(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_short_float,PREPEND)
+#else
+#define SHORT_FLOAT(name, ftype) NULL
+#endif
+
 #define FLOATING_POINT(name, ftype)                                         \
-    [OMPI_OP_BASE_TYPE_SHORT_FLOAT] = NULL,                                 \
+    [OMPI_OP_BASE_TYPE_SHORT_FLOAT] = SHORT_FLOAT(name, ftype),             \
     [OMPI_OP_BASE_TYPE_FLOAT] = FLOAT(name, ftype),                         \
     [OMPI_OP_BASE_TYPE_DOUBLE] = DOUBLE(name, ftype)
 
+/** Complex, only for sum and product ***********************************/
+#if OMPI_OP_AVX_HAVE_SHORT_FLOAT_COMPLEX
+#define SHORT_FLOAT_COMPLEX(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_c_short_float_complex,PREPEND)
+#else
+#define SHORT_FLOAT_COMPLEX(name, ftype) NULL
+#endif
+
+#define COMPLEX(name, ftype)                                                \
+    [OMPI_OP_BASE_TYPE_C_FLOAT_COMPLEX] = OP_CONCAT(ompi_op_avx_##ftype##_##name##_c_float_complex,PREPEND), \
+    [OMPI_OP_BASE_TYPE_C_DOUBLE_COMPLEX] = OP_CONCAT(ompi_op_avx_##ftype##_##name##_c_double_complex,PREPEND)
+
 /*
  * MPI_OP_NULL
  * All types
@@ -1175,11 +1726,14 @@ ompi_op_base_handler_fn_t OP_CONCAT(ompi_op_avx_functions, PREPEND)[OMPI_OP_BASE
     [OMPI_OP_BASE_FORTRAN_SUM] = {
         C_INTEGER(sum, 2buff),
         FLOATING_POINT(add, 2buff),
+        COMPLEX(add, 2buff),
+        [OMPI_OP_BASE_TYPE_C_SHORT_FLOAT_COMPLEX] = SHORT_FLOAT_COMPLEX(add, 2buff),
     },
     /* Corresponds to MPI_PROD */
     [OMPI_OP_BASE_FORTRAN_PROD] = {
         C_INTEGER_OPTIONAL(prod, 2buff),
         FLOATING_POINT(mul, 2buff),
+        COMPLEX(mul, 2buff),
     },
     /* Corresponds to MPI_LAND */
     [OMPI_OP_BASE_FORTRAN_LAND] = {
@@ -1238,11 +1792,14 @@ ompi_op_base_3buff_handler_fn_t OP_CONCAT(ompi_op_avx_3buff_functions, PREPEND)[
     [OMPI_OP_BASE_FORTRAN_SUM] = {
         C_INTEGER(sum, 3buff),
         FLOATING_POINT(add, 3buff),
+        COMPLEX(add, 3buff),
+        [OMPI_OP_BASE_TYPE_C_SHORT_FLOAT_COMPLEX] = SHORT_FLOAT_COMPLEX(add, 3buff),
     },
     /* Corresponds to MPI_PROD */
     [OMPI_OP_BASE_FORTRAN_PROD] = {
         C_INTEGER_OPTIONAL(prod, 3buff),
         FLOATING_POINT(mul, 3buff),
+        COMPLEX(mul, 3buff),
     },
     /* Corresponds to MPI_LAND */
     [OMPI_OP_BASE_FORTRAN_LAND] ={
@@ -93,6 +93,18 @@ int ompi_op_base_op_select(struct ompi_op_t *op);
  */
 OMPI_DECLSPEC int ompi_op_base_op_unselect(struct ompi_op_t *op);
 
+/**
+ * Register the MCA parameters of the large reduction engine
+ * (op_base_reduce_*).  Called from the framework register function.
+ */
+int ompi_op_base_reduce_register(void);
+
+/**
+ * Stop and join the reduction helper threads, if any were started.
+ * Called when the op framework is closed.
+ */
+void ompi_op_base_reduce_finalize(void);
+
 OMPI_DECLSPEC extern mca_base_framework_t ompi_op_base_framework;
 
 END_C_DECLS
@@ -59,5 +59,19 @@ OBJ_CLASS_INSTANCE(ompi_op_base_module_t, opal_object_t,
 OBJ_CLASS_INSTANCE(ompi_op_base_module_1_0_0_t, opal_object_t,
                    module_constructor_1_0_0, NULL);
 
-MCA_BASE_FRAMEWORK_DECLARE(ompi, op, NULL, NULL, NULL, NULL,
-                           mca_op_base_static_components, 0);
+static int ompi_op_base_register(mca_base_register_flag_t flags)
+{
+    return ompi_op_base_reduce_register();
+}
+
+static int ompi_op_base_close(void)
+{
+    /* Stop the reduction helper threads before the modules whose
+     * functions they call go away */
+    ompi_op_base_reduce_finalize();
+
+    return mca_base_framework_components_close(&ompi_op_base_framework, NULL);
+}
+
+MCA_BASE_FRAMEWORK_DECLARE(ompi, op, NULL, ompi_op_base_register, NULL,
+                           ompi_op_base_close, mca_op_base_static_components, 0);
@@ -0,0 +1,329 @@
+/* -*- Mode: C; c-basic-offset:4 ; -*- */
+/*
+ * Copyright (c) 2004-2005 The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2004-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Large-buffer reduction engine.
+ *
+ * ompi_op_reduce() and ompi_3buff_op_reduce() hand a whole buffer to a
+ * single back-end handler.  For buffers of hundreds of MB this streams
+ * every operand through the caches once per reduction and leaves all
+ * but one core idle.  When enabled (op_base_reduce_threshold != 0) the
+ * intrinsic reductions larger than the threshold are routed here,
+ * split into op_base_reduce_chunk_size byte chunks and distributed
+ * over the calling thread and up to op_base_reduce_threads helper
+ * threads.  The same engine also implements ompi_op_reduce_copy(),
+ * which writes the result of each chunk to a second buffer while it
+ * is still cache resident, so a reduce followed by a copy of the
+ * result only walks the operands once.
+ *
+ * Only intrinsic operations on predefined datatypes are handled;
+ * everything else keeps using the single call path in op.h.  Chunks
+ * are laid out with the extent of the datatype, which differs from its
+ * size for the pair types of MINLOC and MAXLOC (MPI_DOUBLE_INT has size
+ * 12 and extent 16).
+ */
+
+#include "ompi_config.h"
+
+#include "opal/class/opal_object.h"
+#include "opal/mca/threads/mutex.h"
+#include "opal/mca/threads/threads.h"
+#include "opal/sys/atomic.h"
+#include "opal/util/output.h"
+#include "opal/mca/base/base.h"
+
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/op/op.h"
+#include "ompi/mca/op/op.h"
+#include "ompi/mca/op/base/base.h"
+
+/* Maximum number of helper threads, the caller always participates */
+#define OMPI_OP_BASE_REDUCE_MAX_THREADS 64
+
+size_t ompi_op_base_reduce_threshold = 0;
+size_t ompi_op_base_reduce_chunk_size = 256 * 1024;
+static int ompi_op_base_reduce_threads = 0;
+
+/*
+ * One reduction, shared by all the threads working on it. Chunks are
+ * handed out through an atomic counter so that faster threads simply
+ * take more of them.
+ */
+typedef struct ompi_op_base_reduce_job_t {
+    ompi_op_base_handler_fn_t fn;
+    ompi_op_base_3buff_handler_fn_t fn3;
+    struct ompi_op_base_module_1_0_0_t *module;
+    ompi_datatype_t *dtype;
+    const char *source1;
+    const char *source2;
+    char *target;
+    char *copy;
+    size_t extent;
+    int count;
+    int chunk_count;
+    int nchunks;
+    opal_atomic_int32_t next;
+    opal_atomic_int32_t done;
+    opal_atomic_int32_t active;
+} ompi_op_base_reduce_job_t;
+
+typedef struct ompi_op_base_reduce_pool_t {
+    opal_mutex_t lock;
+    opal_cond_t cond;
+    ompi_op_base_reduce_job_t *job;
+    uint32_t generation;
+    bool stop;
+    int nthreads;
+    opal_atomic_int32_t busy;
+    opal_thread_t threads[OMPI_OP_BASE_REDUCE_MAX_THREADS];
+} ompi_op_base_reduce_pool_t;
+
+static ompi_op_base_reduce_pool_t reduce_pool;
+static bool reduce_pool_initialized = false;
+static opal_mutex_t reduce_pool_init_lock = OPAL_MUTEX_STATIC_INIT;
+
+static void reduce_job_run(ompi_op_base_reduce_job_t *job)
+{
+    int32_t c, completed = 0;
+
+    while ((c = opal_atomic_fetch_add_32(&job->next, 1)) < job->nchunks) {
+        size_t offset = (size_t)c * job->chunk_count * job->extent;
+        int count = job->count - c * job->chunk_count;
+        ompi_datatype_t *dtype = job->dtype;
+
+        if (count > job->chunk_count) {
+            count = job->chunk_count;
+        }
+        if (NULL == job->source2) {
+            job->fn((void *)(job->source1 + offset), job->target + offset,
+                    &count, &dtype, job->module);
+        } else {
+            job->fn3((void *)(job->source1 + offset), (void *)(job->source2 + offset),
+                     job->target + offset, &count, &dtype, job->module);
+        }
+        if (NULL != job->copy) {
+            ompi_datatype_copy_content_same_ddt(dtype, count, job->copy + offset,
+                                                job->target + offset);
+        }
+        ++completed;
+    }
+    if (0 != completed) {
+        opal_atomic_wmb();
+        opal_atomic_add_fetch_32(&job->done, completed);
+    }
+}
+
+static void *reduce_pool_worker(opal_object_t *obj)
+{
+    opal_thread_t *thread = (opal_thread_t *)obj;
+    ompi_op_base_reduce_pool_t *pool = (ompi_op_base_reduce_pool_t *)thread->t_arg;
+    uint32_t seen = 0;
+
+    opal_mutex_lock(&pool->lock);
+    while (!pool->stop) {
+        ompi_op_base_reduce_job_t *job = pool->job;
+
+        if (NULL == job || seen == pool->generation) {
+            opal_cond_wait(&pool->cond, &pool->lock);
+            continue;
+        }
+        seen = pool->generation;
+        /* registered under the lock so the owner can wait for us to let go */
+        opal_atomic_add_fetch_32(&job->active, 1);
+        opal_mutex_unlock(&pool->lock);
+
+        reduce_job_run(job);
+
+        opal_atomic_add_fetch_32(&job->active, -1);
+        opal_mutex_lock(&pool->lock);
+    }
+    opal_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void reduce_pool_init(void)
+{
+    int nthreads = ompi_op_base_reduce_threads;
+
+    opal_mutex_lock(&reduce_pool_init_lock);
+    if (reduce_pool_initialized) {
+        opal_mutex_unlock(&reduce_pool_init_lock);
+        return;
+    }
+    if (nthreads > OMPI_OP_BASE_REDUCE_MAX_THREADS) {
+        nthreads = OMPI_OP_BASE_REDUCE_MAX_THREADS;
+    }
+
+    OBJ_CONSTRUCT(&reduce_pool.lock, opal_mutex_t);
+    opal_cond_init(&reduce_pool.cond);
+    reduce_pool.job = NULL;
+    reduce_pool.generation = 0;
+    reduce_pool.stop = false;
+    reduce_pool.busy = 0;
+    reduce_pool.nthreads = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        opal_thread_t *thread = &reduce_pool.threads[i];
+
+        OBJ_CONSTRUCT(thread, opal_thread_t);
+        thread->t_run = reduce_pool_worker;
+        thread->t_arg = &reduce_pool;
+        if (OPAL_SUCCESS != opal_thread_start(thread)) {
+            opal_output_verbose(1, ompi_op_base_framework.framework_output,
+                                "op:base: could only start %d of %d reduction threads",
+                                i, nthreads);
+            OBJ_DESTRUCT(thread);
+            break;
+        }
+        reduce_pool.nthreads++;
+    }
+    opal_atomic_wmb();
+    reduce_pool_initialized = true;
+    opal_mutex_unlock(&reduce_pool_init_lock);
+}
+
+void ompi_op_base_reduce_large(ompi_op_t *op, int dtype_id, const void *source1,
+                               const void *source2, void *target, void *copy,
+                               int count, ompi_datatype_t *dtype)
+{
+    ompi_op_base_reduce_job_t job;
+    ptrdiff_t lb, extent;
+    int32_t expected = 0;
+
+    if (NULL == source2) {
+        job.fn = op->o_func.intrinsic.fns[dtype_id];
+        job.fn3 = NULL;
+        job.module = op->o_func.intrinsic.modules[dtype_id];
+    } else {
+        job.fn = NULL;
+        job.fn3 = op->o_3buff_intrinsic.fns[dtype_id];
+        job.module = op->o_3buff_intrinsic.modules[dtype_id];
+    }
+    ompi_datatype_get_extent(dtype, &lb, &extent);
+    job.dtype = dtype;
+    job.source1 = (const char *)source1;
+    job.source2 = (const char *)source2;
+    job.target = (char *)target;
+    job.copy = (char *)copy;
+    job.extent = extent;
+    job.count = count;
+    job.chunk_count = (int)(ompi_op_base_reduce_chunk_size / (size_t)extent);
+    if (job.chunk_count <= 0) {
+        job.chunk_count = 1;
+    }
+    job.nchunks = (int)(((size_t)count + job.chunk_count - 1) / job.chunk_count);
+    job.next = 0;
+    job.done = 0;
+    job.active = 0;
+
+    /* Helpers only pay off when there is more than a chunk each to do
+     * and nobody else is already using them; otherwise the caller
+     * walks the chunks alone. */
+    if (0 == ompi_op_base_reduce_threads || job.nchunks < 2) {
+        reduce_job_run(&job);
+        return;
+    }
+    if (OPAL_UNLIKELY(!reduce_pool_initialized)) {
+        reduce_pool_init();
+    }
+    if (0 == reduce_pool.nthreads ||
+        !opal_atomic_compare_exchange_strong_32(&reduce_pool.busy, &expected, 1)) {
+        reduce_job_run(&job);
+        return;
+    }
+
+    opal_mutex_lock(&reduce_pool.lock);
+    reduce_pool.job = &job;
+    reduce_pool.generation++;
+    opal_cond_broadcast(&reduce_pool.cond);
+    opal_mutex_unlock(&reduce_pool.lock);
+
+    reduce_job_run(&job);
+
+    /* Retract the job so no late helper picks it up, then wait for the
+     * ones that did to finish their chunks and drop the reference. */
+    opal_mutex_lock(&reduce_pool.lock);
+    reduce_pool.job = NULL;
+    opal_mutex_unlock(&reduce_pool.lock);
+    while (job.done < job.nchunks || 0 != job.active) {
+        opal_atomic_rmb();
+    }
+    opal_atomic_rmb();
+
+    reduce_pool.busy = 0;
+    opal_atomic_wmb();
+}
+
+int ompi_op_base_reduce_register(void)
+{
+    ompi_op_base_reduce_threshold = 0;
+    (void) mca_base_var_register("ompi", "op", "base", "reduce_threshold",
+                                 "Size in bytes from which reductions on intrinsic operations "
+                                 "and predefined datatypes are split into cache sized chunks "
+                                 "and optionally spread over helper threads (0 = disabled)",
+                                 MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                 OPAL_INFO_LVL_6,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &ompi_op_base_reduce_threshold);
+
+    ompi_op_base_reduce_chunk_size = 256 * 1024;
+    (void) mca_base_var_register("ompi", "op", "base", "reduce_chunk_size",
+                                 "Size in bytes of the chunks a large reduction is split into. "
+                                 "Should be small enough for all operands of a chunk to fit "
+                                 "in the L2 cache",
+                                 MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                 OPAL_INFO_LVL_6,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &ompi_op_base_reduce_chunk_size);
+    if (0 == ompi_op_base_reduce_chunk_size) {
+        ompi_op_base_reduce_chunk_size = 256 * 1024;
+    }
+
+    ompi_op_base_reduce_threads = 0;
+    (void) mca_base_var_register("ompi", "op", "base", "reduce_threads",
+                                 "Number of helper threads working on reductions larger than "
+                                 "op_base_reduce_threshold, in addition to the calling thread "
+                                 "(maximum 64)",
+                                 MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                 OPAL_INFO_LVL_6,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &ompi_op_base_reduce_threads);
+    if (ompi_op_base_reduce_threads < 0) {
+        ompi_op_base_reduce_threads = 0;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+void ompi_op_base_reduce_finalize(void)
+{
+    if (!reduce_pool_initialized) {
+        return;
+    }
+
+    opal_mutex_lock(&reduce_pool.lock);
+    reduce_pool.stop = true;
+    opal_cond_broadcast(&reduce_pool.cond);
+    opal_mutex_unlock(&reduce_pool.lock);
+
+    for (int i = 0; i < reduce_pool.nthreads; ++i) {
+        opal_thread_join(&reduce_pool.threads[i], NULL);
+        OBJ_DESTRUCT(&reduce_pool.threads[i]);
+    }
+    reduce_pool.nthreads = 0;
+    opal_cond_destroy(&reduce_pool.cond);
+    OBJ_DESTRUCT(&reduce_pool.lock);
+    reduce_pool_initialized = false;
+}
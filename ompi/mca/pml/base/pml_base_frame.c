@@ -42,6 +42,7 @@
 #include "ompi/mca/pml/pml.h"
 #include "ompi/mca/pml/base/base.h"
 #include "ompi/mca/pml/base/pml_base_request.h"
+#include "ompi/mca/pml/base/pml_base_part.h"
 
 /*
  * The following file was created by configure.  It contains extern
@@ -106,6 +107,15 @@ static int mca_pml_base_register(mca_base_register_flag_t flags)
                                  MCA_BASE_VAR_SCOPE_READONLY,
                                  &ompi_pml_base_bsend_allocator_name);
 
+    mca_pml_base_part_min_message_size = 16384;
+    (void) mca_base_var_register("ompi", "pml", "base", "part_min_message_size",
+                                 "Consecutive partitions of a partitioned send are coalesced "
+                                 "into messages of at least this many bytes",
+                                 MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                 OPAL_INFO_LVL_5,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &mca_pml_base_part_min_message_size);
+
 #if !MCA_ompi_pml_DIRECT_CALL && OPAL_ENABLE_FT_CR == 1
     ompi_pml_base_wrapper = NULL;
     var_id = mca_base_var_register("ompi", "pml", "base", "wrapper",
@@ -137,6 +147,9 @@ static int mca_pml_base_close(void)
         opal_progress_unregister(mca_pml.pml_progress);
     }
 
+    /* release the partitioned communication handshake state */
+    mca_pml_base_part_fini();
+
     /* Blatently ignore the return code (what would we do to recover,
        anyway?  This module is going away, so errors don't matter
        anymore) */
@@ -0,0 +1,863 @@
+/*
+ * Copyright (c) 2004-2005 The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2004-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "opal/class/opal_list.h"
+#include "opal/mca/threads/mutex.h"
+#include "opal/runtime/opal_progress.h"
+#include "opal/sys/atomic.h"
+
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/request/request.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/mca/pml/base/pml_base_part.h"
+
+size_t mca_pml_base_part_min_message_size = 16384;
+
+/*
+ * Handshake messages.  The sender describes its side, the receiver
+ * answers with the coalescing factor and the first data tag, or with
+ * a group of 0 if the two sides do not describe the same amount of
+ * data.
+ */
+typedef struct mca_pml_base_part_setup_t {
+    int32_t tag;
+    int32_t reply_tag;
+    int32_t partitions;
+    int32_t padding;
+    uint64_t part_bytes;
+} mca_pml_base_part_setup_t;
+
+typedef struct mca_pml_base_part_reply_t {
+    int32_t data_tag;
+    int32_t group;
+} mca_pml_base_part_reply_t;
+
+struct mca_pml_base_part_request_t;
+
+/* One message, i.e. group consecutive send partitions */
+typedef struct mca_pml_base_part_msg_t {
+    struct mca_pml_base_part_request_t *request;
+    opal_atomic_int32_t ready;
+    int32_t partitions;
+    volatile int32_t arrived;
+} mca_pml_base_part_msg_t;
+
+typedef struct mca_pml_base_part_request_t {
+    ompi_request_t super;
+    opal_mutex_t lock;
+    bool is_send;
+    char *buf;
+    int partitions;
+    size_t count;
+    ompi_datatype_t *datatype;
+    int peer;
+    int tag;
+    ompi_communicator_t *comm;
+
+    bool setup_started;
+    volatile bool setup_done;
+    int setup_error;
+    mca_pml_base_part_setup_t setup;
+    mca_pml_base_part_reply_t reply;
+    ompi_request_t *setup_req;
+
+    int group;
+    int nmsgs;
+    ompi_request_t **reqs;
+    mca_pml_base_part_msg_t *msgs;
+    /* send partitions marked ready before the handshake completed */
+    uint8_t *early;
+    opal_atomic_int32_t pending;
+} mca_pml_base_part_request_t;
+
+static void mca_pml_base_part_request_construct(mca_pml_base_part_request_t *req)
+{
+    OBJ_CONSTRUCT(&req->lock, opal_mutex_t);
+    req->setup_started = false;
+    req->setup_done = false;
+    req->setup_error = OMPI_SUCCESS;
+    req->setup_req = MPI_REQUEST_NULL;
+    req->group = 0;
+    req->nmsgs = 0;
+    req->reqs = NULL;
+    req->msgs = NULL;
+    req->early = NULL;
+    req->pending = 0;
+}
+
+static void mca_pml_base_part_request_destruct(mca_pml_base_part_request_t *req)
+{
+    OBJ_DESTRUCT(&req->lock);
+}
+
+static OBJ_CLASS_INSTANCE(mca_pml_base_part_request_t, ompi_request_t,
+                          mca_pml_base_part_request_construct,
+                          mca_pml_base_part_request_destruct);
+
+/*
+ * A handshake receive posted on behalf of the pending partitioned
+ * receives from one peer, or a handshake that arrived before the
+ * receive it belongs to was started (req is then MPI_REQUEST_NULL).
+ */
+typedef struct mca_pml_base_part_setup_item_t {
+    opal_list_item_t super;
+    ompi_communicator_t *comm;
+    int peer;
+    ompi_request_t *req;
+    mca_pml_base_part_setup_t setup;
+} mca_pml_base_part_setup_item_t;
+
+static OBJ_CLASS_INSTANCE(mca_pml_base_part_setup_item_t, opal_list_item_t, NULL, NULL);
+
+static opal_mutex_t mca_pml_base_part_lock = OPAL_MUTEX_STATIC_INIT;
+static bool mca_pml_base_part_initialized = false;
+static bool mca_pml_base_part_progress_active = false;
+static opal_list_t mca_pml_base_part_posted;      /* handshake receives in flight */
+static opal_list_t mca_pml_base_part_unexpected;  /* handshakes nobody asked for yet */
+static opal_list_t mca_pml_base_part_recv_pending; /* started receives without handshake */
+static opal_list_t mca_pml_base_part_send_pending; /* started sends waiting for the reply */
+static opal_atomic_int32_t mca_pml_base_part_next_tag = 0;
+
+static int mca_pml_base_part_progress(void);
+
+/* Reserve n consecutive (downwards) tags, returns the first one */
+static int mca_pml_base_part_alloc_tags(int n)
+{
+    int32_t first = opal_atomic_fetch_add_32(&mca_pml_base_part_next_tag, n);
+
+    if (first + n > MCA_PML_BASE_PART_TAG_RANGE) {
+        /* wrap around, the tags handed out first are long gone */
+        opal_mutex_lock(&mca_pml_base_part_lock);
+        if (mca_pml_base_part_next_tag >= MCA_PML_BASE_PART_TAG_RANGE) {
+            mca_pml_base_part_next_tag = 0;
+        }
+        opal_mutex_unlock(&mca_pml_base_part_lock);
+        first = opal_atomic_fetch_add_32(&mca_pml_base_part_next_tag, n);
+    }
+    return MCA_PML_BASE_PART_TAG_BASE - first;
+}
+
+/* Must be called with mca_pml_base_part_lock held */
+static void mca_pml_base_part_activate_progress(void)
+{
+    if (!mca_pml_base_part_progress_active) {
+        opal_progress_register(mca_pml_base_part_progress);
+        mca_pml_base_part_progress_active = true;
+    }
+}
+
+static void mca_pml_base_part_request_fail(mca_pml_base_part_request_t *req, int rc)
+{
+    req->setup_error = rc;
+    req->super.req_status.MPI_ERROR = rc;
+    ompi_request_complete(&req->super, true);
+}
+
+static int mca_pml_base_part_msg_complete(ompi_request_t *subreq)
+{
+    mca_pml_base_part_msg_t *msg = (mca_pml_base_part_msg_t *) subreq->req_complete_cb_data;
+    mca_pml_base_part_request_t *req = msg->request;
+
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != subreq->req_status.MPI_ERROR)) {
+        req->super.req_status.MPI_ERROR = subreq->req_status.MPI_ERROR;
+    }
+    opal_atomic_wmb();
+    msg->arrived = 1;
+    if (1 == opal_atomic_fetch_add_32(&req->pending, -1)) {
+        ompi_request_complete(&req->super, true);
+    }
+    return OMPI_SUCCESS;
+}
+
+static inline int mca_pml_base_part_msg_start(mca_pml_base_part_request_t *req, int first, int n)
+{
+    for (int i = first; i < first + n; ++i) {
+        req->reqs[i]->req_complete_cb = mca_pml_base_part_msg_complete;
+        req->reqs[i]->req_complete_cb_data = &req->msgs[i];
+    }
+    return MCA_PML_CALL(start(n, req->reqs + first));
+}
+
+/*
+ * Build the persistent requests of every message once group and
+ * the first data tag are known.
+ */
+static int mca_pml_base_part_create_msgs(mca_pml_base_part_request_t *req)
+{
+    size_t size, part_bytes = req->setup.part_bytes;
+    ptrdiff_t extent;
+    int rc;
+
+    ompi_datatype_type_size(req->datatype, &size);
+    ompi_datatype_type_extent(req->datatype, &extent);
+
+    req->nmsgs = (0 == req->setup.partitions) ? 0 :
+        (req->setup.partitions + req->group - 1) / req->group;
+    req->reqs = (ompi_request_t **) calloc(req->nmsgs + 1, sizeof(ompi_request_t *));
+    req->msgs = (mca_pml_base_part_msg_t *) calloc(req->nmsgs + 1, sizeof(mca_pml_base_part_msg_t));
+    if (NULL == req->reqs || NULL == req->msgs) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    for (int m = 0; m < req->nmsgs; ++m) {
+        int first = m * req->group;
+        int nparts = req->setup.partitions - first;
+        int tag = req->reply.data_tag - m;
+
+        if (nparts > req->group) {
+            nparts = req->group;
+        }
+        req->msgs[m].request = req;
+        req->msgs[m].partitions = nparts;
+
+        if (req->is_send) {
+            size_t elems = (size_t) nparts * req->count;
+            if (elems > INT_MAX) {
+                return OMPI_ERR_NOT_SUPPORTED;
+            }
+            rc = MCA_PML_CALL(isend_init(req->buf + (ptrdiff_t) first * req->count * extent,
+                                         (int) elems, req->datatype, req->peer, tag,
+                                         MCA_PML_BASE_SEND_STANDARD, req->comm,
+                                         &req->reqs[m]));
+        } else {
+            /* the message boundaries are multiples of the receive
+             * datatype size, see mca_pml_base_part_recv_setup */
+            size_t offset = (size_t) first * part_bytes;
+            size_t bytes = (size_t) nparts * part_bytes;
+            size_t elems = (0 == size) ? 0 : bytes / size;
+            if (elems > INT_MAX) {
+                return OMPI_ERR_NOT_SUPPORTED;
+            }
+            rc = MCA_PML_CALL(irecv_init(req->buf + (ptrdiff_t) (0 == size ? 0 : offset / size) * extent,
+                                         (int) elems, req->datatype, req->peer, tag,
+                                         req->comm, &req->reqs[m]));
+        }
+        if (OMPI_SUCCESS != rc) {
+            return rc;
+        }
+    }
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Receiver side of the handshake: check that both sides describe the
+ * same amount of data, pick the coalescing factor, reply and post the
+ * data receives for the round that is already active.
+ */
+static void mca_pml_base_part_recv_setup(mca_pml_base_part_request_t *req,
+                                         const mca_pml_base_part_setup_t *setup)
+{
+    size_t size, part_bytes = setup->part_bytes;
+    ompi_request_t *reply_req;
+    int group, rc;
+
+    ompi_datatype_type_size(req->datatype, &size);
+    req->setup = *setup;
+
+    if ((size_t) req->partitions * req->count * size !=
+        (size_t) setup->partitions * part_bytes) {
+        group = 0;
+    } else if (0 == part_bytes || 0 == size || 0 == setup->partitions) {
+        group = (setup->partitions > 0) ? setup->partitions : 1;
+    } else {
+        /* smallest multiple of step (so that messages end on a receive
+         * element) carrying at least min_message_size bytes */
+        size_t a = part_bytes % size, b = size;
+        while (0 != a) {
+            size_t t = b % a;
+            b = a;
+            a = t;
+        }
+        size_t step = size / b;
+        size_t g = (mca_pml_base_part_min_message_size + part_bytes - 1) / part_bytes;
+        if (g < 1) {
+            g = 1;
+        }
+        g = ((g + step - 1) / step) * step;
+        group = (g >= (size_t) setup->partitions) ? setup->partitions : (int) g;
+    }
+
+    req->group = group;
+    req->reply.group = group;
+    req->reply.data_tag = 0;
+    if (0 != group) {
+        int nmsgs = (setup->partitions + group - 1) / group;
+        req->reply.data_tag = mca_pml_base_part_alloc_tags(nmsgs > 0 ? nmsgs : 1);
+    }
+
+    rc = MCA_PML_CALL(isend(&req->reply, sizeof(req->reply), MPI_BYTE, req->peer,
+                            setup->reply_tag, MCA_PML_BASE_SEND_STANDARD, req->comm,
+                            &reply_req));
+    if (OMPI_SUCCESS != rc) {
+        mca_pml_base_part_request_fail(req, rc);
+        return;
+    }
+    /* the reply is delivered before any data can come back */
+    ompi_request_free(&reply_req);
+
+    if (0 == group) {
+        mca_pml_base_part_request_fail(req, MPI_ERR_TRUNCATE);
+        return;
+    }
+
+    rc = mca_pml_base_part_create_msgs(req);
+    if (OMPI_SUCCESS != rc) {
+        mca_pml_base_part_request_fail(req, rc);
+        return;
+    }
+
+    req->super.req_status._ucount = (size_t) setup->partitions * part_bytes;
+    req->pending = req->nmsgs;
+    opal_atomic_wmb();
+    req->setup_done = true;
+    if (0 == req->nmsgs) {
+        ompi_request_complete(&req->super, true);
+        return;
+    }
+    rc = mca_pml_base_part_msg_start(req, 0, req->nmsgs);
+    if (OMPI_SUCCESS != rc) {
+        mca_pml_base_part_request_fail(req, rc);
+    }
+}
+
+/*
+ * Sender side of the handshake: the reply arrived. Account for the
+ * partitions already marked ready and start the complete messages.
+ */
+static void mca_pml_base_part_send_setup(mca_pml_base_part_request_t *req)
+{
+    int rc;
+
+    if (0 == req->reply.group) {
+        mca_pml_base_part_request_fail(req, MPI_ERR_TRUNCATE);
+        return;
+    }
+    req->group = req->reply.group;
+
+    rc = mca_pml_base_part_create_msgs(req);
+    if (OMPI_SUCCESS != rc) {
+        mca_pml_base_part_request_fail(req, rc);
+        return;
+    }
+
+    req->pending = req->nmsgs;
+    if (0 == req->nmsgs) {
+        req->setup_done = true;
+        ompi_request_complete(&req->super, true);
+        return;
+    }
+
+    opal_mutex_lock(&req->lock);
+    for (int p = 0; p < req->partitions; ++p) {
+        if (req->early[p]) {
+            req->msgs[p / req->group].ready++;
+        }
+    }
+    for (int m = 0; m < req->nmsgs; ++m) {
+        if (req->msgs[m].ready == req->msgs[m].partitions) {
+            rc = mca_pml_base_part_msg_start(req, m, 1);
+            if (OMPI_SUCCESS != rc) {
+                break;
+            }
+        }
+    }
+    /* from here on Pready counts directly into the messages */
+    opal_atomic_wmb();
+    req->setup_done = true;
+    opal_mutex_unlock(&req->lock);
+
+    if (OMPI_SUCCESS != rc) {
+        mca_pml_base_part_request_fail(req, rc);
+    }
+}
+
+/* Must be called with mca_pml_base_part_lock held */
+static int mca_pml_base_part_post_setup_recv(ompi_communicator_t *comm, int peer,
+                                             mca_pml_base_part_setup_item_t *item)
+{
+    int rc;
+
+    if (NULL == item) {
+        item = OBJ_NEW(mca_pml_base_part_setup_item_t);
+        if (NULL == item) {
+            return OMPI_ERR_OUT_OF_RESOURCE;
+        }
+    }
+    item->comm = comm;
+    item->peer = peer;
+    rc = MCA_PML_CALL(irecv(&item->setup, sizeof(item->setup), MPI_BYTE, peer,
+                            MCA_PML_BASE_PART_TAG_SETUP, comm, &item->req));
+    if (OMPI_SUCCESS != rc) {
+        OBJ_RELEASE(item);
+        return rc;
+    }
+    opal_list_append(&mca_pml_base_part_posted, &item->super);
+    mca_pml_base_part_activate_progress();
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_base_part_progress(void)
+{
+    static opal_atomic_int32_t progressing = 0;
+    mca_pml_base_part_setup_item_t *item, *next_item;
+    mca_pml_base_part_request_t *req, *next_req;
+    int completed = 0;
+
+    /* don't allow re-entry */
+    if (opal_atomic_swap_32(&progressing, 1)) {
+        return 0;
+    }
+
+    opal_mutex_lock(&mca_pml_base_part_lock);
+
+    /* Incoming handshakes go to the oldest started receive with the
+     * same communicator, source and tag, or wait in the unexpected
+     * list.  In the latter case a new receive is posted, so that there
+     * is always one posted handshake receive per pending receive. */
+    OPAL_LIST_FOREACH_SAFE(item, next_item, &mca_pml_base_part_posted,
+                           mca_pml_base_part_setup_item_t) {
+        bool matched = false;
+
+        if (!REQUEST_COMPLETE(item->req)) {
+            continue;
+        }
+        ompi_request_free(&item->req);
+        opal_list_remove_item(&mca_pml_base_part_posted, &item->super);
+        ++completed;
+
+        OPAL_LIST_FOREACH(req, &mca_pml_base_part_recv_pending, mca_pml_base_part_request_t) {
+            if (req->comm == item->comm && req->peer == item->peer &&
+                req->tag == item->setup.tag) {
+                opal_list_remove_item(&mca_pml_base_part_recv_pending,
+                                      (opal_list_item_t *) req);
+                mca_pml_base_part_recv_setup(req, &item->setup);
+                OBJ_RELEASE(item);
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) {
+            opal_list_append(&mca_pml_base_part_unexpected, &item->super);
+            (void) mca_pml_base_part_post_setup_recv(item->comm, item->peer, NULL);
+        }
+    }
+
+    OPAL_LIST_FOREACH_SAFE(req, next_req, &mca_pml_base_part_send_pending,
+                           mca_pml_base_part_request_t) {
+        if (!REQUEST_COMPLETE(req->setup_req)) {
+            continue;
+        }
+        ompi_request_free(&req->setup_req);
+        opal_list_remove_item(&mca_pml_base_part_send_pending, (opal_list_item_t *) req);
+        mca_pml_base_part_send_setup(req);
+        ++completed;
+    }
+
+    if (0 == opal_list_get_size(&mca_pml_base_part_posted) &&
+        0 == opal_list_get_size(&mca_pml_base_part_send_pending)) {
+        /* nothing left to wait for. disable this progress function */
+        mca_pml_base_part_progress_active = false;
+        opal_progress_unregister(mca_pml_base_part_progress);
+    }
+
+    opal_mutex_unlock(&mca_pml_base_part_lock);
+    progressing = 0;
+
+    return completed;
+}
+
+/* First start of a request: initiate the handshake */
+static int mca_pml_base_part_start_setup(mca_pml_base_part_request_t *req)
+{
+    mca_pml_base_part_setup_item_t *item;
+    ompi_request_t *setup_req;
+    int rc = OMPI_SUCCESS;
+
+    req->setup_started = true;
+
+    if (req->is_send) {
+        size_t size;
+
+        ompi_datatype_type_size(req->datatype, &size);
+        req->setup.tag = req->tag;
+        req->setup.reply_tag = mca_pml_base_part_alloc_tags(1);
+        req->setup.partitions = req->partitions;
+        req->setup.padding = 0;
+        req->setup.part_bytes = (uint64_t) req->count * size;
+
+        rc = MCA_PML_CALL(irecv(&req->reply, sizeof(req->reply), MPI_BYTE, req->peer,
+                                req->setup.reply_tag, req->comm, &req->setup_req));
+        if (OMPI_SUCCESS != rc) {
+            return rc;
+        }
+        rc = MCA_PML_CALL(isend(&req->setup, sizeof(req->setup), MPI_BYTE, req->peer,
+                                MCA_PML_BASE_PART_TAG_SETUP, MCA_PML_BASE_SEND_STANDARD,
+                                req->comm, &setup_req));
+        if (OMPI_SUCCESS != rc) {
+            return rc;
+        }
+        /* the reply can only come once the handshake was delivered */
+        ompi_request_free(&setup_req);
+
+        opal_mutex_lock(&mca_pml_base_part_lock);
+        opal_list_append(&mca_pml_base_part_send_pending, (opal_list_item_t *) req);
+        mca_pml_base_part_activate_progress();
+        opal_mutex_unlock(&mca_pml_base_part_lock);
+        return OMPI_SUCCESS;
+    }
+
+    opal_mutex_lock(&mca_pml_base_part_lock);
+    OPAL_LIST_FOREACH(item, &mca_pml_base_part_unexpected, mca_pml_base_part_setup_item_t) {
+        if (item->comm == req->comm && item->peer == req->peer &&
+            item->setup.tag == req->tag) {
+            opal_list_remove_item(&mca_pml_base_part_unexpected, &item->super);
+            mca_pml_base_part_recv_setup(req, &item->setup);
+            OBJ_RELEASE(item);
+            opal_mutex_unlock(&mca_pml_base_part_lock);
+            return OMPI_SUCCESS;
+        }
+    }
+    opal_list_append(&mca_pml_base_part_recv_pending, (opal_list_item_t *) req);
+    rc = mca_pml_base_part_post_setup_recv(req->comm, req->peer, NULL);
+    if (OMPI_SUCCESS != rc) {
+        opal_list_remove_item(&mca_pml_base_part_recv_pending, (opal_list_item_t *) req);
+    }
+    opal_mutex_unlock(&mca_pml_base_part_lock);
+    return rc;
+}
+
+static int mca_pml_base_part_start(size_t count, ompi_request_t **requests)
+{
+    int rc;
+
+    for (size_t i = 0; i < count; ++i) {
+        mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) requests[i];
+
+        if (OMPI_REQUEST_ACTIVE == req->super.req_state) {
+            return OMPI_ERR_REQUEST;
+        }
+        req->super.req_state = OMPI_REQUEST_ACTIVE;
+        req->super.req_complete = REQUEST_PENDING;
+        req->super.req_status.MPI_ERROR = OMPI_SUCCESS;
+        req->super.req_status._cancelled = 0;
+        if (!req->is_send) {
+            req->super.req_status.MPI_SOURCE = req->peer;
+            req->super.req_status.MPI_TAG = req->tag;
+            req->super.req_status._ucount = req->setup_done ?
+                (size_t) req->setup.partitions * req->setup.part_bytes : 0;
+        }
+
+        if (OMPI_SUCCESS != req->setup_error) {
+            mca_pml_base_part_request_fail(req, req->setup_error);
+            continue;
+        }
+
+        if (!req->setup_started) {
+            if (req->is_send) {
+                memset(req->early, 0, req->partitions);
+            }
+            rc = mca_pml_base_part_start_setup(req);
+            if (OMPI_SUCCESS != rc) {
+                req->super.req_state = OMPI_REQUEST_INACTIVE;
+                req->super.req_complete = REQUEST_COMPLETED;
+                return rc;
+            }
+            continue;
+        }
+
+        if (!req->setup_done) {
+            /* only possible if a previous round failed in the handshake */
+            return OMPI_ERR_REQUEST;
+        }
+
+        req->pending = req->nmsgs;
+        for (int m = 0; m < req->nmsgs; ++m) {
+            req->msgs[m].ready = 0;
+            req->msgs[m].arrived = 0;
+        }
+        opal_atomic_wmb();
+        if (0 == req->nmsgs) {
+            ompi_request_complete(&req->super, true);
+        } else if (!req->is_send) {
+            rc = mca_pml_base_part_msg_start(req, 0, req->nmsgs);
+            if (OMPI_SUCCESS != rc) {
+                return rc;
+            }
+        }
+    }
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_base_part_free(ompi_request_t **request)
+{
+    mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) *request;
+
+    if (!REQUEST_COMPLETE(&req->super)) {
+        return MPI_ERR_REQUEST;
+    }
+
+    for (int m = 0; m < req->nmsgs; ++m) {
+        if (NULL != req->reqs[m] && MPI_REQUEST_NULL != req->reqs[m]) {
+            ompi_request_free(&req->reqs[m]);
+        }
+    }
+    free(req->reqs);
+    free(req->msgs);
+    free(req->early);
+    OBJ_RELEASE(req->datatype);
+    OBJ_RELEASE(req->comm);
+
+    OMPI_REQUEST_FINI(&req->super);
+    OBJ_RELEASE(req);
+    *request = MPI_REQUEST_NULL;
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_base_part_cancel(ompi_request_t *request, int complete)
+{
+    /* partitioned requests cannot be cancelled */
+    return OMPI_SUCCESS;
+}
+
+int mca_pml_base_part_init(void *buf, int partitions, size_t count,
+                           ompi_datatype_t *datatype, int peer, int tag,
+                           ompi_communicator_t *comm, bool is_send,
+                           ompi_request_t **request)
+{
+    mca_pml_base_part_request_t *req;
+
+    if (OPAL_UNLIKELY(!mca_pml_base_part_initialized)) {
+        opal_mutex_lock(&mca_pml_base_part_lock);
+        if (!mca_pml_base_part_initialized) {
+            OBJ_CONSTRUCT(&mca_pml_base_part_posted, opal_list_t);
+            OBJ_CONSTRUCT(&mca_pml_base_part_unexpected, opal_list_t);
+            OBJ_CONSTRUCT(&mca_pml_base_part_recv_pending, opal_list_t);
+            OBJ_CONSTRUCT(&mca_pml_base_part_send_pending, opal_list_t);
+            opal_atomic_wmb();
+            mca_pml_base_part_initialized = true;
+        }
+        opal_mutex_unlock(&mca_pml_base_part_lock);
+    }
+
+    req = OBJ_NEW(mca_pml_base_part_request_t);
+    if (NULL == req) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    if (is_send) {
+        req->early = (uint8_t *) calloc(partitions > 0 ? partitions : 1, 1);
+        if (NULL == req->early) {
+            OBJ_RELEASE(req);
+            return OMPI_ERR_OUT_OF_RESOURCE;
+        }
+    }
+
+    OMPI_REQUEST_INIT(&req->super, true);
+    req->super.req_type = OMPI_REQUEST_PART;
+    req->super.req_start = mca_pml_base_part_start;
+    req->super.req_free = mca_pml_base_part_free;
+    req->super.req_cancel = mca_pml_base_part_cancel;
+    req->super.req_mpi_object.comm = comm;
+    req->super.req_status = ompi_request_empty.req_status;
+
+    req->is_send = is_send;
+    req->buf = (char *) buf;
+    req->partitions = partitions;
+    req->count = count;
+    req->datatype = datatype;
+    req->peer = peer;
+    req->tag = tag;
+    req->comm = comm;
+    OBJ_RETAIN(datatype);
+    OBJ_RETAIN(comm);
+
+    *request = &req->super;
+    return OMPI_SUCCESS;
+}
+
+static inline int mca_pml_base_part_pready_one(mca_pml_base_part_request_t *req, int partition)
+{
+    mca_pml_base_part_msg_t *msg;
+
+    opal_atomic_rmb();
+    if (OPAL_UNLIKELY(!req->setup_done)) {
+        opal_mutex_lock(&req->lock);
+        if (!req->setup_done) {
+            req->early[partition] = 1;
+            opal_mutex_unlock(&req->lock);
+            return OMPI_SUCCESS;
+        }
+        opal_mutex_unlock(&req->lock);
+    }
+
+    msg = &req->msgs[partition / req->group];
+    if (opal_atomic_add_fetch_32(&msg->ready, 1) == msg->partitions) {
+        return mca_pml_base_part_msg_start(req, (int) (msg - req->msgs), 1);
+    }
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_base_part_check(ompi_request_t *request, bool is_send)
+{
+    mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) request;
+
+    if (OMPI_REQUEST_PART != request->req_type || req->is_send != is_send ||
+        OMPI_REQUEST_ACTIVE != request->req_state) {
+        return OMPI_ERR_REQUEST;
+    }
+    return OMPI_SUCCESS;
+}
+
+int mca_pml_base_part_pready(ompi_request_t *request, int first, int last)
+{
+    mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) request;
+    int rc;
+
+    if (OMPI_REQUEST_NOOP == request->req_type) {
+        return OMPI_SUCCESS;
+    }
+    if (OMPI_SUCCESS != (rc = mca_pml_base_part_check(request, true))) {
+        return rc;
+    }
+    if (first < 0 || last >= req->partitions || first > last) {
+        return OMPI_ERR_BAD_PARAM;
+    }
+    if (OMPI_SUCCESS != req->setup_error) {
+        return OMPI_SUCCESS;
+    }
+
+    for (int p = first; p <= last; ++p) {
+        if (OMPI_SUCCESS != (rc = mca_pml_base_part_pready_one(req, p))) {
+            return rc;
+        }
+    }
+    return OMPI_SUCCESS;
+}
+
+int mca_pml_base_part_pready_list(ompi_request_t *request, int length, const int partitions[])
+{
+    mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) request;
+    int rc;
+
+    if (OMPI_REQUEST_NOOP == request->req_type) {
+        return OMPI_SUCCESS;
+    }
+    if (OMPI_SUCCESS != (rc = mca_pml_base_part_check(request, true))) {
+        return rc;
+    }
+    for (int i = 0; i < length; ++i) {
+        if (partitions[i] < 0 || partitions[i] >= req->partitions) {
+            return OMPI_ERR_BAD_PARAM;
+        }
+    }
+    if (OMPI_SUCCESS != req->setup_error) {
+        return OMPI_SUCCESS;
+    }
+
+    for (int i = 0; i < length; ++i) {
+        if (OMPI_SUCCESS != (rc = mca_pml_base_part_pready_one(req, partitions[i]))) {
+            return rc;
+        }
+    }
+    return OMPI_SUCCESS;
+}
+
+static bool mca_pml_base_part_arrived(mca_pml_base_part_request_t *req, int partition)
+{
+    size_t size, msg_bytes, first, last;
+
+    if (REQUEST_COMPLETE(&req->super)) {
+        return true;
+    }
+    opal_atomic_rmb();
+    if (!req->setup_done) {
+        return false;
+    }
+
+    ompi_datatype_type_size(req->datatype, &size);
+    msg_bytes = (size_t) req->group * req->setup.part_bytes;
+    if (0 == msg_bytes || 0 == req->count * size) {
+        return true;
+    }
+    first = (size_t) partition * req->count * size / msg_bytes;
+    last = ((size_t) (partition + 1) * req->count * size - 1) / msg_bytes;
+    for (size_t m = first; m <= last; ++m) {
+        if (!req->msgs[m].arrived) {
+            return false;
+        }
+    }
+    opal_atomic_rmb();
+    return true;
+}
+
+int mca_pml_base_part_parrived(ompi_request_t *request, int partition, int *flag)
+{
+    mca_pml_base_part_request_t *req = (mca_pml_base_part_request_t *) request;
+
+    if (OMPI_REQUEST_NOOP == request->req_type) {
+        *flag = 1;
+        return OMPI_SUCCESS;
+    }
+    if (OMPI_REQUEST_PART != request->req_type || req->is_send) {
+        return OMPI_ERR_REQUEST;
+    }
+    if (partition < 0 || partition >= req->partitions) {
+        return OMPI_ERR_BAD_PARAM;
+    }
+    if (OMPI_REQUEST_ACTIVE != request->req_state) {
+        /* inactive requests have nothing pending */
+        *flag = 1;
+        return OMPI_SUCCESS;
+    }
+    if (mca_pml_base_part_arrived(req, partition)) {
+        *flag = 1;
+        return OMPI_SUCCESS;
+    }
+    opal_progress();
+    *flag = mca_pml_base_part_arrived(req, partition) ? 1 : 0;
+    return OMPI_SUCCESS;
+}
+
+void mca_pml_base_part_fini(void)
+{
+    mca_pml_base_part_setup_item_t *item;
+
+    if (!mca_pml_base_part_initialized) {
+        return;
+    }
+
+    opal_mutex_lock(&mca_pml_base_part_lock);
+    if (mca_pml_base_part_progress_active) {
+        opal_progress_unregister(mca_pml_base_part_progress);
+        mca_pml_base_part_progress_active = false;
+    }
+    while (NULL != (item = (mca_pml_base_part_setup_item_t *)
+                    opal_list_remove_first(&mca_pml_base_part_posted))) {
+        ompi_request_cancel(item->req);
+        ompi_request_free(&item->req);
+        OBJ_RELEASE(item);
+    }
+    OPAL_LIST_DESTRUCT(&mca_pml_base_part_unexpected);
+    OBJ_DESTRUCT(&mca_pml_base_part_posted);
+    OBJ_DESTRUCT(&mca_pml_base_part_recv_pending);
+    OBJ_DESTRUCT(&mca_pml_base_part_send_pending);
+    mca_pml_base_part_initialized = false;
+    opal_mutex_unlock(&mca_pml_base_part_lock);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2004-2005 The Trustees of Indiana University and Indiana
+ *                         University Research and Technology
+ *                         Corporation.  All rights reserved.
+ * Copyright (c) 2004-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * MPI-4 partitioned point-to-point communication, layered on top of
+ * the persistent requests of the selected PML.
+ *
+ * MPI_Psend_init / MPI_Precv_init are local.  The first MPI_Start on
+ * each side runs a one-time handshake on the user communicator: the
+ * sender describes its partitioning, and the receiver matches it
+ * against its own pending partitioned receives (comm, source, tag), in
+ * order. It then decides how many consecutive send partitions are
+ * coalesced into one message (so that every message is at least
+ * pml_base_part_min_message_size bytes and ends on a receive datatype
+ * boundary) and hands out a block of private tags, one per message.
+ * From then on each message is an ordinary persistent PML request
+ * with its own tag, started as soon as the last of its partitions is
+ * marked ready. No further matching setup is needed, and the data
+ * moves over whatever BTLs the PML uses for the peer.
+ *
+ * The handshake and data messages use negative tags, which MPI_ANY_TAG
+ * never matches, so they cannot be mistaken for user traffic on the
+ * same communicator.
+ */
+
+#ifndef MCA_PML_BASE_PART_H
+#define MCA_PML_BASE_PART_H
+
+#include "ompi_config.h"
+
+#include "ompi/request/request.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/base/coll_tags.h"
+
+BEGIN_C_DECLS
+
+/*
+ * Tags used by partitioned communication.  They are carved out of the
+ * hcoll range, right below the neighbourhood collectives (which do the
+ * same).
+ */
+#define MCA_PML_BASE_PART_TAG_SETUP  (MCA_COLL_BASE_TAG_NEIGHBOR_END - 1)
+#define MCA_PML_BASE_PART_TAG_BASE   (MCA_COLL_BASE_TAG_NEIGHBOR_END - 2)
+#define MCA_PML_BASE_PART_TAG_RANGE  (1 << 28)
+
+/** Coalescing threshold (pml_base_part_min_message_size MCA parameter) */
+OMPI_DECLSPEC extern size_t mca_pml_base_part_min_message_size;
+
+/**
+ * Initialize a partitioned send or receive request.
+ *
+ * @param buf         Buffer holding partitions * count elements
+ * @param partitions  Number of partitions
+ * @param count       Number of elements per partition
+ * @param datatype    Datatype of the elements
+ * @param peer        Destination (send) or source (receive) rank
+ * @param tag         User tag
+ * @param comm        Communicator
+ * @param is_send     true for MPI_Psend_init, false for MPI_Precv_init
+ * @param request     (OUT) The new persistent request
+ *
+ * This call is local.  The matching with the peer is done the first
+ * time the request is started.
+ */
+OMPI_DECLSPEC int mca_pml_base_part_init(void *buf, int partitions, size_t count,
+                                         ompi_datatype_t *datatype, int peer, int tag,
+                                         ompi_communicator_t *comm, bool is_send,
+                                         ompi_request_t **request);
+
+/**
+ * Mark the send partitions first..last (inclusive) as ready.
+ */
+OMPI_DECLSPEC int mca_pml_base_part_pready(ompi_request_t *request, int first, int last);
+
+/**
+ * Mark length send partitions, listed in partitions, as ready.
+ */
+OMPI_DECLSPEC int mca_pml_base_part_pready_list(ompi_request_t *request, int length,
+                                                const int partitions[]);
+
+/**
+ * Check whether receive partition partition has arrived.
+ */
+OMPI_DECLSPEC int mca_pml_base_part_parrived(ompi_request_t *request, int partition,
+                                             int *flag);
+
+/**
+ * Release the handshake state.  Called when the PML framework closes.
+ */
+void mca_pml_base_part_fini(void);
+
+END_C_DECLS
+
+#endif /* MCA_PML_BASE_PART_H */
@@ -10,11 +10,13 @@
 
 # MCA_ompi_pml_ob1_POST_CONFIG(will_build)
 # ----------------------------------------
-# The OB1 PML requires a BML endpoint tag to compile, so require it.
+# The OB1 PML requires a BML endpoint tag to compile, so require it,
+# and a PML one for the per-peer message aggregation state.
 # Require in POST_CONFIG instead of CONFIG so that we only require it
 # if we're not disabled.
 AC_DEFUN([MCA_ompi_pml_ob1_POST_CONFIG], [
-    AS_IF([test "$1" = "1"], [OMPI_REQUIRE_ENDPOINT_TAG([BML])])
+    AS_IF([test "$1" = "1"], [OMPI_REQUIRE_ENDPOINT_TAG([BML])
+                              OMPI_REQUIRE_ENDPOINT_TAG([PML])])
 ])dnl
 
 # MCA_ompi_pml_ob1_CONFIG(action-if-can-compile,
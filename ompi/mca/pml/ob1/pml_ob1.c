@@ -40,6 +40,7 @@
 #include "opal_stdint.h"
 #include "opal/mca/btl/btl.h"
 #include "opal/mca/btl/base/base.h"
+#include "opal/runtime/opal_progress.h"
 
 #include "ompi/mca/pml/pml.h"
 #include "ompi/mca/pml/base/base.h"
@@ -56,6 +57,7 @@
 #include "pml_ob1_sendreq.h"
 #include "pml_ob1_recvreq.h"
 #include "pml_ob1_rdmafrag.h"
+#include "pml_ob1_agg.h"
 
 mca_pml_ob1_t mca_pml_ob1 = {
     {
@@ -162,6 +164,13 @@ int mca_pml_ob1_enable(bool enable)
     /* missing communicator pending list */
     OBJ_CONSTRUCT(&mca_pml_ob1.non_existing_communicator_pending, opal_list_t);
 
+    /* aggregation of small messages */
+    OBJ_CONSTRUCT(&mca_pml_ob1.agg_lock, opal_mutex_t);
+    OBJ_CONSTRUCT(&mca_pml_ob1.agg_pending, opal_list_t);
+    if (0 != mca_pml_ob1.agg_size) {
+        opal_progress_register (mca_pml_ob1_agg_progress);
+    }
+
     /**
      * If we get here this is the PML who get selected for the run. We
      * should get ownership for the send and receive requests list, and
@@ -250,7 +259,7 @@ int mca_pml_ob1_add_comm(ompi_communicator_t* comm)
 
         if (OMPI_COMM_CHECK_ASSERT_ALLOW_OVERTAKE(comm)) {
 #if !MCA_PML_OB1_CUSTOM_MATCH
-            opal_list_append( &pml_proc->unexpected_frags, (opal_list_item_t*)frag );
+            mca_pml_ob1_unexpected_append(pml_comm, pml_proc, frag);
 #else
             custom_match_umq_append(pml_comm->umq, hdr->hdr_tag, hdr->hdr_src, frag);
 #endif
@@ -265,7 +274,7 @@ int mca_pml_ob1_add_comm(ompi_communicator_t* comm)
             /* We're now expecting the next sequence number. */
             pml_proc->expected_sequence++;
 #if !MCA_PML_OB1_CUSTOM_MATCH
-            opal_list_append( &pml_proc->unexpected_frags, (opal_list_item_t*)frag );
+            mca_pml_ob1_unexpected_append(pml_comm, pml_proc, frag);
 #else
             custom_match_umq_append(pml_comm->umq, hdr->hdr_tag, hdr->hdr_src, frag);
 #endif
@@ -472,6 +481,12 @@ int mca_pml_ob1_add_procs(ompi_proc_t** procs, size_t nprocs)
 
 int mca_pml_ob1_del_procs(ompi_proc_t** procs, size_t nprocs)
 {
+    if (0 != mca_pml_ob1.agg_size) {
+        for (size_t i = 0 ; i < nprocs ; ++i) {
+            mca_pml_ob1_agg_del_proc (procs[i]);
+        }
+    }
+
     return mca_bml.bml_del_procs(nprocs, procs);
 }
 
@@ -573,6 +588,16 @@ static void mca_pml_ob1_dump_frag_list(opal_list_t* queue, bool is_req)
         }
     }
 }
+
+#if !MCA_PML_OB1_CUSTOM_MATCH
+/* dump the tag buckets of a matching queue */
+static void mca_pml_ob1_dump_frag_lists(opal_list_t* queues, bool is_req)
+{
+    for( unsigned int i = 0; i <= mca_pml_ob1_match_mask; i++ ) {
+        mca_pml_ob1_dump_frag_list(queues + i, is_req);
+    }
+}
+#endif
 #endif
 
 void mca_pml_ob1_dump_cant_match(mca_pml_ob1_recv_frag_t* queue)
@@ -604,9 +629,10 @@ int mca_pml_ob1_dump(struct ompi_communicator_t* comm, int verbose)
                 pml_comm->recv_sequence, pml_comm->num_procs, pml_comm->last_probed);
 
 #if !MCA_PML_OB1_CUSTOM_MATCH
-    if( opal_list_get_size(&pml_comm->wild_receives) ) {
+    if( pml_comm->num_posted ) {
         opal_output(0, "expected MPI_ANY_SOURCE fragments\n");
         mca_pml_ob1_dump_frag_list(&pml_comm->wild_receives, true);
+        mca_pml_ob1_dump_frag_lists(pml_comm->wild_tagged, true);
     }
 #endif
 
@@ -634,9 +660,10 @@ int mca_pml_ob1_dump(struct ompi_communicator_t* comm, int verbose)
 
         /* dump all receive queues */
 #if !MCA_PML_OB1_CUSTOM_MATCH
-       if( opal_list_get_size(&proc->specific_receives) ) {
+       if( proc->num_specific ) {
             opal_output(0, "expected specific receives\n");
             mca_pml_ob1_dump_frag_list(&proc->specific_receives, true);
+            mca_pml_ob1_dump_frag_lists(proc->specific_tagged, true);
         }
 #endif
         if( NULL != proc->frags_cant_match ) {
@@ -644,9 +671,9 @@ int mca_pml_ob1_dump(struct ompi_communicator_t* comm, int verbose)
             mca_pml_ob1_dump_cant_match(proc->frags_cant_match);
         }
 #if !MCA_PML_OB1_CUSTOM_MATCH
-        if( opal_list_get_size(&proc->unexpected_frags) ) {
+        if( proc->num_unexpected ) {
             opal_output(0, "unexpected frag\n");
-            mca_pml_ob1_dump_frag_list(&proc->unexpected_frags, false);
+            mca_pml_ob1_dump_frag_lists(proc->unexpected_frags, false);
         }
 #endif
         /* dump all btls used for eager messages */
@@ -83,12 +83,32 @@ struct mca_pml_ob1_t {
     char* allocator_name;
     mca_allocator_base_module_t* allocator;
     unsigned int unexpected_limit;
+
+    /* aggregation of small eager messages (see pml_ob1_agg.h) */
+    size_t agg_size;            /* largest aggregated fragment, 0 disables aggregation */
+    size_t agg_max_message;     /* largest message that is aggregated */
+    unsigned int agg_delay;     /* longest time (usec) a message may wait in an aggregate */
+    opal_mutex_t agg_lock;      /* protects agg_pending */
+    opal_list_t agg_pending;    /* peers with an aggregate being filled */
+
+    /* adaptive protocol thresholds (see pml_ob1_adapt.h) */
+    int adapt_mode;             /* off, fixed or learn, set from the parameters below */
+    bool adapt_learn;           /* adjust the thresholds at runtime */
+    bool adapt_dump;            /* print the thresholds at finalize */
+    unsigned int adapt_explore; /* one message in adapt_explore around a threshold tries the other protocol */
+    unsigned int adapt_interval;        /* samples between two evaluations of a threshold */
+    unsigned int adapt_min_samples;     /* samples of each protocol needed to move a threshold */
+    size_t adapt_min_eager_limit;       /* lowest eager limit */
+    size_t adapt_max_rdma_threshold;    /* highest RDMA threshold */
+    char *adapt_eager_limits;   /* eager limits given by the user, per peer class */
+    char *adapt_rdma_thresholds;        /* RDMA thresholds given by the user, per peer class */
 };
 typedef struct mca_pml_ob1_t mca_pml_ob1_t;
 
 extern mca_pml_ob1_t mca_pml_ob1;
 extern int mca_pml_ob1_output;
 extern bool mca_pml_ob1_matching_protection;
+extern bool mca_pml_ob1_match_per_peer;
 /*
  * PML interface functions.
  */
@@ -0,0 +1,387 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "opal/util/argv.h"
+#include "opal/util/output.h"
+#include "opal/mca/hwloc/base/base.h"
+#include "ompi/runtime/ompi_rte.h"
+#include "pml_ob1.h"
+#include "pml_ob1_adapt.h"
+
+/* number of powers of two of message sizes */
+#define MCA_PML_OB1_ADAPT_BUCKETS 64
+
+/* a protocol must be this much cheaper than the other to move a threshold */
+#define MCA_PML_OB1_ADAPT_MARGIN 0.9
+
+struct mca_pml_ob1_adapt_stat_t {
+    double cost[2];                 /**< average cycles per byte of each protocol */
+    uint32_t count[2];              /**< number of samples of each protocol */
+};
+typedef struct mca_pml_ob1_adapt_stat_t mca_pml_ob1_adapt_stat_t;
+
+struct mca_pml_ob1_adapt_threshold_t {
+    size_t value;                   /**< current threshold */
+    size_t min;
+    size_t max;
+    opal_atomic_int32_t explore;    /**< messages around the threshold since the last exploration */
+    opal_atomic_int32_t samples;    /**< samples since the last evaluation */
+    mca_pml_ob1_adapt_stat_t stats[MCA_PML_OB1_ADAPT_BUCKETS];
+};
+typedef struct mca_pml_ob1_adapt_threshold_t mca_pml_ob1_adapt_threshold_t;
+
+struct mca_pml_ob1_adapt_class_t {
+    mca_pml_ob1_adapt_threshold_t thresholds[2];
+    size_t user[2];                 /**< values given by the user, 0 if none */
+    volatile bool ready;            /**< bounds set from the first BTL used */
+};
+typedef struct mca_pml_ob1_adapt_class_t mca_pml_ob1_adapt_class_t;
+
+static mca_pml_ob1_adapt_class_t mca_pml_ob1_adapt_classes[MCA_PML_OB1_ADAPT_CLASSES];
+static opal_atomic_int64_t mca_pml_ob1_adapt_moves = 0;
+
+static const char *mca_pml_ob1_adapt_class_names[MCA_PML_OB1_ADAPT_CLASSES] = {
+    "socket", "node", "remote"
+};
+
+static inline int mca_pml_ob1_adapt_class (ompi_proc_t *proc)
+{
+    if (OPAL_PROC_ON_LOCAL_SOCKET(proc->super.proc_flags)) {
+        return MCA_PML_OB1_ADAPT_SOCKET;
+    }
+    if (OPAL_PROC_ON_LOCAL_NODE(proc->super.proc_flags)) {
+        return MCA_PML_OB1_ADAPT_NODE;
+    }
+    return MCA_PML_OB1_ADAPT_REMOTE;
+}
+
+static inline int mca_pml_ob1_adapt_bucket (size_t size)
+{
+    int bucket = 0;
+
+    while (size >>= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+/* the buckets on each side of the threshold: below it is all lo, or only
+ * the bucket of the threshold when it is not a power of two */
+static inline void mca_pml_ob1_adapt_window (const mca_pml_ob1_adapt_threshold_t *threshold,
+                                             int *lo, int *hi)
+{
+    size_t value = threshold->value;
+
+    *hi = mca_pml_ob1_adapt_bucket (value);
+    *lo = (value & (value - 1)) ? *hi : *hi - 1;
+}
+
+static inline size_t mca_pml_ob1_adapt_clamp (const mca_pml_ob1_adapt_threshold_t *threshold,
+                                              size_t value)
+{
+    if (value < threshold->min) {
+        return threshold->min;
+    }
+    if (value > threshold->max) {
+        return threshold->max;
+    }
+    return value;
+}
+
+static void mca_pml_ob1_adapt_class_init (int cls, size_t eager_limit)
+{
+    mca_pml_ob1_adapt_class_t *class = mca_pml_ob1_adapt_classes + cls;
+    mca_pml_ob1_adapt_threshold_t *eager = class->thresholds + MCA_PML_OB1_ADAPT_EAGER;
+    mca_pml_ob1_adapt_threshold_t *rdma = class->thresholds + MCA_PML_OB1_ADAPT_RDMA;
+
+    OPAL_THREAD_LOCK(&mca_pml_ob1.lock);
+    if (!class->ready) {
+        eager->max = eager_limit ? eager_limit : 1;
+        eager->min = mca_pml_ob1.adapt_min_eager_limit ? mca_pml_ob1.adapt_min_eager_limit : 1;
+        if (eager->min > eager->max) {
+            eager->min = eager->max;
+        }
+        eager->value = class->user[MCA_PML_OB1_ADAPT_EAGER] ?
+            mca_pml_ob1_adapt_clamp (eager, class->user[MCA_PML_OB1_ADAPT_EAGER]) : eager->max;
+
+        /* below the largest eager limit messages are never rendezvous */
+        rdma->min = eager_limit + 1;
+        rdma->max = mca_pml_ob1.adapt_max_rdma_threshold;
+        if (rdma->max < rdma->min) {
+            rdma->max = rdma->min;
+        }
+        rdma->value = class->user[MCA_PML_OB1_ADAPT_RDMA] ?
+            mca_pml_ob1_adapt_clamp (rdma, class->user[MCA_PML_OB1_ADAPT_RDMA]) : rdma->min;
+
+        opal_atomic_wmb ();
+        class->ready = true;
+    }
+    OPAL_THREAD_UNLOCK(&mca_pml_ob1.lock);
+}
+
+/* decide whether a message of the given bucket is sent with the other
+ * protocol this time. returns false if the bucket is not around the
+ * threshold (nothing to learn from it). */
+static inline bool mca_pml_ob1_adapt_explore (mca_pml_ob1_adapt_threshold_t *threshold, int bucket,
+                                              bool *flip)
+{
+    int lo, hi;
+
+    mca_pml_ob1_adapt_window (threshold, &lo, &hi);
+    if (bucket != lo && bucket != hi) {
+        return false;
+    }
+
+    *flip = (OPAL_THREAD_ADD_FETCH32(&threshold->explore, 1) % mca_pml_ob1.adapt_explore) == 0;
+    return true;
+}
+
+static inline void mca_pml_ob1_adapt_sample (mca_pml_ob1_adapt_sample_t *sample, int cls, int threshold,
+                                             int bucket, int proto)
+{
+    /* a request retried from the pending list keeps its first start time */
+    if (MCA_PML_OB1_ADAPT_NONE == sample->threshold) {
+        sample->start = opal_timer_base_get_cycles ();
+    }
+    sample->cls = (uint8_t) cls;
+    sample->threshold = (uint8_t) threshold;
+    sample->bucket = (uint8_t) bucket;
+    sample->proto = (uint8_t) proto;
+}
+
+size_t mca_pml_ob1_adapt_eager_limit (mca_pml_ob1_adapt_sample_t *sample, ompi_proc_t *proc,
+                                      bool standard, size_t size, size_t eager_limit)
+{
+    int cls = mca_pml_ob1_adapt_class (proc);
+    mca_pml_ob1_adapt_class_t *class = mca_pml_ob1_adapt_classes + cls;
+    mca_pml_ob1_adapt_threshold_t *threshold = class->thresholds + MCA_PML_OB1_ADAPT_EAGER;
+    size_t limit;
+    bool flip;
+    int bucket;
+
+    if (OPAL_UNLIKELY(!class->ready)) {
+        mca_pml_ob1_adapt_class_init (cls, eager_limit);
+    }
+
+    limit = threshold->value;
+    if (limit > eager_limit) {
+        limit = eager_limit;
+    }
+
+    if (MCA_PML_OB1_ADAPT_LEARN != mca_pml_ob1.adapt_mode || !standard || 0 == size) {
+        return limit;
+    }
+
+    bucket = mca_pml_ob1_adapt_bucket (size);
+    if (!mca_pml_ob1_adapt_explore (threshold, bucket, &flip)) {
+        return limit;
+    }
+
+    if (flip) {
+        if (size <= limit) {
+            limit = size - 1;
+        } else if (size <= eager_limit) {
+            limit = size;
+        }
+    }
+
+    mca_pml_ob1_adapt_sample (sample, cls, MCA_PML_OB1_ADAPT_EAGER, bucket, size > limit);
+    return limit;
+}
+
+bool mca_pml_ob1_adapt_use_rdma (mca_pml_ob1_adapt_sample_t *sample, ompi_proc_t *proc,
+                                 bool standard, size_t size)
+{
+    int cls = mca_pml_ob1_adapt_class (proc);
+    mca_pml_ob1_adapt_class_t *class = mca_pml_ob1_adapt_classes + cls;
+    mca_pml_ob1_adapt_threshold_t *threshold = class->thresholds + MCA_PML_OB1_ADAPT_RDMA;
+    bool use, flip;
+    int bucket;
+
+    /* the eager limit of the class is always looked at first */
+    if (OPAL_UNLIKELY(!class->ready)) {
+        return true;
+    }
+
+    use = size >= threshold->value;
+
+    /* a message already measured against the eager limit stays with it */
+    if (MCA_PML_OB1_ADAPT_LEARN != mca_pml_ob1.adapt_mode || !standard ||
+        MCA_PML_OB1_ADAPT_EAGER == sample->threshold) {
+        return use;
+    }
+
+    bucket = mca_pml_ob1_adapt_bucket (size);
+    if (!mca_pml_ob1_adapt_explore (threshold, bucket, &flip)) {
+        return use;
+    }
+
+    use ^= flip;
+    mca_pml_ob1_adapt_sample (sample, cls, MCA_PML_OB1_ADAPT_RDMA, bucket, use);
+    return use;
+}
+
+static void mca_pml_ob1_adapt_evaluate (int cls, int index)
+{
+    mca_pml_ob1_adapt_threshold_t *threshold = mca_pml_ob1_adapt_classes[cls].thresholds + index;
+    unsigned int min_samples = mca_pml_ob1.adapt_min_samples;
+    size_t value = threshold->value, target = value;
+    mca_pml_ob1_adapt_stat_t *stat;
+    int lo, hi;
+
+    mca_pml_ob1_adapt_window (threshold, &lo, &hi);
+
+    /* the protocol above the threshold is cheaper just below it: move down */
+    stat = threshold->stats + (lo >= 0 ? lo : 0);
+    if (lo >= 0 && stat->count[0] >= min_samples && stat->count[1] >= min_samples &&
+        stat->cost[1] < MCA_PML_OB1_ADAPT_MARGIN * stat->cost[0]) {
+        target = mca_pml_ob1_adapt_clamp (threshold, (size_t) 1 << lo);
+    }
+
+    /* the protocol below the threshold is cheaper just above it: move up */
+    stat = threshold->stats + hi;
+    if (target == value && hi + 1 < MCA_PML_OB1_ADAPT_BUCKETS &&
+        stat->count[0] >= min_samples && stat->count[1] >= min_samples &&
+        stat->cost[0] < MCA_PML_OB1_ADAPT_MARGIN * stat->cost[1]) {
+        target = mca_pml_ob1_adapt_clamp (threshold, (size_t) 1 << (hi + 1));
+    }
+
+    if (target == value) {
+        return;
+    }
+
+    /* the buckets around the new threshold start over */
+    for (int i = (lo > 0 ? lo - 1 : 0) ; i <= hi + 1 && i < MCA_PML_OB1_ADAPT_BUCKETS ; ++i) {
+        threshold->stats[i].count[0] = threshold->stats[i].count[1] = 0;
+    }
+    threshold->value = target;
+    (void) OPAL_THREAD_ADD_FETCH64(&mca_pml_ob1_adapt_moves, 1);
+
+    opal_output_verbose (10, mca_pml_ob1_output, "pml:ob1: %s threshold of class %s moved from %"
+                         PRIsize_t " to %" PRIsize_t, MCA_PML_OB1_ADAPT_EAGER == index ? "eager" : "rdma",
+                         mca_pml_ob1_adapt_class_names[cls], value, target);
+}
+
+void mca_pml_ob1_adapt_record (mca_pml_ob1_adapt_sample_t *sample, size_t size)
+{
+    mca_pml_ob1_adapt_threshold_t *threshold = mca_pml_ob1_adapt_classes[sample->cls].thresholds +
+        sample->threshold;
+    mca_pml_ob1_adapt_stat_t *stat = threshold->stats + sample->bucket;
+    double cost = (double) (opal_timer_base_get_cycles () - sample->start) / (double) size;
+    int proto = sample->proto;
+
+    sample->threshold = MCA_PML_OB1_ADAPT_NONE;
+
+    /* the statistics are not protected: a lost or torn update only slows
+     * the learning down */
+    if (0 == stat->count[proto]) {
+        stat->cost[proto] = cost;
+    } else {
+        stat->cost[proto] += (cost - stat->cost[proto]) / 8.0;
+    }
+    ++stat->count[proto];
+
+    if ((int32_t) mca_pml_ob1.adapt_interval == OPAL_THREAD_ADD_FETCH32(&threshold->samples, 1)) {
+        mca_pml_ob1_adapt_evaluate (sample->cls, (int) (threshold - mca_pml_ob1_adapt_classes[sample->cls].thresholds));
+        (void) OPAL_THREAD_ADD_FETCH32(&threshold->samples, -(int32_t) mca_pml_ob1.adapt_interval);
+    }
+}
+
+size_t mca_pml_ob1_adapt_get_threshold (int cls, int threshold)
+{
+    mca_pml_ob1_adapt_class_t *class = mca_pml_ob1_adapt_classes + cls;
+
+    return class->ready ? class->thresholds[threshold].value : 0;
+}
+
+unsigned long long mca_pml_ob1_adapt_get_moves (void)
+{
+    return (unsigned long long) mca_pml_ob1_adapt_moves;
+}
+
+/* parse a list of one value per class, 0 or missing keeping the BTL value */
+static int mca_pml_ob1_adapt_parse (const char *list, int threshold)
+{
+    char **values;
+    int count;
+
+    if (NULL == list || '\0' == list[0]) {
+        return 0;
+    }
+
+    values = opal_argv_split (list, ',');
+    count = opal_argv_count (values);
+    if (count > MCA_PML_OB1_ADAPT_CLASSES) {
+        opal_output (0, "pml:ob1: ignoring the values after the third one of \"%s\"", list);
+        count = MCA_PML_OB1_ADAPT_CLASSES;
+    }
+    for (int i = 0 ; i < count ; ++i) {
+        mca_pml_ob1_adapt_classes[i].user[threshold] = (size_t) strtoull (values[i], NULL, 0);
+    }
+    opal_argv_free (values);
+
+    return count;
+}
+
+int mca_pml_ob1_adapt_init (void)
+{
+    int given;
+
+    memset (mca_pml_ob1_adapt_classes, 0, sizeof (mca_pml_ob1_adapt_classes));
+    mca_pml_ob1_adapt_moves = 0;
+
+    given = mca_pml_ob1_adapt_parse (mca_pml_ob1.adapt_eager_limits, MCA_PML_OB1_ADAPT_EAGER) +
+        mca_pml_ob1_adapt_parse (mca_pml_ob1.adapt_rdma_thresholds, MCA_PML_OB1_ADAPT_RDMA);
+
+    if (mca_pml_ob1.adapt_learn) {
+        mca_pml_ob1.adapt_mode = MCA_PML_OB1_ADAPT_LEARN;
+    } else if (given) {
+        mca_pml_ob1.adapt_mode = MCA_PML_OB1_ADAPT_FIXED;
+    } else {
+        mca_pml_ob1.adapt_mode = MCA_PML_OB1_ADAPT_OFF;
+    }
+
+    /* at least every other message must take the usual path */
+    if (mca_pml_ob1.adapt_explore < 2) {
+        mca_pml_ob1.adapt_explore = 2;
+    }
+    if (0 == mca_pml_ob1.adapt_interval) {
+        mca_pml_ob1.adapt_interval = 1;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+void mca_pml_ob1_adapt_fini (void)
+{
+    size_t values[2][MCA_PML_OB1_ADAPT_CLASSES];
+
+    if (MCA_PML_OB1_ADAPT_OFF == mca_pml_ob1.adapt_mode || !mca_pml_ob1.adapt_dump) {
+        return;
+    }
+
+    for (int i = 0 ; i < MCA_PML_OB1_ADAPT_CLASSES ; ++i) {
+        values[MCA_PML_OB1_ADAPT_EAGER][i] = mca_pml_ob1_adapt_get_threshold (i, MCA_PML_OB1_ADAPT_EAGER);
+        values[MCA_PML_OB1_ADAPT_RDMA][i] = mca_pml_ob1_adapt_get_threshold (i, MCA_PML_OB1_ADAPT_RDMA);
+    }
+
+    opal_output (0, "pml:ob1: %s thresholds (socket,node,remote; %llu moves): "
+                 "--mca pml_ob1_adaptive_eager_limits %" PRIsize_t ",%" PRIsize_t ",%" PRIsize_t
+                 " --mca pml_ob1_adaptive_rdma_thresholds %" PRIsize_t ",%" PRIsize_t ",%" PRIsize_t,
+                 OMPI_NAME_PRINT(OMPI_PROC_MY_NAME), mca_pml_ob1_adapt_get_moves (),
+                 values[0][0], values[0][1], values[0][2], values[1][0], values[1][1], values[1][2]);
+}
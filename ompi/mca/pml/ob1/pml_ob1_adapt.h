@@ -0,0 +1,121 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ * @file
+ *
+ * Adaptive protocol thresholds (opt-in, pml_ob1_adaptive).
+ *
+ * Two thresholds are kept for each class of peer (same socket, same node,
+ * remote): the eager limit, largest message sent eagerly, and the RDMA
+ * threshold, smallest contiguous rendezvous message that uses the RDMA
+ * protocol instead of the copy in/out pipeline. They start at the values
+ * the BTLs imply and stay within [pml_ob1_adaptive_min_eager_limit, BTL
+ * eager limit] and [BTL eager limit + 1,
+ * pml_ob1_adaptive_max_rdma_threshold].
+ *
+ * Every pml_ob1_adaptive_explore-th message whose size is within a power
+ * of two of a threshold goes the other way, and the time from the start
+ * of a standard send to its completion is sampled, per byte, for each
+ * protocol and power of two of size. Every pml_ob1_adaptive_interval
+ * samples the threshold moves by a power of two toward the protocol that
+ * was clearly cheaper around it.
+ *
+ * The thresholds are exported as MPI_T pvars and printed at finalize when
+ * pml_ob1_adaptive_dump is set, in a form that can be given back through
+ * pml_ob1_adaptive_eager_limits and pml_ob1_adaptive_rdma_thresholds to
+ * replay a run with them fixed.
+ */
+
+#ifndef MCA_PML_OB1_ADAPT_H
+#define MCA_PML_OB1_ADAPT_H
+
+#include "pml_ob1.h"
+#include "opal/mca/timer/base/base.h"
+#include "ompi/proc/proc.h"
+
+BEGIN_C_DECLS
+
+enum {
+    MCA_PML_OB1_ADAPT_OFF,           /**< the BTL limits are used as is */
+    MCA_PML_OB1_ADAPT_FIXED,         /**< the limits given by the user are used */
+    MCA_PML_OB1_ADAPT_LEARN,         /**< the limits are adjusted at runtime */
+};
+
+enum {
+    MCA_PML_OB1_ADAPT_SOCKET,
+    MCA_PML_OB1_ADAPT_NODE,
+    MCA_PML_OB1_ADAPT_REMOTE,
+    MCA_PML_OB1_ADAPT_CLASSES,
+};
+
+enum {
+    MCA_PML_OB1_ADAPT_EAGER,
+    MCA_PML_OB1_ADAPT_RDMA,
+    MCA_PML_OB1_ADAPT_NONE = 0xff,
+};
+
+/**
+ * Ongoing measure of a send request.
+ */
+struct mca_pml_ob1_adapt_sample_t {
+    opal_timer_t start;     /**< cycles at the first protocol decision */
+    uint8_t cls;            /**< class of the peer */
+    uint8_t threshold;      /**< threshold that decided, MCA_PML_OB1_ADAPT_NONE if not sampled */
+    uint8_t bucket;         /**< power of two of the size */
+    uint8_t proto;          /**< 0 below the threshold (eager, copy), 1 above (rendezvous, RDMA) */
+};
+typedef struct mca_pml_ob1_adapt_sample_t mca_pml_ob1_adapt_sample_t;
+
+/**
+ * Eager limit to use for a message of size bytes to proc, given the eager
+ * limit of the BTL. standard is true for MCA_PML_BASE_SEND_STANDARD, the
+ * only sends that are sampled.
+ */
+size_t mca_pml_ob1_adapt_eager_limit (mca_pml_ob1_adapt_sample_t *sample, ompi_proc_t *proc,
+                                      bool standard, size_t size, size_t eager_limit);
+
+/**
+ * Whether a contiguous rendezvous message of size bytes to proc should
+ * try the RDMA protocol.
+ */
+bool mca_pml_ob1_adapt_use_rdma (mca_pml_ob1_adapt_sample_t *sample, ompi_proc_t *proc,
+                                 bool standard, size_t size);
+
+/**
+ * Account a completed send request.
+ */
+void mca_pml_ob1_adapt_record (mca_pml_ob1_adapt_sample_t *sample, size_t size);
+
+/**
+ * Current value of a threshold of a class, 0 while no message has been
+ * sent to a peer of the class.
+ */
+size_t mca_pml_ob1_adapt_get_threshold (int cls, int threshold);
+
+/**
+ * Number of times a threshold moved.
+ */
+unsigned long long mca_pml_ob1_adapt_get_moves (void);
+
+/**
+ * Set the mode and the user values from the MCA parameters.
+ */
+int mca_pml_ob1_adapt_init (void);
+
+/**
+ * Print the thresholds if pml_ob1_adaptive_dump is set.
+ */
+void mca_pml_ob1_adapt_fini (void);
+
+END_C_DECLS
+
+#endif  /* MCA_PML_OB1_ADAPT_H */
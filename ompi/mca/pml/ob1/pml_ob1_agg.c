@@ -0,0 +1,276 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "opal/align.h"
+#include "opal/datatype/opal_convertor.h"
+#include "ompi/runtime/ompi_spc.h"
+#include "ompi/mca/bml/base/base.h"
+#include "pml_ob1.h"
+#include "pml_ob1_hdr.h"
+#include "pml_ob1_agg.h"
+
+static void mca_pml_ob1_agg_construct (mca_pml_ob1_agg_t *agg)
+{
+    OBJ_CONSTRUCT(&agg->lock, opal_mutex_t);
+    agg->bml_btl = NULL;
+    agg->des = NULL;
+    agg->size = 0;
+    agg->limit = 0;
+    agg->deadline = 0;
+    agg->queued = false;
+}
+
+static void mca_pml_ob1_agg_destruct (mca_pml_ob1_agg_t *agg)
+{
+    assert (NULL == agg->des);
+    OBJ_DESTRUCT(&agg->lock);
+}
+
+OBJ_CLASS_INSTANCE(mca_pml_ob1_agg_t, opal_list_item_t,
+                   mca_pml_ob1_agg_construct,
+                   mca_pml_ob1_agg_destruct);
+
+/* space taken in an aggregate by a message of size bytes */
+#define MCA_PML_OB1_AGG_RECORD_SIZE(size)                                       \
+    OPAL_ALIGN(sizeof (mca_pml_ob1_agg_hdr_t) + OMPI_PML_OB1_MATCH_HDR_LEN + (size), 8, size_t)
+
+static inline mca_pml_ob1_agg_t *mca_pml_ob1_agg_lookup (ompi_proc_t *proc)
+{
+    mca_pml_ob1_agg_t *agg = (mca_pml_ob1_agg_t *) proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_PML];
+
+    if (OPAL_UNLIKELY(NULL == agg)) {
+        intptr_t expected = 0;
+
+        agg = OBJ_NEW(mca_pml_ob1_agg_t);
+        if (!opal_atomic_compare_exchange_strong_ptr ((opal_atomic_intptr_t *) &proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_PML],
+                                                      &expected, (intptr_t) agg)) {
+            /* another thread was faster */
+            OBJ_RELEASE(agg);
+            agg = (mca_pml_ob1_agg_t *) expected;
+        }
+    }
+
+    return agg;
+}
+
+/* must be called with the lock of agg held */
+static int mca_pml_ob1_agg_flush_locked (mca_pml_ob1_agg_t *agg)
+{
+    mca_btl_base_descriptor_t *des = agg->des;
+    int rc;
+
+    des->des_segments[0].seg_len = agg->size;
+    rc = mca_bml_base_send (agg->bml_btl, des, MCA_PML_OB1_HDR_TYPE_MATCH);
+    if (OPAL_UNLIKELY(rc < 0)) {
+        /* the descriptor is still ours, the progress engine will try again */
+        return rc;
+    }
+
+    agg->des = NULL;
+    agg->size = 0;
+    return OMPI_SUCCESS;
+}
+
+/* must be called with the lock of agg held */
+static int mca_pml_ob1_agg_open_locked (mca_pml_ob1_agg_t *agg, mca_bml_base_endpoint_t *endpoint,
+                                        size_t record)
+{
+    mca_bml_base_btl_t *bml_btl = mca_bml_base_btl_array_get_next (&endpoint->btl_eager);
+    size_t limit = bml_btl->btl->btl_eager_limit;
+
+    if (limit > mca_pml_ob1.agg_size) {
+        limit = mca_pml_ob1.agg_size;
+    }
+    /* not worth it if the fragment cannot hold at least two messages */
+    if (OPAL_UNLIKELY(2 * record > limit)) {
+        return OMPI_ERR_NOT_AVAILABLE;
+    }
+
+    mca_bml_base_alloc (bml_btl, &agg->des, MCA_BTL_NO_ORDER, limit,
+                        MCA_BTL_DES_FLAGS_PRIORITY | MCA_BTL_DES_FLAGS_BTL_OWNERSHIP);
+    if (OPAL_UNLIKELY(NULL == agg->des)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    agg->bml_btl = bml_btl;
+    agg->size = 0;
+    agg->limit = limit;
+    agg->deadline = opal_timer_base_get_usec () + mca_pml_ob1.agg_delay;
+
+    if (!agg->queued) {
+        agg->queued = true;
+        OPAL_THREAD_LOCK(&mca_pml_ob1.agg_lock);
+        opal_list_append (&mca_pml_ob1.agg_pending, &agg->super);
+        OPAL_THREAD_UNLOCK(&mca_pml_ob1.agg_lock);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+int mca_pml_ob1_agg_send (const void *buf, size_t count, ompi_datatype_t *datatype,
+                          int tag, int16_t seqn, ompi_proc_t *dst_proc,
+                          mca_bml_base_endpoint_t *endpoint, ompi_communicator_t *comm)
+{
+    mca_pml_ob1_agg_t *agg = mca_pml_ob1_agg_lookup (dst_proc);
+    mca_pml_ob1_match_hdr_t *match;
+    mca_pml_ob1_agg_hdr_t *hdr;
+    opal_convertor_t convertor;
+    size_t size, record;
+    unsigned char *ptr;
+    int rc = OMPI_SUCCESS;
+
+    ompi_datatype_type_size (datatype, &size);
+    if ((size * count) > mca_pml_ob1.agg_max_message) {
+        mca_pml_ob1_agg_flush_proc (dst_proc);
+        return OMPI_ERR_NOT_AVAILABLE;
+    }
+
+    if (count > 0) {
+        /* We will create a convertor specialized for the        */
+        /* remote architecture and prepared with the datatype.   */
+        OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+        opal_convertor_copy_and_prepare_for_send (dst_proc->super.proc_convertor,
+                                                  (const struct opal_datatype_t *) datatype,
+                                                  count, buf, 0, &convertor);
+        opal_convertor_get_packed_size (&convertor, &size);
+    } else {
+        size = 0;
+    }
+    record = MCA_PML_OB1_AGG_RECORD_SIZE(size);
+
+    OPAL_THREAD_LOCK(&agg->lock);
+    if (NULL != agg->des && agg->size + record > agg->limit) {
+        rc = mca_pml_ob1_agg_flush_locked (agg);
+    }
+    if (OMPI_SUCCESS == rc && NULL == agg->des) {
+        rc = mca_pml_ob1_agg_open_locked (agg, endpoint, record);
+    }
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != rc)) {
+        OPAL_THREAD_UNLOCK(&agg->lock);
+        if (count > 0) {
+            opal_convertor_cleanup (&convertor);
+        }
+        return rc;
+    }
+
+    ptr = (unsigned char *) agg->des->des_segments[0].seg_addr.pval + agg->size;
+    hdr = (mca_pml_ob1_agg_hdr_t *) ptr;
+    match = (mca_pml_ob1_match_hdr_t *) (hdr + 1);
+
+    mca_pml_ob1_match_hdr_prepare (match, MCA_PML_OB1_HDR_TYPE_MATCH, 0,
+                                   comm->c_contextid, comm->c_my_rank,
+                                   tag, seqn);
+    ob1_hdr_hton(match, MCA_PML_OB1_HDR_TYPE_MATCH, dst_proc);
+
+    if (size > 0) {
+        struct iovec iov = {.iov_base = (IOVBASE_TYPE *) ((unsigned char *) match + OMPI_PML_OB1_MATCH_HDR_LEN),
+                            .iov_len = size};
+        uint32_t iov_count = 1;
+
+        (void) opal_convertor_pack (&convertor, &iov, &iov_count, &size);
+    }
+
+    mca_pml_ob1_agg_hdr_prepare (hdr, (uint32_t) (OMPI_PML_OB1_MATCH_HDR_LEN + size));
+#if OPAL_ENABLE_HETEROGENEOUS_SUPPORT
+    if (match->hdr_common.hdr_flags & MCA_PML_OB1_HDR_FLAGS_NBO) {
+        hdr->hdr_common.hdr_flags |= MCA_PML_OB1_HDR_FLAGS_NBO;
+        MCA_PML_OB1_AGG_HDR_HTON(*hdr);
+    }
+#endif
+    agg->size += record;
+
+    /* send it now if not even an empty message would fit anymore */
+    if (agg->size + MCA_PML_OB1_AGG_RECORD_SIZE(0) > agg->limit) {
+        (void) mca_pml_ob1_agg_flush_locked (agg);
+    }
+    OPAL_THREAD_UNLOCK(&agg->lock);
+
+#if SPC_ENABLE == 1
+    SPC_USER_OR_MPI(tag, (ompi_spc_value_t)size, OMPI_SPC_BYTES_SENT_USER, OMPI_SPC_BYTES_SENT_MPI);
+#endif
+
+    if (count > 0) {
+        opal_convertor_cleanup (&convertor);
+    }
+
+    return (int) size;
+}
+
+void mca_pml_ob1_agg_flush (mca_pml_ob1_agg_t *agg)
+{
+    OPAL_THREAD_LOCK(&agg->lock);
+    if (NULL != agg->des) {
+        (void) mca_pml_ob1_agg_flush_locked (agg);
+    }
+    OPAL_THREAD_UNLOCK(&agg->lock);
+}
+
+int mca_pml_ob1_agg_progress (void)
+{
+    mca_pml_ob1_agg_t *agg, *next;
+    opal_timer_t now;
+    int count = 0;
+
+    if (opal_list_is_empty (&mca_pml_ob1.agg_pending)) {
+        return 0;
+    }
+
+    now = opal_timer_base_get_usec ();
+
+    /* the senders lock a peer then the list: only try the peer locks here,
+     * a busy peer is being filled and will be looked at next time */
+    OPAL_THREAD_LOCK(&mca_pml_ob1.agg_lock);
+    OPAL_LIST_FOREACH_SAFE(agg, next, &mca_pml_ob1.agg_pending, mca_pml_ob1_agg_t) {
+        if (0 != OPAL_THREAD_TRYLOCK(&agg->lock)) {
+            continue;
+        }
+        if (NULL != agg->des && now >= agg->deadline &&
+            OMPI_SUCCESS == mca_pml_ob1_agg_flush_locked (agg)) {
+            ++count;
+        }
+        if (NULL == agg->des) {
+            opal_list_remove_item (&mca_pml_ob1.agg_pending, &agg->super);
+            agg->queued = false;
+        }
+        OPAL_THREAD_UNLOCK(&agg->lock);
+    }
+    OPAL_THREAD_UNLOCK(&mca_pml_ob1.agg_lock);
+
+    return count;
+}
+
+void mca_pml_ob1_agg_del_proc (ompi_proc_t *proc)
+{
+    mca_pml_ob1_agg_t *agg = (mca_pml_ob1_agg_t *) proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_PML];
+
+    if (NULL == agg) {
+        return;
+    }
+    proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_PML] = NULL;
+
+    OPAL_THREAD_LOCK(&agg->lock);
+    if (NULL != agg->des && OMPI_SUCCESS != mca_pml_ob1_agg_flush_locked (agg)) {
+        /* the peer is going away, drop what could not be sent */
+        mca_bml_base_free (agg->bml_btl, agg->des);
+        agg->des = NULL;
+    }
+    if (agg->queued) {
+        OPAL_THREAD_LOCK(&mca_pml_ob1.agg_lock);
+        opal_list_remove_item (&mca_pml_ob1.agg_pending, &agg->super);
+        OPAL_THREAD_UNLOCK(&mca_pml_ob1.agg_lock);
+    }
+    OPAL_THREAD_UNLOCK(&agg->lock);
+
+    OBJ_RELEASE(agg);
+}
@@ -0,0 +1,97 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ * @file
+ *
+ * Aggregation of small eager messages (opt-in, pml_ob1_aggregation_size).
+ *
+ * Consecutive small sends to the same peer are packed into one BTL
+ * fragment instead of being sent one by one. The data is copied, so the
+ * sends complete immediately. A fragment goes out when the next message
+ * does not fit, when a message to the peer takes another path (so it
+ * does not get ahead of the aggregated ones), or from the progress
+ * engine once the oldest message has waited pml_ob1_aggregation_delay
+ * microseconds. The receiver unpacks it in
+ * mca_pml_ob1_recv_frag_callback_match, each message being matched on
+ * its own.
+ */
+
+#ifndef MCA_PML_OB1_AGG_H
+#define MCA_PML_OB1_AGG_H
+
+#include "pml_ob1.h"
+#include "opal/mca/timer/base/base.h"
+#include "ompi/proc/proc.h"
+#include "ompi/mca/bml/bml.h"
+
+BEGIN_C_DECLS
+
+/**
+ * Aggregation state of one peer, hung off its ompi_proc_t.
+ */
+struct mca_pml_ob1_agg_t {
+    opal_list_item_t super;            /**< item of mca_pml_ob1.agg_pending */
+    opal_mutex_t lock;
+    mca_bml_base_btl_t *bml_btl;       /**< BTL of the fragment being filled */
+    mca_btl_base_descriptor_t *des;    /**< fragment being filled, NULL if none */
+    size_t size;                       /**< bytes used in des */
+    size_t limit;                      /**< capacity of des */
+    opal_timer_t deadline;             /**< time (usec) by which des must be sent */
+    bool queued;                       /**< on mca_pml_ob1.agg_pending */
+};
+typedef struct mca_pml_ob1_agg_t mca_pml_ob1_agg_t;
+
+OBJ_CLASS_DECLARATION(mca_pml_ob1_agg_t);
+
+/**
+ * Try to add a send to the aggregate of the peer.
+ *
+ * @return the size of the message if it was aggregated, an error
+ * otherwise. In that case anything already aggregated for the peer has
+ * been sent, and the message must take the regular path.
+ */
+int mca_pml_ob1_agg_send (const void *buf, size_t count, ompi_datatype_t *datatype,
+                          int tag, int16_t seqn, ompi_proc_t *dst_proc,
+                          mca_bml_base_endpoint_t *endpoint, ompi_communicator_t *comm);
+
+/**
+ * Send the aggregate of a peer, whatever its age.
+ */
+void mca_pml_ob1_agg_flush (mca_pml_ob1_agg_t *agg);
+
+/**
+ * Send the aggregates that are due. Registered with opal_progress when
+ * aggregation is enabled.
+ */
+int mca_pml_ob1_agg_progress (void);
+
+/**
+ * Send what is left for the peer and release its aggregation state.
+ */
+void mca_pml_ob1_agg_del_proc (ompi_proc_t *proc);
+
+/**
+ * Send the aggregate of proc, if any, before a message to it takes
+ * another path.
+ */
+static inline void mca_pml_ob1_agg_flush_proc (ompi_proc_t *proc)
+{
+    mca_pml_ob1_agg_t *agg = (mca_pml_ob1_agg_t *) proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_PML];
+
+    if (OPAL_UNLIKELY(NULL != agg && NULL != agg->des)) {
+        mca_pml_ob1_agg_flush (agg);
+    }
+}
+
+END_C_DECLS
+
+#endif  /* MCA_PML_OB1_AGG_H */
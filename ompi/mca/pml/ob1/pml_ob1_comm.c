@@ -25,6 +25,31 @@
 #include "pml_ob1.h"
 #include "pml_ob1_comm.h"
 
+#if !MCA_PML_OB1_CUSTOM_MATCH
+unsigned int mca_pml_ob1_match_mask = 0;
+
+static opal_list_t *mca_pml_ob1_match_queues_alloc (void)
+{
+    opal_list_t *queues = malloc ((mca_pml_ob1_match_mask + 1) * sizeof (opal_list_t));
+
+    if (NULL == queues) {
+        ompi_rte_abort (-1, "PML OB1 could not allocate its matching queues");
+    }
+    for (unsigned int i = 0 ; i <= mca_pml_ob1_match_mask ; ++i) {
+        OBJ_CONSTRUCT(queues + i, opal_list_t);
+    }
+
+    return queues;
+}
+
+static void mca_pml_ob1_match_queues_free (opal_list_t *queues)
+{
+    for (unsigned int i = 0 ; i <= mca_pml_ob1_match_mask ; ++i) {
+        OBJ_DESTRUCT(queues + i);
+    }
+    free (queues);
+}
+#endif
 
 
 static void mca_pml_ob1_comm_proc_construct(mca_pml_ob1_comm_proc_t* proc)
@@ -35,7 +60,13 @@ static void mca_pml_ob1_comm_proc_construct(mca_pml_ob1_comm_proc_t* proc)
     proc->frags_cant_match = NULL;
 #if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_CONSTRUCT(&proc->specific_receives, opal_list_t);
-    OBJ_CONSTRUCT(&proc->unexpected_frags, opal_list_t);
+    proc->specific_tagged = mca_pml_ob1_match_queues_alloc ();
+    proc->unexpected_frags = mca_pml_ob1_match_queues_alloc ();
+    proc->num_specific = 0;
+    proc->num_unexpected = 0;
+    proc->unexpected_order = 0;
+    OBJ_CONSTRUCT(&proc->matching_lock, opal_mutex_t);
+    memset (&proc->stats, 0, sizeof (proc->stats));
 #endif
 }
 
@@ -45,7 +76,9 @@ static void mca_pml_ob1_comm_proc_destruct(mca_pml_ob1_comm_proc_t* proc)
     assert(NULL == proc->frags_cant_match);
 #if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_DESTRUCT(&proc->specific_receives);
-    OBJ_DESTRUCT(&proc->unexpected_frags);
+    mca_pml_ob1_match_queues_free (proc->specific_tagged);
+    mca_pml_ob1_match_queues_free (proc->unexpected_frags);
+    OBJ_DESTRUCT(&proc->matching_lock);
 #endif
     if (proc->ompi_proc) {
         OBJ_RELEASE(proc->ompi_proc);
@@ -62,6 +95,7 @@ static void mca_pml_ob1_comm_construct(mca_pml_ob1_comm_t* comm)
 {
 #if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_CONSTRUCT(&comm->wild_receives, opal_list_t);
+    comm->wild_tagged = mca_pml_ob1_match_queues_alloc ();
 #else
     comm->prq = custom_match_prq_init();
     comm->umq = custom_match_umq_init();
@@ -69,9 +103,15 @@ static void mca_pml_ob1_comm_construct(mca_pml_ob1_comm_t* comm)
     OBJ_CONSTRUCT(&comm->matching_lock, opal_mutex_t);
     OBJ_CONSTRUCT(&comm->proc_lock, opal_mutex_t);
     comm->recv_sequence = 0;
+    comm->wild_posted = 0;
     comm->procs = NULL;
     comm->last_probed = 0;
     comm->num_procs = 0;
+    comm->num_posted = 0;
+    comm->num_unexpected = 0;
+    comm->max_posted = 0;
+    comm->max_unexpected = 0;
+    memset (&comm->stats, 0, sizeof (comm->stats));
 }
 
 
@@ -89,6 +129,7 @@ static void mca_pml_ob1_comm_destruct(mca_pml_ob1_comm_t* comm)
 
 #if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_DESTRUCT(&comm->wild_receives);
+    mca_pml_ob1_match_queues_free (comm->wild_tagged);
 #else
     custom_match_prq_destroy(comm->prq);
     custom_match_umq_destroy(comm->umq);
@@ -39,6 +39,19 @@ typedef struct mca_pml_ob1_comm_proc_t mca_pml_ob1_comm_proc_t;
 
 BEGIN_C_DECLS
 
+/**
+ * Matching statistics, exported as MPI_T performance variables. Kept
+ * per peer for the specific traffic and per communicator for the
+ * MPI_ANY_SOURCE receives, so that each is updated under the lock
+ * that already protects the queues.
+ */
+struct mca_pml_ob1_match_stats_t {
+    unsigned long long posted_searches;     /**< searches of the posted queues by incoming messages */
+    unsigned long long posted_scanned;      /**< receives inspected by these searches */
+    unsigned long long unexpected_searches; /**< searches of the unexpected queues by new receives */
+    unsigned long long unexpected_scanned;  /**< fragments inspected by these searches */
+};
+typedef struct mca_pml_ob1_match_stats_t mca_pml_ob1_match_stats_t;
 
 struct mca_pml_ob1_comm_proc_t {
     opal_object_t super;
@@ -47,8 +60,14 @@ struct mca_pml_ob1_comm_proc_t {
     opal_atomic_int32_t send_sequence; /**< send side sequence number */
     struct mca_pml_ob1_recv_frag_t* frags_cant_match;  /**< out-of-order fragment queues */
 #if !MCA_PML_OB1_CUSTOM_MATCH
-    opal_list_t specific_receives; /**< queues of unmatched specific receives */
-    opal_list_t unexpected_frags;  /**< unexpected fragment queues */
+    opal_list_t specific_receives; /**< queue of unmatched specific receives posted with MPI_ANY_TAG */
+    opal_list_t *specific_tagged;  /**< queues of the other unmatched specific receives, hashed on the tag */
+    opal_list_t *unexpected_frags; /**< unexpected fragment queues, hashed on the tag */
+    size_t num_specific;           /**< number of unmatched specific receives */
+    size_t num_unexpected;         /**< number of unexpected fragments */
+    size_t unexpected_order;       /**< arrival counter of unexpected fragments */
+    opal_mutex_t matching_lock;    /**< protects the matching state above (pml_ob1_match_per_peer) */
+    mca_pml_ob1_match_stats_t stats;
 #endif
 };
 
@@ -60,10 +79,13 @@ OBJ_CLASS_DECLARATION(mca_pml_ob1_comm_proc_t);
  */
 struct mca_pml_comm_t {
     opal_object_t super;
-    volatile uint32_t recv_sequence;  /**< recv request sequence number - receiver side */
+    opal_atomic_int32_t recv_sequence;  /**< recv request sequence number - receiver side */
     opal_mutex_t matching_lock;   /**< matching lock */
+    opal_atomic_int32_t wild_posted; /**< MPI_ANY_SOURCE receives posted or being posted */
 #if !MCA_PML_OB1_CUSTOM_MATCH
-    opal_list_t wild_receives;    /**< queue of unmatched wild (source process not specified) receives */
+    opal_list_t wild_receives;    /**< queue of unmatched wild (source process not specified) receives
+                                       posted with MPI_ANY_TAG */
+    opal_list_t *wild_tagged;     /**< queues of the other unmatched wild receives, hashed on the tag */
 #endif
     opal_mutex_t proc_lock;
     mca_pml_ob1_comm_proc_t **procs;
@@ -73,11 +95,32 @@ struct mca_pml_comm_t {
     custom_match_prq* prq;
     custom_match_umq* umq;
 #endif
+    /* matching statistics, exported as MPI_T performance variables */
+    opal_atomic_size_t num_posted;     /**< number of unmatched receives */
+    opal_atomic_size_t num_unexpected; /**< number of unexpected fragments */
+    size_t max_posted;                 /**< high watermark of num_posted */
+    size_t max_unexpected;             /**< high watermark of num_unexpected */
+    mca_pml_ob1_match_stats_t stats;   /**< MPI_ANY_SOURCE receives only, see the procs for the rest */
 };
 typedef struct mca_pml_comm_t mca_pml_ob1_comm_t;
 
 OBJ_CLASS_DECLARATION(mca_pml_ob1_comm_t);
 
+#if !MCA_PML_OB1_CUSTOM_MATCH
+/**
+ * Number of hash buckets of the tag-indexed matching queues minus one.
+ * Set from the pml_ob1_match_buckets MCA parameter, rounded up to a
+ * power of two. Zero gives one bucket, i.e. plain linear queues.
+ */
+extern unsigned int mca_pml_ob1_match_mask;
+
+static inline unsigned int mca_pml_ob1_match_bucket (int tag)
+{
+    /* spread consecutive tags (the common case) over consecutive buckets */
+    return (unsigned int) tag & mca_pml_ob1_match_mask;
+}
+#endif
+
 static inline mca_pml_ob1_comm_proc_t *mca_pml_ob1_peer_lookup (struct ompi_communicator_t *comm, int rank)
 {
     mca_pml_ob1_comm_t *pml_comm = (mca_pml_ob1_comm_t *)comm->c_pml_comm;
@@ -107,6 +150,50 @@ static inline mca_pml_ob1_comm_proc_t *mca_pml_ob1_peer_lookup (struct ompi_comm
     return pml_comm->procs[rank];
 }
 
+/**
+ * Lock the matching state of one peer of a communicator: its queues,
+ * its expected sequence number and its out-of-order fragments.
+ *
+ * With pml_ob1_match_per_peer this state is protected by a lock of the
+ * peer, so traffic with different peers is matched concurrently. The
+ * MPI_ANY_SOURCE queues belong to the communicator and may concern any
+ * peer: while such a receive is posted, or being posted (wild_posted is
+ * raised before the poster visits the peers, under their locks), the
+ * communicator lock is taken first. Returns whether it was.
+ */
+static inline bool mca_pml_ob1_matching_lock_peer (mca_pml_ob1_comm_t *comm,
+                                                   mca_pml_ob1_comm_proc_t *proc)
+{
+#if !MCA_PML_OB1_CUSTOM_MATCH
+    if (mca_pml_ob1_match_per_peer) {
+        OB1_MATCHING_LOCK(&proc->matching_lock);
+        if (OPAL_LIKELY(0 == comm->wild_posted)) {
+            return false;
+        }
+        OB1_MATCHING_UNLOCK(&proc->matching_lock);
+        OB1_MATCHING_LOCK(&comm->matching_lock);
+        OB1_MATCHING_LOCK(&proc->matching_lock);
+        return true;
+    }
+#endif
+    OB1_MATCHING_LOCK(&comm->matching_lock);
+    return true;
+}
+
+static inline void mca_pml_ob1_matching_unlock_peer (mca_pml_ob1_comm_t *comm,
+                                                     mca_pml_ob1_comm_proc_t *proc,
+                                                     bool comm_locked)
+{
+#if !MCA_PML_OB1_CUSTOM_MATCH
+    if (mca_pml_ob1_match_per_peer) {
+        OB1_MATCHING_UNLOCK(&proc->matching_lock);
+    }
+#endif
+    if (comm_locked) {
+        OB1_MATCHING_UNLOCK(&comm->matching_lock);
+    }
+}
+
 /**
  * Initialize an instance of mca_pml_ob1_comm_t based on the communicator size.
  *
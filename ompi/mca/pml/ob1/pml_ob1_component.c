@@ -37,12 +37,16 @@
 #include "pml_ob1_recvreq.h"
 #include "pml_ob1_rdmafrag.h"
 #include "pml_ob1_recvfrag.h"
+#include "pml_ob1_agg.h"
+#include "pml_ob1_adapt.h"
 #include "ompi/mca/bml/base/base.h"
 #include "pml_ob1_component.h"
 #include "opal/mca/allocator/base/base.h"
 #include "opal/mca/base/mca_base_pvar.h"
 #include "opal/runtime/opal_params.h"
+#include "opal/runtime/opal_progress.h"
 #include "opal/mca/btl/base/base.h"
+#include "opal/util/bit_ops.h"
 
 OBJ_CLASS_INSTANCE( mca_pml_ob1_pckt_pending_t,
                     opal_free_list_item_t,
@@ -58,6 +62,12 @@ mca_pml_ob1_component_init( int* priority, bool enable_progress_threads,
 static int mca_pml_ob1_component_fini(void);
 int mca_pml_ob1_output = 0;
 static int mca_pml_ob1_verbose = 0;
+#if !MCA_PML_OB1_CUSTOM_MATCH
+static unsigned int mca_pml_ob1_match_buckets = 1;
+bool mca_pml_ob1_match_per_peer = true;
+#else
+bool mca_pml_ob1_match_per_peer = false;
+#endif
 bool mca_pml_ob1_matching_protection = false;
 
 mca_pml_base_component_2_0_0_t mca_pml_ob1_component = {
@@ -155,7 +165,7 @@ static int mca_pml_ob1_get_unex_msgq_size (const struct mca_base_pvar_t *pvar, v
             values[i] = custom_match_umq_size(pml_comm->umq); // TODO: given the structure of custom match this does not make sense,
                                                      //       as we only have one set of queues.
 #else
-            values[i] = opal_list_get_size (&pml_proc->unexpected_frags);
+            values[i] = pml_proc->num_unexpected;
 #endif
         } else {
             values[i] = 0;
@@ -182,7 +192,7 @@ static int mca_pml_ob1_get_posted_recvq_size (const struct mca_base_pvar_t *pvar
             values[i] = custom_match_prq_size(pml_comm->prq); // TODO: given the structure of custom match this does not make sense,
                                                      //       as we only have one set of queues.
 #else
-            values[i] = opal_list_get_size (&pml_proc->specific_receives);
+            values[i] = pml_proc->num_specific;
 #endif
         } else {
             values[i] = 0;
@@ -192,6 +202,83 @@ static int mca_pml_ob1_get_posted_recvq_size (const struct mca_base_pvar_t *pvar
     return OMPI_SUCCESS;
 }
 
+static int mca_pml_ob1_get_posted_recvq_max (const struct mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    mca_pml_ob1_comm_t *pml_comm = ((ompi_communicator_t *) obj_handle)->c_pml_comm;
+
+    *(size_t *) value = pml_comm->max_posted;
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_ob1_get_unex_msgq_max (const struct mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    mca_pml_ob1_comm_t *pml_comm = ((ompi_communicator_t *) obj_handle)->c_pml_comm;
+
+    *(size_t *) value = pml_comm->max_unexpected;
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_ob1_get_match_stat (const struct mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    mca_pml_ob1_comm_t *pml_comm = ((ompi_communicator_t *) obj_handle)->c_pml_comm;
+    /* the offset of the counter in mca_pml_ob1_match_stats_t is the pvar context */
+    size_t offset = (uintptr_t) pvar->ctx;
+    unsigned long long total;
+
+    /* the MPI_ANY_SOURCE receives are accounted in the communicator, the
+     * rest in the peers */
+    total = *(unsigned long long *) ((char *) &pml_comm->stats + offset);
+#if !MCA_PML_OB1_CUSTOM_MATCH
+    for (size_t i = 0 ; i < pml_comm->num_procs ; ++i) {
+        mca_pml_ob1_comm_proc_t *pml_proc = pml_comm->procs[i];
+        if (pml_proc) {
+            total += *(unsigned long long *) ((char *) &pml_proc->stats + offset);
+        }
+    }
+#endif
+
+    *(unsigned long long *) value = total;
+    return OMPI_SUCCESS;
+}
+
+static void mca_pml_ob1_register_match_stat (const char *name, const char *desc, size_t offset)
+{
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           name, desc, OPAL_INFO_LVL_4, MPI_T_PVAR_CLASS_COUNTER,
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL, MPI_T_BIND_MPI_COMM,
+                                           MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_match_stat, NULL, NULL, (void *) offset);
+}
+
+static int mca_pml_ob1_adapt_class_notify (mca_base_pvar_t *pvar, mca_base_pvar_event_t event, void *obj_handle, int *count)
+{
+    if (MCA_BASE_PVAR_HANDLE_BIND == event) {
+        /* one value per class of peer */
+        *count = MCA_PML_OB1_ADAPT_CLASSES;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_ob1_get_adapt_threshold (const struct mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    /* the threshold is the pvar context */
+    int threshold = (int) (uintptr_t) pvar->ctx;
+    size_t *values = (size_t *) value;
+
+    for (int i = 0 ; i < MCA_PML_OB1_ADAPT_CLASSES ; ++i) {
+        values[i] = mca_pml_ob1_adapt_get_threshold (i, threshold);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static int mca_pml_ob1_get_adapt_moves (const struct mca_base_pvar_t *pvar, void *value, void *obj_handle)
+{
+    *(unsigned long long *) value = mca_pml_ob1_adapt_get_moves ();
+    return OMPI_SUCCESS;
+}
+
 static int mca_pml_ob1_component_register(void)
 {
     mca_pml_ob1_param_register_int("verbose", 0, &mca_pml_ob1_verbose);
@@ -214,6 +301,81 @@ static int mca_pml_ob1_component_register(void)
 
     mca_pml_ob1_param_register_uint("unexpected_limit", 128, &mca_pml_ob1.unexpected_limit);
 
+    mca_pml_ob1.agg_size = 0;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "aggregation_size",
+                                           "Size of the fragments that aggregate consecutive small sends to the "
+                                           "same peer (capped by the eager limit of the BTL). 0 sends every message "
+                                           "on its own (default: 0)", MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.agg_size);
+    mca_pml_ob1.agg_max_message = 128;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "aggregation_max_message",
+                                           "Largest message that is aggregated when pml_ob1_aggregation_size is "
+                                           "set (default: 128)", MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.agg_max_message);
+    mca_pml_ob1.agg_delay = 0;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "aggregation_delay",
+                                           "Longest time (in microseconds) an aggregated message waits for others "
+                                           "before being sent by the progress engine. 0 sends the aggregate at the "
+                                           "next progress call (default: 0)", MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.agg_delay);
+
+    mca_pml_ob1.adapt_learn = false;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive",
+                                           "Adjust the eager limit and the RDMA threshold of each class of peer "
+                                           "(same socket, same node, remote) at runtime from the measured cost of "
+                                           "the protocols around them (default: false)", MCA_BASE_VAR_TYPE_BOOL,
+                                           NULL, 0, 0, OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_pml_ob1.adapt_learn);
+    mca_pml_ob1.adapt_eager_limits = NULL;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_eager_limits",
+                                           "Comma separated eager limits (in bytes, without the header) for "
+                                           "peers on the same socket, on the same node and remote. 0 keeps the "
+                                           "limit of the BTL. They are used as is unless pml_ob1_adaptive is set, "
+                                           "in which case they are the starting point (default: none)",
+                                           MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_eager_limits);
+    mca_pml_ob1.adapt_rdma_thresholds = NULL;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_rdma_thresholds",
+                                           "Comma separated sizes (in bytes) from which contiguous rendezvous "
+                                           "messages use RDMA instead of the copy in/out pipeline, for peers on "
+                                           "the same socket, on the same node and remote. 0 uses RDMA whenever "
+                                           "possible. Same rules as pml_ob1_adaptive_eager_limits (default: none)",
+                                           MCA_BASE_VAR_TYPE_STRING, NULL, 0, 0, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_rdma_thresholds);
+    mca_pml_ob1.adapt_dump = false;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_dump",
+                                           "Print the thresholds in use at finalize, as the parameters that "
+                                           "replay them (default: false)", MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_dump);
+    mca_pml_ob1.adapt_explore = 16;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_explore",
+                                           "With pml_ob1_adaptive, one message in this many of the sizes around a "
+                                           "threshold is sent with the other protocol to measure it (minimum 2, "
+                                           "default: 16)", MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_explore);
+    mca_pml_ob1.adapt_interval = 256;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_interval",
+                                           "With pml_ob1_adaptive, number of samples between two evaluations "
+                                           "of a threshold (default: 256)", MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL,
+                                           0, 0, OPAL_INFO_LVL_6, MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_pml_ob1.adapt_interval);
+    mca_pml_ob1.adapt_min_samples = 8;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_min_samples",
+                                           "With pml_ob1_adaptive, number of samples of each protocol needed "
+                                           "before a threshold moves (default: 8)", MCA_BASE_VAR_TYPE_UNSIGNED_INT,
+                                           NULL, 0, 0, OPAL_INFO_LVL_6, MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_pml_ob1.adapt_min_samples);
+    mca_pml_ob1.adapt_min_eager_limit = 256;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_min_eager_limit",
+                                           "Lowest eager limit pml_ob1_adaptive may set (default: 256)",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0, OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_min_eager_limit);
+    mca_pml_ob1.adapt_max_rdma_threshold = 4 * 1024 * 1024;
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "adaptive_max_rdma_threshold",
+                                           "Highest RDMA threshold pml_ob1_adaptive may set (default: 4194304)",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0, OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.adapt_max_rdma_threshold);
+
     mca_pml_ob1.use_all_rdma = false;
     (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "use_all_rdma",
                                            "Use all available RDMA btls for the RDMA and RDMA pipeline protocols "
@@ -239,6 +401,80 @@ static int mca_pml_ob1_component_register(void)
                                            MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
                                            mca_pml_ob1_get_posted_recvq_size, NULL, mca_pml_ob1_comm_size_notify, NULL);
 
+#if !MCA_PML_OB1_CUSTOM_MATCH
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "match_buckets",
+                                           "Number of tag hash buckets of each posted receive and unexpected "
+                                           "message queue, rounded up to a power of two. 1 keeps a single "
+                                           "linear queue per peer; more buckets shorten the searches when many "
+                                           "distinct tags are outstanding, at the cost of memory per peer "
+                                           "(default: 1)", MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1_match_buckets);
+    if (mca_pml_ob1_match_buckets < 1) {
+        mca_pml_ob1_match_buckets = 1;
+    } else if (mca_pml_ob1_match_buckets > (1 << 16)) {
+        mca_pml_ob1_match_buckets = 1 << 16;
+    }
+    mca_pml_ob1_match_mask = (unsigned int) opal_next_poweroftwo_inclusive ((int) mca_pml_ob1_match_buckets) - 1;
+
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "match_per_peer",
+                                           "Protect the matching state of each peer of a communicator with its "
+                                           "own lock, so that threads receiving from different peers match "
+                                           "concurrently. MPI_ANY_SOURCE receives still serialize on the "
+                                           "communicator while they are posted. When false a single lock per "
+                                           "communicator is used (default: true)", MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1_match_per_peer);
+#endif
+
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           "posted_recvq_max_length", "Largest number of unmatched receives "
+                                           "posted at the same time in a communicator", OPAL_INFO_LVL_4,
+                                           MPI_T_PVAR_CLASS_HIGHWATERMARK, MCA_BASE_VAR_TYPE_SIZE_T, NULL,
+                                           MPI_T_BIND_MPI_COMM, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_posted_recvq_max, NULL, NULL, NULL);
+
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           "unexpected_msgq_max_length", "Largest number of unexpected messages "
+                                           "queued at the same time in a communicator", OPAL_INFO_LVL_4,
+                                           MPI_T_PVAR_CLASS_HIGHWATERMARK, MCA_BASE_VAR_TYPE_SIZE_T, NULL,
+                                           MPI_T_BIND_MPI_COMM, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_unex_msgq_max, NULL, NULL, NULL);
+
+    mca_pml_ob1_register_match_stat ("posted_recvq_searches", "Number of searches of the posted receive "
+                                     "queues by incoming messages in a communicator",
+                                     offsetof (mca_pml_ob1_match_stats_t, posted_searches));
+    mca_pml_ob1_register_match_stat ("posted_recvq_search_length", "Number of posted receives inspected "
+                                     "by the searches of the posted receive queues in a communicator",
+                                     offsetof (mca_pml_ob1_match_stats_t, posted_scanned));
+    mca_pml_ob1_register_match_stat ("unexpected_msgq_searches", "Number of searches of the unexpected "
+                                     "message queues by new receives in a communicator",
+                                     offsetof (mca_pml_ob1_match_stats_t, unexpected_searches));
+    mca_pml_ob1_register_match_stat ("unexpected_msgq_search_length", "Number of unexpected messages "
+                                     "inspected by the searches of the unexpected message queues in a "
+                                     "communicator", offsetof (mca_pml_ob1_match_stats_t, unexpected_scanned));
+
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           "adaptive_eager_limit", "Eager limit in use for peers on the same "
+                                           "socket, on the same node and remote (0 until a message is sent to "
+                                           "such a peer)", OPAL_INFO_LVL_4, MPI_T_PVAR_CLASS_SIZE,
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, MPI_T_BIND_NO_OBJECT,
+                                           MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_adapt_threshold, NULL, mca_pml_ob1_adapt_class_notify,
+                                           (void *) (uintptr_t) MCA_PML_OB1_ADAPT_EAGER);
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           "adaptive_rdma_threshold", "RDMA threshold in use for peers on the "
+                                           "same socket, on the same node and remote (0 until a message is sent "
+                                           "to such a peer)", OPAL_INFO_LVL_4, MPI_T_PVAR_CLASS_SIZE,
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, MPI_T_BIND_NO_OBJECT,
+                                           MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_adapt_threshold, NULL, mca_pml_ob1_adapt_class_notify,
+                                           (void *) (uintptr_t) MCA_PML_OB1_ADAPT_RDMA);
+    (void)mca_base_component_pvar_register(&mca_pml_ob1_component.pmlm_version,
+                                           "adaptive_moves", "Number of times pml_ob1_adaptive moved a "
+                                           "threshold", OPAL_INFO_LVL_4, MPI_T_PVAR_CLASS_COUNTER,
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL, MPI_T_BIND_NO_OBJECT,
+                                           MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                           mca_pml_ob1_get_adapt_moves, NULL, NULL, NULL);
+
     return OMPI_SUCCESS;
 }
 
@@ -248,6 +484,7 @@ static int mca_pml_ob1_component_open(void)
     opal_output_set_verbosity(mca_pml_ob1_output, mca_pml_ob1_verbose);
 
     mca_pml_ob1.enabled = false;
+    (void) mca_pml_ob1_adapt_init ();
     return mca_base_framework_open(&ompi_bml_base_framework, 0);
 }
 
@@ -333,6 +570,8 @@ int mca_pml_ob1_component_fini(void)
     }
     mca_pml_ob1.enabled = false;  /* not anymore */
 
+    mca_pml_ob1_adapt_fini ();
+
     /* return the static receive/send requests to the respective free list and
      * let the free list handle destruction. */
     if( NULL != mca_pml_ob1_recvreq ) {
@@ -345,6 +584,11 @@ int mca_pml_ob1_component_fini(void)
         mca_pml_ob1_sendreq = NULL;
     }
 
+    if (0 != mca_pml_ob1.agg_size) {
+        opal_progress_unregister (mca_pml_ob1_agg_progress);
+    }
+    OBJ_DESTRUCT(&mca_pml_ob1.agg_pending);
+    OBJ_DESTRUCT(&mca_pml_ob1.agg_lock);
     OBJ_DESTRUCT(&mca_pml_ob1.rdma_pending);
     OBJ_DESTRUCT(&mca_pml_ob1.pckt_pending);
     OBJ_DESTRUCT(&mca_pml_ob1.recv_pending);
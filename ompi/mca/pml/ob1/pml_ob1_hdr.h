@@ -56,6 +56,7 @@
 #define MCA_PML_OB1_HDR_FLAGS_CONTIG  8  /* is user buffer contiguous */
 #define MCA_PML_OB1_HDR_FLAGS_NORDMA  16 /* rest will be send by copy-in-out */
 #define MCA_PML_OB1_HDR_FLAGS_SIGNAL  32 /* message can be optionally signalling */
+#define MCA_PML_OB1_HDR_FLAGS_AGG     64 /* fragment aggregates several match messages */
 
 /**
  * Common hdr attributes - must be first element in each hdr type
@@ -413,6 +414,40 @@ static inline void mca_pml_ob1_fin_hdr_prepare (mca_pml_ob1_fin_hdr_t *hdr, uint
         (h).hdr_size = hton64((h).hdr_size);         \
     } while (0)
 
+/**
+ *  Header of each message packed in an aggregated fragment. The fragment
+ *  is sent with the MATCH tag and is a sequence of such records, each
+ *  aligned on 8 bytes: this header (with MCA_PML_OB1_HDR_FLAGS_AGG set),
+ *  then hdr_len bytes holding a match header and the message data.
+ */
+struct mca_pml_ob1_agg_hdr_t {
+    mca_pml_ob1_common_hdr_t hdr_common;   /**< common attributes */
+    uint8_t  hdr_padding[2];
+    uint32_t hdr_len;                      /**< length of the match header and data that follow */
+};
+typedef struct mca_pml_ob1_agg_hdr_t mca_pml_ob1_agg_hdr_t;
+
+static inline void mca_pml_ob1_agg_hdr_prepare (mca_pml_ob1_agg_hdr_t *hdr, uint32_t hdr_len)
+{
+    mca_pml_ob1_common_hdr_prepare (&hdr->hdr_common, MCA_PML_OB1_HDR_TYPE_MATCH,
+                                    MCA_PML_OB1_HDR_FLAGS_AGG);
+    hdr->hdr_padding[0] = 0;
+    hdr->hdr_padding[1] = 0;
+    hdr->hdr_len = hdr_len;
+}
+
+#define MCA_PML_OB1_AGG_HDR_NTOH(h)                  \
+    do {                                             \
+        MCA_PML_OB1_COMMON_HDR_NTOH((h).hdr_common); \
+        (h).hdr_len = ntohl((h).hdr_len);            \
+    } while (0)
+
+#define MCA_PML_OB1_AGG_HDR_HTON(h)                  \
+    do {                                             \
+        MCA_PML_OB1_COMMON_HDR_HTON((h).hdr_common); \
+        (h).hdr_len = htonl((h).hdr_len);            \
+    } while (0)
+
 /**
  * Union of defined hdr types.
  */
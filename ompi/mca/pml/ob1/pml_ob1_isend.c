@@ -70,6 +70,8 @@ int mca_pml_ob1_isend_init(const void *buf,
      * allows us to detect this state. */
     sendreq->req_send.req_base.req_pml_complete = true;
 
+    mca_pml_ob1_send_request_persist_prepare (sendreq);
+
     *request = (ompi_request_t *) sendreq;
     return OMPI_SUCCESS;
 }
@@ -169,8 +171,15 @@ int mca_pml_ob1_isend(const void *buf,
     }
 
     if (MCA_PML_BASE_SEND_SYNCHRONOUS != sendmode) {
-        rc = mca_pml_ob1_send_inline (buf, count, datatype, dst, tag, seqn, dst_proc,
-                                      endpoint, comm);
+        rc = OMPI_ERR_NOT_AVAILABLE;
+        if (OPAL_UNLIKELY(0 != mca_pml_ob1.agg_size)) {
+            rc = mca_pml_ob1_agg_send (buf, count, datatype, tag, seqn, dst_proc,
+                                       endpoint, comm);
+        }
+        if (rc < 0) {
+            rc = mca_pml_ob1_send_inline (buf, count, datatype, dst, tag, seqn, dst_proc,
+                                          endpoint, comm);
+        }
         if (OPAL_LIKELY(0 <= rc)) {
             /* NTH: it is legal to return ompi_request_empty since the only valid
              * field in a send completion status is whether or not the send was
@@ -243,8 +252,15 @@ int mca_pml_ob1_send(const void *buf,
      * the parallel application.
      */
     if (MCA_PML_BASE_SEND_SYNCHRONOUS != sendmode) {
-        rc = mca_pml_ob1_send_inline (buf, count, datatype, dst, tag, seqn, dst_proc,
-                                      endpoint, comm);
+        rc = OMPI_ERR_NOT_AVAILABLE;
+        if (OPAL_UNLIKELY(0 != mca_pml_ob1.agg_size)) {
+            rc = mca_pml_ob1_agg_send (buf, count, datatype, tag, seqn, dst_proc,
+                                       endpoint, comm);
+        }
+        if (rc < 0) {
+            rc = mca_pml_ob1_send_inline (buf, count, datatype, dst, tag, seqn, dst_proc,
+                                          endpoint, comm);
+        }
         if (OPAL_LIKELY(0 <= rc)) {
             return OMPI_SUCCESS;
         }
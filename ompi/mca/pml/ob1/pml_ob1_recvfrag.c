@@ -36,6 +36,7 @@
 #include "opal/class/opal_list.h"
 #include "opal/mca/threads/mutex.h"
 #include "opal/prefetch.h"
+#include "opal/align.h"
 
 #include "ompi/constants.h"
 #include "ompi/communicator/communicator.h"
@@ -308,6 +309,8 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
  * @param segments (IN)             Received recv_frag descriptor.
  * @param num_segments (IN)         Flag indicating wether a match was made.
  * @param type (IN)                 Type of the message header.
+ * @param comm_locked (IN)          Whether the communicator matching lock is held
+ *                                  (see mca_pml_ob1_matching_lock_peer).
  * @return                          OMPI_SUCCESS or error status on failure.
  */
 static int
@@ -318,14 +321,16 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
                                   const mca_btl_base_segment_t *segments,
                                   size_t num_segments,
                                   int type,
-                                  mca_pml_ob1_recv_frag_t *frag);
+                                  mca_pml_ob1_recv_frag_t *frag,
+                                  bool comm_locked);
 
 static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
                                               const mca_pml_ob1_match_hdr_t *hdr,
                                               const mca_btl_base_segment_t *segments,
                                               size_t num_segments, ompi_communicator_t *comm_ptr,
                                               mca_pml_ob1_comm_proc_t *proc,
-                                              mca_pml_ob1_recv_frag_t *frag);
+                                              mca_pml_ob1_recv_frag_t *frag,
+                                              bool comm_locked);
 
 mca_pml_ob1_recv_frag_t *check_cantmatch_for_match (mca_pml_ob1_comm_proc_t *proc)
 {
@@ -337,17 +342,19 @@ mca_pml_ob1_recv_frag_t *check_cantmatch_for_match (mca_pml_ob1_comm_proc_t *pro
     return NULL;
 }
 
-void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
-                                           const mca_btl_base_receive_descriptor_t *descriptor)
+/* match one eager message, either a whole fragment or one record of an
+ * aggregated fragment */
+static inline void mca_pml_ob1_recv_frag_match_msg (mca_btl_base_module_t *btl,
+                                                    const mca_btl_base_segment_t *segments,
+                                                    size_t num_segments)
 {
-    const mca_btl_base_segment_t *segments = descriptor->des_segments;
     const mca_pml_ob1_match_hdr_t *hdr = (const mca_pml_ob1_match_hdr_t *) segments->seg_addr.pval;
     ompi_communicator_t *comm_ptr;
     mca_pml_ob1_recv_request_t *match = NULL;
     mca_pml_ob1_comm_t *comm;
     mca_pml_ob1_comm_proc_t *proc;
-    size_t num_segments = descriptor->des_segment_count;
     size_t bytes_received = 0;
+    bool comm_locked;
 
     assert(num_segments <= MCA_BTL_DES_MAX_SEGMENTS);
 
@@ -391,7 +398,7 @@ void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
      * end points) from being processed, and potentially "loosing"
      * the fragment.
      */
-    OB1_MATCHING_LOCK(&comm->matching_lock);
+    comm_locked = mca_pml_ob1_matching_lock_peer(comm, proc);
 
     if (!OMPI_COMM_CHECK_ASSERT_ALLOW_OVERTAKE(comm_ptr)) {
         /* get sequence number of next message that can be processed.
@@ -404,7 +411,7 @@ void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
             MCA_PML_OB1_RECV_FRAG_INIT(frag, hdr, segments, num_segments, btl);
             append_frag_to_ordered_list(&proc->frags_cant_match, frag, proc->expected_sequence);
             SPC_RECORD(OMPI_SPC_OUT_OF_SEQUENCE, 1);
-            OB1_MATCHING_UNLOCK(&comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
             return;
         }
 
@@ -419,7 +426,7 @@ void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
     PERUSE_TRACE_MSG_EVENT(PERUSE_COMM_SEARCH_POSTED_Q_BEGIN, comm_ptr,
                            hdr->hdr_src, hdr->hdr_tag, PERUSE_RECV);
 
-    match = match_one(btl, hdr, segments, num_segments, comm_ptr, proc, NULL);
+    match = match_one(btl, hdr, segments, num_segments, comm_ptr, proc, NULL, comm_locked);
 
     /* The match is over. We generate the SEARCH_POSTED_Q_END here,
      * before going into check_cantmatch_for_match so we can make
@@ -429,7 +436,7 @@ void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
                            hdr->hdr_src, hdr->hdr_tag, PERUSE_RECV);
 
     /* release matching lock before processing fragment */
-    OB1_MATCHING_UNLOCK(&comm->matching_lock);
+    mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
 
     if(OPAL_LIKELY(match)) {
         bytes_received = segments->seg_len - OMPI_PML_OB1_MATCH_HDR_LEN;
@@ -492,25 +499,79 @@ void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
      *
      * NOTE:
      * To optimize the number of lock used, mca_pml_ob1_recv_frag_match_proc()
-     * MUST be called with communicator lock and will RELEASE the lock. This is
+     * MUST be called with the peer matching lock and will RELEASE the lock. This is
      * not ideal but it is better for the performance.
      */
     if(NULL != proc->frags_cant_match) {
         mca_pml_ob1_recv_frag_t* frag;
 
-        OB1_MATCHING_LOCK(&comm->matching_lock);
+        comm_locked = mca_pml_ob1_matching_lock_peer(comm, proc);
         if((frag = check_cantmatch_for_match(proc))) {
             /* mca_pml_ob1_recv_frag_match_proc() will release the lock. */
             mca_pml_ob1_recv_frag_match_proc(frag->btl, comm_ptr, proc,
                                              &frag->hdr.hdr_match,
                                              frag->segments, frag->num_segments,
-                                             frag->hdr.hdr_match.hdr_common.hdr_type, frag);
+                                             frag->hdr.hdr_match.hdr_common.hdr_type, frag,
+                                             comm_locked);
         } else {
-            OB1_MATCHING_UNLOCK(&comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
+        }
+    }
+}
+
+/* unpack the messages of a fragment built by pml_ob1_agg.c */
+static void mca_pml_ob1_recv_frag_match_agg (mca_btl_base_module_t *btl,
+                                             const mca_btl_base_segment_t *segments,
+                                             size_t num_segments)
+{
+    unsigned char *ptr = (unsigned char *) segments->seg_addr.pval;
+    size_t offset = 0, length = segments->seg_len;
+
+    /* the sender packs the aggregate in a single segment */
+    assert (1 == num_segments);
+
+    while (offset + sizeof (mca_pml_ob1_agg_hdr_t) <= length) {
+        mca_pml_ob1_agg_hdr_t *hdr = (mca_pml_ob1_agg_hdr_t *) (ptr + offset);
+        mca_btl_base_segment_t segment;
+
+#if !defined(WORDS_BIGENDIAN) && OPAL_ENABLE_HETEROGENEOUS_SUPPORT
+        if (hdr->hdr_common.hdr_flags & MCA_PML_OB1_HDR_FLAGS_NBO) {
+            MCA_PML_OB1_AGG_HDR_NTOH(*hdr);
         }
+#endif
+        if (OPAL_UNLIKELY(offset + sizeof (*hdr) + hdr->hdr_len > length)) {
+            break;
+        }
+
+        segment.seg_addr.pval = (void *) (hdr + 1);
+        segment.seg_len = hdr->hdr_len;
+        mca_pml_ob1_recv_frag_match_msg (btl, &segment, 1);
+
+        offset += OPAL_ALIGN(sizeof (*hdr) + hdr->hdr_len, 8, size_t);
     }
 }
 
+void mca_pml_ob1_recv_frag_callback_match (mca_btl_base_module_t *btl,
+                                           const mca_btl_base_receive_descriptor_t *descriptor)
+{
+    const mca_btl_base_segment_t *segments = descriptor->des_segments;
+    size_t num_segments = descriptor->des_segment_count;
+    const mca_pml_ob1_common_hdr_t *hdr = (const mca_pml_ob1_common_hdr_t *) segments->seg_addr.pval;
+
+    assert(num_segments <= MCA_BTL_DES_MAX_SEGMENTS);
+
+    if (OPAL_UNLIKELY(segments->seg_len < sizeof (mca_pml_ob1_common_hdr_t))) {
+        return;
+    }
+
+    if (OPAL_UNLIKELY(hdr->hdr_flags & MCA_PML_OB1_HDR_FLAGS_AGG)) {
+        mca_pml_ob1_recv_frag_match_agg (btl, segments, num_segments);
+        return;
+    }
+
+    mca_pml_ob1_recv_frag_match_msg (btl, segments, num_segments);
+}
+
 
 void mca_pml_ob1_recv_frag_callback_rndv (mca_btl_base_module_t *btl,
                                           const mca_btl_base_receive_descriptor_t *descriptor)
@@ -673,73 +734,85 @@ void mca_pml_ob1_recv_frag_callback_fin(mca_btl_base_module_t *btl,
 
 #define PML_MAX_SEQ ~((mca_pml_sequence_t)0);
 
-static inline mca_pml_ob1_recv_request_t* get_posted_recv(opal_list_t *queue)
+#if !MCA_PML_OB1_CUSTOM_MATCH
+/* first receive of a tag bucket that matches tag exactly */
+static inline mca_pml_ob1_recv_request_t *get_posted_recv_tagged (opal_list_t *queue, int tag,
+                                                                  mca_pml_ob1_match_stats_t *stats)
 {
-    if(opal_list_get_size(queue) == 0)
-        return NULL;
+    mca_pml_ob1_recv_request_t *recv_req;
+
+    OPAL_LIST_FOREACH(recv_req, queue, mca_pml_ob1_recv_request_t) {
+        ++stats->posted_scanned;
+        if (recv_req->req_recv.req_base.req_tag == tag) {
+            return recv_req;
+        }
+    }
 
-    return (mca_pml_ob1_recv_request_t*)opal_list_get_first(queue);
+    return NULL;
 }
 
-static inline mca_pml_ob1_recv_request_t* get_next_posted_recv(
-        opal_list_t *queue,
-        mca_pml_ob1_recv_request_t* req)
+/* first receive of a MPI_ANY_TAG queue, which matches any user tag */
+static inline mca_pml_ob1_recv_request_t *get_posted_recv_any_tag (opal_list_t *queue, int tag)
 {
-    opal_list_item_t *i = opal_list_get_next((opal_list_item_t*)req);
-
-    if(opal_list_get_end(queue) == i)
+    if (tag < 0 || 0 == opal_list_get_size (queue)) {
         return NULL;
+    }
+
+    return (mca_pml_ob1_recv_request_t *) opal_list_get_first (queue);
+}
 
-    return (mca_pml_ob1_recv_request_t*)i;
+/*
+ * Receives are posted on four kinds of queues: the MPI_ANY_TAG queue and
+ * the tag buckets of the peer, and the same two for MPI_ANY_SOURCE. Each
+ * queue is in posting order, so the receive that MPI ordering selects is
+ * the matching candidate with the lowest sequence number among the (up
+ * to) four queue candidates.
+ */
+static inline void select_posted_recv (mca_pml_ob1_recv_request_t *candidate, opal_list_t *queue,
+                                       mca_pml_ob1_recv_request_t **match, opal_list_t **match_queue)
+{
+    if (NULL != candidate && (NULL == *match || candidate->req_recv.req_base.req_sequence <
+                              (*match)->req_recv.req_base.req_sequence)) {
+        *match = candidate;
+        *match_queue = queue;
+    }
 }
+#endif
 
 static mca_pml_ob1_recv_request_t *match_incomming(const mca_pml_ob1_match_hdr_t *hdr,
                                                    mca_pml_ob1_comm_t *comm,
                                                    mca_pml_ob1_comm_proc_t *proc)
 {
 #if !MCA_PML_OB1_CUSTOM_MATCH
-    mca_pml_ob1_recv_request_t *specific_recv, *wild_recv;
-    mca_pml_sequence_t wild_recv_seq, specific_recv_seq;
+    mca_pml_ob1_recv_request_t *match = NULL;
+    opal_list_t *queue = NULL, *bucket;
     int tag = hdr->hdr_tag;
 
-    specific_recv = get_posted_recv(&proc->specific_receives);
-    wild_recv = get_posted_recv(&comm->wild_receives);
-
-    wild_recv_seq = wild_recv ?
-        wild_recv->req_recv.req_base.req_sequence : PML_MAX_SEQ;
-    specific_recv_seq = specific_recv ?
-        specific_recv->req_recv.req_base.req_sequence : PML_MAX_SEQ;
-
-    /* they are equal only if both are PML_MAX_SEQ */
-    while(wild_recv_seq != specific_recv_seq) {
-        mca_pml_ob1_recv_request_t **match;
-        opal_list_t *queue;
-        int req_tag;
-        mca_pml_sequence_t *seq;
-
-        if (OPAL_UNLIKELY(wild_recv_seq < specific_recv_seq)) {
-            match = &wild_recv;
-            queue = &comm->wild_receives;
-            seq = &wild_recv_seq;
-        } else {
-            match = &specific_recv;
-            queue = &proc->specific_receives;
-            seq = &specific_recv_seq;
-        }
+    ++proc->stats.posted_searches;
 
-        req_tag = (*match)->req_recv.req_base.req_tag;
-        if(req_tag == tag || (req_tag == OMPI_ANY_TAG && tag >= 0)) {
-            opal_list_remove_item(queue, (opal_list_item_t*)(*match));
-            PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
-                    &((*match)->req_recv.req_base), PERUSE_RECV);
-            return *match;
-        }
+    bucket = proc->specific_tagged + mca_pml_ob1_match_bucket (tag);
+    select_posted_recv (get_posted_recv_tagged (bucket, tag, &proc->stats), bucket, &match, &queue);
+    select_posted_recv (get_posted_recv_any_tag (&proc->specific_receives, tag),
+                        &proc->specific_receives, &match, &queue);
+    bucket = comm->wild_tagged + mca_pml_ob1_match_bucket (tag);
+    select_posted_recv (get_posted_recv_tagged (bucket, tag, &proc->stats), bucket, &match, &queue);
+    select_posted_recv (get_posted_recv_any_tag (&comm->wild_receives, tag),
+                        &comm->wild_receives, &match, &queue);
 
-        *match = get_next_posted_recv(queue, *match);
-        *seq = (*match) ? (*match)->req_recv.req_base.req_sequence : PML_MAX_SEQ;
+    if (NULL == match) {
+        return NULL;
     }
 
-    return NULL;
+    opal_list_remove_item (queue, (opal_list_item_t *) match);
+    if (OMPI_ANY_SOURCE != match->req_recv.req_base.req_peer) {
+        --proc->num_specific;
+    } else {
+        (void) OPAL_THREAD_ADD_FETCH32(&comm->wild_posted, -1);
+    }
+    (void) OPAL_THREAD_SUB_FETCH_SIZE_T(&comm->num_posted, 1);
+    PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
+                            &(match->req_recv.req_base), PERUSE_RECV);
+    return match;
 #else
     return custom_match_prq_find_dequeue_verify(comm->prq, hdr->hdr_tag, hdr->hdr_src);
 #endif
@@ -750,21 +823,27 @@ static mca_pml_ob1_recv_request_t *match_incomming_no_any_source (const mca_pml_
                                                                   mca_pml_ob1_comm_t *comm,
                                                                   mca_pml_ob1_comm_proc_t *proc)
 {
-    mca_pml_ob1_recv_request_t *recv_req;
+    mca_pml_ob1_recv_request_t *match = NULL;
+    opal_list_t *queue = NULL, *bucket;
     int tag = hdr->hdr_tag;
 
-    OPAL_LIST_FOREACH(recv_req, &proc->specific_receives, mca_pml_ob1_recv_request_t) {
-        int req_tag = recv_req->req_recv.req_base.req_tag;
+    ++proc->stats.posted_searches;
 
-        if (req_tag == tag || (req_tag == OMPI_ANY_TAG && tag >= 0)) {
-            opal_list_remove_item (&proc->specific_receives, (opal_list_item_t *) recv_req);
-            PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
-                    &(recv_req->req_recv.req_base), PERUSE_RECV);
-            return recv_req;
-        }
+    bucket = proc->specific_tagged + mca_pml_ob1_match_bucket (tag);
+    select_posted_recv (get_posted_recv_tagged (bucket, tag, &proc->stats), bucket, &match, &queue);
+    select_posted_recv (get_posted_recv_any_tag (&proc->specific_receives, tag),
+                        &proc->specific_receives, &match, &queue);
+
+    if (NULL == match) {
+        return NULL;
     }
 
-    return NULL;
+    opal_list_remove_item (queue, (opal_list_item_t *) match);
+    --proc->num_specific;
+    (void) OPAL_THREAD_SUB_FETCH_SIZE_T(&comm->num_posted, 1);
+    PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
+                            &(match->req_recv.req_base), PERUSE_RECV);
+    return match;
 }
 #endif
 
@@ -773,7 +852,8 @@ static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
                                               const mca_btl_base_segment_t *segments,
                                               size_t num_segments, ompi_communicator_t *comm_ptr,
                                               mca_pml_ob1_comm_proc_t *proc,
-                                              mca_pml_ob1_recv_frag_t* frag)
+                                              mca_pml_ob1_recv_frag_t* frag,
+                                              bool comm_locked)
 {
 #if SPC_ENABLE == 1
     opal_timer_t timer = 0;
@@ -787,7 +867,9 @@ static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
 #if MCA_PML_OB1_CUSTOM_MATCH
         match = match_incomming(hdr, comm, proc);
 #else
-        if (!OMPI_COMM_CHECK_ASSERT_NO_ANY_SOURCE (comm_ptr)) {
+        /* the MPI_ANY_SOURCE queues are empty unless the communicator
+         * lock had to be taken */
+        if (comm_locked && !OMPI_COMM_CHECK_ASSERT_NO_ANY_SOURCE (comm_ptr)) {
             match = match_incomming(hdr, comm, proc);
         } else {
             match = match_incomming_no_any_source (hdr, comm, proc);
@@ -836,8 +918,11 @@ static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
         append_frag_to_umq(comm->umq, btl, hdr, segments,
                             num_segments, frag);
 #else
-        append_frag_to_list(&proc->unexpected_frags, btl, hdr, segments,
-                            num_segments, frag);
+        if (NULL == frag) {
+            MCA_PML_OB1_RECV_FRAG_ALLOC(frag);
+            MCA_PML_OB1_RECV_FRAG_INIT(frag, hdr, segments, num_segments, btl);
+        }
+        mca_pml_ob1_unexpected_append (comm, proc, frag);
 #endif
         SPC_RECORD(OMPI_SPC_UNEXPECTED, 1);
         SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, 1);
@@ -891,6 +976,7 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
     ompi_communicator_t *comm_ptr;
     mca_pml_ob1_comm_t *comm;
     mca_pml_ob1_comm_proc_t *proc;
+    bool comm_locked;
 
     /* communicator pointer */
     comm_ptr = ompi_comm_lookup(hdr->hdr_ctx);
@@ -927,7 +1013,7 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
      * end points) from being processed, and potentially "loosing"
      * the fragment.
      */
-    OB1_MATCHING_LOCK(&comm->matching_lock);
+    comm_locked = mca_pml_ob1_matching_lock_peer(comm, proc);
 
     frag_msg_seq = hdr->hdr_seq;
     next_msg_seq_expected = (uint16_t)proc->expected_sequence;
@@ -944,7 +1030,7 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
             SPC_RECORD(OMPI_SPC_OOS_IN_QUEUE, 1);
             SPC_UPDATE_WATERMARK(OMPI_SPC_MAX_OOS_IN_QUEUE, OMPI_SPC_OOS_IN_QUEUE);
 
-            OB1_MATCHING_UNLOCK(&comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
             return OMPI_SUCCESS;
         }
     }
@@ -952,7 +1038,7 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
     /* mca_pml_ob1_recv_frag_match_proc() will release the lock. */
     return mca_pml_ob1_recv_frag_match_proc(btl, comm_ptr, proc, hdr,
                                             segments, num_segments,
-                                            type, NULL);
+                                            type, NULL, comm_locked);
 }
 
 
@@ -960,8 +1046,9 @@ static int mca_pml_ob1_recv_frag_match (mca_btl_base_module_t *btl,
  * then try to match the next frag in sequence by looking into arrived
  * out of order frags in frags_cant_match list until it can't find one.
  *
- * ATTENTION: THIS FUNCTION MUST BE CALLED WITH COMMUNICATOR LOCK HELD.
- * THE LOCK WILL BE RELEASED UPON RETURN. USE WITH CARE. */
+ * ATTENTION: THIS FUNCTION MUST BE CALLED WITH THE PEER MATCHING LOCK HELD
+ * (mca_pml_ob1_matching_lock_peer). THE LOCK WILL BE RELEASED UPON RETURN.
+ * USE WITH CARE. */
 static int
 mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
                                   ompi_communicator_t* comm_ptr,
@@ -970,7 +1057,8 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
                                   const mca_btl_base_segment_t *segments,
                                   size_t num_segments,
                                   int type,
-                                  mca_pml_ob1_recv_frag_t *frag)
+                                  mca_pml_ob1_recv_frag_t *frag,
+                                  bool comm_locked)
 {
     /* local variables */
     mca_pml_ob1_comm_t *comm = (mca_pml_ob1_comm_t *)comm_ptr->c_pml_comm;
@@ -995,7 +1083,7 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
     PERUSE_TRACE_MSG_EVENT(PERUSE_COMM_SEARCH_POSTED_Q_BEGIN, comm_ptr,
                            hdr->hdr_src, hdr->hdr_tag, PERUSE_RECV);
 
-    match = match_one(btl, hdr, segments, num_segments, comm_ptr, proc, frag);
+    match = match_one(btl, hdr, segments, num_segments, comm_ptr, proc, frag, comm_locked);
 
     /* The match is over. We generate the SEARCH_POSTED_Q_END here,
      * before going into check_cantmatch_for_match we can make a
@@ -1005,7 +1093,7 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
                            hdr->hdr_src, hdr->hdr_tag, PERUSE_RECV);
 
     /* release matching lock before processing fragment */
-    OB1_MATCHING_UNLOCK(&comm->matching_lock);
+    mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
 
     if(OPAL_LIKELY(match)) {
         switch(type) {
@@ -1030,7 +1118,7 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
      * may now be used to form new matchs
      */
     if(OPAL_UNLIKELY(NULL != proc->frags_cant_match)) {
-        OB1_MATCHING_LOCK(&comm->matching_lock);
+        comm_locked = mca_pml_ob1_matching_lock_peer(comm, proc);
         if((frag = check_cantmatch_for_match(proc))) {
             hdr = &frag->hdr.hdr_match;
             segments = frag->segments;
@@ -1039,7 +1127,7 @@ mca_pml_ob1_recv_frag_match_proc (mca_btl_base_module_t *btl,
             type = hdr->hdr_common.hdr_type;
             goto match_this_frag;
         }
-        OB1_MATCHING_UNLOCK(&comm->matching_lock);
+        mca_pml_ob1_matching_unlock_peer(comm, proc, comm_locked);
     }
 
     return OMPI_SUCCESS;
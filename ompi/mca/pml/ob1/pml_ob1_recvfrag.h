@@ -29,6 +29,7 @@
 #define MCA_PML_OB1_RECVFRAG_H
 
 #include "pml_ob1_hdr.h"
+#include "pml_ob1_comm.h"
 
 BEGIN_C_DECLS
 
@@ -44,6 +45,7 @@ struct mca_pml_ob1_recv_frag_t {
     mca_pml_ob1_hdr_t hdr;
     size_t num_segments;
     struct mca_pml_ob1_recv_frag_t* range;
+    size_t order;  /**< arrival order on the unexpected queues of the peer */
     mca_btl_base_module_t* btl;
     mca_btl_base_segment_t segments[MCA_BTL_DES_MAX_SEGMENTS];
     mca_pml_ob1_buffer_t buffers[MCA_BTL_DES_MAX_SEGMENTS];
@@ -110,6 +112,44 @@ do {                                                                    \
  } while(0)
 
 
+#if !MCA_PML_OB1_CUSTOM_MATCH
+/**
+ * Queue an unexpected fragment from proc. Must be called with the
+ * matching state of proc locked (mca_pml_ob1_matching_lock_peer), unless
+ * comm is not yet visible to the user.
+ */
+static inline void mca_pml_ob1_unexpected_append (mca_pml_ob1_comm_t *comm,
+                                                  mca_pml_ob1_comm_proc_t *proc,
+                                                  mca_pml_ob1_recv_frag_t *frag)
+{
+    size_t num_unexpected;
+
+    frag->order = proc->unexpected_order++;
+    opal_list_append (proc->unexpected_frags + mca_pml_ob1_match_bucket (frag->hdr.hdr_match.hdr_tag),
+                      (opal_list_item_t *) frag);
+    ++proc->num_unexpected;
+    /* the watermark is only approximate when peers are matched concurrently */
+    num_unexpected = OPAL_THREAD_ADD_FETCH_SIZE_T(&comm->num_unexpected, 1);
+    if (num_unexpected > comm->max_unexpected) {
+        comm->max_unexpected = num_unexpected;
+    }
+}
+
+/**
+ * Remove a matched fragment from the unexpected queues of proc. Must be
+ * called with the matching state of proc locked.
+ */
+static inline void mca_pml_ob1_unexpected_remove (mca_pml_ob1_comm_t *comm,
+                                                  mca_pml_ob1_comm_proc_t *proc,
+                                                  mca_pml_ob1_recv_frag_t *frag)
+{
+    opal_list_remove_item (proc->unexpected_frags + mca_pml_ob1_match_bucket (frag->hdr.hdr_match.hdr_tag),
+                           (opal_list_item_t *) frag);
+    --proc->num_unexpected;
+    (void) OPAL_THREAD_SUB_FETCH_SIZE_T(&comm->num_unexpected, 1);
+}
+#endif
+
 /**
  *  Callback from BTL on receipt of a recv_frag (match).
  */
@@ -97,16 +97,47 @@ static int mca_pml_ob1_recv_request_free(struct ompi_request_t** request)
     return OMPI_SUCCESS;
 }
 
+#if !MCA_PML_OB1_CUSTOM_MATCH
+/* the posted queue of a receive: MPI_ANY_TAG queue or tag bucket, of the
+ * peer or of the communicator for MPI_ANY_SOURCE (proc == NULL) */
+static inline opal_list_t *posted_recv_queue(mca_pml_ob1_comm_t *comm,
+                                             mca_pml_ob1_comm_proc_t *proc,
+                                             const mca_pml_ob1_recv_request_t *req)
+{
+    int tag = req->req_recv.req_base.req_tag;
+
+    if (NULL == proc) {
+        return OMPI_ANY_TAG == tag ? &comm->wild_receives :
+            comm->wild_tagged + mca_pml_ob1_match_bucket(tag);
+    }
+    return OMPI_ANY_TAG == tag ? &proc->specific_receives :
+        proc->specific_tagged + mca_pml_ob1_match_bucket(tag);
+}
+#endif
+
 static int mca_pml_ob1_recv_request_cancel(struct ompi_request_t* ompi_request, int complete)
 {
     mca_pml_ob1_recv_request_t* request = (mca_pml_ob1_recv_request_t*)ompi_request;
     ompi_communicator_t *comm = request->req_recv.req_base.req_comm;
     mca_pml_ob1_comm_t *ob1_comm = comm->c_pml_comm;
-
-    /* The rest should be protected behind the match logic lock */
-    OB1_MATCHING_LOCK(&ob1_comm->matching_lock);
+    mca_pml_ob1_comm_proc_t* proc = NULL;
+    bool comm_locked = true;
+
+    /* The rest should be protected behind the match logic lock: the one of
+     * the peer for a specific receive, the one of the communicator for
+     * MPI_ANY_SOURCE */
+    if( request->req_recv.req_base.req_peer != OMPI_ANY_SOURCE ) {
+        proc = mca_pml_ob1_peer_lookup (comm, request->req_recv.req_base.req_peer);
+        comm_locked = mca_pml_ob1_matching_lock_peer (ob1_comm, proc);
+    } else {
+        OB1_MATCHING_LOCK(&ob1_comm->matching_lock);
+    }
     if( true == request->req_match_received ) { /* way to late to cancel this one */
-        OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+        if (NULL != proc) {
+            mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
+        } else {
+            OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+        }
         assert( OMPI_ANY_TAG != ompi_request->req_status.MPI_TAG ); /* not matched isn't it */
         return OMPI_SUCCESS;
     }
@@ -114,12 +145,13 @@ static int mca_pml_ob1_recv_request_cancel(struct ompi_request_t* ompi_request,
 #if MCA_PML_OB1_CUSTOM_MATCH
     custom_match_prq_cancel(ob1_comm->prq, request);
 #else
-    if( request->req_recv.req_base.req_peer == OMPI_ANY_SOURCE ) {
-        opal_list_remove_item( &ob1_comm->wild_receives, (opal_list_item_t*)request );
+    if (NULL != proc) {
+        --proc->num_specific;
     } else {
-        mca_pml_ob1_comm_proc_t* proc = mca_pml_ob1_peer_lookup (comm, request->req_recv.req_base.req_peer);
-        opal_list_remove_item(&proc->specific_receives, (opal_list_item_t*)request);
+        (void) OPAL_THREAD_ADD_FETCH32(&ob1_comm->wild_posted, -1);
     }
+    opal_list_remove_item(posted_recv_queue(ob1_comm, proc, request), (opal_list_item_t*)request);
+    (void) OPAL_THREAD_SUB_FETCH_SIZE_T(&ob1_comm->num_posted, 1);
 #endif
     PERUSE_TRACE_COMM_EVENT( PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
                              &(request->req_recv.req_base), PERUSE_RECV );
@@ -128,7 +160,11 @@ static int mca_pml_ob1_recv_request_cancel(struct ompi_request_t* ompi_request,
      * to true. Otherwise, the request will never be freed.
      */
     request->req_recv.req_base.req_pml_complete = true;
-    OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+    if (NULL != proc) {
+        mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
+    } else {
+        OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+    }
 
     ompi_request->req_status._cancelled = true;
     /* This macro will set the req_complete to true so the MPI Test/Wait* functions
@@ -1081,10 +1117,21 @@ int mca_pml_ob1_recv_request_schedule_once( mca_pml_ob1_recv_request_t* recvreq,
     ((MCA_PML_REQUEST_IMPROBE == (R)->req_recv.req_base.req_type) || \
      (MCA_PML_REQUEST_MPROBE == (R)->req_recv.req_base.req_type))
 
-static inline void append_recv_req_to_queue(opal_list_t *queue,
-        mca_pml_ob1_recv_request_t *req)
+#if !MCA_PML_OB1_CUSTOM_MATCH
+static inline void append_recv_req_to_queue(mca_pml_ob1_comm_t *comm,
+        mca_pml_ob1_comm_proc_t *proc, mca_pml_ob1_recv_request_t *req)
 {
-    opal_list_append(queue, (opal_list_item_t*)req);
+    size_t num_posted;
+
+    opal_list_append(posted_recv_queue(comm, proc, req), (opal_list_item_t*)req);
+    if (NULL != proc) {
+        ++proc->num_specific;
+    }
+    /* the watermark is only approximate when peers are matched concurrently */
+    num_posted = OPAL_THREAD_ADD_FETCH_SIZE_T(&comm->num_posted, 1);
+    if (num_posted > comm->max_posted) {
+        comm->max_posted = num_posted;
+    }
 
 #if OMPI_WANT_PERUSE
     /**
@@ -1097,11 +1144,12 @@ static inline void append_recv_req_to_queue(opal_list_t *queue,
     }
 #endif
 }
+#endif
 
 /*
  *  this routine tries to match a posted receive.  If a match is found,
  *  it places the request in the appropriate matched receive list. This
- *  function has to be called with the communicator matching lock held.
+ *  function has to be called with the matching state of proc locked.
 */
 
 #if MCA_PML_OB1_CUSTOM_MATCH
@@ -1123,25 +1171,35 @@ recv_req_match_specific_proc( const mca_pml_ob1_recv_request_t *req,
 
 #if !MCA_PML_OB1_CUSTOM_MATCH
     int tag = req->req_recv.req_base.req_tag;
-    opal_list_t* unexpected_frags = &proc->unexpected_frags;
-    mca_pml_ob1_recv_frag_t* frag;
+    mca_pml_ob1_recv_frag_t *frag, *match = NULL;
 
-    if(opal_list_get_size(unexpected_frags) == 0) {
+    if(0 == proc->num_unexpected) {
         return NULL;
     }
 
     if( OMPI_ANY_TAG == tag ) {
-        OPAL_LIST_FOREACH(frag, unexpected_frags, mca_pml_ob1_recv_frag_t) {
-            if( frag->hdr.hdr_match.hdr_tag >= 0 )
-                return frag;
+        /* the oldest fragment with a user tag, whatever its bucket */
+        for (unsigned int i = 0 ; i <= mca_pml_ob1_match_mask ; ++i) {
+            OPAL_LIST_FOREACH(frag, proc->unexpected_frags + i, mca_pml_ob1_recv_frag_t) {
+                ++proc->stats.unexpected_scanned;
+                if( frag->hdr.hdr_match.hdr_tag >= 0 ) {
+                    if( NULL == match || frag->order < match->order )
+                        match = frag;
+                    break;
+                }
+            }
         }
     } else {
-        OPAL_LIST_FOREACH(frag, unexpected_frags, mca_pml_ob1_recv_frag_t) {
-            if( frag->hdr.hdr_match.hdr_tag == tag )
-                return frag;
+        OPAL_LIST_FOREACH(frag, proc->unexpected_frags + mca_pml_ob1_match_bucket (tag),
+                          mca_pml_ob1_recv_frag_t) {
+            ++proc->stats.unexpected_scanned;
+            if( frag->hdr.hdr_match.hdr_tag == tag ) {
+                match = frag;
+                break;
+            }
         }
     }
-    return NULL;
+    return match;
 #else
     return custom_match_umq_find_verify_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq,
                                              req->req_recv.req_base.req_tag,
@@ -1194,30 +1252,36 @@ recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
      * process.
      *
      * In order to avoid starvation do this in a round-robin fashion.
+     *
+     * With pml_ob1_match_per_peer each process is locked while its
+     * messages are searched, and stays locked when one matches, so that
+     * the caller can remove it.
      */
-    for (size_t i = comm->last_probed + 1; i < comm->num_procs; i++) {
+    for (size_t n = 0, i = comm->last_probed + 1; n < comm->num_procs; n++, i++) {
+        mca_pml_ob1_comm_proc_t *proc;
         mca_pml_ob1_recv_frag_t* frag;
 
-        /* loop over messages from the current proc */
-        if((frag = recv_req_match_specific_proc(req, procp[i]))) {
-            *p = procp[i];
-            comm->last_probed = i;
-            req->req_recv.req_base.req_proc = procp[i]->ompi_proc;
-            prepare_recv_req_converter(req);
-            return frag; /* match found */
+        if (i == comm->num_procs) {
+            i = 0;
+        }
+        if (NULL == (proc = procp[i])) {
+            continue;
+        }
+        if (mca_pml_ob1_match_per_peer) {
+            OB1_MATCHING_LOCK(&proc->matching_lock);
         }
-    }
-    for (size_t i = 0; i <= comm->last_probed; i++) {
-        mca_pml_ob1_recv_frag_t* frag;
 
         /* loop over messages from the current proc */
-        if((frag = recv_req_match_specific_proc(req, procp[i]))) {
-            *p = procp[i];
+        if((frag = recv_req_match_specific_proc(req, proc))) {
+            *p = proc;
             comm->last_probed = i;
-            req->req_recv.req_base.req_proc = procp[i]->ompi_proc;
+            req->req_recv.req_base.req_proc = proc->ompi_proc;
             prepare_recv_req_converter(req);
             return frag; /* match found */
         }
+        if (mca_pml_ob1_match_per_peer) {
+            OB1_MATCHING_UNLOCK(&proc->matching_lock);
+        }
     }
 
     *p = NULL;
@@ -1233,12 +1297,11 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
     mca_pml_ob1_comm_proc_t* proc;
     mca_pml_ob1_recv_frag_t* frag;
     mca_pml_ob1_hdr_t* hdr;
+    bool comm_locked = true;
 #if MCA_PML_OB1_CUSTOM_MATCH
     custom_match_umq_node* hold_prev;
     custom_match_umq_node* hold_elem;
     int hold_index;
-#else
-    opal_list_t *queue;
 #endif
 
     /* init/re-init the request */
@@ -1253,7 +1316,20 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
 
     MCA_PML_BASE_RECV_START(&req->req_recv);
 
-    OB1_MATCHING_LOCK(&ob1_comm->matching_lock);
+    /* A specific receive only needs the matching state of its peer. A
+     * MPI_ANY_SOURCE receive takes the communicator lock, and announces
+     * itself in wild_posted before it looks at the peers, so that
+     * incoming messages take the communicator lock too until it is
+     * matched or cancelled. */
+    if(req->req_recv.req_base.req_peer == OMPI_ANY_SOURCE) {
+        OB1_MATCHING_LOCK(&ob1_comm->matching_lock);
+        (void) OPAL_THREAD_ADD_FETCH32(&ob1_comm->wild_posted, 1);
+        opal_atomic_mb ();
+        proc = NULL;
+    } else {
+        proc = mca_pml_ob1_peer_lookup (comm, req->req_recv.req_base.req_peer);
+        comm_locked = mca_pml_ob1_matching_lock_peer (ob1_comm, proc);
+    }
     /**
      * The laps of time between the ACTIVATE event and the SEARCH_UNEX one include
      * the cost of the request lock.
@@ -1262,7 +1338,10 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
                             &(req->req_recv.req_base), PERUSE_RECV);
 
     /* assign sequence number */
-    req->req_recv.req_base.req_sequence = ob1_comm->recv_sequence++;
+    req->req_recv.req_base.req_sequence = OPAL_THREAD_ADD_FETCH32(&ob1_comm->recv_sequence, 1) - 1;
+#if !MCA_PML_OB1_CUSTOM_MATCH
+    ++(NULL == proc ? &ob1_comm->stats : &proc->stats)->unexpected_searches;
+#endif
 
     /* attempt to match posted recv */
     if(req->req_recv.req_base.req_peer == OMPI_ANY_SOURCE) {
@@ -1270,7 +1349,6 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
         frag = recv_req_match_wild(req, &proc, &hold_prev, &hold_elem, &hold_index);
 #else
         frag = recv_req_match_wild(req, &proc);
-        queue = &ob1_comm->wild_receives;
 #endif
 #if !OPAL_ENABLE_HETEROGENEOUS_SUPPORT
         /* As we are in a homogeneous environment we know that all remote
@@ -1284,13 +1362,11 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
         }
 #endif  /* !OPAL_ENABLE_HETEROGENEOUS_SUPPORT */
     } else {
-        proc = mca_pml_ob1_peer_lookup (comm, req->req_recv.req_base.req_peer);
         req->req_recv.req_base.req_proc = proc->ompi_proc;
 #if MCA_PML_OB1_CUSTOM_MATCH
         frag = recv_req_match_specific_proc(req, proc, &hold_prev, &hold_elem, &hold_index);
 #else
         frag = recv_req_match_specific_proc(req, proc);
-        queue = &proc->specific_receives;
 #endif
         /* wildcard recv will be prepared on match */
         prepare_recv_req_converter(req);
@@ -1308,11 +1384,23 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
                                     req->req_recv.req_base.req_tag,
                                     req->req_recv.req_base.req_peer);
 #else
-            append_recv_req_to_queue(queue, req);
+            append_recv_req_to_queue(ob1_comm, proc, req);
 #endif
         req->req_match_received = false;
-        OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+        if (NULL == proc) {
+            if (OPAL_UNLIKELY(req->req_recv.req_base.req_type == MCA_PML_REQUEST_IPROBE ||
+                              req->req_recv.req_base.req_type == MCA_PML_REQUEST_IMPROBE)) {
+                (void) OPAL_THREAD_ADD_FETCH32(&ob1_comm->wild_posted, -1);
+            }
+            OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+        } else {
+            mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
+        }
     } else {
+        if (req->req_recv.req_base.req_peer == OMPI_ANY_SOURCE) {
+            /* matched right away, not posted */
+            (void) OPAL_THREAD_ADD_FETCH32(&ob1_comm->wild_posted, -1);
+        }
         if(OPAL_LIKELY(!IS_PROB_REQ(req))) {
             PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_REQ_MATCH_UNEX,
                                     &(req->req_recv.req_base), PERUSE_RECV);
@@ -1330,11 +1418,10 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
 #if MCA_PML_OB1_CUSTOM_MATCH
             custom_match_umq_remove_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq, hold_prev, hold_elem, hold_index);
 #else
-            opal_list_remove_item(&proc->unexpected_frags,
-                                  (opal_list_item_t*)frag);
+            mca_pml_ob1_unexpected_remove(ob1_comm, proc, frag);
 #endif
             SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, -1);
-            OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
 
             switch(hdr->hdr_common.hdr_type) {
             case MCA_PML_OB1_HDR_TYPE_MATCH:
@@ -1366,18 +1453,17 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
 #if MCA_PML_OB1_CUSTOM_MATCH
             custom_match_umq_remove_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq, hold_prev, hold_elem, hold_index);
 #else
-            opal_list_remove_item(&proc->unexpected_frags,
-                                  (opal_list_item_t*)frag);
+            mca_pml_ob1_unexpected_remove(ob1_comm, proc, frag);
 #endif
             SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, -1);
-            OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
 
             req->req_recv.req_base.req_addr = frag;
             mca_pml_ob1_recv_request_matched_probe(req, frag->btl,
                                                    frag->segments, frag->num_segments);
 
         } else {
-            OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
+            mca_pml_ob1_matching_unlock_peer (ob1_comm, proc, comm_locked);
             mca_pml_ob1_recv_request_matched_probe(req, frag->btl,
                                                    frag->segments, frag->num_segments);
         }
@@ -32,8 +32,11 @@
 #include "pml_ob1_hdr.h"
 #include "pml_ob1_rdma.h"
 #include "pml_ob1_rdmafrag.h"
+#include "pml_ob1_agg.h"
+#include "pml_ob1_adapt.h"
 #include "ompi/mca/bml/bml.h"
 #include "ompi/memchecker.h"
+#include "ompi/runtime/ompi_spc.h"
 
 BEGIN_C_DECLS
 
@@ -57,6 +60,12 @@ struct mca_pml_ob1_send_request_t {
     opal_mutex_t req_send_range_lock;
     opal_list_t req_send_ranges;
     mca_pml_ob1_rdma_frag_t *rdma_frag;
+    /** Persistent requests only: BTL and match header cached by
+     *  mca_pml_ob1_send_request_persist_prepare (NULL if not eligible) */
+    mca_bml_base_btl_t *req_persist_btl;
+    mca_pml_ob1_match_hdr_t req_persist_match;
+    /** Measure of the protocol used, with pml_ob1_adaptive */
+    mca_pml_ob1_adapt_sample_t req_adapt;
     /** The size of this array is set from mca_pml_ob1.max_rdma_per_request */
     mca_pml_ob1_com_btl_t req_rdma[];
 };
@@ -156,6 +165,7 @@ get_request_from_send_pending(mca_pml_ob1_send_pending_t *type)
                                        persistent,                      \
                                        0); /* convertor_flags */        \
         (sendreq)->req_recv.pval = NULL;                                \
+        (sendreq)->req_persist_btl = NULL;                              \
     }
 
 #define MCA_PML_OB1_SEND_REQUEST_RESET(sendreq)                         \
@@ -260,6 +270,10 @@ send_request_pml_complete(mca_pml_ob1_send_request_t *sendreq)
                                      &(sendreq->req_send.req_base), PERUSE_SEND);
         }
 
+        if (OPAL_UNLIKELY(MCA_PML_OB1_ADAPT_NONE != sendreq->req_adapt.threshold)) {
+            mca_pml_ob1_adapt_record (&sendreq->req_adapt, sendreq->req_send.req_bytes_packed);
+        }
+
         /* return mpool resources */
         mca_pml_ob1_free_rdma_resources(sendreq);
 
@@ -399,6 +413,18 @@ mca_pml_ob1_send_request_start_btl( mca_pml_ob1_send_request_t* sendreq,
     }
 #endif /* OPAL_CUDA_GDR_SUPPORT */
 
+    if (OPAL_UNLIKELY(MCA_PML_OB1_ADAPT_OFF != mca_pml_ob1.adapt_mode) &&
+        MCA_PML_BASE_SEND_BUFFERED != sendreq->req_send.req_send_mode) {
+        size_t limit = mca_pml_ob1_adapt_eager_limit (&sendreq->req_adapt, sendreq->req_send.req_base.req_proc,
+                                                      MCA_PML_BASE_SEND_STANDARD == sendreq->req_send.req_send_mode,
+                                                      size, eager_limit);
+        if (size > limit && size <= eager_limit) {
+            /* a rendezvous the BTL would have sent eagerly: only the
+             * header goes first, the data follows without copies */
+            eager_limit = 0;
+        }
+    }
+
     if( OPAL_LIKELY(size <= eager_limit) ) {
         switch(sendreq->req_send.req_send_mode) {
         case MCA_PML_BASE_SEND_SYNCHRONOUS:
@@ -429,7 +455,16 @@ mca_pml_ob1_send_request_start_btl( mca_pml_ob1_send_request_t* sendreq,
             unsigned char *base;
             opal_convertor_get_current_pointer( &sendreq->req_send.req_base.req_convertor, (void**)&base );
 
-            if( 0 != (sendreq->req_rdma_cnt = (uint32_t)mca_pml_ob1_rdma_btls(
+            bool use_rdma = true;
+
+            if (OPAL_UNLIKELY(MCA_PML_OB1_ADAPT_OFF != mca_pml_ob1.adapt_mode)) {
+                /* below the RDMA threshold of the peer use the copy in/out pipeline */
+                use_rdma = mca_pml_ob1_adapt_use_rdma (&sendreq->req_adapt, sendreq->req_send.req_base.req_proc,
+                                                       MCA_PML_BASE_SEND_STANDARD == sendreq->req_send.req_send_mode,
+                                                       sendreq->req_send.req_bytes_packed);
+            }
+
+            if( use_rdma && 0 != (sendreq->req_rdma_cnt = (uint32_t)mca_pml_ob1_rdma_btls(
                                                                               sendreq->req_endpoint,
                                                                               base,
                                                                               sendreq->req_send.req_bytes_packed,
@@ -440,6 +475,11 @@ mca_pml_ob1_send_request_start_btl( mca_pml_ob1_send_request_t* sendreq,
                     mca_pml_ob1_free_rdma_resources(sendreq);
                 }
             } else {
+                if (OPAL_UNLIKELY(use_rdma && MCA_PML_OB1_ADAPT_RDMA == sendreq->req_adapt.threshold)) {
+                    /* no RDMA BTL for this buffer, nothing to compare */
+                    sendreq->req_adapt.threshold = MCA_PML_OB1_ADAPT_NONE;
+                }
+                sendreq->req_rdma_cnt = 0;
                 rc = mca_pml_ob1_send_request_start_rndv(sendreq, bml_btl, size,
                                                          MCA_PML_OB1_HDR_FLAGS_CONTIG);
             }
@@ -466,9 +506,13 @@ mca_pml_ob1_send_request_start_seq (mca_pml_ob1_send_request_t* sendreq, mca_bml
     sendreq->req_bytes_delivered = 0;
     sendreq->req_pending = MCA_PML_OB1_SEND_PENDING_NONE;
     sendreq->req_send.req_base.req_sequence = seqn;
+    sendreq->req_adapt.threshold = MCA_PML_OB1_ADAPT_NONE;
 
     MCA_PML_BASE_SEND_START( &sendreq->req_send );
 
+    /* do not get ahead of the messages aggregated for the peer */
+    mca_pml_ob1_agg_flush_proc (sendreq->req_send.req_base.req_proc);
+
     for(size_t i = 0; i < mca_bml_base_btl_array_get_size(&endpoint->btl_eager); i++) {
         mca_bml_base_btl_t* bml_btl;
         int rc;
@@ -511,6 +555,107 @@ mca_pml_ob1_send_request_start( mca_pml_ob1_send_request_t* sendreq )
     return mca_pml_ob1_send_request_start_seq (sendreq, endpoint, seqn);
 }
 
+/**
+ * Decide once, when a persistent send is created, whether every start can
+ * go out as a single sendi on a fixed BTL: contiguous data that fits in
+ * the eager limit of the only eager BTL to the peer, in standard or ready
+ * mode. If so, cache the BTL and a match header that only lacks the
+ * sequence number.
+ */
+static inline void
+mca_pml_ob1_send_request_persist_prepare (mca_pml_ob1_send_request_t *sendreq)
+{
+    ompi_communicator_t *comm = sendreq->req_send.req_base.req_comm;
+    mca_bml_base_endpoint_t *endpoint = mca_bml_base_get_endpoint (sendreq->req_send.req_base.req_proc);
+    mca_bml_base_btl_t *bml_btl;
+
+    if (OPAL_UNLIKELY(NULL == endpoint) ||
+        (MCA_PML_BASE_SEND_STANDARD != sendreq->req_send.req_send_mode &&
+         MCA_PML_BASE_SEND_READY != sendreq->req_send.req_send_mode) ||
+        opal_convertor_need_buffers (&sendreq->req_send.req_base.req_convertor) ||
+        1 != mca_bml_base_btl_array_get_size (&endpoint->btl_eager)) {
+        return;
+    }
+
+#if OPAL_CUDA_SUPPORT
+    if (sendreq->req_send.req_base.req_convertor.flags & CONVERTOR_CUDA) {
+        return;
+    }
+#endif /* OPAL_CUDA_SUPPORT */
+
+    bml_btl = mca_bml_base_btl_array_get_index (&endpoint->btl_eager, 0);
+    if (NULL == bml_btl->btl->btl_sendi ||
+        sendreq->req_send.req_bytes_packed > bml_btl->btl->btl_eager_limit - sizeof (mca_pml_ob1_hdr_t)) {
+        return;
+    }
+
+    mca_pml_ob1_match_hdr_prepare (&sendreq->req_persist_match, MCA_PML_OB1_HDR_TYPE_MATCH, 0,
+                                   comm->c_contextid, comm->c_my_rank,
+                                   sendreq->req_send.req_base.req_tag, 0);
+    sendreq->req_endpoint = endpoint;
+    sendreq->req_persist_btl = bml_btl;
+}
+
+/**
+ * Start a persistent send prepared by mca_pml_ob1_send_request_persist_prepare.
+ * The request must be complete at the PML level. If the BTL cannot take
+ * the message right away fall back to the generic protocol selection,
+ * reusing the sequence number already consumed.
+ */
+static inline int
+mca_pml_ob1_send_request_start_persist (mca_pml_ob1_send_request_t *sendreq)
+{
+    mca_bml_base_endpoint_t *endpoint = sendreq->req_endpoint;
+    mca_bml_base_btl_t *bml_btl = sendreq->req_persist_btl;
+    ompi_communicator_t *comm = sendreq->req_send.req_base.req_comm;
+    mca_pml_ob1_comm_proc_t *ob1_proc = mca_pml_ob1_peer_lookup (comm, sendreq->req_send.req_base.req_peer);
+    size_t size = sendreq->req_send.req_bytes_packed;
+    mca_pml_ob1_match_hdr_t match;
+    int32_t seqn;
+    int rc;
+
+    /* the BTL set of an endpoint can change (e.g. on BTL failure) */
+    if (OPAL_UNLIKELY(1 != mca_bml_base_btl_array_get_size (&endpoint->btl_eager) ||
+                      bml_btl != mca_bml_base_btl_array_get_index (&endpoint->btl_eager, 0))) {
+        sendreq->req_persist_btl = NULL;
+        return mca_pml_ob1_send_request_start (sendreq);
+    }
+
+    seqn = OPAL_THREAD_ADD_FETCH32(&ob1_proc->send_sequence, 1);
+
+    sendreq->req_state = 0;
+    sendreq->req_lock = 0;
+    sendreq->req_pipeline_depth = 0;
+    sendreq->req_bytes_delivered = 0;
+    sendreq->req_pending = MCA_PML_OB1_SEND_PENDING_NONE;
+    sendreq->req_send.req_base.req_sequence = seqn;
+    sendreq->req_adapt.threshold = MCA_PML_OB1_ADAPT_NONE;
+
+    /* also rewinds the convertor */
+    MCA_PML_BASE_SEND_START( &sendreq->req_send );
+
+    mca_pml_ob1_agg_flush_proc (sendreq->req_send.req_base.req_proc);
+
+    match = sendreq->req_persist_match;
+    match.hdr_seq = (uint16_t) seqn;
+    ob1_hdr_hton (&match, MCA_PML_OB1_HDR_TYPE_MATCH, sendreq->req_send.req_base.req_proc);
+
+    rc = mca_bml_base_sendi (bml_btl, &sendreq->req_send.req_base.req_convertor,
+                             &match, OMPI_PML_OB1_MATCH_HDR_LEN, size, MCA_BTL_NO_ORDER,
+                             MCA_BTL_DES_FLAGS_PRIORITY | MCA_BTL_DES_FLAGS_BTL_OWNERSHIP,
+                             MCA_PML_OB1_HDR_TYPE_MATCH, NULL);
+    if (OPAL_LIKELY(OMPI_SUCCESS == rc)) {
+#if SPC_ENABLE == 1
+        SPC_USER_OR_MPI(sendreq->req_send.req_base.req_tag, (ompi_spc_value_t)size,
+                        OMPI_SPC_BYTES_SENT_USER, OMPI_SPC_BYTES_SENT_MPI);
+#endif
+        send_request_pml_complete (sendreq);
+        return OMPI_SUCCESS;
+    }
+
+    return mca_pml_ob1_send_request_start_seq (sendreq, endpoint, seqn);
+}
+
 /**
  *  Initiate a put scheduled by the receiver.
  */
@@ -57,6 +57,15 @@ int mca_pml_ob1_start(size_t count, ompi_request_t** requests)
                                     pml_request->req_datatype);
                 );
 
+                /* prepared at init: a single pre-built fragment send */
+                if (OPAL_LIKELY(NULL != sendreq->req_persist_btl && pml_request->req_pml_complete)) {
+                    rc = mca_pml_ob1_send_request_start_persist (sendreq);
+                    if (OPAL_UNLIKELY(OMPI_SUCCESS != rc)) {
+                        return rc;
+                    }
+                    break;
+                }
+
                 if (!pml_request->req_pml_complete) {
                     ompi_request_t *request;
 
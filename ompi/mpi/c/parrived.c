@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2004-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+#include "ompi_config.h"
+#include <stdio.h>
+
+#include "ompi/mpi/c/bindings.h"
+#include "ompi/runtime/params.h"
+#include "ompi/errhandler/errhandler.h"
+#include "ompi/mca/pml/base/pml_base_part.h"
+#include "ompi/request/request.h"
+#include "ompi/memchecker.h"
+
+#if OMPI_BUILD_MPI_PROFILING
+#if OPAL_HAVE_WEAK_SYMBOLS
+#pragma weak MPI_Parrived = PMPI_Parrived
+#endif
+#define MPI_Parrived PMPI_Parrived
+#endif
+
+static const char FUNC_NAME[] = "MPI_Parrived";
+
+int MPI_Parrived(MPI_Request request, int partition, int *flag)
+{
+    int rc;
+
+    MEMCHECKER(
+        memchecker_request(&request);
+    );
+
+    if ( MPI_PARAM_CHECK ) {
+        int rc = MPI_SUCCESS;
+        OMPI_ERR_INIT_FINALIZE(FUNC_NAME);
+        if (MPI_REQUEST_NULL == request || NULL == request) {
+            rc = MPI_ERR_REQUEST;
+        } else if (NULL == flag) {
+            rc = MPI_ERR_ARG;
+        }
+        OMPI_ERRHANDLER_NOHANDLE_CHECK(rc, rc, FUNC_NAME);
+    }
+
+    rc = mca_pml_base_part_parrived(request, partition, flag);
+    OMPI_ERRHANDLER_NOHANDLE_RETURN(rc, rc, FUNC_NAME);
+}
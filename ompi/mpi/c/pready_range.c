@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2004-2020 The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+#include "ompi_config.h"
+#include <stdio.h>
+
+#include "ompi/mpi/c/bindings.h"
+#include "ompi/runtime/params.h"
+#include "ompi/errhandler/errhandler.h"
+#include "ompi/mca/pml/base/pml_base_part.h"
+#include "ompi/request/request.h"
+#include "ompi/memchecker.h"
+
+#if OMPI_BUILD_MPI_PROFILING
+#if OPAL_HAVE_WEAK_SYMBOLS
+#pragma weak MPI_Pready_range = PMPI_Pready_range
+#endif
+#define MPI_Pready_range PMPI_Pready_range
+#endif
+
+static const char FUNC_NAME[] = "MPI_Pready_range";
+
+int MPI_Pready_range(int partition_low, int partition_high, MPI_Request request)
+{
+    int rc;
+
+    MEMCHECKER(
+        memchecker_request(&request);
+    );
+
+    if ( MPI_PARAM_CHECK ) {
+        int rc = MPI_SUCCESS;
+        OMPI_ERR_INIT_FINALIZE(FUNC_NAME);
+        if (MPI_REQUEST_NULL == request || NULL == request) {
+            rc = MPI_ERR_REQUEST;
+        } else if (partition_low > partition_high) {
+            rc = MPI_ERR_ARG;
+        }
+        OMPI_ERRHANDLER_NOHANDLE_CHECK(rc, rc, FUNC_NAME);
+    }
+
+    rc = mca_pml_base_part_pready(request, partition_low, partition_high);
+    OMPI_ERRHANDLER_NOHANDLE_RETURN(rc, rc, FUNC_NAME);
+}
@@ -514,6 +514,28 @@ static inline bool ompi_op_is_valid(ompi_op_t * op, ompi_datatype_t * ddt,
 }
 
 
+/**
+ * Size in bytes from which intrinsic reductions are handed to
+ * ompi_op_base_reduce_large() (0 disables it), and size of the chunks
+ * it splits them into.  Both are set from the op_base_reduce_threshold
+ * and op_base_reduce_chunk_size MCA parameters.
+ */
+OMPI_DECLSPEC extern size_t ompi_op_base_reduce_threshold;
+OMPI_DECLSPEC extern size_t ompi_op_base_reduce_chunk_size;
+
+/**
+ * Cache-blocked (and optionally multithreaded) reduction of an
+ * intrinsic op on a predefined datatype.  target = source1 op target
+ * when source2 is NULL, target = source1 op source2 otherwise.  When
+ * copy is not NULL each chunk of the result is also copied there
+ * while it is still in cache.  Use through ompi_op_reduce(),
+ * ompi_3buff_op_reduce() and ompi_op_reduce_copy().
+ */
+OMPI_DECLSPEC void ompi_op_base_reduce_large(ompi_op_t *op, int dtype_id,
+                                             const void *source1, const void *source2,
+                                             void *target, void *copy,
+                                             int count, ompi_datatype_t *dtype);
+
 /**
  * Perform a reduction operation.
  *
@@ -581,6 +603,12 @@ static inline void ompi_op_reduce(ompi_op_t * op, void *source,
             dtype_id = ompi_op_ddt_map[dt->id];
         } else {
             dtype_id = ompi_op_ddt_map[dtype->id];
+            if (OPAL_UNLIKELY(0 != ompi_op_base_reduce_threshold) &&
+                (size_t)count * dtype->super.size >= ompi_op_base_reduce_threshold) {
+                ompi_op_base_reduce_large(op, dtype_id, source, NULL, target, NULL,
+                                          count, dtype);
+                return;
+            }
         }
         op->o_func.intrinsic.fns[dtype_id](source, target,
                                            &count, &dtype,
@@ -651,6 +679,12 @@ static inline void ompi_3buff_op_reduce(ompi_op_t * op, void *source1,
     tgt = target;
 
     if (OPAL_LIKELY(ompi_op_is_intrinsic (op))) {
+        if (OPAL_UNLIKELY(0 != ompi_op_base_reduce_threshold) &&
+            (size_t)count * dtype->super.size >= ompi_op_base_reduce_threshold) {
+            ompi_op_base_reduce_large(op, ompi_op_ddt_map[dtype->id], src1, src2, tgt,
+                                      NULL, count, dtype);
+            return;
+        }
         op->o_3buff_intrinsic.fns[ompi_op_ddt_map[dtype->id]](src1, src2,
                                                               tgt, &count,
                                                               &dtype,
@@ -660,6 +694,39 @@ static inline void ompi_3buff_op_reduce(ompi_op_t * op, void *source1,
     }
 }
 
+/**
+ * Perform a reduction operation and copy the result.
+ *
+ * @param op The operation (IN)
+ * @param source Source (input) buffer (IN)
+ * @param target Target (output) buffer (IN/OUT)
+ * @param copy Buffer receiving a copy of the result (OUT)
+ * @param count Number of elements (IN)
+ * @param dtype MPI datatype (IN)
+ *
+ * Same as ompi_op_reduce() followed by a copy of count elements of
+ * target into copy.  When the large reduction engine is enabled, for
+ * intrinsic ops on predefined datatypes above its threshold the copy
+ * is done chunk by chunk right after the reduction, so the result is
+ * read back from cache rather than from memory.
+ *
+ * @returns OMPI_SUCCESS, or the error of the copy.
+ */
+static inline int ompi_op_reduce_copy(ompi_op_t * op, void *source,
+                                      void *target, void *copy, int count,
+                                      ompi_datatype_t * dtype)
+{
+    if (OPAL_UNLIKELY(0 != ompi_op_base_reduce_threshold) &&
+        ompi_op_is_intrinsic(op) && ompi_datatype_is_predefined(dtype) &&
+        (size_t)count * dtype->super.size >= ompi_op_base_reduce_threshold) {
+        ompi_op_base_reduce_large(op, ompi_op_ddt_map[dtype->id], source, NULL,
+                                  target, copy, count, dtype);
+        return OMPI_SUCCESS;
+    }
+    ompi_op_reduce(op, source, target, count, dtype);
+    return ompi_datatype_copy_content_same_ddt(dtype, count, (char*)copy, (char*)target);
+}
+
 END_C_DECLS
 
 #endif /* OMPI_OP_H */
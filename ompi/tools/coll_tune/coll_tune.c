@@ -0,0 +1,544 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Generate a coll/tuned dynamic rules file for this machine.
+ *
+ * For each collective, communicator size and message size, every
+ * algorithm of coll/tuned (and every segment size asked for) is timed
+ * against the compiled in decision.  The algorithms are forced through
+ * their MPI_T control variables, which coll/tuned reads when a
+ * communicator is created, so the communicators are created again for
+ * each of them.  An algorithm replaces the compiled in decision only
+ * when it is faster with 95% confidence.
+ */
+
+#include "ompi_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "mpi.h"
+#include "ompi/mca/coll/base/coll_base_functions.h"
+
+typedef struct {
+    const char *name;
+    COLLTYPE_T id;
+    /* The message size of the rules is multiplied by the communicator size */
+    bool scaled;
+    /* Reduction on ints, else data movement of bytes */
+    bool reduction;
+    /* Fanout coll/tuned uses when the algorithm is forced, NULL if none */
+    const char *fanout;
+} tune_coll_t;
+
+static const tune_coll_t colls[] = {
+    { "allgather",            ALLGATHER,          true,  false, "tree"  },
+    { "allreduce",            ALLREDUCE,          false, true,  "tree"  },
+    { "alltoall",             ALLTOALL,           true,  false, "tree"  },
+    { "barrier",              BARRIER,            false, false, NULL    },
+    { "bcast",                BCAST,              false, false, "chain" },
+    { "exscan",               EXSCAN,             true,  true,  NULL    },
+    { "gather",               GATHER,             true,  false, "tree"  },
+    { "reduce",               REDUCE,             false, true,  "chain" },
+    { "reduce_scatter_block", REDUCESCATTERBLOCK, true,  true,  "tree"  },
+    { "scan",                 SCAN,               true,  true,  NULL    },
+    { "scatter",              SCATTER,            true,  false, "chain" },
+};
+#define NCOLLS ((int) (sizeof(colls) / sizeof(colls[0])))
+
+/* An algorithm and segment size; algorithm 0 is the compiled in decision */
+typedef struct {
+    int alg;
+    int segsize;
+} tune_variant_t;
+
+static int rank, wsize, iterations = 20, repetitions = 10, verbose = 0;
+static size_t max_bytes = 1 << 20;
+static char *sbuf, *rbuf;
+
+/* 97.5% quantiles of Student's t distribution, by degrees of freedom */
+static const double t_quantiles[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double t_quantile(int df)
+{
+    return df <= (int) (sizeof(t_quantiles) / sizeof(t_quantiles[0])) ?
+        t_quantiles[df - 1] : 1.960;
+}
+
+/*
+ * MPI_T control variables
+ */
+
+static int cvar_handle(const char *name, MPI_T_cvar_handle *handle)
+{
+    int index, count;
+
+    if (MPI_SUCCESS != MPI_T_cvar_get_index(name, &index)) {
+        return -1;
+    }
+    return MPI_SUCCESS == MPI_T_cvar_handle_alloc(index, NULL, handle, &count) ? 0 : -1;
+}
+
+static int cvar_read(const char *name, int *value)
+{
+    MPI_T_cvar_handle handle;
+    int rc;
+
+    if (0 != cvar_handle(name, &handle)) {
+        return -1;
+    }
+    rc = MPI_T_cvar_read(handle, value);
+    MPI_T_cvar_handle_free(&handle);
+    return MPI_SUCCESS == rc ? 0 : -1;
+}
+
+static int cvar_write(const char *name, int value)
+{
+    MPI_T_cvar_handle handle;
+    int rc;
+
+    if (0 != cvar_handle(name, &handle)) {
+        return -1;
+    }
+    rc = MPI_T_cvar_write(handle, &value);
+    MPI_T_cvar_handle_free(&handle);
+    return MPI_SUCCESS == rc ? 0 : -1;
+}
+
+static int coll_cvar_read(const tune_coll_t *coll, const char *suffix, int *value)
+{
+    char name[128];
+
+    snprintf(name, sizeof(name), "coll_tuned_%s_%s", coll->name, suffix);
+    return cvar_read(name, value);
+}
+
+static int coll_cvar_write(const tune_coll_t *coll, const char *suffix, int value)
+{
+    char name[128];
+
+    snprintf(name, sizeof(name), "coll_tuned_%s_%s", coll->name, suffix);
+    return cvar_write(name, value);
+}
+
+/*
+ * Measurements
+ */
+
+static int run(const tune_coll_t *coll, MPI_Comm comm, size_t bytes)
+{
+    int n = (int) bytes, nint = (int) (bytes / sizeof(int));
+
+    switch (coll->id) {
+    case ALLGATHER:
+        return MPI_Allgather(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, comm);
+    case ALLREDUCE:
+        return MPI_Allreduce(sbuf, rbuf, nint, MPI_INT, MPI_SUM, comm);
+    case ALLTOALL:
+        return MPI_Alltoall(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, comm);
+    case BARRIER:
+        return MPI_Barrier(comm);
+    case BCAST:
+        return MPI_Bcast(sbuf, n, MPI_BYTE, 0, comm);
+    case EXSCAN:
+        return MPI_Exscan(sbuf, rbuf, nint, MPI_INT, MPI_SUM, comm);
+    case GATHER:
+        return MPI_Gather(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, 0, comm);
+    case REDUCE:
+        return MPI_Reduce(sbuf, rbuf, nint, MPI_INT, MPI_SUM, 0, comm);
+    case REDUCESCATTERBLOCK:
+        return MPI_Reduce_scatter_block(sbuf, rbuf, nint, MPI_INT, MPI_SUM, comm);
+    case SCAN:
+        return MPI_Scan(sbuf, rbuf, nint, MPI_INT, MPI_SUM, comm);
+    case SCATTER:
+        return MPI_Scatter(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, 0, comm);
+    default:
+        return MPI_ERR_INTERN;
+    }
+}
+
+/*
+ * Time the collective on comm.  Rank 0 gets the mean and the half
+ * width of the 95% confidence interval of the time of a call, the
+ * slowest process counting for each repetition.  Returns false if the
+ * collective failed on a process.
+ */
+static bool measure(const tune_coll_t *coll, MPI_Comm comm, size_t bytes,
+                    double *mean, double *half_width)
+{
+    double t, slowest, sum = 0.0, sum2 = 0.0, var;
+    int r, it, failed, any_failed;
+
+    failed = (MPI_SUCCESS != run(coll, comm, bytes));
+    MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_LOR, comm);
+    if (any_failed) {
+        return false;
+    }
+
+    for (r = 0; r < repetitions; ++r) {
+        MPI_Barrier(comm);
+        t = MPI_Wtime();
+        for (it = 0; it < iterations; ++it) {
+            run(coll, comm, bytes);
+        }
+        t = (MPI_Wtime() - t) / iterations;
+        MPI_Reduce(&t, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+        sum += slowest;
+        sum2 += slowest * slowest;
+    }
+
+    *mean = sum / repetitions;
+    var = repetitions > 1 ? (sum2 - sum * *mean) / (repetitions - 1) : 0.0;
+    *half_width = repetitions > 1 ? t_quantile(repetitions - 1) * sqrt(var > 0.0 ? var : 0.0) /
+        sqrt((double) repetitions) : 0.0;
+    return true;
+}
+
+/* Message sizes per process of the sweep: powers of two up to max_bytes */
+static int sweep_sizes(const tune_coll_t *coll, size_t *sizes)
+{
+    size_t bytes = coll->reduction ? sizeof(int) : 1;
+    int n = 0;
+
+    if (BARRIER == coll->id) {
+        sizes[0] = 0;
+        return 1;
+    }
+    for (; bytes <= max_bytes; bytes *= 2) {
+        sizes[n++] = bytes;
+    }
+    return n;
+}
+
+/*
+ * Rules
+ */
+
+/* Write the rules of a communicator size, merging consecutive message
+   sizes with the same choice */
+static void write_com_rules(FILE *out, const tune_coll_t *coll, int fanout, int comsize,
+                            const size_t *sizes, const tune_variant_t *choice, int nsizes)
+{
+    int i, nrules = 0;
+
+    for (i = 0; i < nsizes; ++i) {
+        if (0 == i || choice[i].alg != choice[i - 1].alg ||
+            choice[i].segsize != choice[i - 1].segsize) {
+            ++nrules;
+        }
+    }
+    fprintf(out, "%d # communicator size\n", comsize);
+    fprintf(out, "%d # number of message sizes\n", nrules);
+    for (i = 0; i < nsizes; ++i) {
+        if (0 == i || choice[i].alg != choice[i - 1].alg ||
+            choice[i].segsize != choice[i - 1].segsize) {
+            /* The first rule has to start at 0 */
+            size_t msgsize = 0 == i ? 0 : sizes[i] * (coll->scaled ? comsize : 1);
+
+            fprintf(out, "%zu %d %d %d # message size, algorithm, fanout, segment size\n",
+                    msgsize, choice[i].alg, 0 == choice[i].alg ? 0 : fanout,
+                    choice[i].segsize);
+        }
+    }
+}
+
+/* Number of coll/tuned algorithms of the collective, 0 if unknown */
+static int algorithm_count(const tune_coll_t *coll)
+{
+    int count;
+
+    return 0 == coll_cvar_read(coll, "algorithm_count", &count) ? count : 0;
+}
+
+/*
+ * Tune a collective for all the communicator sizes, rank 0 writes its
+ * rules to out.  Collective on MPI_COMM_WORLD.
+ */
+static void tune(FILE *out, const tune_coll_t *coll, const int *comsizes, int ncomsizes,
+                const int *segsizes, int nsegsizes)
+{
+    size_t sizes[64];
+    int nsizes = sweep_sizes(coll, sizes);
+    int algs = algorithm_count(coll), fanout = 0, nvariants, v, c, i, best, segmented, failed;
+    tune_variant_t *variants, *choice;
+    double *mean, *hw;
+    MPI_Comm comm;
+
+    if (NULL != coll->fanout) {
+        char suffix[64];
+
+        snprintf(suffix, sizeof(suffix), "algorithm_%s_fanout", coll->fanout);
+        (void) coll_cvar_read(coll, suffix, &fanout);
+    }
+    segmented = (0 == coll_cvar_write(coll, "algorithm_segmentsize", 0));
+
+    /* Algorithm 0, then each of the others with each segment size */
+    nvariants = 1 + (algs - 1) * (segmented ? nsegsizes : 1);
+    variants = malloc(nvariants * sizeof(tune_variant_t));
+    choice = malloc(nsizes * sizeof(tune_variant_t));
+    mean = malloc(nvariants * nsizes * sizeof(double));
+    hw = malloc(nvariants * nsizes * sizeof(double));
+    if (NULL == variants || NULL == choice || NULL == mean || NULL == hw) {
+        fprintf(stderr, "ompi_coll_tune: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    variants[0].alg = variants[0].segsize = 0;
+    for (v = 1; v < nvariants; ++v) {
+        variants[v].alg = 1 + (v - 1) / (segmented ? nsegsizes : 1);
+        variants[v].segsize = segmented ? segsizes[(v - 1) % nsegsizes] : 0;
+    }
+
+    if (NULL != out) {
+        fprintf(out, "%d # %s\n", (int) coll->id, coll->name);
+        fprintf(out, "%d # number of communicator sizes\n", ncomsizes);
+    }
+
+    for (c = 0; c < ncomsizes; ++c) {
+        for (v = 0; v < nvariants; ++v) {
+            failed = (0 != coll_cvar_write(coll, "algorithm", variants[v].alg));
+            if (segmented && !failed) {
+                failed = (0 != coll_cvar_write(coll, "algorithm_segmentsize", variants[v].segsize));
+            }
+            /* Otherwise whatever algorithm is active would be timed under the
+               name of this variant.  All the ranks skip it together */
+            MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            if (failed) {
+                if (0 == rank) {
+                    fprintf(stderr, "ompi_coll_tune: cannot force %s alg %d seg %d, skipping it\n",
+                            coll->name, variants[v].alg, variants[v].segsize);
+                }
+                for (i = 0; i < nsizes; ++i) {
+                    mean[v * nsizes + i] = hw[v * nsizes + i] = -1.0;
+                }
+                continue;
+            }
+
+            /* coll/tuned reads the forced algorithm on new communicators */
+            MPI_Comm_split(MPI_COMM_WORLD, rank < comsizes[c] ? 0 : MPI_UNDEFINED, rank, &comm);
+            if (MPI_COMM_NULL == comm) {
+                continue;
+            }
+            MPI_Comm_set_errhandler(comm, MPI_ERRORS_RETURN);
+            for (i = 0; i < nsizes; ++i) {
+                if (!measure(coll, comm, sizes[i], &mean[v * nsizes + i], &hw[v * nsizes + i])) {
+                    mean[v * nsizes + i] = -1.0;
+                }
+                if (0 == rank && verbose) {
+                    printf("%-20s %6d %10zu alg %2d seg %7d: %12.2f +- %8.2f usec\n",
+                           coll->name, comsizes[c], sizes[i], variants[v].alg,
+                           variants[v].segsize, mean[v * nsizes + i] * 1e6,
+                           hw[v * nsizes + i] * 1e6);
+                }
+            }
+            MPI_Comm_free(&comm);
+        }
+        if (0 != coll_cvar_write(coll, "algorithm", 0) ||
+            (segmented && 0 != coll_cvar_write(coll, "algorithm_segmentsize", 0))) {
+            fprintf(stderr, "ompi_coll_tune: cannot reset the forced %s algorithm\n", coll->name);
+        }
+
+        if (0 != rank) {
+            continue;
+        }
+        /* The fastest variant replaces the compiled in decision if the
+           confidence intervals do not overlap */
+        for (i = 0; i < nsizes; ++i) {
+            best = 0;
+            for (v = 1; v < nvariants; ++v) {
+                if (mean[v * nsizes + i] >= 0.0 &&
+                    (mean[best * nsizes + i] < 0.0 ||
+                     mean[v * nsizes + i] < mean[best * nsizes + i])) {
+                    best = v;
+                }
+            }
+            if (0 != best && mean[i] >= 0.0 &&
+                mean[best * nsizes + i] + hw[best * nsizes + i] >= mean[i] - hw[i]) {
+                best = 0;
+            }
+            choice[i] = variants[best];
+            printf("%-20s %6d %10zu: alg %2d seg %7d %12.2f usec (decision %12.2f usec)\n",
+                   coll->name, comsizes[c], sizes[i], choice[i].alg, choice[i].segsize,
+                   mean[best * nsizes + i] * 1e6, mean[i] * 1e6);
+        }
+        write_com_rules(out, coll, fanout, comsizes[c], sizes, choice, nsizes);
+    }
+
+    free(variants);
+    free(choice);
+    free(mean);
+    free(hw);
+}
+
+/* Parse a comma separated list of ints */
+static int parse_list(const char *arg, int **list)
+{
+    const char *p;
+    int n = 1, i = 0;
+
+    for (p = arg; *p; ++p) {
+        n += (',' == *p);
+    }
+    *list = malloc(n * sizeof(int));
+    if (NULL == *list) {
+        fprintf(stderr, "ompi_coll_tune: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (p = arg; NULL != p && i < n; p = strchr(p, ',')) {
+        if (',' == *p) {
+            ++p;
+        }
+        (*list)[i++] = atoi(p);
+    }
+    return n;
+}
+
+static void usage(const char *argv0)
+{
+    if (0 == rank) {
+        fprintf(stderr,
+                "Usage: %s [-c collective[,collective...]] [-n comm size[,comm size...]]\n"
+                "       [-s segment size[,segment size...]] [-m max bytes]\n"
+                "       [-i iterations] [-r repetitions] [-o rules file] [-v]\n", argv0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt, provided, i, c, ncomsizes = 0, nsegsizes = 0, ntuned = 0;
+    int *comsizes = NULL, *segsizes = NULL;
+    bool selected[NCOLLS];
+    const char *filename = "coll_tuned_rules.conf", *only = NULL;
+    FILE *out = NULL;
+
+    /* The forced algorithms are only looked at with dynamic rules,
+       and a rules file would take precedence over them */
+    setenv("OMPI_MCA_coll_tuned_use_dynamic_rules", "1", 1);
+    unsetenv("OMPI_MCA_coll_tuned_dynamic_rules_filename");
+    setenv("OMPI_MCA_coll_tuned_priority", "100", 0);
+
+    MPI_Init(&argc, &argv);
+    MPI_T_init_thread(MPI_THREAD_SINGLE, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &wsize);
+
+    while (-1 != (opt = getopt(argc, argv, "c:n:s:m:i:r:o:vh"))) {
+        switch (opt) {
+        case 'c': only = optarg; break;
+        case 'n': ncomsizes = parse_list(optarg, &comsizes); break;
+        case 's': nsegsizes = parse_list(optarg, &segsizes); break;
+        case 'm': max_bytes = strtoul(optarg, NULL, 0); break;
+        case 'i': iterations = atoi(optarg); break;
+        case 'r': repetitions = atoi(optarg); break;
+        case 'o': filename = optarg; break;
+        case 'v': verbose = 1; break;
+        default:
+            usage(argv[0]);
+            MPI_T_finalize();
+            MPI_Finalize();
+            return 'h' == opt ? 0 : 1;
+        }
+    }
+
+    /* Default communicator sizes: the powers of two, and the whole */
+    if (0 == ncomsizes) {
+        comsizes = malloc(32 * sizeof(int));
+        if (NULL == comsizes) {
+            fprintf(stderr, "ompi_coll_tune: out of memory\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        for (i = 2; i < wsize; i *= 2) {
+            comsizes[ncomsizes++] = i;
+        }
+        comsizes[ncomsizes++] = wsize;
+    }
+    if (0 == nsegsizes) {
+        nsegsizes = parse_list("0", &segsizes);
+    }
+    for (i = 0; i < ncomsizes; ++i) {
+        if (comsizes[i] < 2 || comsizes[i] > wsize || (i > 0 && comsizes[i] <= comsizes[i - 1])) {
+            if (0 == rank) {
+                fprintf(stderr, "ompi_coll_tune: communicator sizes must increase from 2 to %d\n",
+                        wsize);
+            }
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    for (c = 0; c < NCOLLS; ++c) {
+        const char *p = only;
+        size_t len = strlen(colls[c].name);
+
+        selected[c] = (NULL == only);
+        for (; NULL != p && !selected[c]; p = strchr(p, ',')) {
+            if (',' == *p) {
+                ++p;
+            }
+            selected[c] = (0 == strncmp(p, colls[c].name, len) && (',' == p[len] || '\0' == p[len]));
+        }
+    }
+    if (iterations < 1 || repetitions < 1 || max_bytes < sizeof(int)) {
+        usage(argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    sbuf = calloc(wsize, max_bytes);
+    rbuf = calloc(wsize, max_bytes);
+    if (NULL == sbuf || NULL == rbuf) {
+        fprintf(stderr, "ompi_coll_tune: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    for (c = 0; c < NCOLLS; ++c) {
+        if (selected[c] && algorithm_count(&colls[c]) > 0) {
+            ++ntuned;
+        } else if (selected[c] && 0 == rank) {
+            fprintf(stderr, "ompi_coll_tune: no coll/tuned algorithms for %s, skipping it\n",
+                    colls[c].name);
+        }
+    }
+    if (0 == rank) {
+        out = fopen(filename, "w");
+        if (NULL == out) {
+            fprintf(stderr, "ompi_coll_tune: cannot write %s\n", filename);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        fprintf(out, "# coll/tuned rules generated by ompi_coll_tune on %d processes\n", wsize);
+        fprintf(out, "# use with --mca coll_tuned_use_dynamic_rules 1 "
+                "--mca coll_tuned_dynamic_rules_filename %s\n", filename);
+        fprintf(out, "%d # number of collectives\n", ntuned);
+        printf("# %d processes, %d repetitions of %d iterations\n",
+               wsize, repetitions, iterations);
+    }
+    for (c = 0; c < NCOLLS; ++c) {
+        if (selected[c] && algorithm_count(&colls[c]) > 0) {
+            tune(out, &colls[c], comsizes, ncomsizes, segsizes, nsegsizes);
+        }
+    }
+    if (0 == rank) {
+        fclose(out);
+        printf("# rules written to %s\n", filename);
+    }
+
+    free(sbuf);
+    free(rbuf);
+    free(comsizes);
+    free(segsizes);
+    MPI_T_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -45,6 +45,12 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif /* HAVE_UNISTD_H */
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define MCA_BTL_SM_HAVE_NT_STORES 1
+#else
+# define MCA_BTL_SM_HAVE_NT_STORES 0
+#endif
 
 #include "opal/mca/shmem/base/base.h"
 
@@ -76,6 +82,9 @@ BEGIN_C_DECLS
 
 struct sm_fifo_t;
 
+/* largest number of fast box sizes (powers of two from btl_sm_fbox_size) */
+#define MCA_BTL_SM_FBOX_MAX_CLASSES 8
+
 /*
  * Modex data
  */
@@ -129,21 +138,29 @@ struct mca_btl_sm_component_t {
     opal_free_list_t sm_frags_eager;     /**< free list of sm send frags */
     opal_free_list_t sm_frags_max_send;  /**< free list of sm max send frags (large fragments) */
     opal_free_list_t sm_frags_user;      /**< free list of small inline frags */
-    opal_free_list_t sm_fboxes;          /**< free list of available fast-boxes */
+    opal_free_list_t sm_fboxes[MCA_BTL_SM_FBOX_MAX_CLASSES]; /**< free lists of available fast-boxes (one per size class) */
 
     unsigned int fbox_threshold;            /**< number of sends required before we setup a send fast box for a peer */
     unsigned int fbox_max;                  /**< maximum number of send fast boxes to allocate */
-    unsigned int fbox_size;                 /**< size of each peer fast box allocation */
+    unsigned int fbox_size;                 /**< size of the smallest peer fast box allocation */
+    unsigned int fbox_max_size;             /**< size a peer fast box may grow to */
+    unsigned int fbox_classes;              /**< number of fast box sizes in use */
+    bool fbox_numa;                         /**< place fast boxes on the NUMA node of the receiver */
 
     int single_copy_mechanism;              /**< single copy mechanism to use */
 
     int memcpy_limit;                       /**< Limit where we switch from memmove to memcpy */
+    bool nt_stores;                         /**< use non-temporal stores for large transfers */
+    size_t nt_store_min;                    /**< transfers this large use non-temporal stores (0 disables) */
+    unsigned int sc_emu_depth;              /**< fragments in flight for an emulated get or put */
     int log_attach_align;                   /**< Log of the alignment for xpmem segments */
     unsigned int max_inline_send;           /**< Limit for copy-in-copy-out fragments */
 
     mca_btl_base_endpoint_t *endpoints;     /**< array of local endpoints (one for each local peer including myself) */
-    mca_btl_base_endpoint_t **fbox_in_endpoints; /**< array of fast box in endpoints */
-    unsigned int num_fbox_in_endpoints;     /**< number of fast boxes to poll */
+    opal_atomic_int32_t *fbox_pending;      /**< bitmap (in my segment) of the peers that wrote to their fast box */
+    uint32_t *fbox_pending_local;           /**< peers whose fast box must be looked at again */
+    unsigned int fbox_pending_words;        /**< number of words in the pending bitmaps (0 until the first add_procs) */
+    int32_t fbox_pending_bit;               /**< my bit in a peer's pending bitmap */
     struct sm_fifo_t *my_fifo;           /**< pointer to the local fifo */
 
     opal_list_t pending_endpoints;          /**< list of endpoints with pending fragments */
@@ -183,10 +200,62 @@ OPAL_MODULE_DECLSPEC extern mca_btl_sm_t mca_btl_sm;
 /* local rank in the group */
 #define MCA_BTL_SM_LOCAL_RANK opal_process_info.my_local_rank
 
+#if MCA_BTL_SM_HAVE_NT_STORES
+/* copy with stores that bypass the caches, for streams that would only
+ * evict useful data from them */
+static inline void sm_memcpy_nt (void *dst, const void *src, size_t size)
+{
+    size_t head = (16 - ((uintptr_t) dst & 15)) & 15;
+    const __m128i *s;
+    __m128i *d;
+
+    if (head > size) {
+        head = size;
+    }
+    memcpy (dst, src, head);
+    d = (__m128i *) ((char *) dst + head);
+    s = (const __m128i *) ((const char *) src + head);
+    size -= head;
+
+    for ( ; size >= 64 ; size -= 64, d += 4, s += 4) {
+        __m128i x0 = _mm_loadu_si128 (s), x1 = _mm_loadu_si128 (s + 1);
+        __m128i x2 = _mm_loadu_si128 (s + 2), x3 = _mm_loadu_si128 (s + 3);
+        _mm_stream_si128 (d, x0);
+        _mm_stream_si128 (d + 1, x1);
+        _mm_stream_si128 (d + 2, x2);
+        _mm_stream_si128 (d + 3, x3);
+    }
+    /* order the streaming stores before whatever signals completion */
+    _mm_sfence ();
+
+    memcpy (d, s, size);
+}
+#endif
+
+/* copy of a piece of a stream of stream_size bytes. non-temporal stores
+   are only worth it when the whole stream does not fit in the caches */
+static inline void sm_memcpy_stream (void *dst, const void *src, size_t size, size_t stream_size)
+{
+#if MCA_BTL_SM_HAVE_NT_STORES
+    if (mca_btl_sm_component.nt_store_min && stream_size >= mca_btl_sm_component.nt_store_min) {
+        sm_memcpy_nt (dst, src, size);
+        return;
+    }
+#endif
+    memcpy (dst, src, size);
+}
+
 /* memcpy is faster at larger sizes but is undefined if the
    pointers are aliased (TODO -- readd alias check) */
 static inline void sm_memmove (void *dst, void *src, size_t size)
 {
+#if MCA_BTL_SM_HAVE_NT_STORES
+    if (mca_btl_sm_component.nt_store_min && size >= mca_btl_sm_component.nt_store_min) {
+        sm_memcpy_nt (dst, src, size);
+        return;
+    }
+#endif
+
     if (size >= (size_t) mca_btl_sm_component.memcpy_limit) {
         memcpy (dst, src, size);
     } else {
@@ -35,6 +35,7 @@
 #include "opal/util/printf.h"
 #include "opal/mca/threads/mutex.h"
 #include "opal/mca/btl/base/btl_base_error.h"
+#include "opal/mca/hwloc/base/base.h"
 
 #include "btl_sm.h"
 #include "btl_sm_frag.h"
@@ -145,6 +146,31 @@ static int mca_btl_sm_component_register (void)
                                            NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
                                            MCA_BASE_VAR_SCOPE_LOCAL,
                                            &mca_btl_sm_component.memcpy_limit);
+
+    mca_btl_sm_component.nt_stores = false;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "nt_stores", "Copy the data of single-copy transfers of at "
+                                           "least btl_sm_nt_store_min bytes with non-temporal stores, so that "
+                                           "they do not evict the caches. Only available on processors with "
+                                           "SSE2 (default: false)", MCA_BASE_VAR_TYPE_BOOL, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.nt_stores);
+    mca_btl_sm_component.nt_store_min = 0;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "nt_store_min", "Smallest transfer copied with non-temporal "
+                                           "stores when btl_sm_nt_stores is set. 0 uses the size of the "
+                                           "largest cache (default: 0)", MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.nt_store_min);
+
+    mca_btl_sm_component.sc_emu_depth = 4;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "sc_emu_depth", "Number of fragments in flight for a get or put "
+                                           "emulated with copy-in copy-out. With more than one the peer copies "
+                                           "a fragment while the previous one is copied here (default: 4)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.sc_emu_depth);
 #if OPAL_BTL_SM_HAVE_XPMEM
     mca_btl_sm_component.log_attach_align = 21;
     (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
@@ -193,7 +219,9 @@ static int mca_btl_sm_component_register (void)
     mca_btl_sm_component.fbox_max = 32;
     (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
                                            "fbox_max", "Maximum number of eager send buffers "
-                                           "to allocate (default: 32)", MCA_BASE_VAR_TYPE_UNSIGNED_INT,
+                                           "to allocate. Buffers used less than btl_sm_fbox_threshold "
+                                           "sends apart are reclaimed for busier peers (default: 32)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT,
                                            NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
                                            MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.fbox_max);
 
@@ -203,6 +231,21 @@ static int mca_btl_sm_component_register (void)
                                            MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
                                            OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.fbox_size);
 
+    mca_btl_sm_component.fbox_max_size = 16384;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "fbox_max_size", "Size per-peer fast transfer buffers that "
+                                           "are often full double up to (default: 16k)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.fbox_max_size);
+
+    mca_btl_sm_component.fbox_numa = true;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "fbox_numa", "Place per-peer fast transfer buffers on the NUMA "
+                                           "node of the receiving process when it is bound to a single "
+                                           "one (default: true)", MCA_BASE_VAR_TYPE_BOOL, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL, &mca_btl_sm_component.fbox_numa);
+
     (void) mca_base_var_enum_create ("btl_sm_single_copy_mechanisms", single_copy_mechanisms, &new_enum);
 
     /* Default to the best available mechanism (see the enumerator for ordering) */
@@ -310,7 +353,9 @@ static int mca_btl_sm_component_open(void)
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_eager, opal_free_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_user, opal_free_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_max_send, opal_free_list_t);
-    OBJ_CONSTRUCT(&mca_btl_sm_component.sm_fboxes, opal_free_list_t);
+    for (int i = 0 ; i < MCA_BTL_SM_FBOX_MAX_CLASSES ; ++i) {
+        OBJ_CONSTRUCT(mca_btl_sm_component.sm_fboxes + i, opal_free_list_t);
+    }
     OBJ_CONSTRUCT(&mca_btl_sm_component.lock, opal_mutex_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.pending_endpoints, opal_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.pending_fragments, opal_list_t);
@@ -331,7 +376,9 @@ static int mca_btl_sm_component_close(void)
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_eager);
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_user);
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_max_send);
-    OBJ_DESTRUCT(&mca_btl_sm_component.sm_fboxes);
+    for (int i = 0 ; i < MCA_BTL_SM_FBOX_MAX_CLASSES ; ++i) {
+        OBJ_DESTRUCT(mca_btl_sm_component.sm_fboxes + i);
+    }
     OBJ_DESTRUCT(&mca_btl_sm_component.lock);
     OBJ_DESTRUCT(&mca_btl_sm_component.pending_endpoints);
     OBJ_DESTRUCT(&mca_btl_sm_component.pending_fragments);
@@ -421,6 +468,55 @@ static void mca_btl_sm_select_next_single_copy_mechanism (void)
 }
 #endif
 
+/* size of the largest cache above the first PU, 0 if unknown */
+static size_t mca_btl_sm_largest_cache_size (void)
+{
+    size_t size = 0;
+    hwloc_obj_t obj;
+
+    if (OPAL_SUCCESS != opal_hwloc_base_get_topology ()) {
+        return 0;
+    }
+
+    for (obj = hwloc_get_obj_by_type (opal_hwloc_topology, HWLOC_OBJ_PU, 0) ; NULL != obj ; obj = obj->parent) {
+#if HWLOC_API_VERSION < 0x20000
+        if (HWLOC_OBJ_CACHE == obj->type && obj->attr->cache.size > size) {
+#else
+        if (hwloc_obj_type_is_cache (obj->type) && obj->attr->cache.size > size) {
+#endif
+            size = obj->attr->cache.size;
+        }
+    }
+
+    return size;
+}
+
+/* os index of the NUMA node this process is bound to, -1 if it is not bound to a single one */
+static int mca_btl_sm_local_numa_node (void)
+{
+    hwloc_bitmap_t cpuset, nodeset;
+    int node = -1;
+
+    if (OPAL_SUCCESS != opal_hwloc_base_get_topology ()) {
+        return -1;
+    }
+
+    cpuset = hwloc_bitmap_alloc ();
+    nodeset = hwloc_bitmap_alloc ();
+    if (NULL != cpuset && NULL != nodeset &&
+        0 == hwloc_get_cpubind (opal_hwloc_topology, cpuset, HWLOC_CPUBIND_PROCESS)) {
+        hwloc_cpuset_to_nodeset (opal_hwloc_topology, cpuset, nodeset);
+        if (1 == hwloc_bitmap_weight (nodeset)) {
+            node = hwloc_bitmap_first (nodeset);
+        }
+    }
+
+    hwloc_bitmap_free (cpuset);
+    hwloc_bitmap_free (nodeset);
+
+    return node;
+}
+
 static void mca_btl_sm_check_single_copy (void)
 {
 #if OPAL_BTL_SM_HAVE_XPMEM || OPAL_BTL_SM_HAVE_CMA || OPAL_BTL_SM_HAVE_KNEM
@@ -553,12 +649,28 @@ static mca_btl_base_module_t **mca_btl_sm_component_init (int *num_btls,
 
     component->fbox_size = (component->fbox_size + MCA_BTL_SM_FBOX_ALIGNMENT_MASK) & ~MCA_BTL_SM_FBOX_ALIGNMENT_MASK;
 
+    /* fast boxes grow by powers of two */
+    for (component->fbox_classes = 1 ; component->fbox_classes < MCA_BTL_SM_FBOX_MAX_CLASSES &&
+             (component->fbox_size << component->fbox_classes) <= component->fbox_max_size ;
+         ++component->fbox_classes);
+
     if (component->segment_size > (1ul << MCA_BTL_SM_OFFSET_BITS)) {
         component->segment_size = 2ul << MCA_BTL_SM_OFFSET_BITS;
     }
 
-    /* no fast boxes allocated initially */
-    component->num_fbox_in_endpoints = 0;
+    /* no fast boxes to poll until the first add_procs */
+    component->fbox_pending_words = 0;
+
+    if (!MCA_BTL_SM_HAVE_NT_STORES || !component->nt_stores) {
+        component->nt_store_min = 0;
+    } else if (0 == component->nt_store_min) {
+        component->nt_store_min = mca_btl_sm_largest_cache_size ();
+        if (0 == component->nt_store_min) {
+            /* a guess, most last level caches are smaller */
+            component->nt_store_min = 64 * 1024 * 1024;
+        }
+        BTL_VERBOSE(("using non-temporal stores from %" PRIsize_t " bytes", component->nt_store_min));
+    }
 
     component->local_rank = 0;
 
@@ -601,6 +713,9 @@ static mca_btl_base_module_t **mca_btl_sm_component_init (int *num_btls,
 
     /* initialize my fifo */
     sm_fifo_init ((struct sm_fifo_t *) component->my_segment);
+    if (component->fbox_numa) {
+        component->my_fifo->numa_node = mca_btl_sm_local_numa_node ();
+    }
 
     rc = mca_btl_base_sm_modex_send ();
     if (OPAL_SUCCESS != rc) {
@@ -665,7 +780,8 @@ void mca_btl_sm_poll_handle_frag (mca_btl_sm_hdr_t *hdr, struct mca_btl_base_end
 
     if (OPAL_UNLIKELY(MCA_BTL_SM_FLAG_SETUP_FBOX & hdr->flags)) {
         mca_btl_sm_endpoint_setup_fbox_recv (endpoint, relative2virtual(hdr->fbox_base));
-        mca_btl_sm_component.fbox_in_endpoints[mca_btl_sm_component.num_fbox_in_endpoints++] = endpoint;
+        /* the peer may have set its bit before this fragment was read */
+        mca_btl_sm_fbox_set_pending_local (endpoint->peer_smp_rank);
     }
 
     hdr->flags = MCA_BTL_SM_FLAG_COMPLETE;
@@ -758,7 +874,7 @@ static int mca_btl_sm_component_progress (void)
     }
 
     /* check for messages in fast boxes */
-    if (mca_btl_sm_component.num_fbox_in_endpoints) {
+    if (mca_btl_sm_component.fbox_pending_words) {
         count = mca_btl_sm_check_fboxes ();
     }
 
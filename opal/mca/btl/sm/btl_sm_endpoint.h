@@ -43,7 +43,29 @@ struct sm_fifo_t;
  *  and BTL pair at startup.
  */
 
-struct mca_btl_sm_fbox_t;
+/**
+ * A fast box. Its size is mca_btl_sm_component.fbox_size << size_class.
+ */
+struct mca_btl_sm_fbox_t {
+    opal_free_list_item_t super;
+    unsigned int size_class;   /**< free list the box belongs to */
+    int numa_node;             /**< NUMA node the box was placed on (-1 if never placed) */
+};
+typedef struct mca_btl_sm_fbox_t mca_btl_sm_fbox_t;
+
+OBJ_CLASS_DECLARATION(mca_btl_sm_fbox_t);
+
+/** value the receiver stores in the start offset of a fast box once it read the retire marker */
+#define MCA_BTL_SM_FBOX_RETIRED 0
+
+/**
+ * Retire state of a send fast box
+ */
+enum {
+    MCA_BTL_SM_FBOX_RETIRE_NONE,    /**< the box is in use */
+    MCA_BTL_SM_FBOX_RETIRE_PENDING, /**< the retire marker will be written when there is room */
+    MCA_BTL_SM_FBOX_RETIRE_WAITING, /**< the marker was written, waiting for the peer to read it */
+};
 
 typedef struct mca_btl_base_endpoint_t {
     opal_list_item_t super;
@@ -53,6 +75,7 @@ typedef struct mca_btl_base_endpoint_t {
         unsigned char *buffer; /**< starting address of peer's fast box out */
         uint32_t *startp;
         unsigned int start;
+        unsigned int size;     /**< size of the peer's fast box */
         uint16_t seq;
     } fbox_in;
 
@@ -60,8 +83,15 @@ typedef struct mca_btl_base_endpoint_t {
         unsigned char *buffer; /**< starting address of peer's fast box in */
         uint32_t *startp;      /**< pointer to location storing start offset */
         unsigned int start, end;
+        unsigned int size;     /**< size of the fast box */
         uint16_t seq;
-        opal_free_list_item_t *fbox; /**< fast-box free list item */
+        uint8_t size_class;    /**< size class of the next fast box set up for this peer */
+        uint8_t retire;        /**< retire state (MCA_BTL_SM_FBOX_RETIRE_*) */
+        uint32_t sends;        /**< fragments written to the fast box */
+        uint32_t sends_seen;   /**< value of sends at the last reclaim pass */
+        uint32_t overflows;    /**< sends that found the fast box full */
+        opal_atomic_int32_t *pending; /**< word of the peer's pending bitmap holding our bit */
+        mca_btl_sm_fbox_t *fbox; /**< fast-box free list item */
     } fbox_out;
 
     int32_t peer_smp_rank;  /**< my peer's SMP process rank.  Used for accessing
@@ -101,20 +131,29 @@ static inline void mca_btl_sm_endpoint_setup_fbox_recv (struct mca_btl_base_endp
 {
     endpoint->fbox_in.startp = (uint32_t *) base;
     endpoint->fbox_in.start = MCA_BTL_SM_FBOX_ALIGNMENT;
+    endpoint->fbox_in.size = endpoint->fbox_in.startp[1];
     endpoint->fbox_in.seq = 0;
     opal_atomic_wmb ();
     endpoint->fbox_in.buffer = base;
 }
 
-static inline void mca_btl_sm_endpoint_setup_fbox_send (struct mca_btl_base_endpoint_t *endpoint, opal_free_list_item_t *fbox)
+static inline void mca_btl_sm_endpoint_setup_fbox_send (struct mca_btl_base_endpoint_t *endpoint, mca_btl_sm_fbox_t *fbox,
+                                                        unsigned int size)
 {
-    void *base = fbox->ptr;
+    void *base = fbox->super.ptr;
 
     endpoint->fbox_out.start = MCA_BTL_SM_FBOX_ALIGNMENT;
     endpoint->fbox_out.end = MCA_BTL_SM_FBOX_ALIGNMENT;
     endpoint->fbox_out.startp = (uint32_t *) base;
     endpoint->fbox_out.startp[0] = MCA_BTL_SM_FBOX_ALIGNMENT;
+    /* the receiver reads the size of the box next to the start offset */
+    endpoint->fbox_out.startp[1] = size;
+    endpoint->fbox_out.size = size;
     endpoint->fbox_out.seq = 0;
+    endpoint->fbox_out.size_class = fbox->size_class;
+    endpoint->fbox_out.retire = MCA_BTL_SM_FBOX_RETIRE_NONE;
+    endpoint->fbox_out.sends = endpoint->fbox_out.sends_seen = 0;
+    endpoint->fbox_out.overflows = 0;
     endpoint->fbox_out.fbox = fbox;
 
     /* zero out the first header in the fast box */
@@ -0,0 +1,237 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Fast boxes are set up for a peer after btl_sm_fbox_threshold sends and live
+ * until they are retired, either because they are often full (the next box for
+ * the peer is twice as large, up to btl_sm_fbox_max_size) or because a busier
+ * peer needs one and this one is used less (the next box is the smallest one).
+ *
+ * Retiring a box writes an empty skip record to it. Fragments for the peer are
+ * held back until the peer reads the record and stores MCA_BTL_SM_FBOX_RETIRED
+ * as its start offset, so nothing sent through the fifo afterward can overtake
+ * what is still in the box.
+ */
+
+#include "opal_config.h"
+
+#include "opal/mca/hwloc/base/base.h"
+#include "opal/util/sys_limits.h"
+
+#include "btl_sm.h"
+#include "btl_sm_endpoint.h"
+#include "btl_sm_fifo.h"
+#include "btl_sm_fbox.h"
+
+static void mca_btl_sm_fbox_construct (mca_btl_sm_fbox_t *fbox)
+{
+    fbox->size_class = 0;
+    fbox->numa_node = -1;
+}
+
+OBJ_CLASS_INSTANCE(mca_btl_sm_fbox_t, opal_free_list_item_t, mca_btl_sm_fbox_construct, NULL);
+
+/* bind the pages of a fast box to the NUMA node of the peer reading it */
+static void mca_btl_sm_fbox_place (mca_btl_sm_fbox_t *fbox, unsigned int size, int node)
+{
+    const uintptr_t page_mask = (uintptr_t) opal_getpagesize () - 1;
+    hwloc_bitmap_t nodeset;
+    int rc;
+
+    if (!mca_btl_sm_component.fbox_numa || node < 0 || fbox->numa_node == node ||
+        ((uintptr_t) fbox->super.ptr & page_mask) || (size & page_mask)) {
+        return;
+    }
+
+    nodeset = hwloc_bitmap_alloc ();
+    if (NULL == nodeset) {
+        return;
+    }
+
+    hwloc_bitmap_only (nodeset, node);
+    /* pages already touched on another node are moved */
+#if HWLOC_API_VERSION < 0x20000
+    rc = hwloc_set_area_membind_nodeset (opal_hwloc_topology, fbox->super.ptr, size, nodeset,
+                                         HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_MIGRATE);
+#else
+    rc = hwloc_set_area_membind (opal_hwloc_topology, fbox->super.ptr, size, nodeset, HWLOC_MEMBIND_BIND,
+                                 HWLOC_MEMBIND_MIGRATE | HWLOC_MEMBIND_BYNODESET);
+#endif
+    if (0 == rc) {
+        fbox->numa_node = node;
+    } else {
+        BTL_VERBOSE(("could not bind fast box to NUMA node %d", node));
+    }
+
+    hwloc_bitmap_free (nodeset);
+}
+
+bool mca_btl_sm_fbox_retire (mca_btl_base_endpoint_t *ep)
+{
+    const unsigned int fbox_size = ep->fbox_out.size;
+    unsigned int start, end;
+    bool hbs, hbm;
+
+    hbs = MCA_BTL_SM_FBOX_OFFSET_HBS(ep->fbox_out.end);
+    end = ep->fbox_out.end & MCA_BTL_SM_FBOX_OFFSET_MASK;
+
+    /* the marker is a header without data */
+    start = ep->fbox_out.start = ep->fbox_out.startp[0];
+    hbm = MCA_BTL_SM_FBOX_OFFSET_HBS(start) == hbs;
+    start &= MCA_BTL_SM_FBOX_OFFSET_MASK;
+    if (BUFFER_FREE(start, end, hbm, fbox_size) < MCA_BTL_SM_FBOX_ALIGNMENT) {
+        return false;
+    }
+
+    opal_atomic_rmb ();
+
+    BTL_VERBOSE(("retiring fast box to %d at offset %u", ep->peer_smp_rank, end));
+
+    mca_btl_sm_fbox_set_header (MCA_BTL_SM_FBOX_HDR(ep->fbox_out.buffer + end), 0xff, ep->fbox_out.seq++, 0);
+    ep->fbox_out.buffer = NULL;
+    ep->fbox_out.retire = MCA_BTL_SM_FBOX_RETIRE_WAITING;
+    mca_btl_sm_fbox_notify (ep);
+
+    return true;
+}
+
+bool mca_btl_sm_fbox_release (mca_btl_base_endpoint_t *ep)
+{
+    mca_btl_sm_fbox_t *fbox;
+    bool released = true;
+
+    OPAL_THREAD_LOCK(&ep->lock);
+    if (MCA_BTL_SM_FBOX_RETIRE_WAITING == ep->fbox_out.retire) {
+        if (MCA_BTL_SM_FBOX_RETIRED != ep->fbox_out.startp[0]) {
+            released = false;
+        } else {
+            opal_atomic_rmb ();
+
+            fbox = ep->fbox_out.fbox;
+            ep->fbox_out.fbox = NULL;
+            ep->fbox_out.startp = NULL;
+            ep->fbox_out.retire = MCA_BTL_SM_FBOX_RETIRE_NONE;
+
+            /* a peer whose box grew gets the new one with its next fragment, any
+             * other has to earn one again */
+            ep->send_count = (ep->fbox_out.size_class > fbox->size_class) ?
+                mca_btl_sm_component.fbox_threshold - 1 : 0;
+
+            opal_free_list_return (mca_btl_sm_component.sm_fboxes + fbox->size_class, &fbox->super);
+            (void) opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, 1);
+        }
+    }
+    OPAL_THREAD_UNLOCK(&ep->lock);
+
+    return released;
+}
+
+/* release the retired boxes the peers are done with and retire the box used the
+ * least since the last pass if it was used less than a peer needs to get one.
+ * called with the component lock held */
+static void mca_btl_sm_fbox_reclaim (void)
+{
+    mca_btl_sm_component_t *component = &mca_btl_sm_component;
+    mca_btl_base_endpoint_t *idlest = NULL;
+    uint32_t idlest_sends = UINT32_MAX;
+
+    for (int i = 0 ; i <= MCA_BTL_SM_NUM_LOCAL_PEERS ; ++i) {
+        mca_btl_base_endpoint_t *ep = component->endpoints + i;
+        uint32_t sends;
+
+        if (MCA_BTL_SM_FBOX_RETIRE_WAITING == ep->fbox_out.retire) {
+            (void) mca_btl_sm_fbox_release (ep);
+            continue;
+        }
+
+        if (NULL == ep->fbox_out.buffer || MCA_BTL_SM_FBOX_RETIRE_NONE != ep->fbox_out.retire) {
+            continue;
+        }
+
+        sends = ep->fbox_out.sends - ep->fbox_out.sends_seen;
+        ep->fbox_out.sends_seen = ep->fbox_out.sends;
+        if (sends < idlest_sends) {
+            idlest_sends = sends;
+            idlest = ep;
+        }
+    }
+
+    /* the peer asking for a box sent fbox_threshold fragments since its last try */
+    if (NULL == idlest || idlest_sends >= component->fbox_threshold) {
+        return;
+    }
+
+    BTL_VERBOSE(("reclaiming fast box to %d (%u sends since the last pass)", idlest->peer_smp_rank,
+                 idlest_sends));
+
+    OPAL_THREAD_LOCK(&idlest->lock);
+    if (NULL != idlest->fbox_out.buffer && MCA_BTL_SM_FBOX_RETIRE_NONE == idlest->fbox_out.retire) {
+        idlest->fbox_out.size_class = 0;
+        idlest->fbox_out.retire = MCA_BTL_SM_FBOX_RETIRE_PENDING;
+        (void) mca_btl_sm_fbox_retire (idlest);
+    }
+    OPAL_THREAD_UNLOCK(&idlest->lock);
+}
+
+void mca_btl_sm_fbox_setup (mca_btl_base_endpoint_t *ep, mca_btl_sm_hdr_t *hdr)
+{
+    mca_btl_sm_component_t *component = &mca_btl_sm_component;
+    mca_btl_sm_fbox_t *fbox = NULL;
+    bool pool_empty = false;
+    unsigned int size;
+
+    /* protect access to mca_btl_sm_component.segment_offset */
+    OPAL_THREAD_LOCK(&component->lock);
+
+    /* verify the remote side will accept another fbox */
+    if (0 <= opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, -1)) {
+        /* fall back on a smaller box if there is no box of the size this peer needs */
+        for (int size_class = ep->fbox_out.size_class ; size_class >= 0 && NULL == fbox ; --size_class) {
+            fbox = (mca_btl_sm_fbox_t *) opal_free_list_get (component->sm_fboxes + size_class);
+            if (NULL != fbox) {
+                fbox->size_class = size_class;
+            }
+        }
+
+        if (NULL == fbox) {
+            opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, 1);
+            pool_empty = true;
+        }
+    } else {
+        /* the receiver refused, give the slot back */
+        opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, 1);
+    }
+
+    if (NULL != fbox) {
+        size = component->fbox_size << fbox->size_class;
+
+        mca_btl_sm_fbox_place (fbox, size, ep->fifo->numa_node);
+
+        /* zero out the fast box */
+        memset (fbox->super.ptr, 0, size);
+        mca_btl_sm_endpoint_setup_fbox_send (ep, fbox, size);
+
+        hdr->flags |= MCA_BTL_SM_FLAG_SETUP_FBOX;
+        hdr->fbox_base = virtual2relative((char *) ep->fbox_out.buffer);
+    } else {
+        /* try again after as many sends. retiring one of our boxes only helps
+         * when our own pool ran out, not when the receiver is out of quota */
+        ep->send_count = 0;
+        if (pool_empty) {
+            mca_btl_sm_fbox_reclaim ();
+        }
+    }
+
+    opal_atomic_wmb ();
+
+    OPAL_THREAD_UNLOCK(&component->lock);
+}
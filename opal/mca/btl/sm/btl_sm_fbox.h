@@ -54,6 +54,42 @@ typedef union mca_btl_sm_fbox_hdr_t {
 
 void mca_btl_sm_poll_handle_frag (mca_btl_sm_hdr_t *hdr, mca_btl_base_endpoint_t *ep);
 
+/**
+ * Set up a send fast box for a peer that reached btl_sm_fbox_threshold sends,
+ * making room for it if a fast box of this process is used less.
+ */
+void mca_btl_sm_fbox_setup (mca_btl_base_endpoint_t *ep, mca_btl_sm_hdr_t *hdr);
+
+/**
+ * Write the retire marker to the send fast box of a peer. Must be called with
+ * the endpoint lock held. Returns false if the box is full.
+ */
+bool mca_btl_sm_fbox_retire (mca_btl_base_endpoint_t *ep);
+
+/**
+ * Return a retired send fast box once the peer read the retire marker. Returns
+ * false while the peer has not.
+ */
+bool mca_btl_sm_fbox_release (mca_btl_base_endpoint_t *ep);
+
+/* tell the peer there is something in our fast box */
+static inline void mca_btl_sm_fbox_notify (mca_btl_base_endpoint_t *ep)
+{
+    const int32_t bit = mca_btl_sm_component.fbox_pending_bit;
+
+    /* the header must be visible before the bit is looked at. the receiver clears
+     * the word before reading the boxes so a bit that is still set covers this write */
+    opal_atomic_mb ();
+    if (!(ep->fbox_out.pending[0] & bit)) {
+        (void) opal_atomic_fetch_or_32 (ep->fbox_out.pending, bit);
+    }
+}
+
+static inline void mca_btl_sm_fbox_set_pending_local (int rank)
+{
+    mca_btl_sm_component.fbox_pending_local[rank >> 5] |= 1u << (rank & 31);
+}
+
 static inline void mca_btl_sm_fbox_set_header (mca_btl_sm_fbox_hdr_t *hdr, uint16_t tag,
                                                uint16_t seq, uint32_t size)
 {
@@ -79,7 +115,7 @@ static inline bool mca_btl_sm_fbox_sendi (mca_btl_base_endpoint_t *ep, unsigned
                                           void * restrict header, const size_t header_size,
                                           void * restrict payload, const size_t payload_size)
 {
-    const unsigned int fbox_size = mca_btl_sm_component.fbox_size;
+    const unsigned int fbox_size = ep->fbox_out.size;
     size_t size = header_size + payload_size;
     unsigned int start, end, buffer_free;
     size_t data_size = size;
@@ -93,6 +129,16 @@ static inline bool mca_btl_sm_fbox_sendi (mca_btl_base_endpoint_t *ep, unsigned
 
     OPAL_THREAD_LOCK(&ep->lock);
 
+    if (OPAL_UNLIKELY(NULL == ep->fbox_out.buffer || ep->fbox_out.retire)) {
+        /* the box is being retired. everything after the marker goes through the fifo
+         * once the peer has read up to it */
+        if (NULL != ep->fbox_out.buffer) {
+            (void) mca_btl_sm_fbox_retire (ep);
+        }
+        OPAL_THREAD_UNLOCK(&ep->lock);
+        return false;
+    }
+
     /* the high bit helps determine if the buffer is empty or full */
     hbs = MCA_BTL_SM_FBOX_OFFSET_HBS(ep->fbox_out.end);
     hbm = MCA_BTL_SM_FBOX_OFFSET_HBS(ep->fbox_out.start) == hbs;
@@ -141,6 +187,16 @@ static inline bool mca_btl_sm_fbox_sendi (mca_btl_base_endpoint_t *ep, unsigned
         if (OPAL_UNLIKELY(buffer_free < size)) {
             ep->fbox_out.end = (hbs << 31) | end;
             opal_atomic_wmb ();
+
+            /* replace a box that is often full by a larger one */
+            if (++ep->fbox_out.overflows >= mca_btl_sm_component.fbox_threshold &&
+                ep->fbox_out.overflows > (ep->fbox_out.sends >> 4) &&
+                ep->fbox_out.size_class + 1U < mca_btl_sm_component.fbox_classes) {
+                BTL_VERBOSE(("fast box to %d is often full. growing it", ep->peer_smp_rank));
+                ep->fbox_out.size_class++;
+                ep->fbox_out.retire = MCA_BTL_SM_FBOX_RETIRE_PENDING;
+            }
+
             OPAL_THREAD_UNLOCK(&ep->lock);
             return false;
         }
@@ -173,84 +229,129 @@ static inline bool mca_btl_sm_fbox_sendi (mca_btl_base_endpoint_t *ep, unsigned
 
     /* align the buffer */
     ep->fbox_out.end = ((uint32_t) hbs << 31) | end;
-    opal_atomic_wmb ();
+    ++ep->fbox_out.sends;
+    mca_btl_sm_fbox_notify (ep);
     OPAL_THREAD_UNLOCK(&ep->lock);
 
     return true;
 }
 
-static inline bool mca_btl_sm_check_fboxes (void)
+/* read the fast box of a peer. returns the number of fragments processed */
+static inline int mca_btl_sm_check_fbox (mca_btl_base_endpoint_t *ep)
 {
-    const unsigned int fbox_size = mca_btl_sm_component.fbox_size;
-    bool processed = false;
+    const unsigned int fbox_size = ep->fbox_in.size;
+    unsigned int start;
+    int poll_count;
+    bool hbs;
+
+    if (OPAL_UNLIKELY(NULL == ep->fbox_in.buffer)) {
+        /* the box was retired or the fragment setting it up has not been read yet. in
+         * the latter case the box is looked at once the fragment is processed */
+        return 0;
+    }
 
-    for (unsigned int i = 0 ; i < mca_btl_sm_component.num_fbox_in_endpoints ; ++i) {
-        mca_btl_base_endpoint_t *ep = mca_btl_sm_component.fbox_in_endpoints[i];
-        unsigned int start = ep->fbox_in.start & MCA_BTL_SM_FBOX_OFFSET_MASK;
+    start = ep->fbox_in.start & MCA_BTL_SM_FBOX_OFFSET_MASK;
 
-        /* save the current high bit state */
-        bool hbs = MCA_BTL_SM_FBOX_OFFSET_HBS(ep->fbox_in.start);
-        int poll_count;
+    /* save the current high bit state */
+    hbs = MCA_BTL_SM_FBOX_OFFSET_HBS(ep->fbox_in.start);
 
-        for (poll_count = 0 ; poll_count <= MCA_BTL_SM_POLL_COUNT ; ++poll_count) {
-            const mca_btl_sm_fbox_hdr_t hdr = mca_btl_sm_fbox_read_header (MCA_BTL_SM_FBOX_HDR(ep->fbox_in.buffer + start));
+    for (poll_count = 0 ; poll_count <= MCA_BTL_SM_POLL_COUNT ; ++poll_count) {
+        const mca_btl_sm_fbox_hdr_t hdr = mca_btl_sm_fbox_read_header (MCA_BTL_SM_FBOX_HDR(ep->fbox_in.buffer + start));
 
-            /* check for a valid tag a sequence number */
-            if (0 == hdr.data.tag || hdr.data.seq != ep->fbox_in.seq) {
-                break;
-            }
+        /* check for a valid tag a sequence number */
+        if (0 == hdr.data.tag || hdr.data.seq != ep->fbox_in.seq) {
+            break;
+        }
 
-            ++ep->fbox_in.seq;
-
-            /* force all prior reads to complete before continuing */
-            opal_atomic_rmb ();
-
-            BTL_VERBOSE(("got frag from %d with header {.tag = %d, .size = %d, .seq = %u} from offset %u",
-                         ep->peer_smp_rank, hdr.data.tag, hdr.data.size, hdr.data.seq, start));
-
-            /* the 0xff tag indicates we should skip the rest of the buffer */
-            if (OPAL_LIKELY((0xfe & hdr.data.tag) != 0xfe)) {
-                mca_btl_base_segment_t segment;
-                const mca_btl_active_message_callback_t *reg =
-                    mca_btl_base_active_message_trigger + hdr.data.tag;
-                mca_btl_base_receive_descriptor_t desc = {.endpoint = ep, .des_segments = &segment,
-                                                          .des_segment_count = 1, .tag = hdr.data.tag,
-                                                          .cbdata = reg->cbdata};
-
-                /* fragment fits entirely in the remaining buffer space. some
-                 * btl users do not handle fragmented data so we can't split
-                 * the fragment without introducing another copy here. this
-                 * limitation has not appeared to cause any performance
-                 * degradation. */
-                segment.seg_len = hdr.data.size;
-                segment.seg_addr.pval = (void *) (ep->fbox_in.buffer + start + sizeof (hdr));
-
-                /* call the registered callback function */
-                reg->cbfunc(&mca_btl_sm.super, &desc);
-            } else if (OPAL_LIKELY(0xfe == hdr.data.tag)) {
-                /* process fragment header */
-                fifo_value_t *value = (fifo_value_t *)(ep->fbox_in.buffer + start + sizeof (hdr));
-                mca_btl_sm_hdr_t *hdr = relative2virtual(*value);
-                mca_btl_sm_poll_handle_frag (hdr, ep);
-            }
+        ++ep->fbox_in.seq;
 
-            start = (start + hdr.data.size + sizeof (hdr) + MCA_BTL_SM_FBOX_ALIGNMENT_MASK) & ~MCA_BTL_SM_FBOX_ALIGNMENT_MASK;
-            if (OPAL_UNLIKELY(fbox_size == start)) {
-                /* jump to the beginning of the buffer */
-                start = MCA_BTL_SM_FBOX_ALIGNMENT;
-                /* toggle the high bit */
-                hbs = !hbs;
-            }
+        /* force all prior reads to complete before continuing */
+        opal_atomic_rmb ();
+
+        BTL_VERBOSE(("got frag from %d with header {.tag = %d, .size = %d, .seq = %u} from offset %u",
+                     ep->peer_smp_rank, hdr.data.tag, hdr.data.size, hdr.data.seq, start));
+
+        /* the 0xff tag indicates we should skip the rest of the buffer */
+        if (OPAL_LIKELY((0xfe & hdr.data.tag) != 0xfe)) {
+            mca_btl_base_segment_t segment;
+            const mca_btl_active_message_callback_t *reg =
+                mca_btl_base_active_message_trigger + hdr.data.tag;
+            mca_btl_base_receive_descriptor_t desc = {.endpoint = ep, .des_segments = &segment,
+                                                      .des_segment_count = 1, .tag = hdr.data.tag,
+                                                      .cbdata = reg->cbdata};
+
+            /* fragment fits entirely in the remaining buffer space. some
+             * btl users do not handle fragmented data so we can't split
+             * the fragment without introducing another copy here. this
+             * limitation has not appeared to cause any performance
+             * degradation. */
+            segment.seg_len = hdr.data.size;
+            segment.seg_addr.pval = (void *) (ep->fbox_in.buffer + start + sizeof (hdr));
+
+            /* call the registered callback function */
+            reg->cbfunc(&mca_btl_sm.super, &desc);
+        } else if (OPAL_LIKELY(0xfe == hdr.data.tag)) {
+            /* process fragment header */
+            fifo_value_t *value = (fifo_value_t *)(ep->fbox_in.buffer + start + sizeof (hdr));
+            mca_btl_sm_hdr_t *hdr = relative2virtual(*value);
+            mca_btl_sm_poll_handle_frag (hdr, ep);
+        } else if (OPAL_UNLIKELY(0 == hdr.data.size)) {
+            /* an empty skip retires the box. let the sender know it can reuse it */
+            BTL_VERBOSE(("fast box from %d retired", ep->peer_smp_rank));
+            ep->fbox_in.buffer = NULL;
+            opal_atomic_mb ();
+            ep->fbox_in.startp[0] = MCA_BTL_SM_FBOX_RETIRED;
+            return poll_count + 1;
+        }
+
+        start = (start + hdr.data.size + sizeof (hdr) + MCA_BTL_SM_FBOX_ALIGNMENT_MASK) & ~MCA_BTL_SM_FBOX_ALIGNMENT_MASK;
+        if (OPAL_UNLIKELY(fbox_size == start)) {
+            /* jump to the beginning of the buffer */
+            start = MCA_BTL_SM_FBOX_ALIGNMENT;
+            /* toggle the high bit */
+            hbs = !hbs;
         }
+    }
+
+    if (poll_count) {
+        BTL_VERBOSE(("left off at offset %u (hbs: %d)", start, hbs));
+
+        /* save where we left off */
+        /* let the sender know where we stopped */
+        opal_atomic_mb ();
+        ep->fbox_in.start = ep->fbox_in.startp[0] = ((uint32_t) hbs << 31) | start;
+
+        if (poll_count > MCA_BTL_SM_POLL_COUNT) {
+            /* there may be more. the sender will not set its bit again for it */
+            mca_btl_sm_fbox_set_pending_local (ep->peer_smp_rank);
+        }
+    }
+
+    return poll_count;
+}
 
-        if (poll_count) {
-            BTL_VERBOSE(("left off at offset %u (hbs: %d)", start, hbs));
+static inline bool mca_btl_sm_check_fboxes (void)
+{
+    opal_atomic_int32_t *pending = mca_btl_sm_component.fbox_pending;
+    uint32_t *pending_local = mca_btl_sm_component.fbox_pending_local;
+    bool processed = false;
 
-            /* save where we left off */
-            /* let the sender know where we stopped */
+    for (unsigned int i = 0 ; i < mca_btl_sm_component.fbox_pending_words ; ++i) {
+        uint32_t bits = pending_local[i];
+
+        if (pending[i]) {
+            /* clear the bits before reading the boxes. a sender that writes after
+             * this sets its bit again */
+            bits |= (uint32_t) opal_atomic_swap_32 (pending + i, 0);
             opal_atomic_mb ();
-            ep->fbox_in.start = ep->fbox_in.startp[0] = ((uint32_t) hbs << 31) | start;
-            processed = true;
+        }
+
+        pending_local[i] = 0;
+
+        for (int rank = i << 5 ; bits ; ++rank, bits >>= 1) {
+            if ((bits & 1) && mca_btl_sm_check_fbox (mca_btl_sm_component.endpoints + rank)) {
+                processed = true;
+            }
         }
     }
 
@@ -261,28 +362,7 @@ static inline bool mca_btl_sm_check_fboxes (void)
 static inline void mca_btl_sm_try_fbox_setup (mca_btl_base_endpoint_t *ep, mca_btl_sm_hdr_t *hdr)
 {
     if (OPAL_UNLIKELY(NULL == ep->fbox_out.buffer && mca_btl_sm_component.fbox_threshold == OPAL_THREAD_ADD_FETCH_SIZE_T (&ep->send_count, 1))) {
-        /* protect access to mca_btl_sm_component.segment_offset */
-        OPAL_THREAD_LOCK(&mca_btl_sm_component.lock);
-
-        /* verify the remote side will accept another fbox */
-        if (0 <= opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, -1)) {
-            opal_free_list_item_t *fbox = opal_free_list_get (&mca_btl_sm_component.sm_fboxes);
-
-            if (NULL != fbox) {
-                /* zero out the fast box */
-                memset (fbox->ptr, 0, mca_btl_sm_component.fbox_size);
-                mca_btl_sm_endpoint_setup_fbox_send (ep, fbox);
-
-                hdr->flags |= MCA_BTL_SM_FLAG_SETUP_FBOX;
-                hdr->fbox_base = virtual2relative((char *) ep->fbox_out.buffer);
-            } else {
-                opal_atomic_add_fetch_32 (&ep->fifo->fbox_available, 1);
-            }
-
-            opal_atomic_wmb ();
-        }
-
-        OPAL_THREAD_UNLOCK(&mca_btl_sm_component.lock);
+        mca_btl_sm_fbox_setup (ep, hdr);
     }
 }
 
@@ -71,11 +71,19 @@ typedef struct sm_fifo_t {
     atomic_fifo_value_t fifo_head;
     atomic_fifo_value_t fifo_tail;
     opal_atomic_int32_t fbox_available;
+    int32_t numa_node;          /**< NUMA node of the owner (-1 if not bound to one) */
 } sm_fifo_t;
 
 /* large enough to ensure the fifo is on its own cache line */
 #define MCA_BTL_SM_FIFO_SIZE 128
 
+/* the fifo is followed by a bitmap with one bit per local rank. a peer sets its
+ * bit after writing to its fast box so the owner only polls the boxes that have
+ * something in them */
+#define MCA_BTL_SM_FBOX_PENDING_WORDS ((MCA_BTL_SM_NUM_LOCAL_PEERS + 32) >> 5)
+#define MCA_BTL_SM_FBOX_PENDING_SIZE                                    \
+    ((MCA_BTL_SM_FBOX_PENDING_WORDS * sizeof (uint32_t) + MCA_BTL_SM_FIFO_SIZE - 1) & ~(size_t) (MCA_BTL_SM_FIFO_SIZE - 1))
+
 /***
  * One or more FIFO components may be a pointer that must be
  * accessed by multiple processes.  Since the shared region may
@@ -161,7 +169,12 @@ static inline void sm_fifo_init (sm_fifo_t *fifo)
     fifo->fifo_head = SM_FIFO_FREE;
     fifo->fifo_tail = SM_FIFO_FREE;
     fifo->fbox_available = mca_btl_sm_component.fbox_max;
+    fifo->numa_node = -1;
     mca_btl_sm_component.my_fifo = fifo;
+
+    mca_btl_sm_component.fbox_pending = (opal_atomic_int32_t *) ((char *) fifo + MCA_BTL_SM_FIFO_SIZE);
+    memset ((void *) mca_btl_sm_component.fbox_pending, 0, MCA_BTL_SM_FBOX_PENDING_SIZE);
+    mca_btl_sm_component.fbox_pending_bit = (int32_t) (1u << (MCA_BTL_SM_LOCAL_RANK & 31));
 }
 
 static inline void sm_fifo_write (sm_fifo_t *fifo, fifo_value_t value)
@@ -204,6 +217,11 @@ static inline bool sm_fifo_write_ep (mca_btl_sm_hdr_t *hdr, struct mca_btl_base_
         opal_atomic_wmb ();
         return mca_btl_sm_fbox_sendi (ep, 0xfe, &rhdr, sizeof (rhdr), NULL, 0);
     }
+    if (OPAL_UNLIKELY(MCA_BTL_SM_FBOX_RETIRE_WAITING == ep->fbox_out.retire) &&
+        !mca_btl_sm_fbox_release (ep)) {
+        /* the peer has not read everything sent through the retired fast box yet */
+        return false;
+    }
     mca_btl_sm_try_fbox_setup (ep, hdr);
     hdr->next = SM_FIFO_FREE;
     sm_fifo_write (ep->fifo, rhdr);
@@ -50,10 +50,30 @@ struct mca_btl_sm_sc_emu_hdr_t {
     uint64_t addr;
     mca_btl_base_atomic_op_t op;
     int flags;
+    /** atomics: operands. put and get: size of the whole transfer (0 if
+     *  it fits in a fragment) */
     int64_t operand[2];
 };
 typedef struct mca_btl_sm_sc_emu_hdr_t mca_btl_sm_sc_emu_hdr_t;
 
+/**
+ * Emulated get or put spread over several fragments in flight, so that
+ * the peer copies a chunk while we copy the previous one.
+ */
+struct mca_btl_sm_rdma_op_t {
+    void *local_address;
+    uint64_t remote_address;
+    mca_btl_base_rdma_completion_fn_t cbfunc;
+    void *context;
+    void *cbdata;
+    size_t size;
+    /** offset of the next chunk to transfer */
+    opal_atomic_size_t offset;
+    /** fragments in flight, plus one while they are being started */
+    opal_atomic_int32_t pending;
+};
+typedef struct mca_btl_sm_rdma_op_t mca_btl_sm_rdma_op_t;
+
 /**
  * FIFO fragment header
  */
@@ -98,6 +118,8 @@ struct mca_btl_sm_frag_t {
         void *cbdata;
         size_t remaining;
         size_t sent;
+        /** pipelined transfer this fragment is part of, if any */
+        mca_btl_sm_rdma_op_t *op;
     } rdma;
 };
 
@@ -236,6 +258,7 @@ mca_btl_sm_rdma_frag_start (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t
     frag->rdma.cbdata = cbdata;
     frag->rdma.remaining = size;
     frag->rdma.sent = 0;
+    frag->rdma.op = NULL;
 
     hdr = (mca_btl_sm_sc_emu_hdr_t *) frag->segments[0].seg_addr.pval;
 
@@ -250,4 +273,12 @@ mca_btl_sm_rdma_frag_start (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t
     return OPAL_SUCCESS;
 }
 
+/**
+ * Start an emulated get or put larger than a fragment with up to
+ * btl_sm_sc_emu_depth fragments in flight.
+ */
+int mca_btl_sm_rdma_op_start (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *endpoint, int type,
+                              int order, int flags, size_t size, void *local_address, uint64_t remote_address,
+                              mca_btl_base_rdma_completion_fn_t cbfunc, void *cbcontext, void *cbdata);
+
 #endif /* MCA_BTL_SM_SEND_FRAG_H */
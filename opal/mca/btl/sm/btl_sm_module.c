@@ -29,6 +29,7 @@
 
 #include "opal_config.h"
 #include "opal/util/show_help.h"
+#include "opal/util/sys_limits.h"
 
 #include "btl_sm.h"
 #include "btl_sm_endpoint.h"
@@ -115,25 +116,33 @@ static int sm_btl_first_time_init(mca_btl_sm_t *sm_btl, int n)
     }
     component->endpoints[n].peer_smp_rank = -1;
 
-    component->fbox_in_endpoints = calloc (n + 1, sizeof (void *));
-    if (NULL == component->fbox_in_endpoints) {
+    component->fbox_pending_local = calloc (MCA_BTL_SM_FBOX_PENDING_WORDS, sizeof (uint32_t));
+    if (NULL == component->fbox_pending_local) {
         free(component->endpoints);
         return OPAL_ERR_OUT_OF_RESOURCE;
     }
 
-    component->mpool = mca_mpool_basic_create ((void *) (component->my_segment + MCA_BTL_SM_FIFO_SIZE),
-                                               (unsigned long) (mca_btl_sm_component.segment_size - MCA_BTL_SM_FIFO_SIZE), 64);
+    /* the segment starts with the fifo and the fast box pending bitmap */
+    component->mpool = mca_mpool_basic_create ((void *) (component->my_segment + MCA_BTL_SM_FIFO_SIZE + MCA_BTL_SM_FBOX_PENDING_SIZE),
+                                               (unsigned long) (mca_btl_sm_component.segment_size - MCA_BTL_SM_FIFO_SIZE -
+                                                                MCA_BTL_SM_FBOX_PENDING_SIZE), 64);
     if (NULL == component->mpool) {
         free (component->endpoints);
         return OPAL_ERR_OUT_OF_RESOURCE;
     }
 
-    rc = opal_free_list_init (&component->sm_fboxes, sizeof (opal_free_list_item_t), 8,
-                              OBJ_CLASS(opal_free_list_item_t), mca_btl_sm_component.fbox_size,
-                              opal_cache_line_size, 0, mca_btl_sm_component.fbox_max, 4,
-                              component->mpool, 0, NULL, NULL, NULL);
-    if (OPAL_SUCCESS != rc) {
-        return rc;
+    /* one free list per fast box size. each holds at most as many bytes as the
+     * smallest one. page aligned boxes can be placed on the NUMA node of the peer */
+    for (unsigned int i = 0 ; i < component->fbox_classes ; ++i) {
+        unsigned int fbox_max = component->fbox_max >> i;
+
+        rc = opal_free_list_init (component->sm_fboxes + i, sizeof (mca_btl_sm_fbox_t), 8,
+                                  OBJ_CLASS(mca_btl_sm_fbox_t), mca_btl_sm_component.fbox_size << i,
+                                  component->fbox_numa ? (size_t) opal_getpagesize () : opal_cache_line_size,
+                                  0, fbox_max ? fbox_max : 1, 4, component->mpool, 0, NULL, NULL, NULL);
+        if (OPAL_SUCCESS != rc) {
+            return rc;
+        }
     }
 
     /* initialize fragment descriptor free lists */
@@ -184,6 +193,9 @@ static int sm_btl_first_time_init(mca_btl_sm_t *sm_btl, int n)
     /* set flag indicating btl has been inited */
     sm_btl->btl_inited = true;
 
+    /* start polling the fast boxes */
+    component->fbox_pending_words = MCA_BTL_SM_FBOX_PENDING_WORDS;
+
 #if OPAL_BTL_SM_HAVE_XPMEM
     if (MCA_BTL_SM_XPMEM == mca_btl_sm_component.single_copy_mechanism) {
         mca_btl_sm_component.vma_module = mca_rcache_base_vma_module_alloc ();
@@ -287,6 +299,7 @@ static int init_sm_endpoint (struct mca_btl_base_endpoint_t *ep, struct opal_pro
     }
 
     ep->fifo = (struct sm_fifo_t *) ep->segment_base;
+    ep->fbox_out.pending = (opal_atomic_int32_t *) (ep->segment_base + MCA_BTL_SM_FIFO_SIZE) + (MCA_BTL_SM_LOCAL_RANK >> 5);
 
     return OPAL_SUCCESS;
 }
@@ -431,8 +444,9 @@ static int sm_finalize(struct mca_btl_base_module_t *btl)
 
     sm_btl->btl_inited = false;
 
-    free (component->fbox_in_endpoints);
-    component->fbox_in_endpoints = NULL;
+    component->fbox_pending_words = 0;
+    free (component->fbox_pending_local);
+    component->fbox_pending_local = NULL;
 
     if (MCA_BTL_SM_XPMEM != mca_btl_sm_component.single_copy_mechanism) {
         opal_shmem_unlink (&mca_btl_sm_component.seg_ds);
@@ -644,7 +658,8 @@ static void mca_btl_sm_endpoint_destructor (mca_btl_sm_endpoint_t *ep)
         opal_shmem_segment_detach (&seg_ds);
     }
     if (ep->fbox_out.fbox) {
-        opal_free_list_return (&mca_btl_sm_component.sm_fboxes, ep->fbox_out.fbox);
+        opal_free_list_return (mca_btl_sm_component.sm_fboxes + ep->fbox_out.fbox->size_class,
+                               &ep->fbox_out.fbox->super);
     }
 
     ep->fbox_in.buffer = ep->fbox_out.buffer = NULL;
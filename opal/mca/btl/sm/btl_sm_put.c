@@ -148,6 +148,12 @@ int mca_btl_sm_put_sc_emu (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *
         return OPAL_ERR_NOT_AVAILABLE;
     }
 
+    if (size + sizeof (mca_btl_sm_sc_emu_hdr_t) > mca_btl_sm.super.btl_max_send_size &&
+        mca_btl_sm_component.sc_emu_depth > 1) {
+        return mca_btl_sm_rdma_op_start (btl, endpoint, MCA_BTL_SM_OP_PUT, order, flags, size,
+                                         local_address, remote_address, cbfunc, cbcontext, cbdata);
+    }
+
     return mca_btl_sm_rdma_frag_start (btl, endpoint, MCA_BTL_SM_OP_PUT, 0, 0, 0, order, flags, size,
                                        local_address, remote_address, cbfunc, cbcontext, cbdata);
 }
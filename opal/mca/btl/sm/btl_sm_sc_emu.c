@@ -98,7 +98,7 @@ static void mca_btl_sm_sc_emu_rdma (mca_btl_base_module_t *btl, const mca_btl_ba
 
     switch (hdr->type) {
     case MCA_BTL_SM_OP_PUT:
-        memcpy ((void *) hdr->addr, data, size);
+        sm_memcpy_stream ((void *) hdr->addr, data, size, (size_t) hdr->operand[0]);
         break;
     case MCA_BTL_SM_OP_GET:
         memcpy (data, (void *) hdr->addr, size);
@@ -139,6 +139,129 @@ static void mca_btl_sm_sc_emu_rdma (mca_btl_base_module_t *btl, const mca_btl_ba
     }
 }
 
+static void mca_btl_sm_rdma_op_release (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *endpoint,
+                                        mca_btl_sm_rdma_op_t *op)
+{
+    if (0 == OPAL_THREAD_ADD_FETCH32(&op->pending, -1)) {
+        op->cbfunc (btl, endpoint, op->local_address, NULL, op->context, op->cbdata, OPAL_SUCCESS);
+        free (op);
+    }
+}
+
+/* load the next chunk of the transfer in the fragment and send it. returns
+ * false once all the chunks have been handed out */
+static bool mca_btl_sm_rdma_op_send_next (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *endpoint,
+                                          mca_btl_sm_frag_t *frag)
+{
+    mca_btl_sm_sc_emu_hdr_t *hdr = (mca_btl_sm_sc_emu_hdr_t *) frag->segments[0].seg_addr.pval;
+    mca_btl_sm_rdma_op_t *op = frag->rdma.op;
+    size_t chunk = mca_btl_sm.super.btl_max_send_size - sizeof (*hdr);
+    size_t offset = OPAL_THREAD_FETCH_ADD_SIZE_T(&op->offset, chunk);
+    size_t len;
+
+    if (offset >= op->size) {
+        return false;
+    }
+    len = min(chunk, op->size - offset);
+
+    frag->rdma.local_address = (void *)((uintptr_t) op->local_address + offset);
+    frag->rdma.remote_address = op->remote_address + offset;
+    frag->rdma.sent = len;
+
+    if (MCA_BTL_SM_OP_PUT == hdr->type) {
+        memcpy ((void *) (hdr + 1), frag->rdma.local_address, len);
+    }
+
+    hdr->addr = frag->rdma.remote_address;
+    /* clear out the complete flag before sending the fragment again */
+    frag->hdr->flags &= ~MCA_BTL_SM_FLAG_COMPLETE;
+    frag->segments[0].seg_len = len + sizeof (*hdr);
+
+    /* send is always successful */
+    (void) mca_btl_sm_send (btl, endpoint, &frag->base, MCA_BTL_TAG_SM);
+    return true;
+}
+
+/* the peer is done with a chunk: consume it and reuse the fragment for the
+ * next one */
+static void mca_btl_sm_rdma_op_advance (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *endpoint,
+                                        mca_btl_sm_frag_t *frag, int status)
+{
+    mca_btl_sm_sc_emu_hdr_t *hdr = (mca_btl_sm_sc_emu_hdr_t *) frag->segments[0].seg_addr.pval;
+    mca_btl_sm_rdma_op_t *op = frag->rdma.op;
+
+    if (MCA_BTL_SM_OP_GET == hdr->type) {
+        sm_memcpy_stream (frag->rdma.local_address, (void *) (hdr + 1), frag->rdma.sent, op->size);
+    }
+
+    if (!mca_btl_sm_rdma_op_send_next (btl, endpoint, frag)) {
+        MCA_BTL_SM_FRAG_RETURN(frag);
+        mca_btl_sm_rdma_op_release (btl, endpoint, op);
+    }
+}
+
+int mca_btl_sm_rdma_op_start (mca_btl_base_module_t *btl, mca_btl_base_endpoint_t *endpoint, int type,
+                              int order, int flags, size_t size, void *local_address, uint64_t remote_address,
+                              mca_btl_base_rdma_completion_fn_t cbfunc, void *cbcontext, void *cbdata)
+{
+    size_t hdr_size = sizeof (mca_btl_sm_sc_emu_hdr_t);
+    size_t chunk = mca_btl_sm.super.btl_max_send_size - hdr_size;
+    size_t depth = min((size_t) mca_btl_sm_component.sc_emu_depth, (size + chunk - 1) / chunk);
+    mca_btl_sm_rdma_op_t *op;
+
+    op = (mca_btl_sm_rdma_op_t *) malloc (sizeof (*op));
+    if (OPAL_UNLIKELY(NULL == op)) {
+        return OPAL_ERR_OUT_OF_RESOURCE;
+    }
+
+    op->local_address = local_address;
+    op->remote_address = remote_address;
+    op->cbfunc = cbfunc;
+    op->context = cbcontext;
+    op->cbdata = cbdata;
+    op->size = size;
+    op->offset = 0;
+    /* keep the operation alive until all the fragments are started */
+    op->pending = 1;
+
+    for (size_t i = 0 ; i < depth ; ++i) {
+        mca_btl_sm_sc_emu_hdr_t *hdr;
+        mca_btl_sm_frag_t *frag;
+
+        frag = (mca_btl_sm_frag_t *) mca_btl_sm_alloc (btl, endpoint, order, chunk + hdr_size,
+                                                       MCA_BTL_DES_SEND_ALWAYS_CALLBACK);
+        if (OPAL_UNLIKELY(NULL == frag)) {
+            if (0 == i) {
+                free (op);
+                return OPAL_ERR_OUT_OF_RESOURCE;
+            }
+            /* go on with the fragments already in flight */
+            break;
+        }
+
+        frag->base.des_cbfunc = (mca_btl_base_completion_fn_t) mca_btl_sm_rdma_op_advance;
+        frag->rdma.op = op;
+
+        hdr = (mca_btl_sm_sc_emu_hdr_t *) frag->segments[0].seg_addr.pval;
+        hdr->type = type;
+        hdr->op = 0;
+        hdr->flags = flags;
+        hdr->operand[0] = (int64_t) size;
+        hdr->operand[1] = 0;
+
+        (void) OPAL_THREAD_ADD_FETCH32(&op->pending, 1);
+        if (!mca_btl_sm_rdma_op_send_next (btl, endpoint, frag)) {
+            /* the fragments in flight took all the chunks */
+            MCA_BTL_SM_FRAG_RETURN(frag);
+            (void) OPAL_THREAD_ADD_FETCH32(&op->pending, -1);
+            break;
+        }
+    }
+
+    mca_btl_sm_rdma_op_release (btl, endpoint, op);
+    return OPAL_SUCCESS;
+}
+
 void mca_btl_sm_sc_emu_init (void)
 {
     mca_btl_base_active_message_trigger[MCA_BTL_TAG_SM].cbfunc = mca_btl_sm_sc_emu_rdma;
@@ -79,3 +79,17 @@ for op in max min sum prod; do
     done
 done
 
+
+echo "========Double int pair type maxloc/minloc (extent larger than size)========="
+echo ""
+for threshold in 0 1024; do
+    for op in maxloc minloc; do
+        for size in 1024 127 130; do
+            foo=$((1024 * 1024 + $size))
+            echo -e "Test $Yellow op_base_reduce_threshold $threshold $NC Total_num_elements = $foo"
+            cmd="$mpirun --mca op_base_reduce_threshold $threshold --mca op_base_reduce_threads 3 -np 1 reduce_local -l $foo -u $foo -t p -o $op"
+            if test $verbose -eq 1 ; then echo $cmd; fi
+            eval $cmd
+        done
+    done
+done
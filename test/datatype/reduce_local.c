@@ -19,12 +19,24 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <complex.h>
 
 #include "mpi.h"
+#include "mpi-ext.h"
 #include "ompi/communicator/communicator.h"
 #include "ompi/runtime/mpiruntime.h"
 #include "ompi/datatype/ompi_datatype.h"
 
+#if defined(OMPI_HAVE_MPI_EXT_SHORTFLOAT) && OMPI_HAVE_MPI_EXT_SHORTFLOAT
+#if defined(HAVE_SHORT_FLOAT)
+typedef short float short_float_t;
+#define HAVE_TEST_SHORT_FLOAT 1
+#elif defined(HAVE_OPAL_SHORT_FLOAT_T)
+typedef opal_short_float_t short_float_t;
+#define HAVE_TEST_SHORT_FLOAT 1
+#endif
+#endif  /* OMPI_HAVE_MPI_EXT_SHORTFLOAT */
+
 typedef struct op_name_s {
     char* name;
     char* mpi_op_name;
@@ -42,9 +54,11 @@ static op_name_t array_of_ops [] = {
     { "lxor", "MPI_LXOR", MPI_LXOR },
     { "bxor", "MPI_BXOR", MPI_BXOR },
     { "replace", "MPI_REPLACE", MPI_REPLACE },
+    { "maxloc", "MPI_MAXLOC", MPI_MAXLOC },
+    { "minloc", "MPI_MINLOC", MPI_MINLOC },
     { NULL, "MPI_OP_NULL", MPI_OP_NULL }
 };
-static int do_ops[12] = { -1, };  /* index of the ops to do. Size +1 larger than the array_of_ops */
+static int do_ops[14] = { -1, };  /* index of the ops to do. Size +1 larger than the array_of_ops */
 static int verbose = 0;
 static int total_errors = 0;
 
@@ -58,8 +72,11 @@ static int total_errors = 0;
        __typeof__ (b) _b = (b); \
      _a < _b ? _a : _b; })
 
+#define sum(a,b) ((a) + (b))
+#define prod(a,b) ((a) * (b))
+
 static void print_status(char* op, char* type, int type_size,
-                         int count, double duration,
+                         int count, size_t elem_size, double duration,
                          int correct )
 {
     if(correct) {
@@ -68,7 +85,8 @@ static void print_status(char* op, char* type, int type_size,
         printf("%-10s %s [\033[1;31mfail\033[0m]", op, type);
         total_errors++;
     }
-    printf(" count  %-10d  time %.6f seconds\n", count, duration);
+    printf(" count  %-10d  time %.6f seconds  %8.3f GB/s\n", count, duration,
+           (duration > 0.0) ? (count * elem_size) / duration / 1e9 : 0.0);
 }
 
 static int do_ops_built = 0;
@@ -115,6 +133,7 @@ do { \
     const TYPE *_p1 = ((TYPE*)(INBUF)), *_p3 = ((TYPE*)(CHECK_BUF)); \
     TYPE *_p2 = ((TYPE*)(INOUT_BUF)); \
     skip_op_type = 0; \
+    elem_size = sizeof(TYPE); \
     for(int _k = 0; _k < min((COUNT), 4); +_k++ ) { \
         memcpy(_p2, _p3, sizeof(TYPE) * (COUNT)); \
         tstart = MPI_Wtime(); \
@@ -139,6 +158,7 @@ do { \
     const TYPE *_p1 = ((TYPE*)(INBUF)), *_p3 = ((TYPE*)(CHECK_BUF)); \
     TYPE *_p2 = ((TYPE*)(INOUT_BUF)); \
     skip_op_type = 0; \
+    elem_size = sizeof(TYPE); \
     for(int _k = 0; _k < min((COUNT), 4); +_k++ ) { \
         memcpy(_p2, _p3, sizeof(TYPE) * (COUNT)); \
         tstart = MPI_Wtime(); \
@@ -159,6 +179,76 @@ do { \
     goto check_and_continue; \
 } while (0)
 
+/*
+ * Same as MPI_OP_TEST for the types that printf cannot take as they are,
+ * short float and complex: OPNAME is a function-like macro, and the values
+ * are printed as (real, imaginary) pairs of doubles.
+ */
+#define MPI_OP_FP_TEST(OPNAME, MPIOP, MPITYPE, TYPE, INBUF, INOUT_BUF, CHECK_BUF, COUNT) \
+do { \
+    const TYPE *_p1 = ((TYPE*)(INBUF)), *_p3 = ((TYPE*)(CHECK_BUF)); \
+    TYPE *_p2 = ((TYPE*)(INOUT_BUF)); \
+    skip_op_type = 0; \
+    elem_size = sizeof(TYPE); \
+    for(int _k = 0; _k < min((COUNT), 4); +_k++ ) { \
+        memcpy(_p2, _p3, sizeof(TYPE) * (COUNT)); \
+        tstart = MPI_Wtime(); \
+        MPI_Reduce_local(_p1+_k, _p2+_k, (COUNT)-_k, (MPITYPE), (MPIOP)); \
+        tend = MPI_Wtime(); \
+        if( check ) { \
+            for( i = 0; i < (COUNT)-_k; i++ ) { \
+                TYPE _v1 = (_p1+_k)[i], _v2 = (_p2+_k)[i], _v3 = (_p3+_k)[i]; \
+                if(_v2 == (TYPE)OPNAME(_v1, _v3)) \
+                    continue; \
+                printf("First error at alignment %d position %d (%s((%g,%g), (%g,%g)) != (%g,%g))\n", \
+                       _k, i, (#OPNAME), creal(_v1), cimag(_v1), creal(_v3), cimag(_v3), \
+                       creal(_v2), cimag(_v2)); \
+                correctness = 0; \
+                break; \
+            } \
+        } \
+    } \
+    goto check_and_continue; \
+} while (0)
+
+/*
+ * MPI_MAXLOC and MPI_MINLOC on MPI_DOUBLE_INT, whose extent (16) is larger
+ * than its size (12). CMP is > for maxloc and < for minloc.
+ */
+typedef struct {
+    double v;
+    int k;
+} double_int_t;
+
+#define MPI_OP_LOC_TEST(CMP, MPIOP, INBUF, INOUT_BUF, CHECK_BUF, COUNT) \
+do { \
+    const double_int_t *_p1 = (INBUF), *_p3 = (CHECK_BUF); \
+    double_int_t *_p2 = (INOUT_BUF); \
+    skip_op_type = 0; \
+    elem_size = sizeof(double_int_t); \
+    for(int _k = 0; _k < min((COUNT), 4); +_k++ ) { \
+        memcpy(_p2, _p3, sizeof(double_int_t) * (COUNT)); \
+        tstart = MPI_Wtime(); \
+        MPI_Reduce_local(_p1+_k, _p2+_k, (COUNT)-_k, MPI_DOUBLE_INT, (MPIOP)); \
+        tend = MPI_Wtime(); \
+        if( check ) { \
+            for( i = 0; i < (COUNT)-_k; i++ ) { \
+                double_int_t _v1 = (_p1+_k)[i], _v2 = (_p2+_k)[i], _v3 = (_p3+_k)[i], _r; \
+                if( _v1.v CMP _v3.v ) _r = _v1; \
+                else if( _v3.v CMP _v1.v ) _r = _v3; \
+                else _r = (_v1.k < _v3.k) ? _v1 : _v3; \
+                if( (_v2.v == _r.v) && (_v2.k == _r.k) ) \
+                    continue; \
+                printf("First error at alignment %d position %d ((%g,%d) %s (%g,%d) != (%g,%d))\n", \
+                       _k, i, _v1.v, _v1.k, (#CMP), _v3.v, _v3.k, _v2.v, _v2.k); \
+                correctness = 0; \
+                break; \
+            } \
+        } \
+    } \
+    goto check_and_continue; \
+} while (0)
+
 int main(int argc, char **argv)
 {
     static void *in_buf = NULL, *inout_buf = NULL, *inout_check_buf = NULL;
@@ -166,8 +256,9 @@ int main(int argc, char **argv)
     int repeats = 1, i, c;
     double tstart, tend;
     bool check = true;
-    char type[5] = "uifd", *op = "sum", *mpi_type;
+    char type[7] = "uifd", *op = "sum", *mpi_type;
     int lower = 1, upper = 1000000, skip_op_type;
+    size_t elem_size = 0;
     MPI_Op mpi_op;
 
     while( -1 != (c = getopt(argc, argv, "l:u:t:o:s:n:vfh")) ) {
@@ -198,12 +289,15 @@ int main(int argc, char **argv)
         case 't':
             for( i = 0; i < (int)strlen(optarg); i++ ) {
                 if( ! (('i' == optarg[i]) || ('u' == optarg[i]) ||
-                       ('f' == optarg[i]) || ('d' == optarg[i])) ) {
-                    fprintf(stderr, "type must be i (signed int), u (unsigned int), f (float) or d (double)\n");
+                       ('f' == optarg[i]) || ('d' == optarg[i]) ||
+                       ('h' == optarg[i]) || ('c' == optarg[i]) ||
+                       ('p' == optarg[i])) ) {
+                    fprintf(stderr, "type must be i (signed int), u (unsigned int), f (float), d (double),"
+                            " h (short float), c (complex) or p (double int pair)\n");
                     exit(-1);
                 }
             }
-            strncpy(type, optarg, 4);
+            strncpy(type, optarg, 6);
             break;
         case 'o':
             build_do_ops( optarg, do_ops);
@@ -221,9 +315,11 @@ int main(int argc, char **argv)
                     " -l <number> : lower number of elements\n"
                     " -u <number> : upper number of elements\n"
                     " -s <type_size> : 8, 16, 32 or 64 bits elements\n"
-                    " -t [i,u,f,d] : type of the elements to apply the operations on\n"
+                    " -t [i,u,f,d,h,c,p] : type of the elements to apply the operations on\n"
+                    "                    (h is short float, c is float complex for -s 32 and\n"
+                    "                    double complex for -s 64, p is MPI_DOUBLE_INT)\n"
                     " -o <op> : comma separated list of operations to execute among\n"
-                    "           sum, min, max, prod, bor, bxor, band\n"
+                    "           sum, min, max, prod, bor, bxor, band, maxloc, minloc\n"
                     " -v: increase the verbosity level\n"
                     " -h: this help message\n", argv[0]);
             exit(0);
@@ -233,9 +329,9 @@ int main(int argc, char **argv)
     if( !do_ops_built ) {  /* not yet done, take the default */
             build_do_ops( "all", do_ops);
     }
-    in_buf          = malloc(upper * sizeof(double));
-    inout_buf       = malloc(upper * sizeof(double));
-    inout_check_buf = malloc(upper * sizeof(double));
+    in_buf          = malloc(upper * sizeof(double _Complex));
+    inout_buf       = malloc(upper * sizeof(double _Complex));
+    inout_check_buf = malloc(upper * sizeof(double _Complex));
 
     ompi_mpi_init(argc, argv, MPI_THREAD_SERIALIZED, &provided, false);
 
@@ -688,10 +784,112 @@ int main(int argc, char **argv)
                                            count, "f");
                     }
                 }
+#if defined(HAVE_TEST_SHORT_FLOAT)
+                /* small integers, so that the results are exact in half precision */
+                if( 'h' == type[type_idx] ) {
+                    short_float_t *in_short_float = (short_float_t*)in_buf,
+                        *inout_short_float = (short_float_t*)inout_buf,
+                        *inout_short_float_for_check = (short_float_t*)inout_check_buf;
+                    for( i = 0; i < count; i++ ) {
+                        in_short_float[i] = (short_float_t)(i % 8 - 3);
+                        inout_short_float[i] = inout_short_float_for_check[i] = (short_float_t)(i % 5 - 2);
+                    }
+                    mpi_type = "MPIX_SHORT_FLOAT";
+
+                    if( 0 == strcmp(op, "sum") ) {
+                        MPI_OP_FP_TEST( sum, mpi_op, MPIX_SHORT_FLOAT, short_float_t,
+                                        in_short_float, inout_short_float, inout_short_float_for_check,
+                                        count);
+                    }
+                    if( 0 == strcmp(op, "prod") ) {
+                        MPI_OP_FP_TEST( prod, mpi_op, MPIX_SHORT_FLOAT, short_float_t,
+                                        in_short_float, inout_short_float, inout_short_float_for_check,
+                                        count);
+                    }
+                    if( 0 == strcmp(op, "max") ) {
+                        MPI_OP_FP_TEST( max, mpi_op, MPIX_SHORT_FLOAT, short_float_t,
+                                        in_short_float, inout_short_float, inout_short_float_for_check,
+                                        count);
+                    }
+                    if( 0 == strcmp(op, "min") ) {
+                        MPI_OP_FP_TEST( min, mpi_op, MPIX_SHORT_FLOAT, short_float_t,
+                                        in_short_float, inout_short_float, inout_short_float_for_check,
+                                        count);
+                    }
+                }
+#endif  /* defined(HAVE_TEST_SHORT_FLOAT) */
+
+                /* small integer parts, so that the products are exact whatever the evaluation */
+                if( ('c' == type[type_idx]) && (32 == type_size) ) {
+                    float _Complex *in_float_complex = (float _Complex*)in_buf,
+                        *inout_float_complex = (float _Complex*)inout_buf,
+                        *inout_float_complex_for_check = (float _Complex*)inout_check_buf;
+                    for( i = 0; i < count; i++ ) {
+                        in_float_complex[i] = (float)(i % 7) + (float)(i % 5 - 2) * I;
+                        inout_float_complex[i] = inout_float_complex_for_check[i] = 3.0f - (float)(i % 3) * I;
+                    }
+                    mpi_type = "MPI_C_FLOAT_COMPLEX";
+
+                    if( 0 == strcmp(op, "sum") ) {
+                        MPI_OP_FP_TEST( sum, mpi_op, MPI_C_FLOAT_COMPLEX, float _Complex,
+                                        in_float_complex, inout_float_complex, inout_float_complex_for_check,
+                                        count);
+                    }
+                    if( 0 == strcmp(op, "prod") ) {
+                        MPI_OP_FP_TEST( prod, mpi_op, MPI_C_FLOAT_COMPLEX, float _Complex,
+                                        in_float_complex, inout_float_complex, inout_float_complex_for_check,
+                                        count);
+                    }
+                }
+
+                if( ('c' == type[type_idx]) && (64 == type_size) ) {
+                    double _Complex *in_double_complex = (double _Complex*)in_buf,
+                        *inout_double_complex = (double _Complex*)inout_buf,
+                        *inout_double_complex_for_check = (double _Complex*)inout_check_buf;
+                    for( i = 0; i < count; i++ ) {
+                        in_double_complex[i] = (double)(i % 7) + (double)(i % 5 - 2) * I;
+                        inout_double_complex[i] = inout_double_complex_for_check[i] = 3.0 - (double)(i % 3) * I;
+                    }
+                    mpi_type = "MPI_C_DOUBLE_COMPLEX";
+
+                    if( 0 == strcmp(op, "sum") ) {
+                        MPI_OP_FP_TEST( sum, mpi_op, MPI_C_DOUBLE_COMPLEX, double _Complex,
+                                        in_double_complex, inout_double_complex, inout_double_complex_for_check,
+                                        count);
+                    }
+                    if( 0 == strcmp(op, "prod") ) {
+                        MPI_OP_FP_TEST( prod, mpi_op, MPI_C_DOUBLE_COMPLEX, double _Complex,
+                                        in_double_complex, inout_double_complex, inout_double_complex_for_check,
+                                        count);
+                    }
+                }
+
+                /* few distinct values, so that the index decides the ties */
+                if( 'p' == type[type_idx] ) {
+                    double_int_t *in_pair = (double_int_t*)in_buf,
+                        *inout_pair = (double_int_t*)inout_buf,
+                        *inout_pair_for_check = (double_int_t*)inout_check_buf;
+                    for( i = 0; i < count; i++ ) {
+                        in_pair[i].v = (double)(i % 5);
+                        in_pair[i].k = i % 11;
+                        inout_pair[i].v = inout_pair_for_check[i].v = (double)(i % 3);
+                        inout_pair[i].k = inout_pair_for_check[i].k = i % 7;
+                    }
+                    mpi_type = "MPI_DOUBLE_INT";
+
+                    if( 0 == strcmp(op, "maxloc") ) {
+                        MPI_OP_LOC_TEST( >, mpi_op, in_pair, inout_pair, inout_pair_for_check,
+                                         count);
+                    }
+                    if( 0 == strcmp(op, "minloc") ) {
+                        MPI_OP_LOC_TEST( <, mpi_op, in_pair, inout_pair, inout_pair_for_check,
+                                         count);
+                    }
+                }
         check_and_continue:
                 if( !skip_op_type )
                     print_status(array_of_ops[do_ops[op_idx]].mpi_op_name,
-                                 mpi_type, type_size, count, tend-tstart, correctness);
+                                 mpi_type, type_size, count, elem_size, tend-tstart, correctness);
             }
             if( !skip_op_type )
                 printf("\n");
@@ -0,0 +1,560 @@
+/*
+ * Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Benchmark of the persistent collectives (MPIX_*_init, from the pcollreq
+  extension) against the matching nonblocking (MPI_I*) and blocking calls
+
+  For every collective, mode and message size it reports:
+    - init_us:     cost of creating (and freeing) the persistent request
+    - lat_*_us:    latency of one start (or call) until completion, the
+                   slowest process of every iteration counts
+    - overlap_pct: how much of the communication is hidden behind synthetic
+                   compute placed between the start and the wait (as in the
+                   OSU nonblocking collective benchmarks)
+    - valid:       whether the result matches the one of the blocking call
+
+  Which component serves each mode is chosen with the usual MCA parameters,
+  the label (-l) is only there to tell the runs apart, see pcollreq_bench.sh
+
+  To be run as:
+
+  mpirun -np 8 --oversubscribe ./pcollreq_bench [-f csv|json] [-l label]
+         [-m min_bytes] [-M max_bytes] [-i iterations] [-w warmup]
+         [-p poll_us] [-o op[,op...]] [-x mode[,mode...]]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include "mpi.h"
+#if defined(OPEN_MPI) && OPEN_MPI
+#include "mpi-ext.h"
+#endif
+
+#if defined(OMPI_HAVE_MPI_EXT_PCOLLREQ) && OMPI_HAVE_MPI_EXT_PCOLLREQ
+#define HAVE_PCOLLREQ 1
+#else
+#define HAVE_PCOLLREQ 0
+#endif
+
+enum bench_mode { MODE_BLOCKING = 0, MODE_NONBLOCKING, MODE_PERSISTENT, NB_MODES };
+static const char *mode_names[NB_MODES] = { "blocking", "nonblocking", "persistent" };
+
+enum bench_format { FORMAT_CSV, FORMAT_JSON };
+
+struct bench_bufs {
+    char *sbuf;
+    char *rbuf;
+    int *counts;          /* per peer element counts, for the v variants */
+    int *displs;
+    MPI_Comm comm;
+    MPI_Comm cart;        /* periodic ring, for the neighbourhood collectives */
+};
+typedef struct bench_bufs bench_bufs_t;
+
+static int rank_world = -1;
+static int size_world = 0;
+
+/* Timing */
+static inline double now_us(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return 1000000.0 * t.tv_sec + t.tv_nsec / 1000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return 1000000.0 * tv.tv_sec + tv.tv_usec;
+#endif
+}
+
+static int comp_double(const void *_a, const void *_b)
+{
+    const double *a = _a;
+    const double *b = _b;
+    return (*a < *b) ? -1 : (*a > *b) ? 1 : 0;
+}
+
+/* Synthetic compute: spins for us microseconds, optionally testing the request
+ * every poll_us microseconds to give a library without asynchronous progress
+ * a chance to move the operation along */
+static double compute_sink = 0.0;
+static void compute(double us, double poll_us, MPI_Request *request)
+{
+    double start = now_us(), last_poll = start, t;
+    int flag = 0;
+    double x = 1.0;
+
+    do {
+        for (int i = 0; i < 64; ++i) {
+            x = x * 1.0000001 + 0.0000001;
+        }
+        t = now_us();
+        if (0 < poll_us && NULL != request && !flag && t - last_poll >= poll_us) {
+            MPI_Test(request, &flag, MPI_STATUS_IGNORE);
+            last_poll = t;
+        }
+    } while (t - start < us);
+    compute_sink += x;
+}
+
+/* Operations: one call per mode, so that all three see exactly the same arguments
+ * count is in elements of MPI_BYTE, or of MPI_INT for the reductions */
+#if HAVE_PCOLLREQ
+#define PERSISTENT(call) return call
+#else
+#define PERSISTENT(call) return MPI_ERR_OTHER
+#endif
+
+static int op_barrier(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Barrier(b->comm);
+    case MODE_NONBLOCKING: return MPI_Ibarrier(b->comm, req);
+    default:               PERSISTENT(MPIX_Barrier_init(b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_bcast(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Bcast(b->sbuf, count, MPI_BYTE, 0, b->comm);
+    case MODE_NONBLOCKING: return MPI_Ibcast(b->sbuf, count, MPI_BYTE, 0, b->comm, req);
+    default:               PERSISTENT(MPIX_Bcast_init(b->sbuf, count, MPI_BYTE, 0, b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_reduce(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Reduce(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, 0, b->comm);
+    case MODE_NONBLOCKING: return MPI_Ireduce(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, 0, b->comm, req);
+    default:               PERSISTENT(MPIX_Reduce_init(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, 0,
+                                                       b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_allreduce(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Allreduce(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, b->comm);
+    case MODE_NONBLOCKING: return MPI_Iallreduce(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, b->comm, req);
+    default:               PERSISTENT(MPIX_Allreduce_init(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM,
+                                                          b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_reduce_scatter_block(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Reduce_scatter_block(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, b->comm);
+    case MODE_NONBLOCKING: return MPI_Ireduce_scatter_block(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM,
+                                                            b->comm, req);
+    default:               PERSISTENT(MPIX_Reduce_scatter_block_init(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM,
+                                                                     b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_scan(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Scan(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, b->comm);
+    case MODE_NONBLOCKING: return MPI_Iscan(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM, b->comm, req);
+    default:               PERSISTENT(MPIX_Scan_init(b->sbuf, b->rbuf, count, MPI_INT, MPI_SUM,
+                                                     b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_gather(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Gather(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0, b->comm);
+    case MODE_NONBLOCKING: return MPI_Igather(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0, b->comm, req);
+    default:               PERSISTENT(MPIX_Gather_init(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0,
+                                                       b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_scatter(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Scatter(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0, b->comm);
+    case MODE_NONBLOCKING: return MPI_Iscatter(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0, b->comm, req);
+    default:               PERSISTENT(MPIX_Scatter_init(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, 0,
+                                                        b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_allgather(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Allgather(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, b->comm);
+    case MODE_NONBLOCKING: return MPI_Iallgather(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, b->comm, req);
+    default:               PERSISTENT(MPIX_Allgather_init(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE,
+                                                          b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_alltoall(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Alltoall(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, b->comm);
+    case MODE_NONBLOCKING: return MPI_Ialltoall(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, b->comm, req);
+    default:               PERSISTENT(MPIX_Alltoall_init(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE,
+                                                         b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_alltoallv(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Alltoallv(b->sbuf, b->counts, b->displs, MPI_BYTE,
+                                                b->rbuf, b->counts, b->displs, MPI_BYTE, b->comm);
+    case MODE_NONBLOCKING: return MPI_Ialltoallv(b->sbuf, b->counts, b->displs, MPI_BYTE,
+                                                 b->rbuf, b->counts, b->displs, MPI_BYTE, b->comm, req);
+    default:               PERSISTENT(MPIX_Alltoallv_init(b->sbuf, b->counts, b->displs, MPI_BYTE,
+                                                          b->rbuf, b->counts, b->displs, MPI_BYTE,
+                                                          b->comm, MPI_INFO_NULL, req));
+    }
+}
+
+static int op_neighbor_alltoall(int mode, bench_bufs_t *b, int count, MPI_Request *req)
+{
+    switch (mode) {
+    case MODE_BLOCKING:    return MPI_Neighbor_alltoall(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE, b->cart);
+    case MODE_NONBLOCKING: return MPI_Ineighbor_alltoall(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE,
+                                                         b->cart, req);
+    default:               PERSISTENT(MPIX_Neighbor_alltoall_init(b->sbuf, count, MPI_BYTE, b->rbuf, count, MPI_BYTE,
+                                                                  b->cart, MPI_INFO_NULL, req));
+    }
+}
+
+struct bench_op {
+    const char *name;
+    int (*op)(int mode, bench_bufs_t *b, int count, MPI_Request *req);
+    int elem_size;        /* MPI_BYTE or MPI_INT elements, 0 if there is no message */
+};
+
+static const struct bench_op ops[] = {
+    { "barrier",              op_barrier,              0 },
+    { "bcast",                op_bcast,                1 },
+    { "reduce",               op_reduce,               sizeof(int) },
+    { "allreduce",            op_allreduce,            sizeof(int) },
+    { "reduce_scatter_block", op_reduce_scatter_block, sizeof(int) },
+    { "scan",                 op_scan,                 sizeof(int) },
+    { "gather",               op_gather,               1 },
+    { "scatter",              op_scatter,              1 },
+    { "allgather",            op_allgather,            1 },
+    { "alltoall",             op_alltoall,             1 },
+    { "alltoallv",            op_alltoallv,            1 },
+    { "neighbor_alltoall",    op_neighbor_alltoall,    1 },
+};
+#define NB_OPS ((int)(sizeof(ops) / sizeof(ops[0])))
+
+static int selected(const char *list, const char *name)
+{
+    size_t len = strlen(name);
+    const char *p = list;
+
+    if (NULL == list) {
+        return 1;
+    }
+    while (NULL != (p = strstr(p, name))) {
+        if ((p == list || ',' == p[-1]) && (',' == p[len] || '\0' == p[len])) {
+            return 1;
+        }
+        p += len;
+    }
+    return 0;
+}
+
+/* every process and element has a distinct value that is small enough to be summed */
+static void fill(bench_bufs_t *b, size_t bytes)
+{
+    int *s = (int*)b->sbuf;
+    for (size_t i = 0; i < bytes / sizeof(int); ++i) {
+        s[i] = (int)((rank_world * 131 + i) % 1021);
+    }
+    memset(b->rbuf, 0, bytes);
+}
+
+/* Timing of one mode: the slowest process of each iteration */
+struct bench_result {
+    double init_us;
+    double lat_min_us;
+    double lat_med_us;
+    double lat_max_us;
+    double overlap_pct;
+    int valid;
+};
+
+static void reduce_times(double *times, int iters)
+{
+    if (0 == rank_world) {
+        MPI_Reduce(MPI_IN_PLACE, times, iters, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        qsort(times, iters, sizeof(double), comp_double);
+    } else {
+        MPI_Reduce(times, NULL, iters, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    }
+}
+
+static int run_once(const struct bench_op *op, int mode, bench_bufs_t *b, int count,
+                    MPI_Request *req, double compute_us, double poll_us)
+{
+    int res;
+
+    if (MODE_BLOCKING == mode) {
+        return op->op(mode, b, count, NULL);
+    }
+    if (MODE_NONBLOCKING == mode) {
+        res = op->op(mode, b, count, req);
+    } else {
+        res = MPI_Start(req);
+    }
+    if (MPI_SUCCESS != res) {
+        return res;
+    }
+    if (0 < compute_us) {
+        compute(compute_us, poll_us, req);
+    }
+    return MPI_Wait(req, MPI_STATUS_IGNORE);
+}
+
+static int bench_mode(const struct bench_op *op, int mode, bench_bufs_t *b, int count, size_t total,
+                      int iters, int warmup, double poll_us, const char *expected,
+                      double *times, struct bench_result *r)
+{
+    MPI_Request req = MPI_REQUEST_NULL;
+    double t, sum_init = 0.0, pure_us;
+    int res, valid, init_iters = (MODE_PERSISTENT == mode) ? 10 : 0;
+
+    memset(r, 0, sizeof(*r));
+
+    /* init cost: create and free the request a few times */
+    for (int i = 0; i < init_iters; ++i) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = now_us();
+        res = op->op(mode, b, count, &req);
+        if (MPI_SUCCESS != res) {
+            return res;
+        }
+        MPI_Request_free(&req);
+        sum_init += now_us() - t;
+    }
+    if (0 < init_iters) {
+        MPI_Allreduce(MPI_IN_PLACE, &sum_init, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        r->init_us = sum_init / init_iters;
+        res = op->op(mode, b, count, &req);
+        if (MPI_SUCCESS != res) {
+            return res;
+        }
+    }
+
+    /* correctness: one start on fresh data must give what the blocking call gave */
+    fill(b, total);
+    res = run_once(op, mode, b, count, &req, 0.0, 0.0);
+    valid = (MPI_SUCCESS == res) && (NULL == expected ||
+                                     (0 == memcmp(expected, b->sbuf, total) &&
+                                      0 == memcmp(expected + total, b->rbuf, total)));
+    MPI_Allreduce(&valid, &r->valid, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    /* pure latency */
+    for (int i = 0; i < warmup; ++i) {
+        run_once(op, mode, b, count, &req, 0.0, 0.0);
+    }
+    for (int i = 0; i < iters; ++i) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = now_us();
+        run_once(op, mode, b, count, &req, 0.0, 0.0);
+        times[i] = now_us() - t;
+    }
+    reduce_times(times, iters);
+    if (0 == rank_world) {
+        r->lat_min_us = times[0];
+        r->lat_med_us = times[(iters - 1) / 2];
+        r->lat_max_us = times[iters - 1];
+    }
+    MPI_Bcast(&r->lat_med_us, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    /* overlap: as much compute as the operation takes, between start and wait */
+    if (MODE_BLOCKING != mode) {
+        pure_us = r->lat_med_us;
+        for (int i = 0; i < iters; ++i) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            t = now_us();
+            run_once(op, mode, b, count, &req, pure_us, poll_us);
+            times[i] = now_us() - t;
+        }
+        reduce_times(times, iters);
+        if (0 == rank_world && 0 < pure_us) {
+            double ovl = 100.0 * (1.0 - (times[(iters - 1) / 2] - pure_us) / pure_us);
+            r->overlap_pct = (ovl < 0.0) ? 0.0 : (ovl > 100.0) ? 100.0 : ovl;
+        }
+    }
+
+    if (MODE_PERSISTENT == mode) {
+        MPI_Request_free(&req);
+    }
+    return MPI_SUCCESS;
+}
+
+static void print_header(int format)
+{
+    if (FORMAT_CSV == format) {
+        printf("label,op,mode,procs,bytes,iters,init_us,lat_min_us,lat_med_us,lat_max_us,overlap_pct,valid\n");
+    } else {
+        printf("[\n");
+    }
+}
+
+static void print_result(int format, int *first, const char *label, const char *op, int mode,
+                         size_t bytes, int iters, const struct bench_result *r)
+{
+    if (FORMAT_CSV == format) {
+        printf("%s,%s,%s,%d,%lu,%d,%.3f,%.3f,%.3f,%.3f,%.1f,%d\n",
+               label, op, mode_names[mode], size_world, (unsigned long)bytes, iters,
+               r->init_us, r->lat_min_us, r->lat_med_us, r->lat_max_us, r->overlap_pct, r->valid);
+    } else {
+        printf("%s  {\"label\": \"%s\", \"op\": \"%s\", \"mode\": \"%s\", \"procs\": %d, \"bytes\": %lu, "
+               "\"iters\": %d, \"init_us\": %.3f, \"lat_min_us\": %.3f, \"lat_med_us\": %.3f, "
+               "\"lat_max_us\": %.3f, \"overlap_pct\": %.1f, \"valid\": %s}",
+               *first ? "" : ",\n", label, op, mode_names[mode], size_world, (unsigned long)bytes, iters,
+               r->init_us, r->lat_min_us, r->lat_med_us, r->lat_max_us, r->overlap_pct,
+               r->valid ? "true" : "false");
+    }
+    *first = 0;
+    fflush(stdout);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-f csv|json] [-l label] [-m min_bytes] [-M max_bytes] [-i iterations]\n"
+                    "          [-w warmup] [-p poll_us] [-o op[,op...]] [-x mode[,mode...]]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int format = FORMAT_CSV, iters_max = 100, warmup = 10, first = 1, c, res;
+    size_t min_bytes = 8, max_bytes = 1 << 20;
+    double poll_us = 0.0, *times;
+    const char *label = "default", *op_list = NULL, *mode_list = NULL;
+    char *expected;
+    bench_bufs_t b;
+    int dims = 0, periods = 1, nblocks;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank_world);
+    MPI_Comm_size(MPI_COMM_WORLD, &size_world);
+
+    while (-1 != (c = getopt(argc, argv, "f:l:m:M:i:w:p:o:x:h"))) {
+        switch (c) {
+        case 'f': format = (0 == strcmp(optarg, "json")) ? FORMAT_JSON : FORMAT_CSV; break;
+        case 'l': label = optarg; break;
+        case 'm': min_bytes = strtoul(optarg, NULL, 0); break;
+        case 'M': max_bytes = strtoul(optarg, NULL, 0); break;
+        case 'i': iters_max = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'p': poll_us = atof(optarg); break;
+        case 'o': op_list = optarg; break;
+        case 'x': mode_list = optarg; break;
+        default:
+            if (0 == rank_world) usage(argv[0]);
+            MPI_Finalize();
+            return ('h' == c) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (iters_max < 1) iters_max = 1;
+    if (min_bytes < sizeof(int)) min_bytes = sizeof(int);
+
+    /* the largest buffers are those of the rooted and all-to-all operations,
+     * and of the neighbourhood ones, which always have two neighbours */
+    nblocks = (size_world < 2) ? 2 : size_world;
+    b.sbuf = malloc(max_bytes * nblocks);
+    b.rbuf = malloc(max_bytes * nblocks);
+    expected = malloc(2 * max_bytes * nblocks);
+    b.counts = malloc(2 * size_world * sizeof(int));
+    times = malloc(iters_max * sizeof(double));
+    if (NULL == b.sbuf || NULL == b.rbuf || NULL == expected || NULL == b.counts || NULL == times) {
+        fprintf(stderr, "[%d] out of memory\n", rank_world);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    b.displs = b.counts + size_world;
+    b.comm = MPI_COMM_WORLD;
+    MPI_Dims_create(size_world, 1, &dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 1, &dims, &periods, 0, &b.cart);
+
+    if (0 == rank_world) {
+        print_header(format);
+    }
+
+    for (int o = 0; o < NB_OPS; ++o) {
+        if (!selected(op_list, ops[o].name)) continue;
+
+        for (size_t bytes = min_bytes; bytes <= max_bytes; bytes *= 2) {
+            int count = (0 < ops[o].elem_size) ? (int)(bytes / ops[o].elem_size) : 0;
+            /* fewer iterations for large messages, so that a full sweep stays short */
+            int iters = (bytes > 8192) ? (int)(iters_max * 8192 / bytes) : iters_max;
+            size_t total = bytes * nblocks;
+            struct bench_result r;
+
+            if (iters < 10) iters = (iters_max < 10) ? iters_max : 10;
+            for (int p = 0; p < size_world; ++p) {
+                b.counts[p] = (int)bytes;
+                b.displs[p] = (int)(p * bytes);
+            }
+
+            /* the blocking call is the reference for the others */
+            fill(&b, total);
+            res = ops[o].op(MODE_BLOCKING, &b, count, NULL);
+            memcpy(expected, b.sbuf, total);
+            memcpy(expected + total, b.rbuf, total);
+
+            for (int m = 0; m < NB_MODES && MPI_SUCCESS == res; ++m) {
+                if (!selected(mode_list, mode_names[m])) continue;
+                if (MODE_PERSISTENT == m && !HAVE_PCOLLREQ) continue;
+
+                res = bench_mode(&ops[o], m, &b, count, total, iters, warmup, poll_us,
+                                 expected, times, &r);
+                if (MPI_SUCCESS != res) {
+                    if (0 == rank_world) {
+                        fprintf(stderr, "%s (%s) failed for %lu bytes (%d)\n",
+                                ops[o].name, mode_names[m], (unsigned long)bytes, res);
+                    }
+                    break;
+                }
+                if (0 == rank_world) {
+                    print_result(format, &first, label, ops[o].name, m,
+                                 (0 < ops[o].elem_size) ? bytes : 0, iters, &r);
+                }
+            }
+            /* the barrier has no message size */
+            if (0 == ops[o].elem_size) break;
+        }
+    }
+
+    if (0 == rank_world && FORMAT_JSON == format) {
+        printf("\n]\n");
+    }
+
+    MPI_Comm_free(&b.cart);
+    free(times);
+    free(b.counts);
+    free(expected);
+    free(b.rbuf);
+    free(b.sbuf);
+
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+#
+# Copyright (c) 2020      EPCC, The University of Edinburgh. All rights
+#                         reserved.
+# $COPYRIGHT$
+#
+# Additional copyrights may follow
+#
+# $HEADER$
+#
+
+#
+# This script runs pcollreq_bench for several communicator sizes (on one
+# node, oversubscribed if need be), once with the persistent collectives of
+# libnbc and once with those of libpnbc_osc, and merges the results into a
+# single CSV file, one row per collective, mode, message size and run
+#
+#   pcollreq_bench.sh [-n "2 4 8 16"] [-o results.csv] [-- benchmark options]
+#
+# e.g. compare the persistent alltoallv of both components up to 64 KiB:
+#   pcollreq_bench.sh -n "4 16" -- -o alltoallv -x persistent -M 65536
+#
+
+exe=${PCOLLREQ_BENCH:-./pcollreq_bench}
+nprocs="2 4 8 16"
+out=pcollreq_bench.csv
+
+while [ $# -gt 0 ]
+do
+    case "$1" in
+        -n) nprocs="$2"; shift 2;;
+        -o) out="$2"; shift 2;;
+        --) shift; break;;
+        *) echo "usage: $0 [-n \"np ...\"] [-o file.csv] [-- benchmark options]"; exit 1;;
+    esac
+done
+
+# label and MCA options of every run
+runs=("libnbc"      "--mca coll ^libpnbc_osc"
+      "libpnbc_osc" "--mca coll_libpnbc_osc_priority 100")
+
+rm -f $out
+for np in $nprocs
+do
+    for ((r = 0; r < ${#runs[@]}; r += 2))
+    do
+        label=${runs[$r]}
+        echo "# $label on $np processes" >&2
+        mpirun -n $np --oversubscribe ${runs[$((r + 1))]} $exe -f csv -l $label "$@" > $out.tmp
+        if [ $? -ne 0 ]
+        then
+            echo "# $label on $np processes failed, see $out.tmp" >&2
+            exit 1
+        fi
+        # keep the header of the first run only
+        if [ -s $out ]
+        then
+            tail -n +2 $out.tmp >> $out
+        else
+            cat $out.tmp > $out
+        fi
+    done
+done
+rm -f $out.tmp
+echo "# results in $out" >&2
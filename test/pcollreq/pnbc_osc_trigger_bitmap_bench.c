@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pnbc_osc_trigger_bitmap.h"
+
+// benchmark of the cost of one libpnbc_osc progress pass over an idle schedule,
+// i.e. one in which nothing is ready yet, against the communicator size. it only
+// needs the trigger sources of the component, not MPI, and runs as a single process
+// the schedule mimics the pull steps of an alltoallv: per peer, signalled RTS and
+// DONE flags, three local counters, three request slots and eight triggers
+
+// stand-in for the request test, which needs the rest of the library
+int triggered_all_byrequest_flag(FLAG_t *trigger, void *cbstate) {
+  return NULL != *(void**)cbstate;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+int main() {
+  int errors = 0;
+
+  printf("%8s %10s %14s %14s %8s\n", "peers", "triggers", "linear ns", "bitmap ns", "speedup");
+  for (int peers = 16 ; peers <= 16384 ; peers *= 4) {
+    int num_flags = 5 * peers, num_requests = 3 * peers, num_triggers = 8 * peers + 1;
+    FLAG_t *flags = calloc(num_flags + 1, sizeof(FLAG_t));
+    FLAG_t *seen = calloc(num_flags + 1, sizeof(FLAG_t));
+    void **requests = calloc(num_requests, sizeof(void*));
+    triggerable_t *triggers = calloc(num_triggers, sizeof(triggerable_t));
+    FLAG_t start_pending = 0;
+    triggerable_bitmap bitmap;
+    int t = 0, fired = 0, iters = (1 << 24) / num_triggers + 10;
+    double t0, linear, scan;
+
+    trigger_init_flag(&triggers[t++], &start_pending, action_all_noop, NULL);
+    for (int p = 0 ; p < peers ; ++p) {
+      trigger_init_signal(&triggers[t++], &flags[p], &seen[p], action_all_noop, NULL);
+      trigger_init_signal(&triggers[t++], &flags[peers + p], &seen[peers + p], action_all_noop, NULL);
+      for (int c = 0 ; c < 3 ; ++c) {
+        trigger_init_counter(&triggers[t++], &flags[(2 + c) * peers + p], 2, action_all_noop, NULL);
+        trigger_init_request(&triggers[t++], &requests[c * peers + p], action_all_noop, NULL);
+      }
+    }
+    if (0 != trigger_bitmap_init(&bitmap, triggers, t, flags, seen, num_flags, requests, num_requests)) {
+      printf("out of memory\n");
+      return 1;
+    }
+    if (1 != bitmap.num_other) errors++;
+    trigger_bitmap_arm(&bitmap);
+
+    t0 = now();
+    for (int i = 0 ; i < iters ; ++i) {
+      for (int k = 0 ; k < t ; ++k) {
+        if (ACTION_SUCCESS == trigger_test(&triggers[k])) fired++;
+      }
+    }
+    linear = (now() - t0) / iters;
+
+    t0 = now();
+    for (int i = 0 ; i < iters ; ++i) {
+      trigger_bitmap_test(&bitmap, triggers, flags, seen, requests, &fired);
+    }
+    scan = (now() - t0) / iters;
+    if (0 != fired) errors++;
+
+    // one remote signal and one request: exactly these two triggers fire, once
+    flags[peers + peers / 2] += 1;
+    requests[2 * peers + 1] = &start_pending;
+    trigger_bitmap_test(&bitmap, triggers, flags, seen, requests, &fired);
+    trigger_bitmap_test(&bitmap, triggers, flags, seen, requests, &fired);
+    if (2 != fired) errors++;
+
+    // the next signal arrives before the next start: it is kept until then
+    flags[peers + peers / 2] += 1;
+    trigger_bitmap_test(&bitmap, triggers, flags, seen, requests, &fired);
+    if (2 != fired) errors++;
+    trigger_bitmap_arm(&bitmap);
+    requests[2 * peers + 1] = NULL;
+    trigger_bitmap_test(&bitmap, triggers, flags, seen, requests, &fired);
+    if (3 != fired || seen[peers + peers / 2] != 2) errors++;
+
+    printf("%8d %10d %14.1f %14.1f %8.1f\n", peers, t, 1e9 * linear, 1e9 * scan, linear / scan);
+
+    trigger_bitmap_free(&bitmap);
+    free(triggers);
+    free(requests);
+    free(seen);
+    free(flags);
+  }
+
+  printf("errors = %d\n", errors);
+  return errors;
+}
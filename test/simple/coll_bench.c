@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Latency of the data movement and reduction collectives, checking their
+  results.
+
+  For each collective and each message size from 1 byte to -m bytes (per
+  process and per block), the average time of -i calls is printed, in
+  microseconds, as the largest over the processes. -c runs a single
+  collective: allgather, allgatherv, alltoall, gather, scatter, scan,
+  exscan or allreduce. The reductions use MPI_INT and MPI_SUM, their
+  sizes are rounded down to a multiple of an int.
+
+  Run it once per component to compare them, e.g.
+
+  mpirun -np 8 --mca coll_sm_priority 100 ./coll_bench
+  mpirun -np 8 --mca coll ^sm ./coll_bench
+
+  options: [-c collective] [-m max bytes] [-i iterations]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mpi.h"
+
+enum { ALLGATHER, ALLGATHERV, ALLTOALL, GATHER, SCATTER, SCAN, EXSCAN, ALLREDUCE, NCOLLS };
+
+static const char *names[NCOLLS] = {
+    "allgather", "allgatherv", "alltoall", "gather", "scatter", "scan", "exscan", "allreduce"
+};
+
+static int rank, size, iterations = 100;
+static size_t max_bytes = 1 << 20;
+static char *sbuf, *rbuf;
+static int *counts, *displs;
+
+static void run(int coll, size_t bytes)
+{
+    int n = (int) bytes, nint = (int) (bytes / sizeof(int));
+
+    switch (coll) {
+    case ALLGATHER:
+        MPI_Allgather(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, MPI_COMM_WORLD);
+        break;
+    case ALLGATHERV:
+        MPI_Allgatherv(sbuf, n, MPI_BYTE, rbuf, counts, displs, MPI_BYTE, MPI_COMM_WORLD);
+        break;
+    case ALLTOALL:
+        MPI_Alltoall(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, MPI_COMM_WORLD);
+        break;
+    case GATHER:
+        MPI_Gather(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, 0, MPI_COMM_WORLD);
+        break;
+    case SCATTER:
+        MPI_Scatter(sbuf, n, MPI_BYTE, rbuf, n, MPI_BYTE, 0, MPI_COMM_WORLD);
+        break;
+    case SCAN:
+        MPI_Scan(sbuf, rbuf, nint, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        break;
+    case EXSCAN:
+        MPI_Exscan(sbuf, rbuf, nint, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        break;
+    case ALLREDUCE:
+        MPI_Allreduce(sbuf, rbuf, nint, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        break;
+    }
+}
+
+/* byte i of the data process p sends to process q */
+static char pattern(int p, int q, size_t i)
+{
+    return (char) (p * 31 + q * 7 + i);
+}
+
+static void fill(int coll, size_t bytes)
+{
+    int *ints = (int *) sbuf;
+
+    switch (coll) {
+    case ALLTOALL:
+    case SCATTER:
+        for (int q = 0; q < size; ++q) {
+            for (size_t i = 0; i < bytes; ++i) {
+                sbuf[q * bytes + i] = pattern(rank, q, i);
+            }
+        }
+        break;
+    case SCAN:
+    case EXSCAN:
+    case ALLREDUCE:
+        for (size_t i = 0; i < bytes / sizeof(int); ++i) {
+            ints[i] = rank + 1 + (int) i;
+        }
+        break;
+    default:
+        for (size_t i = 0; i < bytes; ++i) {
+            sbuf[i] = pattern(rank, 0, i);
+        }
+        break;
+    }
+    memset(rbuf, 0xff, size * max_bytes);
+    for (int p = 0; p < size; ++p) {
+        counts[p] = (int) bytes;
+        displs[p] = (int) (p * bytes);
+    }
+}
+
+static int check(int coll, size_t bytes)
+{
+    int *ints = (int *) rbuf;
+
+    switch (coll) {
+    case ALLGATHER:
+    case ALLGATHERV:
+    case GATHER:
+        if (GATHER == coll && 0 != rank) {
+            return 0;
+        }
+        for (int p = 0; p < size; ++p) {
+            for (size_t i = 0; i < bytes; ++i) {
+                if (rbuf[p * bytes + i] != pattern(p, 0, i)) {
+                    return 1;
+                }
+            }
+        }
+        break;
+    case ALLTOALL:
+        for (int p = 0; p < size; ++p) {
+            for (size_t i = 0; i < bytes; ++i) {
+                if (rbuf[p * bytes + i] != pattern(p, rank, i)) {
+                    return 1;
+                }
+            }
+        }
+        break;
+    case SCATTER:
+        for (size_t i = 0; i < bytes; ++i) {
+            if (rbuf[i] != pattern(0, rank, i)) {
+                return 1;
+            }
+        }
+        break;
+    case SCAN:
+    case EXSCAN:
+    case ALLREDUCE: {
+        /* sum of p + 1 + i over the processes before (and including) me,
+         * or over all of them */
+        int procs = (SCAN == coll) ? rank + 1 : (EXSCAN == coll) ? rank : size;
+
+        if (0 == procs) {
+            return 0;
+        }
+        for (size_t i = 0; i < bytes / sizeof(int); ++i) {
+            if (ints[i] != procs * (procs + 1) / 2 + procs * (int) i) {
+                return 1;
+            }
+        }
+        break;
+    }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt, first = 0, last = NCOLLS - 1, errors = 0, all_errors;
+    double elapsed, max_elapsed;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    while (-1 != (opt = getopt(argc, argv, "c:m:i:h"))) {
+        switch (opt) {
+        case 'c':
+            for (first = 0; first < NCOLLS && 0 != strcmp(optarg, names[first]); ++first);
+            last = first;
+            break;
+        case 'm': max_bytes = strtoul(optarg, NULL, 0); break;
+        case 'i': iterations = atoi(optarg); break;
+        default:
+            if (0 == rank) {
+                fprintf(stderr, "Usage: %s [-c collective] [-m max bytes] [-i iterations]\n",
+                        argv[0]);
+            }
+            MPI_Finalize();
+            return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (first >= NCOLLS || iterations < 1 || max_bytes < 1) {
+        if (0 == rank) {
+            fprintf(stderr, "invalid arguments\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    sbuf = malloc(size * max_bytes);
+    rbuf = malloc(size * max_bytes);
+    counts = malloc(size * sizeof(int));
+    displs = malloc(size * sizeof(int));
+    if (NULL == sbuf || NULL == rbuf || NULL == counts || NULL == displs) {
+        fprintf(stderr, "out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (0 == rank) {
+        printf("# %d processes, %d iterations\n", size, iterations);
+        printf("%-12s %12s %14s\n", "collective", "bytes", "usec");
+    }
+
+    for (int coll = first; coll <= last; ++coll) {
+        for (size_t bytes = 1; bytes <= max_bytes; bytes *= 2) {
+            if ((SCAN == coll || EXSCAN == coll || ALLREDUCE == coll) && bytes < sizeof(int)) {
+                continue;
+            }
+
+            fill(coll, bytes);
+            run(coll, bytes);
+            if (check(coll, bytes)) {
+                fprintf(stderr, "%d: wrong %s result for %zu bytes\n", rank,
+                        names[coll], bytes);
+                ++errors;
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            elapsed = MPI_Wtime();
+            for (int it = 0; it < iterations; ++it) {
+                run(coll, bytes);
+            }
+            elapsed = (MPI_Wtime() - elapsed) / iterations;
+
+            MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+            if (0 == rank) {
+                printf("%-12s %12zu %14.2f\n", names[coll], bytes, max_elapsed * 1e6);
+            }
+        }
+    }
+
+    MPI_Allreduce(&errors, &all_errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    free(sbuf);
+    free(rbuf);
+    free(counts);
+    free(displs);
+    MPI_Finalize();
+    return 0 == all_errors ? 0 : 1;
+}
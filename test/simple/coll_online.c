@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Correctness of the coll/tuned online algorithm selection.
+
+  With coll_tuned_online_trials set (to 2 unless it is in the environment),
+  each of allgather, allreduce, alltoall, barrier, bcast and reduce is called
+  on MPI_COMM_WORLD and, with 3 processes or more, on a communicator of all
+  but the last one, for three message sizes. Each size gets enough calls to
+  try every algorithm, then a few more with the algorithm locked in. Every
+  call checks its result. Once done, the coll_tuned_<coll>_online_decisions
+  MPI_T variable of the communicator must show a decision, the same on all
+  the processes, for each of the sizes (one for barrier).
+
+  To be run as:
+
+  mpirun -np 4 ./coll_online [-m max bytes] [-x extra calls]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mpi.h"
+
+enum { ALLGATHER, ALLREDUCE, ALLTOALL, BARRIER, BCAST, REDUCE, NCOLLS };
+
+static const char *names[NCOLLS] = {
+    "allgather", "allreduce", "alltoall", "barrier", "bcast", "reduce"
+};
+
+#define NSIZES 3
+#define MAX_BUCKETS 64
+
+static int errors = 0, trials;
+static int *sbuf, *rbuf;
+
+static int cvar_read(const char *name, int *value)
+{
+    MPI_T_cvar_handle handle;
+    int index, count;
+
+    if (MPI_SUCCESS != MPI_T_cvar_get_index(name, &index) ||
+        MPI_SUCCESS != MPI_T_cvar_handle_alloc(index, NULL, &handle, &count)) {
+        return -1;
+    }
+    MPI_T_cvar_read(handle, value);
+    MPI_T_cvar_handle_free(&handle);
+    return 0;
+}
+
+/* Decisions of the communicator for each message size bucket, -1 if unknown */
+static int decisions_read(int coll, MPI_Comm comm, int *decisions)
+{
+    MPI_T_pvar_session session;
+    MPI_T_pvar_handle handle;
+    char name[128];
+    int index, count = 0, rc;
+
+    snprintf(name, sizeof(name), "coll_tuned_%s_online_decisions", names[coll]);
+    if (MPI_SUCCESS != MPI_T_pvar_get_index(name, MPI_T_PVAR_CLASS_GENERIC, &index)) {
+        return 0;
+    }
+    MPI_T_pvar_session_create(&session);
+    rc = MPI_T_pvar_handle_alloc(session, index, &comm, &handle, &count);
+    if (MPI_SUCCESS == rc && count > 0 && count <= MAX_BUCKETS) {
+        MPI_T_pvar_read(session, handle, decisions);
+        MPI_T_pvar_handle_free(session, &handle);
+    } else {
+        count = 0;
+    }
+    MPI_T_pvar_session_free(&session);
+    return count;
+}
+
+static void check(int ok, int coll, int comsize, int n, int call, int k)
+{
+    if (!ok) {
+        fprintf(stderr, "%s on %d processes, %d ints, call %d: wrong element %d\n",
+                names[coll], comsize, n, call, k);
+        errors++;
+    }
+}
+
+/* One call of a collective on n ints per process (per block), checked */
+static void run(int coll, MPI_Comm comm, int n, int call)
+{
+    int rank, size, root, k;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    root = call % size;
+
+    switch (coll) {
+    case ALLGATHER:
+        for (k = 0; k < n; ++k) sbuf[k] = rank * n + k + call;
+        MPI_Allgather(sbuf, n, MPI_INT, rbuf, n, MPI_INT, comm);
+        for (k = 0; k < n * size && rbuf[k] == k + call; ++k);
+        check(k == n * size, coll, size, n, call, k);
+        break;
+    case ALLREDUCE:
+        for (k = 0; k < n; ++k) sbuf[k] = rank + k + call;
+        MPI_Allreduce(sbuf, rbuf, n, MPI_INT, MPI_SUM, comm);
+        for (k = 0; k < n && rbuf[k] == size * (k + call) + size * (size - 1) / 2; ++k);
+        check(k == n, coll, size, n, call, k);
+        break;
+    case ALLTOALL:
+        for (k = 0; k < n * size; ++k) sbuf[k] = (rank * size + k / n) * 7 + k % n % 7 + call;
+        MPI_Alltoall(sbuf, n, MPI_INT, rbuf, n, MPI_INT, comm);
+        for (k = 0; k < n * size && rbuf[k] == ((k / n) * size + rank) * 7 + k % n % 7 + call; ++k);
+        check(k == n * size, coll, size, n, call, k);
+        break;
+    case BARRIER:
+        MPI_Barrier(comm);
+        break;
+    case BCAST:
+        for (k = 0; k < n; ++k) rbuf[k] = (rank == root) ? root + k + call : -1;
+        MPI_Bcast(rbuf, n, MPI_INT, root, comm);
+        for (k = 0; k < n && rbuf[k] == root + k + call; ++k);
+        check(k == n, coll, size, n, call, k);
+        break;
+    case REDUCE:
+        for (k = 0; k < n; ++k) sbuf[k] = rank + k + call;
+        MPI_Reduce(sbuf, rbuf, n, MPI_INT, MPI_SUM, root, comm);
+        if (rank == root) {
+            for (k = 0; k < n && rbuf[k] == size * (k + call) + size * (size - 1) / 2; ++k);
+            check(k == n, coll, size, n, call, k);
+        }
+        break;
+    }
+}
+
+static void test(int coll, MPI_Comm comm, const int *counts, int extra)
+{
+    int decisions[MAX_BUCKETS], low[MAX_BUCKETS], high[MAX_BUCKETS];
+    int algs = 0, nbuckets, decided = 0, rank, size;
+    char name[128];
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    snprintf(name, sizeof(name), "coll_tuned_%s_algorithm_count", names[coll]);
+    (void) cvar_read(name, &algs);
+
+    for (int s = 0; s < NSIZES; ++s) {
+        for (int call = 0; call < algs * trials + extra; ++call) {
+            run(coll, comm, counts[s], call);
+        }
+    }
+
+    nbuckets = decisions_read(coll, comm, decisions);
+    if (0 == nbuckets) {
+        if (0 == rank) {
+            fprintf(stderr, "%s: no online decisions, is coll/tuned selected?\n", names[coll]);
+        }
+        errors++;
+        return;
+    }
+    MPI_Allreduce(decisions, low, nbuckets, MPI_INT, MPI_MIN, comm);
+    MPI_Allreduce(decisions, high, nbuckets, MPI_INT, MPI_MAX, comm);
+    for (int b = 0; b < nbuckets; ++b) {
+        if (low[b] != high[b]) {
+            fprintf(stderr, "%s on %d processes: decisions for bucket %d differ (%d to %d)\n",
+                    names[coll], size, b, low[b], high[b]);
+            errors++;
+        } else if (decisions[b] >= algs) {
+            fprintf(stderr, "%s on %d processes: bucket %d decided algorithm %d of %d\n",
+                    names[coll], size, b, decisions[b], algs);
+            errors++;
+        }
+        decided += (decisions[b] >= 0);
+    }
+    if (decided != (BARRIER == coll ? 1 : NSIZES)) {
+        fprintf(stderr, "%s on %d processes: %d message sizes decided instead of %d\n",
+                names[coll], size, decided, BARRIER == coll ? 1 : NSIZES);
+        errors++;
+    }
+    if (0 == rank) {
+        printf("%-10s %4d processes:", names[coll], size);
+        for (int b = 0; b < nbuckets; ++b) {
+            if (decisions[b] >= 0) {
+                printf(" [2^%d] %d", b, decisions[b]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size, opt, provided, total, extra = 3;
+    size_t max_bytes = 1 << 16;
+    int counts[NSIZES];
+    MPI_Comm sub;
+
+    /* The online selection is part of the dynamic rules, after the rule
+       file and the forced algorithms */
+    setenv("OMPI_MCA_coll_tuned_use_dynamic_rules", "1", 1);
+    unsetenv("OMPI_MCA_coll_tuned_dynamic_rules_filename");
+    setenv("OMPI_MCA_coll_tuned_online_trials", "2", 0);
+    setenv("OMPI_MCA_coll_tuned_priority", "100", 0);
+
+    while (-1 != (opt = getopt(argc, argv, "m:x:"))) {
+        switch (opt) {
+        case 'm': max_bytes = strtoul(optarg, NULL, 0); break;
+        case 'x': extra = atoi(optarg); break;
+        }
+    }
+    trials = atoi(getenv("OMPI_MCA_coll_tuned_online_trials"));
+    /* three sizes 2^6 apart, so that they are in different buckets */
+    counts[2] = (int) (max_bytes / sizeof(int));
+    counts[1] = counts[2] >> 6;
+    counts[0] = counts[1] >> 6;
+    if (trials < 1 || extra < 0 || counts[0] < 1) {
+        fprintf(stderr, "coll_online: needs online trials, and -m of 16k or more\n");
+        return 1;
+    }
+
+    MPI_Init(&argc, &argv);
+    MPI_T_init_thread(MPI_THREAD_SINGLE, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    sbuf = malloc(max_bytes * size);
+    rbuf = malloc(max_bytes * size);
+    if (NULL == sbuf || NULL == rbuf) {
+        fprintf(stderr, "coll_online: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    /* A second communicator, of another size, learns on its own */
+    MPI_Comm_split(MPI_COMM_WORLD, (size > 2 && rank < size - 1) ? 0 : MPI_UNDEFINED, rank, &sub);
+    for (int c = 0; c < NCOLLS; ++c) {
+        test(c, MPI_COMM_WORLD, counts, extra);
+        if (MPI_COMM_NULL != sub) {
+            test(c, sub, counts, extra);
+        }
+    }
+    if (MPI_COMM_NULL != sub) {
+        MPI_Comm_free(&sub);
+    }
+
+    MPI_Reduce(&errors, &total, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("coll_online: %d trials: %s\n", trials, 0 == total ? "passed" : "FAILED");
+    }
+
+    free(sbuf);
+    free(rbuf);
+    MPI_T_finalize();
+    MPI_Finalize();
+    return 0 == total ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Multithreaded message rate on a single communicator.
+
+  Every process runs -t threads. Thread t receives from the process t + 1
+  ranks to its left and sends to the process t + 1 ranks to its right, so
+  with at least t + 2 processes each thread of a process talks to its own
+  pair of peers. Each iteration a thread posts a window of -w receives,
+  then -w sends of -s bytes, and waits for all of them. With -a the
+  receives use MPI_ANY_SOURCE instead.
+
+  Run it once per matching mode to compare them, e.g.
+
+  mpirun -np 5 --mca pml ob1 --mca pml_ob1_match_per_peer 0 ./mt_msgrate -t 4
+  mpirun -np 5 --mca pml ob1 --mca pml_ob1_match_per_peer 1 ./mt_msgrate -t 4
+
+  options: [-t threads] [-s bytes] [-w window] [-i iterations] [-a]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "mpi.h"
+
+struct worker {
+    pthread_t thread;
+    int id;
+    char *sbuf;
+    char *rbuf;
+    MPI_Request *reqs;
+    double elapsed;
+};
+
+static int rank, size, nthreads = 4, window = 64, iterations = 2000, any_source = 0;
+static size_t bytes = 8;
+static pthread_barrier_t barrier;
+
+static void *worker_run(void *arg)
+{
+    struct worker *w = (struct worker *) arg;
+    int to = (rank + 1 + w->id) % size;
+    int from = (rank + size - 1 - w->id % size) % size;
+    double start = 0.0;
+
+    if (any_source) {
+        from = MPI_ANY_SOURCE;
+    }
+
+    /* a few warmup iterations, then all the threads of the process start
+     * together */
+    for (int it = -10; it < iterations; ++it) {
+        if (0 == it) {
+            pthread_barrier_wait(&barrier);
+            start = MPI_Wtime();
+        }
+        for (int i = 0; i < window; ++i) {
+            MPI_Irecv(w->rbuf + i * bytes, (int) bytes, MPI_BYTE, from, w->id,
+                      MPI_COMM_WORLD, &w->reqs[i]);
+        }
+        for (int i = 0; i < window; ++i) {
+            MPI_Isend(w->sbuf, (int) bytes, MPI_BYTE, to, w->id,
+                      MPI_COMM_WORLD, &w->reqs[window + i]);
+        }
+        MPI_Waitall(2 * window, w->reqs, MPI_STATUSES_IGNORE);
+    }
+    w->elapsed = MPI_Wtime() - start;
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    struct worker *workers;
+    double elapsed = 0.0, max_elapsed;
+    int provided, opt;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    while (-1 != (opt = getopt(argc, argv, "t:s:w:i:ah"))) {
+        switch (opt) {
+        case 't': nthreads = atoi(optarg); break;
+        case 's': bytes = strtoul(optarg, NULL, 0); break;
+        case 'w': window = atoi(optarg); break;
+        case 'i': iterations = atoi(optarg); break;
+        case 'a': any_source = 1; break;
+        default:
+            if (0 == rank) {
+                fprintf(stderr, "Usage: %s [-t threads] [-s bytes] [-w window]"
+                        " [-i iterations] [-a]\n", argv[0]);
+            }
+            MPI_Finalize();
+            return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (MPI_THREAD_MULTIPLE != provided) {
+        if (0 == rank) {
+            fprintf(stderr, "MPI_THREAD_MULTIPLE is not supported\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    if (nthreads < 1 || window < 1 || iterations < 1 || size < 2) {
+        if (0 == rank) {
+            fprintf(stderr, "invalid arguments\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    if (0 == rank && size < nthreads + 2) {
+        printf("# warning: less than %d processes, threads share peers\n", nthreads + 2);
+    }
+
+    workers = calloc(nthreads, sizeof(struct worker));
+    if (NULL == workers) {
+        fprintf(stderr, "out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    pthread_barrier_init(&barrier, NULL, nthreads);
+
+    for (int t = 0; t < nthreads; ++t) {
+        workers[t].id = t;
+        workers[t].sbuf = malloc(bytes ? bytes : 1);
+        workers[t].rbuf = malloc(window * (bytes ? bytes : 1));
+        workers[t].reqs = malloc(2 * window * sizeof(MPI_Request));
+        if (NULL == workers[t].sbuf || NULL == workers[t].rbuf || NULL == workers[t].reqs) {
+            fprintf(stderr, "out of memory\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        memset(workers[t].sbuf, rank, bytes);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    for (int t = 0; t < nthreads; ++t) {
+        pthread_create(&workers[t].thread, NULL, worker_run, &workers[t]);
+    }
+    for (int t = 0; t < nthreads; ++t) {
+        pthread_join(workers[t].thread, NULL);
+        if (workers[t].elapsed > elapsed) {
+            elapsed = workers[t].elapsed;
+        }
+    }
+
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (0 == rank) {
+        /* messages received per second and per process */
+        double msgs = (double) nthreads * window * iterations;
+        printf("# %d processes, %d threads, %zu bytes, window %d%s\n", size, nthreads,
+               bytes, window, any_source ? ", MPI_ANY_SOURCE" : "");
+        printf("%-12s %14s\n", "seconds", "msgs/s/proc");
+        printf("%-12.4f %14.0f\n", max_elapsed, msgs / max_elapsed);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        free(workers[t].sbuf);
+        free(workers[t].rbuf);
+        free(workers[t].reqs);
+    }
+    free(workers);
+    pthread_barrier_destroy(&barrier);
+    MPI_Finalize();
+    return 0;
+}
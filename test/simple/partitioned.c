@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Correctness of partitioned communication (MPI_Psend_init, MPI_Precv_init,
+  MPI_Pready, MPI_Pready_range, MPI_Pready_list and MPI_Parrived).
+
+  Even ranks send to the next odd rank, over two partitioned requests at a
+  time: A, with the same -p partitions of -c ints on both sides, and B, whose
+  receive side has half as many partitions, twice as large. Each of -i
+  iterations restarts both, with MPI_Startall or with MPI_Start, and checks
+  that
+   - no receive partition has arrived before the sender marks any ready,
+   - the second half of A, marked ready first and in reverse order, arrives
+     while the first half is still missing,
+   - every partition holds the data of this iteration once complete,
+   - MPI_Parrived reports every partition once the request is complete.
+  B is marked ready with MPI_Pready_list in an interleaved order.
+
+  The test sets the pml_base_part_min_message_size MCA parameter so that -g
+  send partitions are coalesced into one message (1 to not coalesce them).
+
+  To be run over both the sm and the tcp BTLs:
+
+  mpirun -np 2 --mca pml ob1 --mca btl self,sm ./partitioned
+  mpirun -np 2 --mca pml ob1 --mca btl self,tcp ./partitioned
+
+  options: [-p partitions] [-c ints per partition] [-g coalesced partitions]
+           [-i iterations]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mpi.h"
+
+#define TAG_A     1
+#define TAG_B     2
+#define TAG_TOKEN 3
+
+static int errors = 0;
+
+static int value(int iter, int req, int index)
+{
+    return (iter * 2 + req) * 1000003 + index;
+}
+
+static void check_data(const int *buf, int first, int last, int iter, int req, const char *what)
+{
+    for (int k = first; k < last; ++k) {
+        if (buf[k] != value(iter, req, k)) {
+            fprintf(stderr, "iteration %d %s: element %d is %d instead of %d\n",
+                    iter, what, k, buf[k], value(iter, req, k));
+            errors++;
+            return;
+        }
+    }
+}
+
+static void check_arrived(MPI_Request req, int first, int last, int expected, int iter,
+                          const char *what)
+{
+    int flag;
+
+    for (int p = first; p < last; ++p) {
+        MPI_Parrived(req, p, &flag);
+        if (!flag != !expected) {
+            fprintf(stderr, "iteration %d %s: partition %d %s\n", iter, what, p,
+                    expected ? "has not arrived" : "arrived too early");
+            errors++;
+            return;
+        }
+    }
+}
+
+static void start(MPI_Request *reqs, int iter)
+{
+    if (iter % 2) {
+        MPI_Start(&reqs[0]);
+        MPI_Start(&reqs[1]);
+    } else {
+        MPI_Startall(2, reqs);
+    }
+}
+
+static void sender(int peer, int parts, int count, int iters)
+{
+    int *bufa = malloc(parts * count * sizeof(int));
+    int *bufb = malloc(parts * count * sizeof(int));
+    int *list = malloc(parts * sizeof(int));
+    MPI_Request reqs[2];
+
+    if (NULL == bufa || NULL == bufb || NULL == list) {
+        fprintf(stderr, "partitioned: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Psend_init(bufa, parts, count, MPI_INT, peer, TAG_A, MPI_COMM_WORLD, MPI_INFO_NULL,
+                   &reqs[0]);
+    MPI_Psend_init(bufb, parts, count, MPI_INT, peer, TAG_B, MPI_COMM_WORLD, MPI_INFO_NULL,
+                   &reqs[1]);
+    /* odd partitions from the last, then even ones from the first */
+    for (int n = 0; n < parts; ++n) {
+        list[n] = (n < parts / 2) ? parts - 1 - 2 * n : 2 * (n - parts / 2);
+    }
+
+    for (int iter = 0; iter < iters; ++iter) {
+        for (int k = 0; k < parts * count; ++k) {
+            bufa[k] = value(iter, 0, k);
+            bufb[k] = value(iter, 1, k);
+        }
+        start(reqs, iter);
+
+        /* the receiver checked that nothing arrived yet */
+        MPI_Recv(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        for (int p = parts - 1; p >= parts / 2; --p) {
+            MPI_Pready(p, reqs[0]);
+        }
+        MPI_Send(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD);
+        /* the receiver got the second half, without the first one */
+        MPI_Recv(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Pready_range(0, parts / 2 - 1, reqs[0]);
+        MPI_Pready_list(parts, list, reqs[1]);
+
+        MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+    }
+
+    MPI_Request_free(&reqs[0]);
+    MPI_Request_free(&reqs[1]);
+    free(list);
+    free(bufb);
+    free(bufa);
+}
+
+static void receiver(int peer, int parts, int count, int iters)
+{
+    int *bufa = malloc(parts * count * sizeof(int));
+    int *bufb = malloc(parts * count * sizeof(int));
+    MPI_Request reqs[2];
+    int flag;
+
+    if (NULL == bufa || NULL == bufb) {
+        fprintf(stderr, "partitioned: out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Precv_init(bufa, parts, count, MPI_INT, peer, TAG_A, MPI_COMM_WORLD, MPI_INFO_NULL,
+                   &reqs[0]);
+    MPI_Precv_init(bufb, parts / 2, 2 * count, MPI_INT, peer, TAG_B, MPI_COMM_WORLD,
+                   MPI_INFO_NULL, &reqs[1]);
+
+    for (int iter = 0; iter < iters; ++iter) {
+        memset(bufa, 0xff, parts * count * sizeof(int));
+        memset(bufb, 0xff, parts * count * sizeof(int));
+        start(reqs, iter);
+
+        check_arrived(reqs[0], 0, parts, 0, iter, "A before pready");
+        check_arrived(reqs[1], 0, parts / 2, 0, iter, "B before pready");
+        MPI_Send(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD);
+
+        /* the second half of A is ready, in reverse order */
+        MPI_Recv(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        for (int p = parts / 2; p < parts; ++p) {
+            do {
+                MPI_Parrived(reqs[0], p, &flag);
+            } while (!flag);
+        }
+        check_data(bufa, parts / 2 * count, parts * count, iter, 0, "A second half");
+        check_arrived(reqs[0], 0, parts / 2, 0, iter, "A first half");
+        MPI_Send(NULL, 0, MPI_BYTE, peer, TAG_TOKEN, MPI_COMM_WORLD);
+
+        MPI_Waitall(2, reqs, MPI_STATUSES_IGNORE);
+        check_data(bufa, 0, parts * count, iter, 0, "A");
+        check_data(bufb, 0, parts * count, iter, 1, "B");
+        check_arrived(reqs[0], 0, parts, 1, iter, "A after completion");
+        check_arrived(reqs[1], 0, parts / 2, 1, iter, "B after completion");
+    }
+
+    MPI_Request_free(&reqs[0]);
+    MPI_Request_free(&reqs[1]);
+    free(bufb);
+    free(bufa);
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size, opt, total;
+    int parts = 16, count = 1024, group = 2, iters = 10;
+    char min_size[32];
+
+    while (-1 != (opt = getopt(argc, argv, "p:c:g:i:"))) {
+        switch (opt) {
+        case 'p': parts = atoi(optarg); break;
+        case 'c': count = atoi(optarg); break;
+        case 'g': group = atoi(optarg); break;
+        case 'i': iters = atoi(optarg); break;
+        }
+    }
+    /* The halves of A must not share a message */
+    if (count < 1 || group < 1 || iters < 1 || parts < 2 * group || parts % (2 * group)) {
+        fprintf(stderr, "partitioned: the partitions must be a multiple of twice the "
+                "coalesced partitions\n");
+        return 1;
+    }
+    snprintf(min_size, sizeof(min_size), "%zu", (size_t) group * count * sizeof(int));
+    setenv("OMPI_MCA_pml_base_part_min_message_size", min_size, 1);
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (0 == rank % 2 && rank + 1 < size) {
+        sender(rank + 1, parts, count, iters);
+    } else if (1 == rank % 2) {
+        receiver(rank - 1, parts, count, iters);
+    }
+
+    MPI_Reduce(&errors, &total, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("partitioned: %d partitions of %d ints, %d per message, %d iterations: %s\n",
+               parts, count, group, iters, 0 == total ? "passed" : "FAILED");
+    }
+
+    MPI_Finalize();
+    return 0 == total ? 0 : 1;
+}
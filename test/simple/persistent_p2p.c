@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020      The University of Tennessee and The University
+ *                         of Tennessee Research Foundation.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+  Latency of a halo exchange done with persistent requests
+  (MPI_Startall + MPI_Waitall) against the same exchange done with
+  MPI_Isend / MPI_Irecv + MPI_Waitall.
+
+  Every process exchanges -n messages with each of its two neighbours on a
+  ring, so one iteration moves 4 * n requests per process. The reported
+  time is the average of one iteration on the slowest process.
+
+  To be run as:
+
+  mpirun -np 2 ./persistent_p2p [-m min_bytes] [-M max_bytes] [-n msgs]
+         [-i iterations] [-w warmup]
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mpi.h"
+
+struct halo {
+    int nreqs;
+    char *sbuf;
+    char *rbuf;
+    int *peers;
+    MPI_Request *reqs;
+};
+
+static void halo_post(struct halo *h, size_t bytes, int persistent)
+{
+    int nmsgs = h->nreqs / 2;
+
+    for (int i = 0; i < nmsgs; ++i) {
+        if (persistent) {
+            MPI_Recv_init(h->rbuf + i * bytes, (int) bytes, MPI_BYTE, h->peers[i],
+                          i, MPI_COMM_WORLD, &h->reqs[i]);
+        } else {
+            MPI_Irecv(h->rbuf + i * bytes, (int) bytes, MPI_BYTE, h->peers[i],
+                      i, MPI_COMM_WORLD, &h->reqs[i]);
+        }
+    }
+    for (int i = 0; i < nmsgs; ++i) {
+        /* slot i goes to the same side as receive slot i, tagged so
+         * that it matches the receive slot of the opposite side there */
+        int peer = h->peers[i];
+        int tag = i ^ 1;
+        if (persistent) {
+            MPI_Send_init(h->sbuf + i * bytes, (int) bytes, MPI_BYTE, peer,
+                          tag, MPI_COMM_WORLD, &h->reqs[nmsgs + i]);
+        } else {
+            MPI_Isend(h->sbuf + i * bytes, (int) bytes, MPI_BYTE, peer,
+                      tag, MPI_COMM_WORLD, &h->reqs[nmsgs + i]);
+        }
+    }
+}
+
+static double halo_run(struct halo *h, size_t bytes, int persistent,
+                       int iterations, int warmup)
+{
+    double start = 0.0, elapsed, max_elapsed;
+
+    if (persistent) {
+        halo_post(h, bytes, 1);
+    }
+
+    for (int it = 0; it < warmup + iterations; ++it) {
+        if (it == warmup) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            start = MPI_Wtime();
+        }
+        if (persistent) {
+            MPI_Startall(h->nreqs, h->reqs);
+        } else {
+            halo_post(h, bytes, 0);
+        }
+        MPI_Waitall(h->nreqs, h->reqs, MPI_STATUSES_IGNORE);
+    }
+    elapsed = (MPI_Wtime() - start) / iterations;
+
+    if (persistent) {
+        for (int i = 0; i < h->nreqs; ++i) {
+            MPI_Request_free(&h->reqs[i]);
+        }
+    }
+
+    MPI_Allreduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return max_elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t min_bytes = 0, max_bytes = 1 << 16;
+    int nmsgs = 8, iterations = 10000, warmup = 100;
+    int rank, size, opt;
+    struct halo h;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    while (-1 != (opt = getopt(argc, argv, "m:M:n:i:w:h"))) {
+        switch (opt) {
+        case 'm': min_bytes = strtoul(optarg, NULL, 0); break;
+        case 'M': max_bytes = strtoul(optarg, NULL, 0); break;
+        case 'n': nmsgs = atoi(optarg); break;
+        case 'i': iterations = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        default:
+            if (0 == rank) {
+                fprintf(stderr, "Usage: %s [-m min_bytes] [-M max_bytes] [-n msgs]"
+                        " [-i iterations] [-w warmup]\n", argv[0]);
+            }
+            MPI_Finalize();
+            return 'h' == opt ? 0 : 1;
+        }
+    }
+    if (nmsgs < 1 || iterations < 1 || warmup < 0) {
+        if (0 == rank) {
+            fprintf(stderr, "invalid arguments\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    /* messages alternate between the left and the right neighbour */
+    h.nreqs = 4 * nmsgs;
+    h.peers = malloc(2 * nmsgs * sizeof(int));
+    h.reqs = malloc(h.nreqs * sizeof(MPI_Request));
+    h.sbuf = malloc(2 * nmsgs * (max_bytes ? max_bytes : 1));
+    h.rbuf = malloc(2 * nmsgs * (max_bytes ? max_bytes : 1));
+    if (NULL == h.peers || NULL == h.reqs || NULL == h.sbuf || NULL == h.rbuf) {
+        fprintf(stderr, "out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int i = 0; i < 2 * nmsgs; ++i) {
+        h.peers[i] = (i & 1) ? (rank + 1) % size : (rank + size - 1) % size;
+    }
+    memset(h.sbuf, rank, 2 * nmsgs * (max_bytes ? max_bytes : 1));
+
+    if (0 == rank) {
+        printf("# %d processes, %d requests per iteration\n", size, h.nreqs);
+        printf("%-10s %14s %14s %10s\n", "bytes", "isend_us", "persistent_us", "speedup");
+    }
+
+    for (size_t bytes = min_bytes; bytes <= max_bytes; bytes = bytes ? bytes * 2 : 1) {
+        double t_nb = halo_run(&h, bytes, 0, iterations, warmup);
+        double t_p = halo_run(&h, bytes, 1, iterations, warmup);
+        if (0 == rank) {
+            printf("%-10zu %14.3f %14.3f %10.2f\n", bytes, t_nb * 1e6, t_p * 1e6, t_nb / t_p);
+        }
+    }
+
+    free(h.peers);
+    free(h.reqs);
+    free(h.sbuf);
+    free(h.rbuf);
+    MPI_Finalize();
+    return 0;
+}